@@ -27,6 +27,7 @@
 #import <Cocoa/Cocoa.h>
 #import "XRGPrefController.h"
 #import "XRGSensorViewController.h"
+#import "XRGDiagnosticsWindowController.h"
 #import "XRGSettings.h"
 #import "XRGModuleManager.h"
 
@@ -38,10 +39,12 @@
 @property (strong) IBOutlet XRGGraphWindow *xrgGraphWindow;
 @property (strong) IBOutlet NSWindow *sensorWindow;
 @property (strong) IBOutlet XRGSensorViewController *sensorViewController;
+@property (strong) XRGDiagnosticsWindowController *diagnosticsWindowController;
 
 - (IBAction)showPrefs:(id)sender;
 - (void)showPrefsWithPanel:(NSString *)panelName;
 - (IBAction)openSensorWindow:(id)sender;
+- (IBAction)openDiagnosticsWindow:(id)sender;
 
 - (XRGSettings *)appSettings;
 - (XRGModuleManager *)moduleManager;
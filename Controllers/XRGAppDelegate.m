@@ -65,6 +65,30 @@
     [[NSUserDefaults standardUserDefaults] setBool:YES forKey:XRG_showSensorWindow];
 }
 
+- (IBAction)openDiagnosticsWindow:(id)sender {
+    if (!self.diagnosticsWindowController) {
+        self.diagnosticsWindowController = [[XRGDiagnosticsWindowController alloc] init];
+    }
+
+    [self.diagnosticsWindowController showWindow:self];
+    [self.diagnosticsWindowController.window makeKeyAndOrderFront:self];
+}
+
+// The menus live in the compiled MainMenu nib, so the Diagnostics item goes in next to Sensors at launch.
+- (void)addDiagnosticsMenuItem {
+    for (NSMenuItem *topItem in NSApp.mainMenu.itemArray) {
+        NSMenu *menu = topItem.submenu;
+        for (NSMenuItem *sensorItem in menu.itemArray) {
+            if (sensorItem.action != @selector(openSensorWindow:)) continue;
+
+            NSMenuItem *item = [[NSMenuItem alloc] initWithTitle:@"Diagnostics" action:@selector(openDiagnosticsWindow:) keyEquivalent:@""];
+            item.target = self;
+            [menu insertItem:item atIndex:[menu indexOfItem:sensorItem] + 1];
+            return;
+        }
+    }
+}
+
 - (BOOL)windowShouldClose:(NSWindow *)sender {
     if (sender == self.sensorWindow) {
         [[NSUserDefaults standardUserDefaults] setBool:NO forKey:XRG_showSensorWindow];
@@ -101,6 +125,8 @@
         [self openSensorWindow:self];
     }
 
+    [self addDiagnosticsMenuItem];
+
     // This is an ugly hack, but we were running into an issue where the menubar wouldn't be selectable at launch until switching to another app and back to XRG (issue exists as of macOS 10.15).  This will perform that programmatically, and switches to the Dock so the user doesn't notice any UI changes.
     [[[NSRunningApplication runningApplicationsWithBundleIdentifier:@"com.apple.dock"] firstObject] activateWithOptions:0];
     dispatch_async(dispatch_get_main_queue(), ^{
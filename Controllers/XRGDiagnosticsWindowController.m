@@ -0,0 +1,159 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGDiagnosticsWindowController.m
+//
+
+#import "XRGDiagnosticsWindowController.h"
+#import "XRGDiagnostics.h"
+#import "XRGScheduler.h"
+#import "XRGBenchmarks.h"
+
+@interface XRGDiagnosticsWindowController ()
+
+@property XRGScheduledTask *timer;
+
+@property NSTextView *reportView;
+@property NSButton *allocationsCheckbox;
+@property NSString *benchmarkReport;
+
+@end
+
+@implementation XRGDiagnosticsWindowController
+
+- (instancetype)init {
+    NSPanel *panel = [[NSPanel alloc] initWithContentRect:NSMakeRect(0, 0, 900, 420)
+                                                styleMask:NSWindowStyleMaskTitled | NSWindowStyleMaskClosable | NSWindowStyleMaskResizable | NSWindowStyleMaskUtilityWindow
+                                                  backing:NSBackingStoreBuffered
+                                                    defer:YES];
+    self = [super initWithWindow:panel];
+    if (self) {
+        panel.title = @"XRG Diagnostics";
+        panel.hidesOnDeactivate = NO;
+        panel.releasedWhenClosed = NO;
+        panel.minSize = NSMakeSize(500, 200);
+        panel.delegate = self;
+        [panel center];
+        
+        [self setUpContentView:panel.contentView];
+    }
+    return self;
+}
+
+- (void)setUpContentView:(NSView *)contentView {
+    NSScrollView *scrollView = [[NSScrollView alloc] initWithFrame:NSZeroRect];
+    scrollView.translatesAutoresizingMaskIntoConstraints = NO;
+    scrollView.hasVerticalScroller = YES;
+    scrollView.hasHorizontalScroller = YES;
+    scrollView.borderType = NSBezelBorder;
+    
+    self.reportView = [[NSTextView alloc] initWithFrame:NSMakeRect(0, 0, 900, 380)];
+    self.reportView.editable = NO;
+    self.reportView.richText = NO;
+    self.reportView.font = [NSFont monospacedSystemFontOfSize:11 weight:NSFontWeightRegular];
+    self.reportView.horizontallyResizable = YES;
+    self.reportView.textContainer.widthTracksTextView = NO;
+    self.reportView.textContainer.containerSize = NSMakeSize(CGFLOAT_MAX, CGFLOAT_MAX);
+    self.reportView.maxSize = NSMakeSize(CGFLOAT_MAX, CGFLOAT_MAX);
+    scrollView.documentView = self.reportView;
+    
+    self.allocationsCheckbox = [NSButton checkboxWithTitle:@"Count allocations" target:self action:@selector(toggleAllocationCounting:)];
+    self.allocationsCheckbox.state = [XRGDiagnostics shared].countsAllocations ? NSControlStateValueOn : NSControlStateValueOff;
+    NSButton *benchmarkButton = [NSButton buttonWithTitle:@"Run Benchmarks" target:self action:@selector(runBenchmarks:)];
+    NSButton *resetButton = [NSButton buttonWithTitle:@"Reset" target:self action:@selector(resetDiagnostics:)];
+    NSButton *saveButton = [NSButton buttonWithTitle:@"Save Dump…" target:self action:@selector(saveDump:)];
+    
+    for (NSView *view in @[scrollView, self.allocationsCheckbox, benchmarkButton, resetButton, saveButton]) {
+        view.translatesAutoresizingMaskIntoConstraints = NO;
+        [contentView addSubview:view];
+    }
+    
+    [NSLayoutConstraint activateConstraints:@[
+        [scrollView.topAnchor constraintEqualToAnchor:contentView.topAnchor constant:12],
+        [scrollView.leadingAnchor constraintEqualToAnchor:contentView.leadingAnchor constant:12],
+        [scrollView.trailingAnchor constraintEqualToAnchor:contentView.trailingAnchor constant:-12],
+        [scrollView.bottomAnchor constraintEqualToAnchor:saveButton.topAnchor constant:-12],
+        
+        [self.allocationsCheckbox.leadingAnchor constraintEqualToAnchor:contentView.leadingAnchor constant:12],
+        [self.allocationsCheckbox.centerYAnchor constraintEqualToAnchor:saveButton.centerYAnchor],
+        [benchmarkButton.trailingAnchor constraintEqualToAnchor:resetButton.leadingAnchor constant:-8],
+        [benchmarkButton.centerYAnchor constraintEqualToAnchor:saveButton.centerYAnchor],
+        [resetButton.trailingAnchor constraintEqualToAnchor:saveButton.leadingAnchor constant:-8],
+        [resetButton.centerYAnchor constraintEqualToAnchor:saveButton.centerYAnchor],
+        [saveButton.trailingAnchor constraintEqualToAnchor:contentView.trailingAnchor constant:-12],
+        [saveButton.bottomAnchor constraintEqualToAnchor:contentView.bottomAnchor constant:-12],
+    ]];
+}
+
+- (void)showWindow:(id)sender {
+    [super showWindow:sender];
+    [self refresh];
+    
+    if (!self.timer) {
+        __weak XRGDiagnosticsWindowController *weakSelf = self;
+        self.timer = [[XRGScheduler shared] scheduleTaskNamed:@"Diagnostics Window" interval:1.0 block:^{
+            [weakSelf refresh];
+        }];
+    }
+}
+
+- (void)windowWillClose:(NSNotification *)notification {
+    [self.timer invalidate];
+    self.timer = nil;
+}
+
+- (void)refresh {
+    NSString *report = [[XRGDiagnostics shared] report];
+    if (self.benchmarkReport) report = [report stringByAppendingFormat:@"\n%@", self.benchmarkReport];
+    self.reportView.string = report;
+}
+
+- (IBAction)toggleAllocationCounting:(id)sender {
+    [XRGDiagnostics shared].countsAllocations = self.allocationsCheckbox.state == NSControlStateValueOn;
+}
+
+- (IBAction)runBenchmarks:(id)sender {
+    self.benchmarkReport = [XRGBenchmarks report];
+    [self refresh];
+}
+
+- (IBAction)resetDiagnostics:(id)sender {
+    [[XRGDiagnostics shared] reset];
+    [self refresh];
+}
+
+- (IBAction)saveDump:(id)sender {
+    NSSavePanel *savePanel = [NSSavePanel savePanel];
+    savePanel.nameFieldStringValue = @"XRG Diagnostics.txt";
+    
+    [savePanel beginSheetModalForWindow:self.window completionHandler:^(NSModalResponse result) {
+        if (result != NSModalResponseOK || !savePanel.URL) return;
+        
+        NSError *error = nil;
+        if (![[XRGDiagnostics shared] writeDumpToURL:savePanel.URL error:&error]) {
+            [[NSAlert alertWithError:error] beginSheetModalForWindow:self.window completionHandler:nil];
+        }
+    }];
+}
+
+@end
@@ -37,18 +37,23 @@
 #import "XRGBackgroundView.h"
 #import "XRGSettings.h"
 #import "XRGModuleManager.h"
+#import "XRGScheduler.h"
 
 @interface XRGGraphWindow : NSWindow
 
 @property int borderWidth;
 //@property NSSize minSize;
-@property BOOL minimized;
+@property (nonatomic) BOOL minimized;
+
+// How many times graphRefresh the graph timer currently waits; more than 1 while adaptive sampling has backed off,
+// because the window is hidden or the graphs on screen have been idle.
+@property (readonly) NSUInteger graphIntervalStretch;
 
 // Timers
-@property NSTimer *min30Timer;
-@property NSTimer *min5Timer;
-@property NSTimer *graphTimer;
-@property NSTimer *fastTimer;
+@property XRGScheduledTask *min30Timer;
+@property XRGScheduledTask *min5Timer;
+@property XRGScheduledTask *graphTimer;
+@property XRGScheduledTask *fastTimer;
 
 // Settings
 @property NSFontManager *fontManager;
@@ -95,6 +100,7 @@
 - (void)min5Update:(NSTimer *)aTimer;
 - (void)graphUpdate:(NSTimer *)aTimer;
 - (void)fastUpdate:(NSTimer *)aTimer;
+- (void)updateSamplingPolicy;
 
 // Methods that set up module references
 - (void)setBackgroundView:(id)background;
@@ -124,6 +130,10 @@
 - (IBAction)setForegroundWhenExpanding:(id)sender;
 - (IBAction)setShowSummary:(id)sender;
 - (IBAction)setMinimizeUpDown:(id)sender;
+- (IBAction)setAdaptiveSampling:(id)sender;
+- (IBAction)setIncrementalGraphs:(id)sender;
+- (IBAction)setLayerBackedGraphs:(id)sender;
+- (IBAction)setGraphHistorySpan:(id)sender;
 
 - (IBAction)setObjectsToColor:(id)sender;
 - (IBAction)setObjectsToTransparency:(id)sender;
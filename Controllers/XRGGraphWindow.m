@@ -26,15 +26,33 @@
 
 #import "XRGGraphWindow.h"
 #import "definitions.h"
+#import "XRGSampler.h"
+#import "XRGDiagnostics.h"
 #import <stdio.h>
 #import <IOKit/IOMessage.h>
 #import <IOKit/pwr_mgt/IOPMLib.h>
+#include <time.h>
 
 // sleep/wake notifications
 bool systemJustWokeUp;
 io_object_t powerConnection;
 void sleepNotification(void *refcon, io_service_t service, natural_t messageType, void *messageArgument);
 
+// Adaptive sampling: how much the graph interval stretches while nothing is on screen, and while every graph on
+// screen has stayed the same for XRG_IDLE_GRAPH_TICKS ticks; and the most graph intervals one tick may backfill.
+#define XRG_HIDDEN_GRAPH_INTERVAL_STRETCH   4
+#define XRG_IDLE_GRAPH_INTERVAL_STRETCH     2
+#define XRG_IDLE_GRAPH_TICKS                30
+#define XRG_MAX_GRAPH_TICK_SPAN             60
+
+@interface XRGGraphWindow ()
+@property NSUInteger graphIntervalStretch;
+@property BOOL backedOffWhileHidden;
+@property uint64_t lastGraphTick;
+@property NSUInteger lastGraphGeneration;
+@property NSUInteger idleGraphTicks;
+@end
+
 @implementation XRGGraphWindow
 
 ///// Initialization Methods /////
@@ -80,6 +98,10 @@ void sleepNotification(void *refcon, io_service_t service, natural_t messageType
 		rls = IONotificationPortGetRunLoopSource(thePortRef);
 		CFRunLoopAddSource(CFRunLoopGetCurrent(), rls, kCFRunLoopDefaultMode);
 		
+		// Covered, on another Space or behind the screen saver: adaptive sampling backs off.
+		self.graphIntervalStretch = 1;
+		[[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(occlusionStateChanged:) name:NSWindowDidChangeOcclusionStateNotification object:self];
+		
 		if ([self.appSettings checkForUpdates]) {
 			[self checkServerForUpdates];
 		}
@@ -157,6 +179,10 @@ void sleepNotification(void *refcon, io_service_t service, natural_t messageType
     appDefs[XRG_showSummary] = @"YES";
     appDefs[XRG_minimizeUpDown] = @"";
     appDefs[XRG_isDockIconHidden] = @"NO";
+    appDefs[XRG_adaptiveSampling] = @"YES";
+    appDefs[XRG_incrementalGraphs] = @"YES";
+    appDefs[XRG_layerBackedGraphs] = @"YES";
+    appDefs[XRG_graphHistorySpan] = @"0";
     
     appDefs[XRG_showCPUBars] = @"YES";
     appDefs[XRG_separateCPUColor] = @"YES";
@@ -215,6 +241,10 @@ void sleepNotification(void *refcon, io_service_t service, natural_t messageType
     [self.appSettings setShowSummary:             [defs[XRG_showSummary] boolValue]];
     [self.appSettings setMinimizeUpDown:          [defs[XRG_minimizeUpDown] intValue]];
     [self.appSettings setIsDockIconHidden:        [defs[XRG_isDockIconHidden] boolValue]];
+    [self.appSettings setAdaptiveSampling:        [defs[XRG_adaptiveSampling] boolValue]];
+    [self.appSettings setIncrementalGraphs:       [defs[XRG_incrementalGraphs] boolValue]];
+    [self.appSettings setLayerBackedGraphs:       [defs[XRG_layerBackedGraphs] boolValue]];
+    [self.appSettings setGraphHistorySpan:        [defs[XRG_graphHistorySpan] intValue]];
 
     [self.appSettings setBackgroundColor:        [NSUnarchiver unarchiveObjectWithData: defs[XRG_backgroundColor]]];
     [self.appSettings setGraphBGColor:           [NSUnarchiver unarchiveObjectWithData: defs[XRG_graphBGColor]]];
@@ -470,34 +500,92 @@ void sleepNotification(void *refcon, io_service_t service, natural_t messageType
 ///// Timer Methods /////
 
 - (void)initTimers {
+    XRGScheduler *scheduler = [XRGScheduler shared];
+    __weak XRGGraphWindow *weakSelf = self;
+    
     if (!self.min30Timer) {
-        self.min30Timer = [NSTimer scheduledTimerWithTimeInterval:1800.0
-														   target:self
-														 selector:@selector(min30Update:)
-														 userInfo:nil
-														  repeats:YES];
+        self.min30Timer = [scheduler scheduleTaskNamed:@"30 Minute" interval:1800.0 block:^{
+            [weakSelf min30Update:nil];
+        }];
     }
     if (!self.min5Timer) {
-        self.min5Timer = [NSTimer scheduledTimerWithTimeInterval:300.0
-														  target:self
-														selector:@selector(min5Update:)
-														userInfo:nil
-														 repeats:YES];
+        self.min5Timer = [scheduler scheduleTaskNamed:@"5 Minute" interval:300.0 block:^{
+            [weakSelf min5Update:nil];
+        }];
     }
     if (!self.graphTimer) {
-        self.graphTimer = [NSTimer scheduledTimerWithTimeInterval:self.appSettings.graphRefresh
-														   target:self
-														 selector:@selector(graphUpdate:)
-														 userInfo:nil
-														  repeats:YES];
+        self.graphTimer = [scheduler scheduleTaskNamed:@"Graph" interval:self.appSettings.graphRefresh block:^{
+            [weakSelf graphUpdate:nil];
+        }];
+        [self updateGraphInterval];
     }
     if (!self.fastTimer) {
-		self.fastTimer = [NSTimer scheduledTimerWithTimeInterval:0.125
-														  target:self
-														selector:@selector(fastUpdate:)
-														userInfo:nil
-														 repeats:YES];
+        [XRGSampler shared].fastBudget = 0.125 * 0.5;
+        self.fastTimer = [scheduler scheduleTaskNamed:@"Fast" interval:0.125 block:^{
+            [weakSelf fastUpdate:nil];
+        }];
     }
+    
+    [self updateSamplingPolicy];
+}
+
+- (void)updateGraphInterval {
+    NSTimeInterval interval = self.appSettings.graphRefresh * self.graphIntervalStretch;
+    
+    // A module that takes more than half the interval is left for the next tick rather than holding up the rest.
+    [XRGSampler shared].graphBudget = interval * 0.5;
+    self.graphTimer.interval = interval;
+}
+
+- (void)setMinimized:(BOOL)minimized {
+    _minimized = minimized;
+    [self updateSamplingPolicy];
+}
+
+- (void)occlusionStateChanged:(NSNotification *)notification {
+    [self updateSamplingPolicy];
+}
+
+- (void)updateSamplingPolicy {
+    // Minimized leaves only the title bar, so no graph or mini graph is showing either way.
+    BOOL hidden = self.minimized || !(self.occlusionState & NSWindowOcclusionStateVisible);
+    BOOL backOff = hidden && self.appSettings.adaptiveSampling;
+    BOOL idle = self.idleGraphTicks >= XRG_IDLE_GRAPH_TICKS && self.appSettings.adaptiveSampling;
+    
+    self.fastTimer.paused = backOff;
+    
+    NSUInteger stretch = backOff ? XRG_HIDDEN_GRAPH_INTERVAL_STRETCH : (idle ? XRG_IDLE_GRAPH_INTERVAL_STRETCH : 1);
+    BOOL revealed = self.backedOffWhileHidden && !backOff;
+    self.backedOffWhileHidden = backOff;
+    if (stretch == self.graphIntervalStretch) return;
+    
+    self.graphIntervalStretch = stretch;
+    [self updateGraphInterval];
+    
+    // Back on screen: catch the graphs up now rather than up to a stretched interval later.
+    if (revealed && self.graphTimer) [self graphUpdate:nil];
+}
+
+// Counts the graph ticks in a row where nothing on screen changed, going by the views' change generations, and backs
+// off or tightens up when that crosses XRG_IDLE_GRAPH_TICKS.  A tick is applied after it's queued, so this sees the
+// result of the previous one.
+- (void)noteGraphActivity {
+    NSUInteger generation = [self.moduleManager graphGeneration];
+    BOOL changed = generation == NSNotFound || generation != self.lastGraphGeneration;
+    self.lastGraphGeneration = generation;
+    
+    BOOL wasIdle = self.idleGraphTicks >= XRG_IDLE_GRAPH_TICKS;
+    self.idleGraphTicks = changed ? 0 : self.idleGraphTicks + 1;
+    if ((self.idleGraphTicks >= XRG_IDLE_GRAPH_TICKS) != wasIdle) [self updateSamplingPolicy];
+}
+
+- (NSUInteger)graphTickSpanAt:(uint64_t)now {
+    uint64_t last = self.lastGraphTick;
+    if (!self.appSettings.adaptiveSampling || !last || now <= last || self.appSettings.graphRefresh <= 0) return 1;
+    
+    // Whole graph intervals since the last tick, so a stretched or late tick fills the slots it stands in for.
+    double intervals = (double)(now - last) / 1e9 / self.appSettings.graphRefresh;
+    return (NSUInteger)MIN(MAX(llround(intervals), 1), XRG_MAX_GRAPH_TICK_SPAN);
 }
 
 - (void)min30Update:(NSTimer *)aTimer {
@@ -509,7 +597,12 @@ void sleepNotification(void *refcon, io_service_t service, natural_t messageType
 }
 
 - (void)graphUpdate:(NSTimer *)aTimer {
-    [self.moduleManager graphUpdate];
+    [[XRGDiagnostics shared] finishFrame];
+    [self noteGraphActivity];
+    
+    // A dropped tick leaves lastGraphTick alone, so the next one that's queued covers its intervals too.
+    uint64_t now = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+    if ([self.moduleManager graphUpdateWithSpan:[self graphTickSpanAt:now]]) self.lastGraphTick = now;
     [self checkServerForUpdatesPostProcess];
 }
 
@@ -651,12 +744,11 @@ void sleepNotification(void *refcon, io_service_t service, natural_t messageType
 	f = roundf(f * 5.) * 0.2;
     [self.appSettings setGraphRefresh:f];
     
-    [self.graphTimer invalidate];
-    self.graphTimer = [NSTimer scheduledTimerWithTimeInterval:f
-													   target:self
-													 selector:@selector(graphUpdate:)
-													 userInfo:nil
-													  repeats:YES];
+    [self updateGraphInterval];
+    [self.cpuView updateHistoryStorage];
+    [self.memoryView updateHistoryStorage];
+    [self.netView updateHistoryStorage];
+    [self.temperatureView updateHistoryStorage];
 }
 
 - (IBAction)setWindowLevel:(id)sender {
@@ -697,6 +789,31 @@ void sleepNotification(void *refcon, io_service_t service, natural_t messageType
     [self.appSettings setMinimizeUpDown:[sender indexOfSelectedItem]];
 }
 
+- (IBAction)setAdaptiveSampling:(id)sender {
+    [self.appSettings setAdaptiveSampling:([sender state] == NSOnState)];
+    [[NSUserDefaults standardUserDefaults] setBool:self.appSettings.adaptiveSampling forKey:XRG_adaptiveSampling];
+    [self updateSamplingPolicy];
+}
+
+- (IBAction)setIncrementalGraphs:(id)sender {
+    [self.appSettings setIncrementalGraphs:([sender state] == NSOnState)];
+    [[NSUserDefaults standardUserDefaults] setBool:self.appSettings.incrementalGraphs forKey:XRG_incrementalGraphs];
+    [self.cpuView setNeedsDisplay:YES];
+}
+
+- (IBAction)setLayerBackedGraphs:(id)sender {
+    [self.appSettings setLayerBackedGraphs:([sender state] == NSOnState)];
+    [[NSUserDefaults standardUserDefaults] setBool:self.appSettings.layerBackedGraphs forKey:XRG_layerBackedGraphs];
+    [self.backgroundView setModulesLayerBacked:self.appSettings.layerBackedGraphs];
+}
+
+// The sender's tag is the XRGGraphHistorySpan.
+- (IBAction)setGraphHistorySpan:(id)sender {
+    [self.appSettings setGraphHistorySpan:[sender tag]];
+    [[NSUserDefaults standardUserDefaults] setInteger:self.appSettings.graphHistorySpan forKey:XRG_graphHistorySpan];
+    [self.backgroundView setNeedsDisplay:YES];
+}
+
 - (IBAction)setShowTotalBandwidthSinceBoot:(id)sender {
     [self.appSettings setShowTotalBandwidthSinceBoot:([sender state] == NSOnState)];
 }
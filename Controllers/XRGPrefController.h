@@ -69,6 +69,10 @@
     IBOutlet id generalForegroundWhenExpanding;
     IBOutlet id generalShowSummary;
     IBOutlet id generalMinimizeUpDown;
+    IBOutlet id generalAdaptiveSampling;
+    IBOutlet id generalSamplingRates;
+    IBOutlet id generalIncrementalGraphs;
+    IBOutlet id generalLayerBackedGraphs;
 
     IBOutlet id backgroundColorWell;
     IBOutlet id backgroundTransparency;
@@ -156,6 +160,8 @@
 - (void)setUpWell:(NSColorWell *)well withTransparency:(NSSlider *)tSlider;
 - (void)setUpModuleSelection;
 - (IBAction)setGraphRefreshAction:(id)sender;
+- (IBAction)setAdaptiveSamplingAction:(id)sender;
+- (void)updateSamplingRatesText;
 - (IBAction)setNetMinGraphValueAction:(id)sender;
 - (IBAction)setNetMinGraphUnitsAction:(id)sender;
 - (NSColorWell *)colorWellForTag:(int)aTag;
@@ -226,6 +226,9 @@
     [defs setObject: ([generalForegroundWhenExpanding state] == NSOnState ? @"YES" : @"NO") forKey:XRG_foregroundWhenExpanding];
     [defs setObject: ([generalShowSummary state] == NSOnState ? @"YES" : @"NO")      forKey:XRG_showSummary];
     [defs setInteger: [generalMinimizeUpDown indexOfSelectedItem]                    forKey:XRG_minimizeUpDown];
+    [defs setBool:    [generalAdaptiveSampling state] == NSOnState                   forKey:XRG_adaptiveSampling];
+    [defs setBool:    [generalIncrementalGraphs state] == NSOnState                  forKey:XRG_incrementalGraphs];
+    [defs setBool:    [generalLayerBackedGraphs state] == NSOnState                  forKey:XRG_layerBackedGraphs];
     
     [defs setObject: ([showCPUGraph state] == NSOnState ? @"YES" : @"NO")            forKey:XRG_showCPUGraph];    
 	[defs setObject: ([showGPUGraph state] == NSOnState ? @"YES" : @"NO")            forKey:XRG_showGPUGraph];
@@ -503,6 +506,22 @@
         [generalMinimizeUpDown selectItemAtIndex:0];
     else
         [generalMinimizeUpDown selectItemAtIndex:selection];    
+    
+    // Setup adaptive sampling, with the rates it has settled on next to it
+    [generalAdaptiveSampling setTarget:self];
+    [generalAdaptiveSampling setAction:@selector(setAdaptiveSamplingAction:)];
+    [generalAdaptiveSampling setState:self.xrgGraphWindow.appSettings.adaptiveSampling ? NSOnState : NSOffState];
+    [self updateSamplingRatesText];
+    
+    // Setup incremental graphs
+    [generalIncrementalGraphs setTarget:self.xrgGraphWindow];
+    [generalIncrementalGraphs setAction:@selector(setIncrementalGraphs:)];
+    [generalIncrementalGraphs setState:self.xrgGraphWindow.appSettings.incrementalGraphs ? NSOnState : NSOffState];
+    
+    // Setup layer-backed graphs
+    [generalLayerBackedGraphs setTarget:self.xrgGraphWindow];
+    [generalLayerBackedGraphs setAction:@selector(setLayerBackedGraphs:)];
+    [generalLayerBackedGraphs setState:self.xrgGraphWindow.appSettings.layerBackedGraphs ? NSOnState : NSOffState];
         
     return;
 }
@@ -1029,6 +1048,37 @@
     [graphRefreshText setStringValue:s];
 
     [self.xrgGraphWindow setGraphRefreshActionPart2:sender];
+    [self updateSamplingRatesText];
+}
+
+- (IBAction)setAdaptiveSamplingAction:(id)sender {
+    [self.xrgGraphWindow setAdaptiveSampling:sender];
+    [self updateSamplingRatesText];
+}
+
+// The intervals the graph window's timers are running at right now, which adaptive sampling stretches or pauses
+// while the graphs are hidden or idle.
+- (void)updateSamplingRatesText {
+    XRGScheduledTask *graphTimer = self.xrgGraphWindow.graphTimer;
+    XRGScheduledTask *fastTimer = self.xrgGraphWindow.fastTimer;
+    
+    NSString *graphRate;
+    if (!graphTimer)
+        graphRate = @"not started";
+    else if (roundf(graphTimer.interval * 10.) == 10)
+        graphRate = @"every second";
+    else
+        graphRate = [NSString stringWithFormat:@"every %2.1f seconds", graphTimer.interval];
+    
+    NSString *fastRate;
+    if (!fastTimer)
+        fastRate = @"not started";
+    else if (fastTimer.paused)
+        fastRate = @"paused";
+    else
+        fastRate = [NSString stringWithFormat:@"every %.3g seconds", fastTimer.interval];
+    
+    [generalSamplingRates setStringValue:[NSString stringWithFormat:@"Now sampling graphs %@ and fast updates %@", graphRate, fastRate]];
 }
 
 - (void)setUpModuleSelection {
@@ -1109,6 +1159,7 @@
 }
 
 -(IBAction) General:(id)sender {
+    [self updateSamplingRatesText];
     if (currentView != GeneralPrefView) {
         [self switchWindowFromView:currentView toView:GeneralPrefView];
         currentView = GeneralPrefView;
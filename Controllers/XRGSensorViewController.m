@@ -31,10 +31,11 @@
 #import "XRGAppDelegate.h"
 #import "XRGStatsManager.h"
 #import "XRGTemperatureView.h"
+#import "XRGScheduler.h"
 
 @interface XRGSensorViewController ()
 
-@property NSTimer *timer;
+@property XRGScheduledTask *timer;
 
 @property IBOutlet NSTextField *nameValuesLabel;
 @property IBOutlet NSTextField *currentValuesLabel;
@@ -65,7 +66,7 @@
     [super viewWillAppear];
     
     __weak XRGSensorViewController *weakSelf = self;
-    self.timer = [NSTimer scheduledTimerWithTimeInterval:1.0 repeats:YES block:^(NSTimer * _Nonnull timer) {
+    self.timer = [[XRGScheduler shared] scheduleTaskNamed:@"Sensor Window" interval:1.0 block:^{
         [weakSelf refresh];
     }];
 }
@@ -93,11 +94,21 @@
     for (NSString *key in sensorKeys) {
         XRGSensorData *sensor = [[XRGTemperatureMiner shared] sensorForLocation:key];
         XRGStatsContentItem *sensorStats = [statsManager statForKey:key inModule:XRGStatsModuleNameTemperature];
+        XRGStatsWindowSummary *recentStats = [sensorStats summaryForWindow:XRGStatsWindowFiveMinutes];
 
         double current = sensorStats.last;
         double avg = sensorStats.average;
         double min = sensorStats.min;
         double max = sensorStats.max;
+        double p50 = sensorStats.p50;
+        double p95 = sensorStats.p95;
+        double p99 = sensorStats.p99;
+        double recentAvg = recentStats.average;
+        double recentMin = recentStats.min;
+        double recentMax = recentStats.max;
+        double recentP50 = recentStats.p50;
+        double recentP95 = recentStats.p95;
+        double recentP99 = recentStats.p99;
 
         NSString *units = sensor.units;
         if ([units isEqualToString:cUnitsString] && convertToF) {
@@ -105,13 +116,22 @@
             avg = avg * 1.8 + 32;
             min = min * 1.8 + 32;
             max = max * 1.8 + 32;
+            p50 = p50 * 1.8 + 32;
+            p95 = p95 * 1.8 + 32;
+            p99 = p99 * 1.8 + 32;
+            recentAvg = recentAvg * 1.8 + 32;
+            recentMin = recentMin * 1.8 + 32;
+            recentMax = recentMax * 1.8 + 32;
+            recentP50 = recentP50 * 1.8 + 32;
+            recentP95 = recentP95 * 1.8 + 32;
+            recentP99 = recentP99 * 1.8 + 32;
 
             units = fUnitsString;
         }
 
         [sensorNames appendFormat:@"%@\n", sensor.humanReadableName];
         [currentValues appendFormat:@"%.0f%@\n", current, units];
-        [statsValues appendFormat:@"%.0f - %.0f - %.0f\n", min, avg, max];
+        [statsValues appendFormat:@"%.0f - %.0f - %.0f  %.0f / %.0f / %.0f    %.0f - %.0f - %.0f  %.0f / %.0f / %.0f\n", recentMin, recentAvg, recentMax, recentP50, recentP95, recentP99, min, avg, max, p50, p95, p99];
     }
 
     [self.nameValuesLabel setStringValue:sensorNames];
@@ -140,9 +160,51 @@
         [copyText appendFormat:@"\t%@:  %.1f\n", sensor.label, sensor.currentValue];
     }
 
+    [copyText appendFormat:@"\nSession Statistics (last, min, avg, max, p50, p95, p99; 5 minute min, avg, max, p50, p95, p99; EWMA %@):\n", [self ewmaTimeConstantsDescription]];
+    [self appendStatsForModule:XRGStatsModuleNameCPU named:@"CPU" toString:copyText];
+    [self appendStatsForModule:XRGStatsModuleNameNetwork named:@"Network" toString:copyText];
+    [self appendStatsForModule:XRGStatsModuleNameDisk named:@"Disk" toString:copyText];
+    [self appendStatsForModule:XRGStatsModuleNameTemperature named:@"Temperature" toString:copyText];
+    [self appendStatsForModule:XRGStatsModuleNameSampler named:@"Sampler" toString:copyText];
+
+    XRGScheduler *scheduler = [XRGScheduler shared];
+    [copyText appendFormat:@"\nScheduled Tasks (interval, tolerance, next fire in, last overrun ms, missed fires; %lu wakeups):\n", (unsigned long)scheduler.wakeups];
+    for (XRGScheduledTask *task in scheduler.tasks) {
+        NSString *nextFire = task.paused ? @"paused" : [NSString stringWithFormat:@"%.3f", [task.nextFireDate timeIntervalSinceNow]];
+        [copyText appendFormat:@"\t%@:  %.3f, %.3f, %@, %.1f, %lu\n", task.name, task.interval, task.tolerance, nextFire, task.lastOverrun * 1000., (unsigned long)task.missedFires];
+    }
+
     [[NSPasteboard generalPasteboard] clearContents];
     [[NSPasteboard generalPasteboard] setString:copyText forType:NSStringPboardType];
 }
 
+// Like "1 min, 5 min, 15 min", for whatever time constants the stats manager is keeping EWMAs over.
+- (NSString *)ewmaTimeConstantsDescription {
+    NSMutableArray<NSString *> *descriptions = [NSMutableArray array];
+    for (NSNumber *seconds in [XRGStatsManager shared].ewmaTimeConstants) {
+        double value = seconds.doubleValue;
+        if (value >= 60 && fmod(value, 60) == 0)
+            [descriptions addObject:[NSString stringWithFormat:@"%g min", value / 60]];
+        else
+            [descriptions addObject:[NSString stringWithFormat:@"%g s", value]];
+    }
+    return [descriptions componentsJoinedByString:@", "];
+}
+
+- (void)appendStatsForModule:(XRGStatsModule)module named:(NSString *)moduleName toString:(NSMutableString *)string {
+    XRGStatsManager *statsManager = [XRGStatsManager shared];
+
+    for (NSString *key in [[statsManager keysForModule:module] sortedArrayUsingSelector:@selector(compare:)]) {
+        XRGStatsContentItem *stats = [statsManager statForKey:key inModule:module];
+        XRGStatsWindowSummary *recent = [stats summaryForWindow:XRGStatsWindowFiveMinutes];
+
+        [string appendFormat:@"\t%@ %@:  %.1f, %.1f, %.1f, %.1f, %.1f, %.1f, %.1f;  %.1f, %.1f, %.1f, %.1f, %.1f, %.1f;", moduleName, key, stats.last, stats.min, stats.average, stats.max, stats.p50, stats.p95, stats.p99, recent.min, recent.average, recent.max, recent.p50, recent.p95, recent.p99];
+        for (NSNumber *ewma in [stats ewmaValues]) {
+            [string appendFormat:@"  %.1f", ewma.doubleValue];
+        }
+        [string appendString:@"\n"];
+    }
+}
+
 
 @end
@@ -25,6 +25,7 @@
 //
 
 #import "XRGBatteryMiner.h"
+#import "XRGDataSetArena.h"
 
 @implementation XRGBatteryInfo
 
@@ -49,6 +50,11 @@
 
 @end
 
+@interface XRGBatteryMiner ()
+// Backs chargeWatts and dischargeWatts.
+@property XRGDataSetArena *arena;
+@end
+
 @implementation XRGBatteryMiner
 
 - (instancetype)init {
@@ -57,14 +63,17 @@
         self.batteries = @[];
         self.chargeWatts = [[XRGDataSet alloc] init];
         self.dischargeWatts = [[XRGDataSet alloc] init];
+        self.arena = [[XRGDataSetArena alloc] initWithName:@"Battery" numberOfSeries:2 numValues:0];
         self.numSamples = 0;
     }
     return self;
 }
 
 - (void)setDataSize:(NSInteger)newNumSamples {
-    [self.chargeWatts resize:newNumSamples];
-    [self.dischargeWatts resize:newNumSamples];
+    if (newNumSamples < 0) return;
+    
+    NSInteger currentIndex = [self.arena resize:(size_t)newNumSamples currentIndex:self.dischargeWatts.currentIndex];
+    [self.arena attachDataSets:@[self.chargeWatts, self.dischargeWatts] currentIndex:currentIndex];
     
     self.numSamples = newNumSamples;
 }
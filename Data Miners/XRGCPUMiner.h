@@ -25,9 +25,26 @@
 //
 
 #import <Foundation/Foundation.h>
+#import "XRGCPUTicks.h"
 #import "XRGDataSet.h"
+#import "XRGDataSetGroup.h"
 #import "XRGTemperatureMiner.h"
 
+/// What one tick read from the system.  Collected on the sampler queue and never changed afterwards.
+@interface XRGCPUSample : NSObject
+
+/// One XRGCPUTicks per CPU.
+@property (readonly) NSData *ticks;
+
+/// -1 if it wasn't collected.
+@property (readonly) CGFloat loadAverage;
+
+/// 0 if it couldn't be read.
+@property (readonly) time_t bootTime;
+
+@end
+
+
 @interface XRGCPUMiner : NSObject {
 @private
 
@@ -37,12 +54,17 @@
     CGFloat						*immediateSystem;
     CGFloat						*immediateNice;
     CGFloat                     *immediateTotal;
+    CGFloat                     *immediateExtra;        // One row of numberOfCPUs values per extra state.
     NSMutableDictionary         *temperatureKeys;
 
-    processor_cpu_load_info_t   lastSlowCPUInfo;
-    processor_cpu_load_info_t   lastFastCPUInfo;
+    XRGCPUTicks                 *lastSlowCPUInfo;
+    XRGCPUTicks                 *lastFastCPUInfo;
     
+#if defined(__linux__)
+    XRGProcStatReader           *procStat;
+#else
     host_name_port_t		host;
+#endif
 }
 
 @property BOOL loadAverage;
@@ -57,15 +79,57 @@
 @property CGFloat currentLoadAverage;
 
 @property NSInteger *fastValues;
-@property NSMutableArray<XRGDataSet *> *userValues;
-@property NSMutableArray<XRGDataSet *> *systemValues;
-@property NSMutableArray<XRGDataSet *> *niceValues;
+@property (readonly) NSArray<XRGDataSet *> *userValues;
+@property (readonly) NSArray<XRGDataSet *> *systemValues;
+@property (readonly) NSArray<XRGDataSet *> *niceValues;
+
+// One series per CPU, stored together so the combined averages stay current as samples arrive.
+@property (readonly) XRGDataSetGroup *userGroup;
+@property (readonly) XRGDataSetGroup *systemGroup;
+@property (readonly) XRGDataSetGroup *niceGroup;
+
+/// One group per CPU state the platform reports beyond user, system and nice, in the order they're stacked: on Linux
+/// irq, softirq, steal, guest and then iowait, which is idle time and so goes on top of the busy states; on macOS
+/// none.  When guest time is reported it's taken out of user, so the layers never count a tick twice.
+@property (readonly) NSArray<XRGDataSetGroup *> *extraGroups;
+
+/// The graph refresh the history file is recorded at, so history from a different refresh is discarded (see
+/// -[XRGHistoryStore graphInterval]).  Set it before the first setDataSize: and again whenever the refresh changes.
+@property (nonatomic) NSTimeInterval historyInterval;
+
+/// Samples a minute at the graph refresh, for the history tier and archive the graph spans draw from on each
+/// group's average (see -[XRGDataSet keepHistoryWithSamplesPerMinute:]).  0 for none.
+@property (nonatomic) NSUInteger historySamplesPerMinute;
+
+/// How many of the data sets from dataForCPU: and combinedData are busy time.  Any after them are iowait, which is idle.
+@property (readonly) NSUInteger busyLayerCount;
+
+/// The average across the CPUs of every state that counts as busy, which is all of them but iowait.
+- (CGFloat)currentUsage;
+/// The same, averaged over the whole graph.
+- (CGFloat)averageUsage;
+
+// Each increases when a tick changes what it covers, so the view can skip or narrow its redraw: the graphed data,
+// only the load average and uptime text, or the fast values.
+@property (readonly) NSUInteger changeGeneration;
+@property (readonly) NSUInteger textGeneration;
+@property (readonly) NSUInteger fastGeneration;
 
 + (NSString *)systemModelIdentifier;
 
 - (void)graphUpdate:(NSTimer *)aTimer;
 - (void)fastUpdate:(NSTimer *)aTimer;
-- (NSInteger)calculateCPUUsageForCPUs:(processor_cpu_load_info_t *)lastCPUInfo count:(NSInteger)count;
+
+// graphUpdate: and fastUpdate: split in two.  The collect methods only make system calls, so they can run on the
+// sampler queue; the apply methods update the data sets and belong on the main thread.
+- (XRGCPUSample *)collectSample;
+- (void)applySample:(XRGCPUSample *)sample;
+/// span is how many graph intervals the sample covers; the usage over all of them is written to that many slots.
+- (void)applySample:(XRGCPUSample *)sample span:(NSUInteger)span;
+- (NSData *)collectFastSample;
+- (void)applyFastSample:(NSData *)ticks;
+
+- (NSInteger)calculateCPUUsageForCPUs:(XRGCPUTicks **)lastCPUInfo count:(NSInteger)count;
 - (NSInteger)getNumCPUs;
 - (CGFloat)getLoadAverage;
 - (void)reset;
@@ -73,7 +137,9 @@
 - (void)setCurrentUptime;
 - (void)setDataSize:(NSInteger)newNumSamples;
 
+/// System, user and nice, then one data set per group in extraGroups.
 - (NSArray *)dataForCPU:(NSInteger)cpuNumber;
+/// The averages across the CPUs, in the same order as dataForCPU:.
 - (NSArray *)combinedData;
 
 @end
@@ -26,19 +26,76 @@
 
 
 #import "XRGCPUMiner.h"
+#import "XRGHistoryStore.h"
+#import "XRGStatsManager.h"
 
 #include <assert.h>
 #include <errno.h>
 #include <stdlib.h>
+#if !defined(__linux__)
 #include <sys/sysctl.h>
 #import <mach/mach_host.h>
 #import <mach/vm_map.h>
+#endif
+
+@interface XRGCPUSample ()
+- (instancetype)initWithTicks:(NSData *)ticks loadAverage:(CGFloat)loadAverage bootTime:(time_t)bootTime;
+@end
+
+@implementation XRGCPUSample
+
+- (instancetype)initWithTicks:(NSData *)ticks loadAverage:(CGFloat)loadAverage bootTime:(time_t)bootTime {
+    self = [super init];
+    if (self) {
+        _ticks = ticks;
+        _loadAverage = loadAverage;
+        _bootTime = bootTime;
+    }
+    return self;
+}
+
+@end
+
+
+#if defined(__linux__)
+static const XRGCPUTickState XRGCPUExtraStates[] = { XRGCPUTickIRQ, XRGCPUTickSoftIRQ, XRGCPUTickSteal, XRGCPUTickGuest, XRGCPUTickIOWait };
+#define XRG_CPU_EXTRA_STATE_COUNT (sizeof(XRGCPUExtraStates) / sizeof(XRGCPUExtraStates[0]))
+// /proc/stat counters are 64 bits; iowait and idle can go backwards without wrapping.
+#define XRG_CPU_TICKS_WRAP_32 false
+#else
+static const XRGCPUTickState *XRGCPUExtraStates = NULL;
+#define XRG_CPU_EXTRA_STATE_COUNT 0
+#define XRG_CPU_TICKS_WRAP_32 true
+#endif
+
+static NSString *XRGCPUStateName(XRGCPUTickState state) {
+    switch (state) {
+        case XRGCPUTickIOWait:  return @"CPU IO Wait";
+        case XRGCPUTickIRQ:     return @"CPU IRQ";
+        case XRGCPUTickSoftIRQ: return @"CPU Soft IRQ";
+        case XRGCPUTickSteal:   return @"CPU Steal";
+        case XRGCPUTickGuest:   return @"CPU Guest";
+        default:                return @"CPU";
+    }
+}
+
+@interface XRGCPUMiner ()
+// User, system and nice rings for every CPU, then one set for each extra state, in that order.  nil if the history
+// file couldn't be opened.
+@property XRGHistoryStore *history;
+@property BOOL triedHistory;
+@property XRGStatHandle usageStatHandle;
+@end
 
 @implementation XRGCPUMiner
 
 + (NSString *)systemModelIdentifier {
     NSString *modelString = nil;
 
+#if defined(__linux__)
+    NSString *productName = [NSString stringWithContentsOfFile:@"/sys/devices/virtual/dmi/id/product_name" encoding:NSUTF8StringEncoding error:nil];
+    modelString = [productName stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]];
+#else
     size_t len = 0;
     sysctlbyname("hw.model", NULL, &len, NULL, 0);
     if (len) {
@@ -47,16 +104,21 @@
         modelString = @(model);
         free(model);
     }
+#endif
 
     return modelString;
 }
 
 - (instancetype)init {
+#if defined(__linux__)
+    procStat = XRGProcStatReaderCreate();
+#else
     host = mach_host_self();
     
     unsigned int count = HOST_BASIC_INFO_COUNT;
     host_basic_info_data_t info;
     host_info(host, HOST_BASIC_INFO, (host_info_t)&info, &count);
+#endif
         
     self.loadAverage = YES;
     
@@ -70,9 +132,10 @@
     immediateUser         = malloc(self.numberOfCPUs * sizeof(CGFloat));
     immediateNice         = malloc(self.numberOfCPUs * sizeof(CGFloat));
     immediateTotal        = malloc(self.numberOfCPUs * sizeof(CGFloat));
+    immediateExtra        = calloc(MAX(XRG_CPU_EXTRA_STATE_COUNT * self.numberOfCPUs, 1), sizeof(CGFloat));
     self.fastValues       = malloc(self.numberOfCPUs * sizeof(NSInteger));
-    lastSlowCPUInfo       = malloc(self.numberOfCPUs * sizeof(*lastSlowCPUInfo));
-    lastFastCPUInfo       = malloc(self.numberOfCPUs * sizeof(*lastFastCPUInfo));
+    lastSlowCPUInfo       = calloc(self.numberOfCPUs, sizeof(*lastSlowCPUInfo));
+    lastFastCPUInfo       = calloc(self.numberOfCPUs, sizeof(*lastFastCPUInfo));
     
     temperatureKeys = [NSMutableDictionary dictionary];
 
@@ -83,9 +146,12 @@
         immediateTotal[i]        = 0;
         self.fastValues[i]       = 0;
     }
-	self.userValues = nil;
-	self.systemValues = nil;
-	self.niceValues = nil;
+	_userGroup = nil;
+	_systemGroup = nil;
+	_niceGroup = nil;
+    _extraGroups = @[];
+
+    self.usageStatHandle = [[XRGStatsManager shared] handleForKey:@"Usage" inModule:XRGStatsModuleNameCPU];
 
     // flush out the first spike
     [self calculateCPUUsageForCPUs:&lastSlowCPUInfo count:self.numberOfCPUs];
@@ -93,122 +159,300 @@
     return self;
 }
 
-- (void)setDataSize:(NSInteger)newNumSamples {
-    NSInteger i;
+#if defined(__linux__)
+- (void)dealloc {
+    XRGProcStatReaderFree(procStat);
+}
+#endif
 
+- (void)setDataSize:(NSInteger)newNumSamples {
     if (newNumSamples < 0) return;
     
-    if(self.userValues && self.systemValues && self.niceValues) {
-        for (i = 0; i < self.numberOfCPUs; i++) {
-            [self.userValues[i] resize:(size_t)newNumSamples];
-            [self.systemValues[i] resize:(size_t)newNumSamples];
-            [self.niceValues[i] resize:(size_t)newNumSamples];
-        }
+    // Open the history once, at the first real graph size, so an empty layout pass can't trim it.
+    if (!self.history && !self.triedHistory && newNumSamples > 0) {
+        self.triedHistory = YES;
+        self.history = [[XRGHistoryStore alloc] initWithName:@"CPU" numberOfSeries:(3 + XRG_CPU_EXTRA_STATE_COUNT) * self.numberOfCPUs numValues:(size_t)newNumSamples graphInterval:self.historyInterval];
+    }
+    
+    if (self.history) {
+        [self.history resize:(size_t)newNumSamples];
+        [self attachHistory];
+    }
+    else if (self.userGroup && self.systemGroup && self.niceGroup) {
+        [self.userGroup resize:(size_t)newNumSamples];
+        [self.systemGroup resize:(size_t)newNumSamples];
+        [self.niceGroup resize:(size_t)newNumSamples];
+        for (XRGDataSetGroup *group in self.extraGroups) [group resize:(size_t)newNumSamples];
     }
     else {
-        self.userValues = [NSMutableArray array];
-        self.systemValues = [NSMutableArray array];
-        self.niceValues = [NSMutableArray array];
+        _userGroup = [[XRGDataSetGroup alloc] initWithNumberOfSeries:self.numberOfCPUs numValues:(size_t)newNumSamples];
+        _systemGroup = [[XRGDataSetGroup alloc] initWithNumberOfSeries:self.numberOfCPUs numValues:(size_t)newNumSamples];
+        _niceGroup = [[XRGDataSetGroup alloc] initWithNumberOfSeries:self.numberOfCPUs numValues:(size_t)newNumSamples];
         
-        for (i = 0; i < self.numberOfCPUs; i++) {
-            XRGDataSet *tmpDataSet = [[XRGDataSet alloc] init];
-            [tmpDataSet resize:(size_t)newNumSamples];
-            [self.userValues addObject:tmpDataSet];
-            
-            tmpDataSet = [[XRGDataSet alloc] init];
-            [tmpDataSet resize:(size_t)newNumSamples];
-            [self.systemValues addObject:tmpDataSet];
-            
-            tmpDataSet = [[XRGDataSet alloc] init];
-            [tmpDataSet resize:(size_t)newNumSamples];
-            [self.niceValues addObject:tmpDataSet];
+        NSMutableArray *extraGroups = [NSMutableArray arrayWithCapacity:XRG_CPU_EXTRA_STATE_COUNT];
+        for (NSUInteger k = 0; k < XRG_CPU_EXTRA_STATE_COUNT; k++) {
+            [extraGroups addObject:[[XRGDataSetGroup alloc] initWithNumberOfSeries:self.numberOfCPUs numValues:(size_t)newNumSamples]];
         }
+        _extraGroups = extraGroups;
+        [self nameGroups];
+        [self updateHistory];
     }
         
     numSamples  = newNumSamples;
+    _changeGeneration++;
+}
+
+// Point the groups at the mapped rings.  Called whenever the history file is opened or resized.
+- (void)attachHistory {
+    size_t numValues = self.history.numValues;
+    NSInteger currentIndex = self.history.currentIndex;
+    CGFloat *userStorage = [self.history valuesForSeries:0];
+    CGFloat *systemStorage = [self.history valuesForSeries:self.numberOfCPUs];
+    CGFloat *niceStorage = [self.history valuesForSeries:2 * self.numberOfCPUs];
+    
+    if (self.userGroup && self.systemGroup && self.niceGroup) {
+        [self.userGroup setExternalStorage:userStorage numValues:numValues currentIndex:currentIndex];
+        [self.systemGroup setExternalStorage:systemStorage numValues:numValues currentIndex:currentIndex];
+        [self.niceGroup setExternalStorage:niceStorage numValues:numValues currentIndex:currentIndex];
+        for (NSUInteger k = 0; k < self.extraGroups.count; k++) {
+            [self.extraGroups[k] setExternalStorage:[self.history valuesForSeries:(3 + k) * self.numberOfCPUs] numValues:numValues currentIndex:currentIndex];
+        }
+    }
+    else {
+        _userGroup = [[XRGDataSetGroup alloc] initWithExternalStorage:userStorage numberOfSeries:self.numberOfCPUs numValues:numValues currentIndex:currentIndex];
+        _systemGroup = [[XRGDataSetGroup alloc] initWithExternalStorage:systemStorage numberOfSeries:self.numberOfCPUs numValues:numValues currentIndex:currentIndex];
+        _niceGroup = [[XRGDataSetGroup alloc] initWithExternalStorage:niceStorage numberOfSeries:self.numberOfCPUs numValues:numValues currentIndex:currentIndex];
+        
+        NSMutableArray *extraGroups = [NSMutableArray arrayWithCapacity:XRG_CPU_EXTRA_STATE_COUNT];
+        for (NSUInteger k = 0; k < XRG_CPU_EXTRA_STATE_COUNT; k++) {
+            CGFloat *storage = [self.history valuesForSeries:(3 + k) * self.numberOfCPUs];
+            [extraGroups addObject:[[XRGDataSetGroup alloc] initWithExternalStorage:storage numberOfSeries:self.numberOfCPUs numValues:numValues currentIndex:currentIndex]];
+        }
+        _extraGroups = extraGroups;
+        [self nameGroups];
+        [self updateHistory];
+    }
+}
+
+- (void)setHistoryInterval:(NSTimeInterval)historyInterval {
+    _historyInterval = historyInterval;
+    self.history.graphInterval = historyInterval;
+}
+
+- (void)setHistorySamplesPerMinute:(NSUInteger)samplesPerMinute {
+    if (samplesPerMinute == _historySamplesPerMinute) return;
+    
+    _historySamplesPerMinute = samplesPerMinute;
+    [self updateHistory];
+}
+
+// Only the averages are graphed over the longer spans, so only they keep the history.
+- (void)updateHistory {
+    NSMutableArray<XRGDataSetGroup *> *groups = [NSMutableArray arrayWithObjects:self.userGroup, self.systemGroup, self.niceGroup, nil];
+    [groups addObjectsFromArray:self.extraGroups];
+    for (XRGDataSetGroup *group in groups) {
+        [group.averageDataSet keepHistoryWithSamplesPerMinute:self.historySamplesPerMinute];
+    }
+}
+
+- (void)nameGroups {
+    self.userGroup.name = @"CPU User";
+    self.systemGroup.name = @"CPU System";
+    self.niceGroup.name = @"CPU Nice";
+    for (NSUInteger k = 0; k < self.extraGroups.count; k++) {
+        self.extraGroups[k].name = XRGCPUStateName(XRGCPUExtraStates[k]);
+    }
+}
+
+- (NSArray<XRGDataSet *> *)userValues {
+    return self.userGroup.dataSets;
+}
+
+- (NSArray<XRGDataSet *> *)systemValues {
+    return self.systemGroup.dataSets;
+}
+
+- (NSArray<XRGDataSet *> *)niceValues {
+    return self.niceGroup.dataSets;
 }
 
 - (void)graphUpdate:(NSTimer *)aTimer {
-    [self calculateCPUUsageForCPUs:&lastSlowCPUInfo count:self.numberOfCPUs];
+    [self applySample:[self collectSample]];
+}
+
+- (void)fastUpdate:(NSTimer *)aTimer {
+    [self applyFastSample:[self collectFastSample]];
+}
+
+- (XRGCPUSample *)collectSample {
+    return [[XRGCPUSample alloc] initWithTicks:[self collectFastSample]
+                                   loadAverage:self.loadAverage ? [self getLoadAverage] : -1
+                                      bootTime:self.uptime ? [self bootTime] : 0];
+}
+
+- (NSData *)collectFastSample {
+#if defined(__linux__)
+    const XRGCPUTicks *ticks = XRGProcStatReaderReadTicks(procStat);
+    if (!ticks) return [NSData data];
+    
+    return [NSData dataWithBytes:ticks length:XRGProcStatReaderCPUCount(procStat) * sizeof(*ticks)];
+#else
+    processor_cpu_load_info_t		newCPUInfo;
+    unsigned int					processor_count;
+    mach_msg_type_number_t			load_count;
+
+    kern_return_t kr = host_processor_info(host,
+                                           PROCESSOR_CPU_LOAD_INFO,
+                                           &processor_count,
+                                           (processor_info_array_t *)&newCPUInfo,
+                                           &load_count);
+    if (kr != KERN_SUCCESS) return [NSData data];
+    
+    // Copied into the shared layout, so everything after collection is the same on every platform.
+    NSMutableData *ticks = [NSMutableData dataWithLength:processor_count * sizeof(XRGCPUTicks)];
+    XRGCPUTicks *cpuTicks = ticks.mutableBytes;
+    for (unsigned int i = 0; i < processor_count; i++) {
+        cpuTicks[i].ticks[XRGCPUTickUser]   = newCPUInfo[i].cpu_ticks[CPU_STATE_USER];
+        cpuTicks[i].ticks[XRGCPUTickSystem] = newCPUInfo[i].cpu_ticks[CPU_STATE_SYSTEM];
+        cpuTicks[i].ticks[XRGCPUTickIdle]   = newCPUInfo[i].cpu_ticks[CPU_STATE_IDLE];
+        cpuTicks[i].ticks[XRGCPUTickNice]   = newCPUInfo[i].cpu_ticks[CPU_STATE_NICE];
+    }
+    
+    vm_deallocate(mach_task_self(),
+                  (vm_address_t)newCPUInfo,
+                  (vm_size_t)(load_count * sizeof(*newCPUInfo)));
+    return ticks;
+#endif
+}
+
+- (void)applySample:(XRGCPUSample *)sample {
+    [self applySample:sample span:1];
+}
+
+- (NSUInteger)dataGeneration {
+    NSUInteger generation = self.userGroup.changeGeneration + self.systemGroup.changeGeneration + self.niceGroup.changeGeneration;
+    for (XRGDataSetGroup *group in self.extraGroups) generation += group.changeGeneration;
+    return generation;
+}
+
+- (NSUInteger)busyLayerCount {
+    // iowait is stacked last, so everything before it is busy.
+    NSUInteger count = 3;
+    for (NSUInteger k = 0; k < self.extraGroups.count; k++) {
+        if (XRGCPUExtraStates[k] != XRGCPUTickIOWait) count++;
+    }
+    return count;
+}
+
+- (CGFloat)currentUsage {
+    CGFloat usage = self.userGroup.averageDataSet.currentValue + self.systemGroup.averageDataSet.currentValue + self.niceGroup.averageDataSet.currentValue;
+    for (NSUInteger k = 0; k < self.extraGroups.count; k++) {
+        if (XRGCPUExtraStates[k] != XRGCPUTickIOWait) usage += self.extraGroups[k].averageDataSet.currentValue;
+    }
+    return usage;
+}
+
+- (CGFloat)averageUsage {
+    CGFloat usage = self.userGroup.averageDataSet.average + self.systemGroup.averageDataSet.average + self.niceGroup.averageDataSet.average;
+    for (NSUInteger k = 0; k < self.extraGroups.count; k++) {
+        if (XRGCPUExtraStates[k] != XRGCPUTickIOWait) usage += self.extraGroups[k].averageDataSet.average;
+    }
+    return usage;
+}
+
+- (void)applySample:(XRGCPUSample *)sample span:(NSUInteger)span {
+    NSUInteger dataGeneration = [self dataGeneration];
+    NSInteger lastUptimeMinutes = self.uptimeMinutes;
+    CGFloat lastLoadAverage = self.currentLoadAverage;
+    
+    [self calculateCPUUsageFromTicks:sample.ticks lastCPUInfo:&lastSlowCPUInfo count:self.numberOfCPUs];
 	
-    for (NSInteger i = 0; i < self.numberOfCPUs; i++) {
-        [self.userValues[i]   setNextValue:immediateUser[i]];
-        [self.systemValues[i] setNextValue:immediateSystem[i]];
-        [self.niceValues[i]   setNextValue:immediateNice[i]];
+    for (NSUInteger i = 0; i < MAX(span, 1); i++) {
+        [self.userGroup setNextValues:immediateUser];
+        [self.systemGroup setNextValues:immediateSystem];
+        [self.niceGroup setNextValues:immediateNice];
+        for (NSUInteger k = 0; k < self.extraGroups.count; k++) {
+            [self.extraGroups[k] setNextValues:immediateExtra + k * self.numberOfCPUs];
+        }
+        [self.history noteSampleAtIndex:self.userGroup.currentIndex];
     }
+    
+    // Record the combined usage in XRGStatsManager
+    [[XRGStatsManager shared] observeStat:[self currentUsage] forHandle:self.usageStatHandle];
                 
-    if (self.uptime) [self setCurrentUptime];
-    if (self.loadAverage) self.currentLoadAverage = [self getLoadAverage];
+    if (self.uptime) [self setUptimeWithBootTime:sample.bootTime];
+    if (self.loadAverage) self.currentLoadAverage = sample.loadAverage;
+    
+    if ([self dataGeneration] != dataGeneration) _changeGeneration++;
+    // The load average is shown to two places.
+    if (self.uptimeMinutes != lastUptimeMinutes || lround(self.currentLoadAverage * 100) != lround(lastLoadAverage * 100)) _textGeneration++;
 }
 
-- (void)fastUpdate:(NSTimer *)aTimer {
-    [self calculateCPUUsageForCPUs:&lastFastCPUInfo count:self.numberOfCPUs];
+- (void)applyFastSample:(NSData *)ticks {
+    [self calculateCPUUsageFromTicks:ticks lastCPUInfo:&lastFastCPUInfo count:self.numberOfCPUs];
 
+    BOOL changed = NO;
     for (NSInteger i = 0; i < self.numberOfCPUs; i++) {
-		CGFloat difference = _fastValues[i] - (immediateUser[i] + immediateSystem[i] + immediateNice[i]);
+        NSInteger lastValue = _fastValues[i];
+        
+		CGFloat difference = _fastValues[i] - immediateTotal[i];
 		
 		if (difference < 5. && difference > -5.) {
-			_fastValues[i] = immediateUser[i] + immediateSystem[i] + immediateNice[i];
+			_fastValues[i] = immediateTotal[i];
 		}
 		else {
-			_fastValues[i] = _fastValues[i] + (0.25 * (immediateUser[i] + immediateSystem[i] + immediateNice[i] - _fastValues[i]));
+			_fastValues[i] = _fastValues[i] + (0.25 * (immediateTotal[i] - _fastValues[i]));
 		}
 		
 		if (_fastValues[i] < 0 || _fastValues[i] > 100) {
-			CGFloat sum = immediateUser[i] + immediateSystem[i] + immediateNice[i];
+			CGFloat sum = immediateTotal[i];
 			
 			if (sum < 0) sum = 0;
 			if (sum > 100) sum = 100;
 			
 			_fastValues[i] = sum;
 		}
+        
+        changed |= _fastValues[i] != lastValue;
     }
+    if (changed) _fastGeneration++;
 }
 
-- (NSInteger)calculateCPUUsageForCPUs:(processor_cpu_load_info_t *)lastCPUInfo count:(NSInteger)count {
-    processor_cpu_load_info_t		newCPUInfo;
-    kern_return_t					kr;
-    unsigned int					processor_count;
-    mach_msg_type_number_t			load_count;
-    NSInteger						totalCPUTicks;
+- (NSInteger)calculateCPUUsageForCPUs:(XRGCPUTicks **)lastCPUInfo count:(NSInteger)count {
+    return [self calculateCPUUsageFromTicks:[self collectFastSample] lastCPUInfo:lastCPUInfo count:count];
+}
 
-    kr = host_processor_info(host, 
-                             PROCESSOR_CPU_LOAD_INFO, 
-                             &processor_count, 
-                             (processor_info_array_t *)&newCPUInfo, 
-                             &load_count);
-    if(kr != KERN_SUCCESS) {
-        return 0;
-    }
-    else {
-        for (NSInteger i = 0; i < processor_count; i++) {
-            if (i >= count) break;
+- (NSInteger)calculateCPUUsageFromTicks:(NSData *)ticks lastCPUInfo:(XRGCPUTicks **)lastCPUInfo count:(NSInteger)count {
+    const XRGCPUTicks *newCPUInfo = ticks.bytes;
+    NSInteger processor_count = (NSInteger)(ticks.length / sizeof(*newCPUInfo));
+    double percentages[XRGCPUTickCount];
+    double layers[3 + XRG_CPU_EXTRA_STATE_COUNT];
+    
+    for (NSInteger i = 0; i < processor_count; i++) {
+        if (i >= count) break;
         
-            totalCPUTicks = 0;
-            
-            for (NSInteger j = 0; j < CPU_STATE_MAX; j++) {
-                totalCPUTicks += newCPUInfo[i].cpu_ticks[j] - (*lastCPUInfo)[i].cpu_ticks[j];
-            }
-            
-            immediateUser[i]   = (totalCPUTicks == 0) ? 0 : (CGFloat)(newCPUInfo[i].cpu_ticks[CPU_STATE_USER] - (*lastCPUInfo)[i].cpu_ticks[CPU_STATE_USER]) / (CGFloat)totalCPUTicks * 100.;
-            immediateSystem[i] = (totalCPUTicks == 0) ? 0 : (CGFloat)(newCPUInfo[i].cpu_ticks[CPU_STATE_SYSTEM] - (*lastCPUInfo)[i].cpu_ticks[CPU_STATE_SYSTEM]) / (CGFloat)totalCPUTicks * 100.;
-            immediateNice[i]   = (totalCPUTicks == 0) ? 0 : (CGFloat)(newCPUInfo[i].cpu_ticks[CPU_STATE_NICE] - (*lastCPUInfo)[i].cpu_ticks[CPU_STATE_NICE]) / (CGFloat)totalCPUTicks * 100.;
-            
-            immediateTotal[i] = immediateUser[i] + immediateSystem[i] + immediateNice[i];
-
-            for(NSInteger j = 0; j < CPU_STATE_MAX; j++)
-                (*lastCPUInfo)[i].cpu_ticks[j] = newCPUInfo[i].cpu_ticks[j];
-        }
+        XRGCPUTicksPercentages(&newCPUInfo[i], &(*lastCPUInfo)[i], XRG_CPU_TICKS_WRAP_32, percentages);
         
-        vm_deallocate(mach_task_self(), 
-                      (vm_address_t)newCPUInfo, 
-                      (vm_size_t)(load_count * sizeof(*newCPUInfo)));
-                      
-        return (NSInteger)processor_count;
+        // On Mach there are no extra states, so user comes through whole.
+        immediateTotal[i]  = XRGCPUTicksLayers(percentages, XRGCPUExtraStates, XRG_CPU_EXTRA_STATE_COUNT, layers);
+        immediateUser[i]   = layers[0];
+        immediateSystem[i] = layers[1];
+        immediateNice[i]   = layers[2];
+        
+        for (NSUInteger k = 0; k < XRG_CPU_EXTRA_STATE_COUNT; k++) {
+            immediateExtra[k * self.numberOfCPUs + i] = layers[3 + k];
+        }
+
+        (*lastCPUInfo)[i] = newCPUInfo[i];
     }
+    
+    return processor_count;
 }
 
 - (NSInteger)getNumCPUs {
+#if defined(__linux__)
+    return (NSInteger)XRGProcStatReaderCPUCount(procStat);
+#else
     processor_cpu_load_info_t		newCPUInfo;
     kern_return_t			kr;
     unsigned int			processor_count;
@@ -229,9 +473,13 @@
                       
         return (NSInteger)processor_count;
     }
+#endif
 }
 
 - (CGFloat)getLoadAverage {
+#if defined(__linux__)
+    return XRGProcStatReaderLoadAverage(procStat);
+#else
     host_load_info_data_t loadData;
     mach_msg_type_number_t count = HOST_LOAD_INFO_COUNT;
     
@@ -239,33 +487,44 @@
         return (CGFloat)loadData.avenrun[0] / (CGFloat)LOAD_SCALE;
     else 
         return -1;
+#endif
 }
 
 - (void)reset {
-    for (XRGDataSet *set in self.userValues) {
-        [set reset];
-    }
-
-    for (XRGDataSet *set in self.systemValues) {
-        [set reset];
-    }
-
-    for (XRGDataSet *set in self.niceValues) {
-        [set reset];
-    }
+    _changeGeneration++;
+    [self.userGroup reset];
+    [self.systemGroup reset];
+    [self.niceGroup reset];
+    for (XRGDataSetGroup *group in self.extraGroups) [group reset];
 }
 
 - (void)setCurrentUptime {
-    time_t         currentTime;
-    time_t         uptimeInSeconds = 0;
+    [self setUptimeWithBootTime:[self bootTime]];
+}
+
+- (time_t)bootTime {
+#if defined(__linux__)
+    double uptime = XRGProcStatReaderUptime(procStat);
+    if (uptime < 0) return 0;
+    return time(NULL) - (time_t)uptime;
+#else
     struct timeval bootTime;
     size_t         size = sizeof(bootTime);
     int mib[2] = { CTL_KERN, KERN_BOOTTIME };    
 
+    if (sysctl(mib, 2, &bootTime, &size, NULL, 0) == -1) return 0;
+    return bootTime.tv_sec;
+#endif
+}
+
+- (void)setUptimeWithBootTime:(time_t)bootTime {
+    time_t         currentTime;
+    time_t         uptimeInSeconds = 0;
+
     (void)time(&currentTime);
         
-    if ((sysctl(mib, 2, &bootTime, &size, NULL, 0) != -1) && (bootTime.tv_sec != 0)) {
-        uptimeInSeconds = currentTime - bootTime.tv_sec;
+    if (bootTime != 0) {
+        uptimeInSeconds = currentTime - bootTime;
 
         self.uptimeDays = uptimeInSeconds / (60 * 60 * 24);
         uptimeInSeconds %= (60 * 60 * 24);
@@ -287,13 +546,14 @@
 }
 
 // Returns an NSArray of XRGDataSet objects.
-// The first XRGDataSet is system cpu usage, the second is user cpu usage, and the third is nice cpu usage.
+// The first XRGDataSet is system cpu usage, the second is user cpu usage, and the third is nice cpu usage.  The rest
+// are the extra states, in the order of extraGroups.
 - (NSArray *)dataForCPU:(NSInteger)cpuNumber {
 	if ((cpuNumber >= self.systemValues.count) || (cpuNumber >= self.userValues.count) || (cpuNumber >= self.niceValues.count)) {
 		return nil;
 	}
 	
-    NSMutableArray *a = [NSMutableArray arrayWithCapacity:3];
+    NSMutableArray *a = [NSMutableArray arrayWithCapacity:3 + self.extraGroups.count];
     
 	XRGDataSet *sys = self.systemValues[cpuNumber];
 	if (sys) [a addObject:sys];
@@ -307,30 +567,22 @@
 	if (nice) [a addObject:nice];
 	else return nil;
     
+    for (XRGDataSetGroup *group in self.extraGroups) {
+        if (cpuNumber >= group.dataSets.count) return nil;
+        [a addObject:group.dataSets[cpuNumber]];
+    }
+    
     return a;
 }
 
-// Return an array of 3 XRGDataSets with combined data for all the CPUs.
+// Return an array of XRGDataSets with combined data for all the CPUs, in the same order as dataForCPU:.
+// The groups keep these averages up to date as samples are added, so there's nothing to compute here.
 - (NSArray *)combinedData {
 	if (!self.systemValues.count || !self.userValues.count || !self.niceValues.count) return nil;
 	
-	XRGDataSet *tmpSystem = [[XRGDataSet alloc] initWithContentsOfOtherDataSet:self.systemValues[0]];
-	XRGDataSet *tmpUser = [[XRGDataSet alloc] initWithContentsOfOtherDataSet:self.userValues[0]];
-	XRGDataSet *tmpNice = [[XRGDataSet alloc] initWithContentsOfOtherDataSet:self.niceValues[0]];
-	
-	for (NSInteger i = 1; i < self.numberOfCPUs; i++) {
-		[tmpSystem addOtherDataSetValues:self.systemValues[i]];
-		[tmpUser addOtherDataSetValues:self.userValues[i]];
-		[tmpNice addOtherDataSetValues:self.niceValues[i]];
-	}
-	
-	[tmpSystem divideAllValuesBy:self.numberOfCPUs];
-	[tmpUser divideAllValuesBy:self.numberOfCPUs];
-	[tmpNice divideAllValuesBy:self.numberOfCPUs];
-	
-	if (tmpSystem == nil || tmpUser == nil || tmpNice == nil) return nil;
-	
-	NSArray *a = @[tmpSystem, tmpUser, tmpNice];
+    NSMutableArray *a = [NSMutableArray arrayWithObjects:self.systemGroup.averageDataSet, self.userGroup.averageDataSet, self.niceGroup.averageDataSet, nil];
+    for (XRGDataSetGroup *group in self.extraGroups) [a addObject:group.averageDataSet];
+    
 	return a;
 }
 
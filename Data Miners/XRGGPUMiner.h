@@ -26,6 +26,7 @@
 
 #import <Foundation/Foundation.h>
 #import "XRGDataSet.h"
+#import "XRGDataSetGroup.h"
 
 typedef NS_ENUM(UInt32, XRGPCIVendor) {
 	XRGPCIVendorIntel = 0x8086,
@@ -52,8 +53,19 @@ typedef NS_ENUM(UInt32, XRGPCIVendor) {
 @property (readonly) NSArray *utilizationDataSets;
 /// Values are NSString objects representing vendor names.
 @property (readonly) NSArray *vendorNames;
+/// Increases whenever a snapshot changes anything the GPU view shows, so an unchanged tick can skip the redraw.
+@property (readonly) NSUInteger changeGeneration;
+
+@class XRGGraphicsCard;
 
 - (void)getLatestGraphicsInfo;
+
+// getLatestGraphicsInfo split in two: collectGraphicsCards walks the IOKit registry, so it runs on the sampler queue;
+// applyGraphicsCards: updates the data sets on the main thread.
+- (NSArray<XRGGraphicsCard *> *)collectGraphicsCards;
+- (void)applyGraphicsCards:(NSArray<XRGGraphicsCard *> *)graphicsCards;
+/// span is how many graph intervals the snapshot covers; it's written to that many slots.
+- (void)applyGraphicsCards:(NSArray<XRGGraphicsCard *> *)graphicsCards span:(NSUInteger)span;
 - (void)setDataSize:(NSInteger)newNumSamples;
 
 @end
@@ -27,17 +27,33 @@
 #import "XRGGPUMiner.h"
 #import <IOKit/graphics/IOGraphicsLib.h>
 
+@interface XRGGPUMiner ()
+
+// One series per GPU for each of the values we track.
+@property XRGDataSetGroup *totalVRAMGroup;
+@property XRGDataSetGroup *freeVRAMGroup;
+@property XRGDataSetGroup *cpuWaitGroup;
+@property XRGDataSetGroup *utilizationGroup;
+
+@end
+
 @implementation XRGGPUMiner
 
 - (instancetype)init {
 	self = [super init];
 	if (self) {
-		_totalVRAMDataSets = nil;
-		_freeVRAMDataSets = nil;
-		_cpuWaitDataSets = nil;
 		self.numSamples = 0;
 		self.numberOfGPUs = 0;
 		
+        self.totalVRAMGroup = [[XRGDataSetGroup alloc] initWithNumberOfSeries:0 numValues:0];
+        self.freeVRAMGroup = [[XRGDataSetGroup alloc] initWithNumberOfSeries:0 numValues:0];
+        self.cpuWaitGroup = [[XRGDataSetGroup alloc] initWithNumberOfSeries:0 numValues:0];
+        self.utilizationGroup = [[XRGDataSetGroup alloc] initWithNumberOfSeries:0 numValues:0];
+        self.totalVRAMGroup.name = @"GPU Total VRAM";
+        self.freeVRAMGroup.name = @"GPU Free VRAM";
+        self.cpuWaitGroup.name = @"GPU CPU Wait";
+        self.utilizationGroup.name = @"GPU Utilization";
+        
 		[self setNumberOfGPUs:1];
 		[self getLatestGraphicsInfo];
 	}
@@ -45,95 +61,62 @@
 	return self;
 }
 
+- (NSArray *)totalVRAMDataSets {
+    return self.totalVRAMGroup.dataSets;
+}
+
+- (NSArray *)freeVRAMDataSets {
+    return self.freeVRAMGroup.dataSets;
+}
+
+- (NSArray *)cpuWaitDataSets {
+    return self.cpuWaitGroup.dataSets;
+}
+
+- (NSArray *)utilizationDataSets {
+    return self.utilizationGroup.dataSets;
+}
 
 - (void)setDataSize:(NSInteger)newNumSamples {
 	if (newNumSamples < 0) return;
 	
-	for (XRGDataSet *values in self.totalVRAMDataSets) {
-		[values resize:newNumSamples];
-	}
-	for (XRGDataSet *values in self.freeVRAMDataSets) {
-		[values resize:newNumSamples];
-	}
-	for (XRGDataSet *values in self.cpuWaitDataSets) {
-		[values resize:newNumSamples];
-	}
-    for (XRGDataSet *values in self.utilizationDataSets) {
-        [values resize:newNumSamples];
-    }
+    [self.totalVRAMGroup resize:newNumSamples];
+    [self.freeVRAMGroup resize:newNumSamples];
+    [self.cpuWaitGroup resize:newNumSamples];
+    [self.utilizationGroup resize:newNumSamples];
 	
 	self.numSamples = newNumSamples;
+    _changeGeneration++;
 }
 
 - (void)setNumberOfGPUs:(NSInteger)newNumGPUs {
-	if ((self.totalVRAMDataSets.count == newNumGPUs) &&
-		(self.freeVRAMDataSets.count == newNumGPUs) &&
-		(self.cpuWaitDataSets.count == newNumGPUs) &&
-        (self.utilizationDataSets.count == newNumGPUs))
+	if ((self.totalVRAMGroup.numSeries == newNumGPUs) &&
+		(self.freeVRAMGroup.numSeries == newNumGPUs) &&
+		(self.cpuWaitGroup.numSeries == newNumGPUs) &&
+        (self.utilizationGroup.numSeries == newNumGPUs))
 	{
 		return;
 	}
 	
-	NSMutableArray *newTotal = [NSMutableArray array];
-	NSMutableArray *newFree = [NSMutableArray array];
-	NSMutableArray *newCPUWait = [NSMutableArray array];
-    NSMutableArray *newUtilization = [NSMutableArray array];
-	
-	if (self.totalVRAMDataSets.count) [newTotal addObjectsFromArray:self.totalVRAMDataSets];
-	if (self.freeVRAMDataSets.count) [newFree addObjectsFromArray:self.freeVRAMDataSets];
-	if (self.cpuWaitDataSets.count) [newCPUWait addObjectsFromArray:self.cpuWaitDataSets];
-    if (self.utilizationDataSets.count) [newUtilization addObjectsFromArray:self.utilizationDataSets];
-	
 	// Make sure we want at least 1 sample.
 	self.numSamples = MAX(1, self.numSamples);
+    [self setDataSize:self.numSamples];
 	
-	// Add new XRGDataSets if needed.
-	for (NSInteger i = 0; i < newNumGPUs; i++) {
-		if (newTotal.count <= i) {
-			XRGDataSet *s = [[XRGDataSet alloc] init];
-			[s resize:self.numSamples];
-			[newTotal addObject:s];
-		}
-		if (newFree.count <= i) {
-			XRGDataSet *s = [[XRGDataSet alloc] init];
-			[s resize:self.numSamples];
-			[newFree addObject:s];
-		}
-		if (newCPUWait.count <= i) {
-			XRGDataSet *s = [[XRGDataSet alloc] init];
-			[s resize:self.numSamples];
-			[newCPUWait addObject:s];
-		}
-        if (newUtilization.count <= i) {
-            XRGDataSet *s = [[XRGDataSet alloc] init];
-            [s resize:self.numSamples];
-            [newUtilization addObject:s];
-        }
-	}
-
-	// Remove extra XRGDataSets if needed.
-	if (newTotal.count > newNumGPUs) {
-		newTotal = [NSMutableArray arrayWithArray:[newTotal subarrayWithRange:NSMakeRange(0, newNumGPUs)]];
-	}
-	if (newFree.count > newNumGPUs) {
-		newFree = [NSMutableArray arrayWithArray:[newFree subarrayWithRange:NSMakeRange(0, newNumGPUs)]];
-	}
-	if (newCPUWait.count > newNumGPUs) {
-		newCPUWait = [NSMutableArray arrayWithArray:[newCPUWait subarrayWithRange:NSMakeRange(0, newNumGPUs)]];
-	}
-    if (newUtilization.count > newNumGPUs) {
-        newUtilization = [NSMutableArray arrayWithArray:[newUtilization subarrayWithRange:NSMakeRange(0, newNumGPUs)]];
-    }
-	
-	_totalVRAMDataSets = newTotal;
-	_freeVRAMDataSets = newFree;
-	_cpuWaitDataSets = newCPUWait;
-    _utilizationDataSets = newUtilization;
+	// Existing series keep their history, new ones start empty.
+    [self.totalVRAMGroup setNumberOfSeries:newNumGPUs];
+    [self.freeVRAMGroup setNumberOfSeries:newNumGPUs];
+    [self.cpuWaitGroup setNumberOfSeries:newNumGPUs];
+    [self.utilizationGroup setNumberOfSeries:newNumGPUs];
 	
-	self.numberOfGPUs = newNumGPUs;
+	_numberOfGPUs = newNumGPUs;
+    _changeGeneration++;
 }
 
 - (void)getLatestGraphicsInfo {
+    [self applyGraphicsCards:[self collectGraphicsCards]];
+}
+
+- (NSArray<XRGGraphicsCard *> *)collectGraphicsCards {
 	// Create an iterator
 	io_iterator_t iterator;
 	
@@ -249,19 +232,46 @@
         }
     }
     
+    return graphicsCards;
+}
+
+- (void)applyGraphicsCards:(NSArray<XRGGraphicsCard *> *)graphicsCards {
+    [self applyGraphicsCards:graphicsCards span:1];
+}
+
+- (NSUInteger)dataGeneration {
+    return self.totalVRAMGroup.changeGeneration + self.freeVRAMGroup.changeGeneration + self.cpuWaitGroup.changeGeneration + self.utilizationGroup.changeGeneration;
+}
+
+- (void)applyGraphicsCards:(NSArray<XRGGraphicsCard *> *)graphicsCards span:(NSUInteger)span {
+    NSUInteger dataGeneration = [self dataGeneration];
+    
 	// Now that we've parsed all the data, set the next values for our data sets.
 	NSMutableArray *updatedVendors = [NSMutableArray array];
 	[self setNumberOfGPUs:graphicsCards.count];
-	for (NSInteger i = 0; i < graphicsCards.count; i++) {
-		[self.totalVRAMDataSets[i] setNextValue:[graphicsCards[i] totalVRAM]];
-		[self.freeVRAMDataSets[i] setNextValue:[graphicsCards[i] freeVRAM]];
-		[self.cpuWaitDataSets[i] setNextValue:[graphicsCards[i] cpuWait]];
-        [self.utilizationDataSets[i] setNextValue:[graphicsCards[i] deviceUtilization]];
+    
+    NSInteger numCards = graphicsCards.count;
+    CGFloat totalVRAM[MAX(numCards, 1)];
+    CGFloat freeVRAM[MAX(numCards, 1)];
+    CGFloat cpuWait[MAX(numCards, 1)];
+    CGFloat utilization[MAX(numCards, 1)];
+	for (NSInteger i = 0; i < numCards; i++) {
+		totalVRAM[i] = [graphicsCards[i] totalVRAM];
+		freeVRAM[i] = [graphicsCards[i] freeVRAM];
+		cpuWait[i] = [graphicsCards[i] cpuWait];
+        utilization[i] = [graphicsCards[i] deviceUtilization];
 		
 		NSString *vendorName = [graphicsCards[i] vendorString];
 		if (!vendorName) vendorName = @"";
 		[updatedVendors addObject:vendorName];
 	}
+    for (NSUInteger i = 0; i < MAX(span, 1); i++) {
+        [self.totalVRAMGroup setNextValues:totalVRAM];
+        [self.freeVRAMGroup setNextValues:freeVRAM];
+        [self.cpuWaitGroup setNextValues:cpuWait];
+        [self.utilizationGroup setNextValues:utilization];
+    }
+    if ([self dataGeneration] != dataGeneration || ![updatedVendors isEqualToArray:_vendorNames]) _changeGeneration++;
 	_vendorNames = updatedVendors;
 }
 
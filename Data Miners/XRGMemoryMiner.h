@@ -27,8 +27,21 @@
 #import <Foundation/Foundation.h>
 #import <mach/host_info.h>
 #import <mach/mach_host.h>
+#include <sys/sysctl.h>
 #import "XRGDataSet.h"
 
+/// What one tick read from the system.  Collected on the sampler queue and never changed afterwards.
+@interface XRGMemorySample : NSObject
+
+@property (readonly) BOOL hasStatistics;
+@property (readonly) vm_statistics_data_t statistics;
+
+@property (readonly) BOOL hasSwapUsage;
+@property (readonly) struct xsw_usage swapUsage;
+
+@end
+
+
 @interface XRGMemoryMiner : NSObject {
 @private
     int							numSamples;
@@ -47,7 +60,21 @@
 @property UInt64 usedSwap;
 @property UInt64 totalSwap;
 
+/// The graph refresh the history file is recorded at, so history from a different refresh is discarded (see
+/// -[XRGHistoryStore graphInterval]).  Set it before the first setDataSize: and again whenever the refresh changes.
+@property (nonatomic) NSTimeInterval historyInterval;
+
+/// Increases whenever a sample changes anything the memory view shows, so an unchanged tick can skip the redraw.
+@property (readonly) NSUInteger changeGeneration;
+
 - (void)getLatestMemoryInfo;
+
+// getLatestMemoryInfo split in two: collectSample only makes system calls, so it can run on the sampler queue;
+// applySample: updates the data sets on the main thread.
+- (XRGMemorySample *)collectSample;
+- (void)applySample:(XRGMemorySample *)sample;
+/// span is how many graph intervals the sample covers; the paging counts are spread evenly over that many slots.
+- (void)applySample:(XRGMemorySample *)sample span:(NSUInteger)span;
 - (void)setDataSize:(int)newNumSamples;
 - (void)reset;
 
@@ -25,7 +25,27 @@
 //
 
 #import "XRGMemoryMiner.h"
-#include <sys/sysctl.h>
+#import "XRGHistoryStore.h"
+#import "XRGDataSetArena.h"
+
+@interface XRGMemorySample ()
+@property BOOL hasStatistics;
+@property vm_statistics_data_t statistics;
+@property BOOL hasSwapUsage;
+@property struct xsw_usage swapUsage;
+@end
+
+@implementation XRGMemorySample
+@end
+
+
+@interface XRGMemoryMiner ()
+// Fault, page in and page out rings, in that order.  nil if the history file couldn't be opened.
+@property XRGHistoryStore *history;
+@property BOOL triedHistory;
+// Backs the data sets when there's no history file.
+@property XRGDataSetArena *arena;
+@end
 
 @implementation XRGMemoryMiner
 
@@ -52,40 +72,89 @@
     return self;
 }
 
+- (void)setHistoryInterval:(NSTimeInterval)historyInterval {
+    _historyInterval = historyInterval;
+    self.history.graphInterval = historyInterval;
+}
+
 - (void)setDataSize:(int)newNumSamples {
     if (newNumSamples < 0) return;
     
-    if(values1 && values2 && values3) {
-        [values1 resize:(size_t)newNumSamples];
-        [values2 resize:(size_t)newNumSamples];
-        [values3 resize:(size_t)newNumSamples];
+    // Open the history once, at the first real graph size, so an empty layout pass can't trim it.
+    if (!self.history && !self.triedHistory && newNumSamples > 0) {
+        self.triedHistory = YES;
+        self.history = [[XRGHistoryStore alloc] initWithName:@"Memory" numberOfSeries:3 numValues:(size_t)newNumSamples graphInterval:self.historyInterval];
     }
-    else {
+    
+    if (!values1 || !values2 || !values3) {
         values1 = [[XRGDataSet alloc] init];
         values2 = [[XRGDataSet alloc] init];
         values3 = [[XRGDataSet alloc] init];
+    }
+    
+    if (self.history) {
+        [self.history resize:(size_t)newNumSamples];
+        [values1 setExternalValues:[self.history valuesForSeries:0] count:self.history.numValues currentIndex:self.history.currentIndex];
+        [values2 setExternalValues:[self.history valuesForSeries:1] count:self.history.numValues currentIndex:self.history.currentIndex];
+        [values3 setExternalValues:[self.history valuesForSeries:2] count:self.history.numValues currentIndex:self.history.currentIndex];
+    }
+    else {
+        if (!self.arena) self.arena = [[XRGDataSetArena alloc] initWithName:@"Memory" numberOfSeries:3 numValues:0];
         
-        [values1 resize:(size_t)newNumSamples];
-        [values2 resize:(size_t)newNumSamples];
-        [values3 resize:(size_t)newNumSamples];
+        NSInteger currentIndex = [self.arena resize:(size_t)newNumSamples currentIndex:values3.currentIndex];
+        [self.arena attachDataSets:@[values1, values2, values3] currentIndex:currentIndex];
     }
             
     numSamples  = newNumSamples;
+    _changeGeneration++;
 }
 
 - (void)reset {
+    _changeGeneration++;
     [values1 reset];
     [values2 reset];
     [values3 reset];
 }
 
 - (void)getLatestMemoryInfo {
-    kern_return_t kr;
+    [self applySample:[self collectSample]];
+}
+
+- (XRGMemorySample *)collectSample {
+    XRGMemorySample *sample = [[XRGMemorySample alloc] init];
+    
     vm_statistics_data_t stats;
     unsigned int numBytes = HOST_VM_INFO_COUNT;
+    if (host_statistics(host, HOST_VM_INFO, (host_info_t)&stats, &numBytes) == KERN_SUCCESS) {
+        sample.statistics = stats;
+        sample.hasStatistics = YES;
+    }
     
-    kr = host_statistics(host, HOST_VM_INFO, (host_info_t)&stats, &numBytes);
-    if (kr != KERN_SUCCESS) {
+	// Swap space monitoring.
+	int vmmib[2] = { CTL_VM, VM_SWAPUSAGE };
+    struct xsw_usage swapInfo;
+    size_t swapLength = sizeof(swapInfo);
+    if (sysctl(vmmib, 2, &swapInfo, &swapLength, NULL, 0) >= 0) {
+        sample.swapUsage = swapInfo;
+        sample.hasSwapUsage = YES;
+    }
+    
+    return sample;
+}
+
+- (void)applySample:(XRGMemorySample *)sample {
+    [self applySample:sample span:1];
+}
+
+- (void)applySample:(XRGMemorySample *)sample span:(NSUInteger)span {
+    vm_statistics_data_t stats = sample.statistics;
+    vm_statistics_data_t previousStats = lastStats;
+    vm_statistics_data_t previousDiffs = currentDiffs;
+    UInt64 previousUsedSwap = self.usedSwap;
+    UInt64 previousTotalSwap = self.totalSwap;
+    NSUInteger dataGeneration = values1.changeGeneration + values2.changeGeneration + values3.changeGeneration;
+    
+    if (!sample.hasStatistics) {
         return;
     }
     else {
@@ -108,19 +177,26 @@
         lastStats.hits               = stats.hits;
     }
 
-    if (values1) [values1 setNextValue:currentDiffs.faults];
-    if (values2) [values2 setNextValue:currentDiffs.pageins];
-    if (values3) [values3 setNextValue:currentDiffs.pageouts];
+    span = MAX(span, 1);
+    for (NSUInteger i = 0; i < span; i++) {
+        if (values1) [values1 setNextValue:(CGFloat)currentDiffs.faults / span];
+        if (values2) [values2 setNextValue:(CGFloat)currentDiffs.pageins / span];
+        if (values3) [values3 setNextValue:(CGFloat)currentDiffs.pageouts / span];
+        [self.history noteSampleAtIndex:values3.currentIndex];
+    }
 	
-	// Swap space monitoring.
-	int vmmib[2] = { CTL_VM, VM_SWAPUSAGE };
-    struct xsw_usage swapInfo;
-    size_t swapLength = sizeof(swapInfo);
-    if (sysctl(vmmib, 2, &swapInfo, &swapLength, NULL, 0) >= 0) {
-		self.usedSwap = swapInfo.xsu_used;
-		self.totalSwap = swapInfo.xsu_total;
+    if (sample.hasSwapUsage) {
+		self.usedSwap = sample.swapUsage.xsu_used;
+		self.totalSwap = sample.swapUsage.xsu_total;
 //		NSLog(@"Used: %d (%3.2fM)    Total: %d (%3.2fM)", usedSwap, (float)usedSwap / 1024. / 1024., totalSwap, (float)totalSwap / 1024. / 1024.);
     }
+    
+    if (values1.changeGeneration + values2.changeGeneration + values3.changeGeneration != dataGeneration ||
+        memcmp(&previousStats, &lastStats, sizeof(lastStats)) != 0 ||
+        memcmp(&previousDiffs, &currentDiffs, sizeof(currentDiffs)) != 0 ||
+        self.usedSwap != previousUsedSwap || self.totalSwap != previousTotalSwap) {
+        _changeGeneration++;
+    }
 }
 
 // actually kilobytes, not bytes
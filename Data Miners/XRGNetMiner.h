@@ -28,6 +28,18 @@
 #import "definitions.h"
 #import "XRGDataSet.h"
 
+/// What one tick read from the system.  Collected on the sampler queue and never changed afterwards.
+@interface XRGNetSample : NSObject
+
+/// The NET_RT_IFLIST routing messages, as returned by sysctl.  Empty if the sysctl failed.
+@property (readonly) NSData *interfaceList;
+@property (readonly) UInt64 pppInBytes;
+@property (readonly) UInt64 pppOutBytes;
+@property (readonly) NSDate *date;
+
+@end
+
+
 @interface XRGNetMiner : NSObject {
     @private
     io_stats                i_net, o_net;
@@ -35,8 +47,6 @@
     NSInteger               sendBytes;
     NSInteger               recvBytes;
     int                     mib[6];
-    char                    *buf;
-    size_t                  alloc;
     
     BOOL                    firstTimeStats;
     
@@ -48,6 +58,15 @@
 
 @property NSString *monitorNetworkInterface;
 
+/// If set before the first setDataSize:, the graph history is kept in the XRGHistoryStore file with this name so it survives a relaunch.
+@property (copy) NSString *historyName;
+/// The graph refresh the history file is recorded at, so history from a different refresh is discarded (see
+/// -[XRGHistoryStore graphInterval]).  Set it before the first setDataSize: and again whenever the refresh changes.
+@property (nonatomic) NSTimeInterval historyInterval;
+
+/// Samples a minute at the graph refresh, for the history tier and archive the graph spans draw from (see -[XRGDataSet keepHistoryWithSamplesPerMinute:]).  0 for none.
+@property (nonatomic) NSUInteger historySamplesPerMinute;
+
 @property (readonly) NSInteger numInterfaces;
 @property (readonly) network_interface_stats *interfaceStats;
 
@@ -55,7 +74,19 @@
 @property (readonly) XRGDataSet *txValues;
 @property (readonly) XRGDataSet *totalValues;          // rxValues + txValues
 
+// Each increases when a sample changes what it covers, so the view can skip or narrow its redraw: the graphed rates,
+// or only the byte totals.
+@property (readonly) NSUInteger changeGeneration;
+@property (readonly) NSUInteger textGeneration;
+
 - (void)getLatestNetInfo;
+
+// getLatestNetInfo split in two: collectSample only makes system calls, so it can run on the sampler queue;
+// applySample: updates the interface totals and data sets on the main thread.
+- (XRGNetSample *)collectSample;
+- (void)applySample:(XRGNetSample *)sample;
+/// span is how many graph intervals the sample covers; the average rate over them is written to that many slots.
+- (void)applySample:(XRGNetSample *)sample span:(NSUInteger)span;
 - (void)setDataSize:(NSInteger)newNumSamples;
 - (CGFloat)maxBandwidth;
 - (CGFloat)currentTX;
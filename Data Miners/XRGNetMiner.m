@@ -25,6 +25,8 @@
 //
 
 #import "XRGNetMiner.h"
+#import "XRGHistoryStore.h"
+#import "XRGDataSetArena.h"
 #import <mach/mach.h>
 #import <mach/mach_error.h>
 #include <sys/types.h>
@@ -43,9 +45,25 @@
 
 int read_ApplePPP_data(io_stats *i_net, io_stats *o_net);
 
+@interface XRGNetSample ()
+@property NSData *interfaceList;
+@property UInt64 pppInBytes;
+@property UInt64 pppOutBytes;
+@property NSDate *date;
+@end
+
+@implementation XRGNetSample
+@end
+
+
 @interface XRGNetMiner ()
 @property NSInteger numSamples;
 @property NSDate *lastUpdate;
+// RX, TX and total rings, in that order.  nil unless historyName is set and the file could be opened.
+@property XRGHistoryStore *history;
+@property BOOL triedHistory;
+// Backs the data sets when there's no history file.
+@property XRGDataSetArena *arena;
 @end
 
 @implementation XRGNetMiner
@@ -80,7 +98,7 @@ int read_ApplePPP_data(io_stats *i_net, io_stats *o_net);
         self.monitorNetworkInterface = @"All";
         
         // flush out the first spike
-        [self setCurrentBandwidth];
+        [self setCurrentBandwidthWithSample:[self collectSample]];
         [self.rxValues setAllValues:0];
         [self.txValues setAllValues:0];
         [self.totalValues setAllValues:0];
@@ -89,11 +107,46 @@ int read_ApplePPP_data(io_stats *i_net, io_stats *o_net);
 }
 
 - (void)getLatestNetInfo {
+    [self applySample:[self collectSample]];
+}
+
+- (XRGNetSample *)collectSample {
+    XRGNetSample *sample = [[XRGNetSample alloc] init];
+    sample.date = [NSDate date];
+    sample.interfaceList = [NSData data];
+    
+    size_t needed;
+    if (sysctl(mib, 6, NULL, &needed, NULL, 0) >= 0) {
+        NSMutableData *interfaceList = [NSMutableData dataWithLength:needed];
+        if (sysctl(mib, 6, interfaceList.mutableBytes, &needed, NULL, 0) >= 0) {
+            interfaceList.length = needed;
+            sample.interfaceList = interfaceList;
+        }
+    }
+    
+    io_stats pppIn = { 0 }, pppOut = { 0 };
+    read_ApplePPP_data(&pppIn, &pppOut);
+    sample.pppInBytes = pppIn.bytes;
+    sample.pppOutBytes = pppOut.bytes;
+    
+    return sample;
+}
+
+- (void)applySample:(XRGNetSample *)sample {
+    [self applySample:sample span:1];
+}
+
+- (void)applySample:(XRGNetSample *)sample span:(NSUInteger)span {
+    NSUInteger dataGeneration = self.rxValues.changeGeneration + self.txValues.changeGeneration + self.totalValues.changeGeneration;
+    UInt64 lastTotalBytesSinceBoot = self.totalBytesSinceBoot;
+    UInt64 lastTotalBytesSinceLoad = self.totalBytesSinceLoad;
+    
     if (!self.lastUpdate) {
-        self.lastUpdate = [NSDate dateWithTimeIntervalSinceNow:-1];
+        self.lastUpdate = [sample.date dateByAddingTimeInterval:-1];
     }
-    NSTimeInterval interval = -[self.lastUpdate timeIntervalSinceNow];
-    self.lastUpdate = [NSDate date];
+    NSTimeInterval interval = [sample.date timeIntervalSinceDate:self.lastUpdate];
+    if (interval <= 0) interval = 1;
+    self.lastUpdate = sample.date;
     
     if (!firstTimeStats) {
         self.totalBytesSinceLoad += i_net.bytes_delta + o_net.bytes_delta;
@@ -109,15 +162,21 @@ int read_ApplePPP_data(io_stats *i_net, io_stats *o_net);
         firstTimeStats = NO;
     }
     
-    [self setCurrentBandwidth];
+    [self setCurrentBandwidthWithSample:sample];
     
     sendBytes = o_net.bytes_delta / interval;
     recvBytes = i_net.bytes_delta / interval;
     
     NSInteger totalBandwidth = sendBytes + recvBytes;
-    [self.rxValues setNextValue:recvBytes];
-    [self.txValues setNextValue:sendBytes];
-    [self.totalValues setNextValue:totalBandwidth];
+    for (NSUInteger i = 0; i < MAX(span, 1); i++) {
+        [self.rxValues setNextValue:recvBytes];
+        [self.txValues setNextValue:sendBytes];
+        [self.totalValues setNextValue:totalBandwidth];
+        [self.history noteSampleAtIndex:self.totalValues.currentIndex];
+    }
+    
+    if (self.rxValues.changeGeneration + self.txValues.changeGeneration + self.totalValues.changeGeneration != dataGeneration) _changeGeneration++;
+    if (self.totalBytesSinceBoot != lastTotalBytesSinceBoot || self.totalBytesSinceLoad != lastTotalBytesSinceLoad) _textGeneration++;
 }
 
 - (void)setDataSize:(NSInteger)newNumSamples {
@@ -131,13 +190,50 @@ int read_ApplePPP_data(io_stats *i_net, io_stats *o_net);
     }
     if (!self.totalValues) {
         _totalValues = [[XRGDataSet alloc] init];
+        [self updateHistory];
     }
     
-    [self.rxValues resize:newNumSamples];
-    [self.txValues resize:newNumSamples];
-    [self.totalValues resize:newNumSamples];
+    // Open the history once, at the first real graph size, so an empty layout pass can't trim it.
+    if (self.historyName && !self.history && !self.triedHistory && newNumSamples > 0) {
+        self.triedHistory = YES;
+        self.history = [[XRGHistoryStore alloc] initWithName:self.historyName numberOfSeries:3 numValues:(size_t)newNumSamples graphInterval:self.historyInterval];
+    }
+    
+    if (self.history) {
+        [self.history resize:(size_t)newNumSamples];
+        [self.rxValues setExternalValues:[self.history valuesForSeries:0] count:self.history.numValues currentIndex:self.history.currentIndex];
+        [self.txValues setExternalValues:[self.history valuesForSeries:1] count:self.history.numValues currentIndex:self.history.currentIndex];
+        [self.totalValues setExternalValues:[self.history valuesForSeries:2] count:self.history.numValues currentIndex:self.history.currentIndex];
+    }
+    else {
+        if (!self.arena) self.arena = [[XRGDataSetArena alloc] initWithName:@"Network" numberOfSeries:3 numValues:0];
+        
+        NSInteger currentIndex = [self.arena resize:(size_t)newNumSamples currentIndex:self.totalValues.currentIndex];
+        [self.arena attachDataSets:@[self.rxValues, self.txValues, self.totalValues] currentIndex:currentIndex];
+    }
     
     self.numSamples  = newNumSamples;
+    _changeGeneration++;
+}
+
+- (void)setHistoryInterval:(NSTimeInterval)historyInterval {
+    _historyInterval = historyInterval;
+    self.history.graphInterval = historyInterval;
+}
+
+- (void)setHistorySamplesPerMinute:(NSUInteger)samplesPerMinute {
+    if (samplesPerMinute == _historySamplesPerMinute) return;
+    
+    _historySamplesPerMinute = samplesPerMinute;
+    [self updateHistory];
+}
+
+- (void)updateHistory {
+    if (!self.totalValues) return;
+    
+    for (XRGDataSet *dataSet in @[self.rxValues, self.txValues, self.totalValues]) {
+        [dataSet keepHistoryWithSamplesPerMinute:self.historySamplesPerMinute];
+    }
 }
 
 - (CGFloat)maxBandwidth {
@@ -153,20 +249,22 @@ int read_ApplePPP_data(io_stats *i_net, io_stats *o_net);
 }
 
 - (void)reset {
+    _changeGeneration++;
     [self.rxValues reset];
     [self.txValues reset];
     [self.totalValues reset];
 }
 
-- (void)setCurrentBandwidth {
+- (void)setCurrentBandwidthWithSample:(XRGNetSample *)sample {
     i_net.bytes = i_net.bytes_delta = 0;
     o_net.bytes = o_net.bytes_delta = 0;
     
     // First get the interface bandwidth for hardware interfaces.
-    [self getInterfacesBandwidth];
+    [self getInterfacesBandwidthFromList:sample.interfaceList];
     
     // Next get the interface bandwidth for ppp0
-    read_ApplePPP_data(&(_interfaceStats[pppInterfaceNum]).if_in, &(_interfaceStats[pppInterfaceNum]).if_out);
+    _interfaceStats[pppInterfaceNum].if_in.bytes += sample.pppInBytes;
+    _interfaceStats[pppInterfaceNum].if_out.bytes += sample.pppOutBytes;
     
     // Now find out which interface we want to monitor and set the stats.
     char *s = (char *)[self.monitorNetworkInterface cStringUsingEncoding:NSUTF8StringEncoding];
@@ -184,29 +282,15 @@ int read_ApplePPP_data(io_stats *i_net, io_stats *o_net);
 }
 
 // The code in this method is based on code from gkrellm.
-- (void)getInterfacesBandwidth {
+- (void)getInterfacesBandwidthFromList:(NSData *)interfaceList {
     struct if_msghdr	*ifm, *nextifm;
     struct sockaddr_dl	*sdl;
     char		*lim, *next;
-    size_t		needed;
     char		s[32];
     
-    if (sysctl(mib, 6, NULL, &needed, NULL, 0) < 0)
-        return;
-    if (alloc < needed) {
-        if (buf != NULL)
-            free(buf);
-        buf = malloc(needed);
-        if (buf == NULL)
-            return;
-        alloc = needed;
-    }
-    
-    if (sysctl(mib, 6, buf, &needed, NULL, 0) < 0)
-        return;
-    lim = buf + needed;
+    lim = (char *)interfaceList.bytes + interfaceList.length;
     
-    next = buf;
+    next = (char *)interfaceList.bytes;
     while (next < lim) {
         ifm = (struct if_msghdr *)next;
         if (ifm->ifm_type != RTM_IFINFO)
@@ -26,7 +26,9 @@
 
 #import <Foundation/Foundation.h>
 #import "XRGDataSet.h"
+#import "XRGDataSetGroup.h"
 #import "SMCSensors.h"
+#import "XRGStatsManager.h"
 
 @class SMCSensors;
 
@@ -54,6 +56,9 @@
 
 @property BOOL isEnabled;
 
+/// This sensor's stat in XRGStatsManager.
+@property XRGStatHandle statHandle;
+
 - (nonnull instancetype)initWithSensorKey:(nonnull NSString *)key;
 
 - (nonnull NSString *)label;
@@ -61,6 +66,17 @@
 @end
 
 
+#pragma mark - XRGTemperatureSample
+/// What one tick read from the SMC and the Apple silicon sensors.  Collected on the sampler queue and never changed afterwards.
+@interface XRGTemperatureSample: NSObject
+
+@property (nonnull, readonly) NSDictionary *smcTemperatures;
+@property (nonnull, readonly) NSDictionary *smcFans;
+@property (nonnull, readonly) NSDictionary *appleSiliconTemperatures;
+
+@end
+
+
 #pragma mark - XRGTemperatureMiner
 @interface XRGTemperatureMiner : NSObject {
     host_name_port_t			host;
@@ -72,12 +88,22 @@
 
 + (nonnull instancetype)shared;
 
+/// Samples a minute at the graph refresh, for the history tier and archive the graph spans draw from on each sensor's
+/// data set (see -[XRGDataSet keepHistoryWithSamplesPerMinute:]).  0 for none.
+@property (nonatomic) NSUInteger historySamplesPerMinute;
+
 - (void)setDataSize:(NSInteger)newNumSamples;
 - (void)reset;
 - (NSInteger)numberOfCPUs;
 
 - (void)updateCurrentTemperatures:(BOOL)includeUnknown;
 
+// updateCurrentTemperatures: split in two: collectSample: reads the sensors, so it runs on the sampler queue;
+// applySample: updates the sensors and data sets on the main thread.  collectSample: returns nil on the ticks
+// between temperature refreshes.
+- (nullable XRGTemperatureSample *)collectSample:(BOOL)includeUnknown;
+- (void)applySample:(nullable XRGTemperatureSample *)sample;
+
 - (nonnull NSArray<NSString *> *)locationKeysIncludingUnknown:(BOOL)includeUnknown;
 - (nonnull NSArray<NSString *> *)allSensorKeys;
 - (void)regenerateLocationKeyOrder;
@@ -27,6 +27,7 @@
 #import "XRGTemperatureMiner.h"
 #import "XRGAppleSiliconSensorMiner.h"
 #import "XRGStatsManager.h"
+#import "XRGSampler.h"
 #import "definitions.h"
 
 #import <mach/mach_host.h>
@@ -35,16 +36,27 @@
 
 #undef DEBUG
 
+@interface XRGTemperatureSample ()
+@property NSDictionary *smcTemperatures;
+@property NSDictionary *smcFans;
+@property NSDictionary *appleSiliconTemperatures;
+@end
+
+@implementation XRGTemperatureSample
+@end
+
+
 @interface XRGTemperatureMiner ()
 
 @property NSInteger numSamples;                    // for the XRGDataSets, number of samples to record.
-@property NSInteger temperatureCounter;            // count and only grab the temperature every 5 seconds.
+@property NSInteger temperatureCounter;            // count and only grab the temperature every 5 seconds.  Only used by collectSample:.
 
 @property NSMutableDictionary<NSString *,XRGSensorData *> *sensorData;
+@property NSMutableArray<XRGSensorData *> *sensorsInSeriesOrder;    // sensors in the order of their series in sensorGroup.
+@property XRGDataSetGroup *sensorGroup;                             // backs each sensor's dataSet.
 @property NSMutableArray<NSString *> *locationKeysInOrder;        // locations in certain order, returned by locationKeysInOrder, generated by regenerateLocationKeyOrder.
 
-@property NSArray *fanCache;
-@property NSDate *fanCacheCreated;
+@property NSArray *fanCache;                        // rebuilt from each sample, so drawing never reads the SMC.
 @property NSMutableDictionary *fanLocations;
 
 @end
@@ -78,6 +90,9 @@
 		self.fanLocations = [NSMutableDictionary dictionary];
 		self.locationKeysInOrder = [NSMutableArray array];
 		self.sensorData = [NSMutableDictionary dictionary];
+        self.sensorsInSeriesOrder = [NSMutableArray array];
+        self.sensorGroup = [[XRGDataSetGroup alloc] initWithNumberOfSeries:0 numValues:0];
+        self.sensorGroup.name = @"Temperature";
 		self.smcSensors = [[SMCSensors alloc] init];
 	}
 
@@ -85,9 +100,7 @@
 }
 
 - (void)reset {
-    for (XRGSensorData *sensor in [self.sensorData allValues]) {
-        [sensor.dataSet reset];
-    }
+    [self.sensorGroup reset];
 }
 
 - (NSInteger)numberOfCPUs {
@@ -111,36 +124,64 @@
 }
 
 - (void)updateCurrentTemperatures:(BOOL)includeUnknown {
+    [self applySample:[self collectSample:includeUnknown]];
+}
+
+- (XRGTemperatureSample *)collectSample:(BOOL)includeUnknown {
     // Only refresh the temperature every 5 seconds.
     self.temperatureCounter = (self.temperatureCounter + 1) % 5;
     if (self.temperatureCounter != 1) {
-        return;
+        return nil;
     }
     
+    XRGTemperatureSample *sample = [[XRGTemperatureSample alloc] init];
+    sample.smcTemperatures = @{};
+    sample.smcFans = @{};
+    
+	// Gather SMC Data
+	@try {
+        sample.smcTemperatures = [self.smcSensors temperatureValuesIncludingUnknown:includeUnknown] ?: @{};
+        sample.smcFans = [self.smcSensors fanValues] ?: @{};
+	} @catch (NSException *e) {}
+    
+    // Gather Apple Silicon Data
+    sample.appleSiliconTemperatures = [XRGAppleSiliconSensorMiner sensorData] ?: @{};
+    
+    return sample;
+}
+
+- (void)applySample:(XRGTemperatureSample *)sample {
+    if (!sample) return;
+    
 	// Set each temperature sensor enable bit to NO.
     for (XRGSensorData *sensor in self.sensorData.allValues) {
         sensor.isEnabled = NO;
 	}
     	
-	// Gather SMC Data
 	@try {
-        [self trySMCTemperature:includeUnknown];
+        [self setSMCTemperatures:sample.smcTemperatures fans:sample.smcFans];
 	} @catch (NSException *e) {}
     
-    // Gather Apple Silicon Data
-    [self tryAppleSiliconTemperature];
+    [self setAppleSiliconTemperatures:sample.appleSiliconTemperatures];
+    
+    self.fanCache = [self fansFromSMCValues:sample.smcFans];
     
 	// Before returning, go through the values and find the ones that aren't enabled.
-    for (XRGSensorData *sensor in self.sensorData.allValues) {
+    NSInteger numSensors = self.sensorsInSeriesOrder.count;
+    CGFloat values[MAX(numSensors, 1)];
+    for (NSInteger i = 0; i < numSensors; i++) {
+        XRGSensorData *sensor = self.sensorsInSeriesOrder[i];
         if (!sensor.isEnabled) {
-            [sensor.dataSet setNextValue:0];
             sensor.currentValue = 0;
         }
+        values[i] = sensor.currentValue;
     }
+    
+    // Add this round of values to every sensor's data set at once.
+    [self.sensorGroup setNextValues:values];
 }
 
-- (void)trySMCTemperature:(BOOL)includeUnknown {
-	NSDictionary *temperatureValues = [self.smcSensors temperatureValuesIncludingUnknown:includeUnknown];
+- (void)setSMCTemperatures:(NSDictionary *)temperatureValues fans:(NSDictionary *)fanValues {
 
     for (NSString *key in temperatureValues) {
 		id aValue = temperatureValues[key];
@@ -157,7 +198,6 @@
 				  forLocation:key];
 	}
     
-    NSDictionary *fanValues = [self.smcSensors fanValues];
     for (NSString *fanKey in fanValues) {
         id fanDict = fanValues[fanKey];
 
@@ -188,8 +228,7 @@
     }
 }
 
-- (void)tryAppleSiliconTemperature {
-    NSDictionary *appleSiliconSensorData = [XRGAppleSiliconSensorMiner sensorData];
+- (void)setAppleSiliconTemperatures:(NSDictionary *)appleSiliconSensorData {
     
     for (NSString *key in appleSiliconSensorData) {
         id aValue = appleSiliconSensorData[key];
@@ -408,6 +447,7 @@
 	// If we didn't find it, we need to create a new one and insert it into our collection.
 	if (sensor == nil) {
 		sensor = [[XRGSensorData alloc] initWithSensorKey:location];
+        sensor.statHandle = [[XRGStatsManager shared] handleForKey:location inModule:XRGStatsModuleNameTemperature];
         self.sensorData[location] = sensor;
 		needRegen = YES;
 	}
@@ -421,15 +461,16 @@
 	// Set that this sensor is enabled.
     sensor.isEnabled = YES;
 	
-	// Set the next value in the data set.
+	// The data set gets this value when updateCurrentTemperatures: adds the values for every sensor.
 	if (sensor.dataSet == nil) {
-		// we have to create an XRGDataSet for this location.
-		XRGDataSet *newSet = [[XRGDataSet alloc] init];
-		[newSet resize:(size_t)self.numSamples];
-		[newSet setAllValues:value];
-		sensor.dataSet = newSet;
+		// we have to add a series to the group for this location.
+        NSUInteger series = self.sensorsInSeriesOrder.count;
+        [self.sensorGroup setNumberOfSeries:series + 1];
+        [self.sensorGroup setAllValues:value forSeries:series];
+		sensor.dataSet = self.sensorGroup.dataSets[series];
+        [sensor.dataSet keepHistoryWithSamplesPerMinute:self.historySamplesPerMinute];
+        [self.sensorsInSeriesOrder addObject:sensor];
 	}
-	[sensor.dataSet setNextValue:value];
 	
 	// If this location doesn't have a label, generate one.
 	if (sensor.humanReadableName == nil) {
@@ -448,7 +489,7 @@
 	if (needRegen) [self regenerateLocationKeyOrder];
 
     // Record in XRGStatsManager
-    [[XRGStatsManager shared] observeStat:value forKey:location inModule:XRGStatsModuleNameTemperature];
+    [[XRGStatsManager shared] observeStat:value forHandle:sensor.statHandle];
 
 	#ifdef DEBUG
 		NSLog(@"Set current value: %f (%@) for location: (%@)", value, units, location);
@@ -457,24 +498,36 @@
 	return;
 }
 
-- (void)setDataSize:(NSInteger)newNumSamples {
-    NSArray *a = [self.sensorData allKeys];
-
-    for (int i = 0; i < [a count]; i++) {
-		[self.sensorData[a[i]].dataSet resize:(size_t)newNumSamples];
+- (void)setHistorySamplesPerMinute:(NSUInteger)samplesPerMinute {
+    if (samplesPerMinute == _historySamplesPerMinute) return;
+    
+    _historySamplesPerMinute = samplesPerMinute;
+    for (XRGSensorData *sensor in self.sensorsInSeriesOrder) {
+        [sensor.dataSet keepHistoryWithSamplesPerMinute:samplesPerMinute];
     }
+}
+
+- (void)setDataSize:(NSInteger)newNumSamples {
+    [self.sensorGroup resize:(size_t)newNumSamples];
     
     self.numSamples = newNumSamples;
 }
 
 - (NSArray<XRGFan *> *)fanValues {
-    if (self.fanCache && ([self.fanCacheCreated timeIntervalSinceNow] > -1)) {
-        return self.fanCache;
+    if (!self.fanCache) {
+        // Nothing has been sampled yet.  Read the SMC on the temperature queue so it can't overlap a collection.
+        NSDictionary *fansD = [[XRGSampler shared] collectSynchronouslyForModule:XRGStatsModuleNameTemperature block:^id{
+            return [self.smcSensors fanValues];
+        }];
+        self.fanCache = [self fansFromSMCValues:fansD];
     }
     
+    return self.fanCache;
+}
+
+- (NSArray<XRGFan *> *)fansFromSMCValues:(NSDictionary *)fansD {
     NSMutableArray *retFans = [NSMutableArray array];
     
-    NSDictionary *fansD = [self.smcSensors fanValues];
     for (NSString *key in [fansD allKeys]) {
         XRGFan *f = [[XRGFan alloc] init];
         f.name = key;
@@ -503,9 +556,6 @@
         [retFans addObject:f];
     }
 
-    self.fanCache = retFans;
-    self.fanCacheCreated = [NSDate date];
-    
     return retFans;
 }
 
@@ -54,6 +54,8 @@
 @property BOOL clickedMinimized;
 
 - (void)getHostname;
+/// Gives this view and each module its own layer, so a module's update only redraws that module and the border and title stay cached.
+- (void)setModulesLayerBacked:(BOOL)layerBacked;
 - (void)offsetDrawingOrigin:(NSSize)offset;
 - (void)minimizeWindow;
 - (void)expandWindow;
@@ -29,6 +29,7 @@
 #import "XRGGenericView.h"
 #import "XRGAppDelegate.h"
 #import "XRGPrefController.h"
+#import "XRGDiagnostics.h"
 #import <sys/sysctl.h>
 
 @implementation XRGBackgroundView
@@ -58,6 +59,33 @@
     [self registerForDraggedTypes:@[NSFilenamesPboardType]];
     
     [parentWindow setBackgroundView: self];
+    
+    [self setModulesLayerBacked:[appSettings layerBackedGraphs]];
+}
+
+- (void)setModulesLayerBacked:(BOOL)layerBacked {
+    // Layer-backing this view backs the modules too.  Their layers are only redrawn when they're invalidated, and
+    // AppKit composites them over this one, so the border and title aren't repainted under a module that changed.
+    self.wantsLayer = layerBacked;
+    self.layerContentsRedrawPolicy = NSViewLayerContentsRedrawOnSetNeedsDisplay;
+    [self setNeedsDisplay:YES];
+}
+
+- (void)setNeedsDisplay:(BOOL)flag {
+    if (flag) [self setNeedsDisplayInRect:self.bounds];
+    else [super setNeedsDisplay:NO];
+}
+
+- (void)setNeedsDisplayInRect:(NSRect)invalidRect {
+    [super setNeedsDisplayInRect:invalidRect];
+    if (!self.layer) return;
+    
+    // Without layers, redrawing part of this view redraws the modules over it too, which settings and theme changes
+    // rely on.  With them, each module has its own layer to invalidate.
+    for (NSView *subview in self.subviews) {
+        NSRect subviewRect = NSIntersectionRect([self convertRect:invalidRect toView:subview], subview.bounds);
+        if (!NSIsEmptyRect(subviewRect)) [subview setNeedsDisplayInRect:subviewRect];
+    }
 }
 
 - (void)setFrame:(NSRect)frame {
@@ -87,6 +115,8 @@
 }
 
 - (void)drawRect:(NSRect)rect{
+    XRG_DIAGNOSTICS_SCOPE(XRGStatsModuleNameSampler, XRGDiagnosticsPhaseDraw);
+    
     // Rotate the coordinate system if necessary
     if (![moduleManager graphOrientationVertical] && isVertical) {
         // first update our size:
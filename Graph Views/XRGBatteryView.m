@@ -27,6 +27,7 @@
 
 #import "XRGGraphWindow.h"
 #import "XRGBatteryView.h"
+#import "XRGDiagnostics.h"
 
 #include <IOKit/pwr_mgt/IOPM.h>
 #include <IOKit/pwr_mgt/IOPMLib.h>
@@ -116,34 +117,38 @@
 
     float width, height;
     height = [appSettings textRectHeight];
-    width = [@"100% Chgd." sizeWithAttributes:textAttributes].width + 6;
+    width = [[XRGLabelCache shared] sizeOfString:@"100% Chgd." attributes:textAttributes].width + 6;
     
     [m setMinWidth: width];
     [m setMinHeight: height];
     
     // Update the cache dictionary
-    NBF_WIDE          = [@"No Battery Found" sizeWithAttributes:textAttributes].width;
-    NBF_NORMAL        = [@"No Battery\nFound" sizeWithAttributes:textAttributes].width;
+    NBF_WIDE          = [[XRGLabelCache shared] sizeOfString:@"No Battery Found" attributes:textAttributes].width;
+    NBF_NORMAL        = [[XRGLabelCache shared] sizeOfString:@"No Battery\nFound" attributes:textAttributes].width;
     
-    PERCENT_WIDE      = [@"100% Charged 9:99 Left" sizeWithAttributes:textAttributes].width;
+    PERCENT_WIDE      = [[XRGLabelCache shared] sizeOfString:@"100% Charged 9:99 Left" attributes:textAttributes].width;
     
-    CHARGED_WIDE      = [@"100% Charged" sizeWithAttributes:textAttributes].width;
+    CHARGED_WIDE      = [[XRGLabelCache shared] sizeOfString:@"100% Charged" attributes:textAttributes].width;
     
-    ESTIMATING_WIDE   = [@"100% Estimating Left" sizeWithAttributes:textAttributes].width;
-    ESTIMATING_NORMAL = [@"100% Estimating" sizeWithAttributes:textAttributes].width;
+    ESTIMATING_WIDE   = [[XRGLabelCache shared] sizeOfString:@"100% Estimating Left" attributes:textAttributes].width;
+    ESTIMATING_NORMAL = [[XRGLabelCache shared] sizeOfString:@"100% Estimating" attributes:textAttributes].width;
     
-    POWER_WIDE        = [@"Power: 99.9V" sizeWithAttributes:textAttributes].width;
+    POWER_WIDE        = [[XRGLabelCache shared] sizeOfString:@"Power: 99.9V" attributes:textAttributes].width;
     
-    CURRENT_WIDE      = [@"Remaining Capacity: " sizeWithAttributes:textAttributes].width;
-    CURRENT_NORMAL    = [@"Rem: " sizeWithAttributes:textAttributes].width;
+    CURRENT_WIDE      = [[XRGLabelCache shared] sizeOfString:@"Remaining Capacity: " attributes:textAttributes].width;
+    CURRENT_NORMAL    = [[XRGLabelCache shared] sizeOfString:@"Rem: " attributes:textAttributes].width;
     
-    CAPACITY_WIDE     = [@"Maximum Capacity: " sizeWithAttributes:textAttributes].width;
-    CAPACITY_NORMAL   = [@"Max: " sizeWithAttributes:textAttributes].width;
+    CAPACITY_WIDE     = [[XRGLabelCache shared] sizeOfString:@"Maximum Capacity: " attributes:textAttributes].width;
+    CAPACITY_NORMAL   = [[XRGLabelCache shared] sizeOfString:@"Max: " attributes:textAttributes].width;
     
-    NBIF_WIDE         = [@"No Battery Info Found" sizeWithAttributes:textAttributes].width;
-    NBIF_NORMAL       = [@"No Battery\nInfo Found" sizeWithAttributes:textAttributes].width;
+    NBIF_WIDE         = [[XRGLabelCache shared] sizeOfString:@"No Battery Info Found" attributes:textAttributes].width;
+    NBIF_NORMAL       = [[XRGLabelCache shared] sizeOfString:@"No Battery\nInfo Found" attributes:textAttributes].width;
     
-    MAH_STRING        = [@"9999mAh" sizeWithAttributes:textAttributes].width;
+    MAH_STRING        = [[XRGLabelCache shared] sizeOfString:@"9999mAh" attributes:textAttributes].width;
+}
+
+- (XRGStatsModule)samplingModule {
+    return XRGStatsModuleNameBattery;
 }
 
 // Battery stats code based on code in Idleize by Jason Patterson.  
@@ -182,6 +187,7 @@
 
 - (void)drawRect:(NSRect)rect {
     if ([self isHidden]) return;
+    XRG_DIAGNOSTICS_SCOPE(XRGStatsModuleNameBattery, XRGDiagnosticsPhaseDraw);
 
     #ifdef XRG_DEBUG
         NSLog(@"In Battery DrawRect."); 
@@ -28,8 +28,10 @@
 #import "XRGGenericView.h"
 #import "XRGCPUMiner.h"
 #import "XRGProcessMiner.h"
+#import "XRGSampler.h"
+#import "XRGScrollingGraphRenderer.h"
 
-@interface XRGCPUView : XRGGenericView
+@interface XRGCPUView : XRGGenericView <XRGSampledView>
 {
 @private
     NSSize						graphSize;
@@ -37,6 +39,7 @@
     XRGModule                   *m;
     XRGCPUMiner                 *CPUMiner;
 	XRGProcessMiner				*processMiner;
+    XRGScrollingGraphRenderer   *graphRenderer;
 
     CGFloat                     UPTIME_WIDE;
     CGFloat                     UPTIME_NORMAL;
@@ -53,4 +56,6 @@
 - (void)graphUpdate:(NSTimer *)aTimer;
 - (void)fastUpdate:(NSTimer *)aTimer;
 - (void)drawGraph:(NSRect)inRect;
+/// Sizes the miner's history for the graph spans to the current graph refresh.
+- (void)updateHistoryStorage;
 @end
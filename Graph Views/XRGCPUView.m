@@ -26,6 +26,8 @@
 
 #import "XRGGraphWindow.h"
 #import "XRGCPUView.h"
+#import "XRGDiagnostics.h"
+#import "XRGStatsManager.h"
 
 #import <stdio.h>
 
@@ -42,6 +44,7 @@
     moduleManager = [parentWindow moduleManager];
     
     CPUMiner = [[XRGCPUMiner alloc] init];
+    [self updateHistoryStorage];
 	processMiner = [[XRGProcessMiner alloc] init];
 
     NSUserDefaults *defs = [NSUserDefaults standardUserDefaults];    
@@ -58,6 +61,11 @@
     [self setGraphSize:[m currentSize]];
 }
 
+- (void)updateHistoryStorage {
+    CPUMiner.historyInterval = [appSettings graphRefresh];
+    CPUMiner.historySamplesPerMinute = (NSUInteger)ceil(60. / MAX([appSettings graphRefresh], 0.2));
+}
+
 - (void)setGraphSize:(NSSize)newSize {
     NSSize tmpSize;
     tmpSize.width = newSize.width;
@@ -89,18 +97,18 @@
         
     NSInteger offset = [appSettings fastCPUUsage] ? 7 : 0;
     
-    UPTIME_WIDE = [@"Uptime: 99d 23:59" sizeWithAttributes:[appSettings alignRightAttributes]].width + offset + 6;
-    UPTIME_NORMAL = [@"U: 99d 23:59" sizeWithAttributes:[appSettings alignRightAttributes]].width + offset + 6;
+    UPTIME_WIDE = [[XRGLabelCache shared] sizeOfString:@"Uptime: 99d 23:59" attributes:[appSettings alignRightAttributes]].width + offset + 6;
+    UPTIME_NORMAL = [[XRGLabelCache shared] sizeOfString:@"U: 99d 23:59" attributes:[appSettings alignRightAttributes]].width + offset + 6;
     
     if ([CPUMiner numberOfCPUs] == 2) {
-        AVG_WIDE = [@"99.9% Average 99.9%" sizeWithAttributes:[appSettings alignRightAttributes]].width + offset + 6;
-        AVG_NORMAL = [@"99.9% Avg 99.9%" sizeWithAttributes:[appSettings alignRightAttributes]].width + offset + 6;
+        AVG_WIDE = [[XRGLabelCache shared] sizeOfString:@"99.9% Average 99.9%" attributes:[appSettings alignRightAttributes]].width + offset + 6;
+        AVG_NORMAL = [[XRGLabelCache shared] sizeOfString:@"99.9% Avg 99.9%" attributes:[appSettings alignRightAttributes]].width + offset + 6;
 
-        width = [@"100% CPU 100%" sizeWithAttributes:[appSettings alignRightAttributes]].width + offset + 6;
+        width = [[XRGLabelCache shared] sizeOfString:@"100% CPU 100%" attributes:[appSettings alignRightAttributes]].width + offset + 6;
     }
     else {  // this takes > 2 CPUs too, at the risk of displaying incorrectly (if Apple ever uses > 2 CPUs :-))
-        AVG_WIDE = [@"Average: 99.9%" sizeWithAttributes:[appSettings alignRightAttributes]].width + offset + 6;
-        AVG_NORMAL = [@"Avg: 99.9%" sizeWithAttributes:[appSettings alignRightAttributes]].width + offset + 6;
+        AVG_WIDE = [[XRGLabelCache shared] sizeOfString:@"Average: 99.9%" attributes:[appSettings alignRightAttributes]].width + offset + 6;
+        AVG_NORMAL = [[XRGLabelCache shared] sizeOfString:@"Avg: 99.9%" attributes:[appSettings alignRightAttributes]].width + offset + 6;
 
         width = UPTIME_NORMAL;
     }
@@ -111,23 +119,61 @@
 }
 
 - (void)graphUpdate:(NSTimer *)aTimer {
+    [self applyGraphSample:[[XRGSampler shared] collectSynchronouslyForModule:XRGStatsModuleNameCPU block:^id{
+        return [self collectGraphSample];
+    }]];
+}
+
+- (void)fastUpdate:(NSTimer *)aTimer {
+    [self applyFastSample:[[XRGSampler shared] collectSynchronouslyForModule:XRGStatsModuleNameCPU block:^id{
+        return [self collectFastSample];
+    }]];
+}
+
+- (XRGStatsModule)samplingModule {
+    return XRGStatsModuleNameCPU;
+}
+
+- (id)collectGraphSample {
+    return [CPUMiner collectSample];
+}
+
+- (void)applyGraphSample:(XRGCPUSample *)sample {
+    [self applyGraphSample:sample span:1];
+}
+
+- (void)applyGraphSample:(XRGCPUSample *)sample span:(NSUInteger)span {
+    // These take effect in the next sample; the miner collects whatever was asked for when collection started.
     [CPUMiner setLoadAverage:[appSettings showLoadAverage]];
     [CPUMiner setUptime:YES];
-    [CPUMiner graphUpdate:aTimer];
+    [CPUMiner applySample:sample span:span];
     
-    [self setNeedsDisplay:YES];
+    // The load average and uptime lines can change while the graph doesn't.  The mini graph shows neither.
+    NSUInteger textGeneration = [self shouldDrawMiniGraph] ? 0 : CPUMiner.textGeneration;
+    [self setNeedsDisplayForGeneration:CPUMiner.changeGeneration textGeneration:textGeneration textRect:[self textRectForLineCount:[self textLineCount]]];
 }
 
-- (void)fastUpdate:(NSTimer *)aTimer {
+- (BOOL)wantsFastSample {
+    return [appSettings fastCPUUsage];
+}
+
+- (id)collectFastSample {
+    return [CPUMiner collectFastSample];
+}
+
+- (void)applyFastSample:(NSData *)ticks {
     if ([appSettings fastCPUUsage]) {
-        [CPUMiner fastUpdate:aTimer];
+        [CPUMiner applyFastSample:ticks];
 
-        [self setNeedsDisplay:YES];
+        // Outside the mini graph, the fast values are only the bars along the bottom half.
+        NSRect fastRect = [self shouldDrawMiniGraph] ? self.bounds : NSMakeRect(0, 0, graphSize.width, ceil(graphSize.height / 2.));
+        [self setNeedsDisplayInRect:fastRect forGeneration:CPUMiner.fastGeneration part:XRGRedrawPartFast];
     }
 }
 
 - (void)drawRect:(NSRect)dummy
 {
+    XRG_DIAGNOSTICS_SCOPE(XRGStatsModuleNameCPU, XRGDiagnosticsPhaseDraw);
     NSRect inRect = NSMakeRect(0, 0, graphSize.width, graphSize.height);
 
     NSGraphicsContext *gc = [NSGraphicsContext currentContext];
@@ -223,28 +269,54 @@
     // Draw the top graph.
 	NSArray *cpuData = [CPUMiner combinedData];
 	if ([cpuData count] < 3) return;
-	// Create a tmpDataSet of the same size as the other ones so we can do some manipulations.
-	XRGDataSet *tmpDataSet = [[XRGDataSet alloc] initWithContentsOfOtherDataSet:cpuData[0]];
-	[tmpDataSet addOtherDataSetValues:cpuData[1]];
-	[tmpDataSet addOtherDataSetValues:cpuData[2]];
-	if ([appSettings separateCPUColor]) {
-		[self drawGraphWithDataFromDataSet:tmpDataSet maxValue:100.0 inRect:graphRect flipped:NO filled:YES color:colors[2]];
-		
-		[tmpDataSet subtractOtherDataSetValues:cpuData[2]];    
-		[self drawGraphWithDataFromDataSet:tmpDataSet maxValue:100.0 inRect:graphRect flipped:NO filled:YES color:colors[1]];
-		
-		[self drawGraphWithDataFromDataSet:cpuData[0] maxValue:100.0 inRect:graphRect flipped:NO filled:YES color:colors[0]];
-	}
-	else {    
-		[self drawGraphWithDataFromDataSet:tmpDataSet maxValue:100.0 inRect:graphRect flipped:NO filled:YES color:colors[0]];
-	}
+    NSMutableArray *graphColors = [appSettings separateCPUColor] ? [@[colors[0], colors[1], colors[2]] mutableCopy] : [@[colors[0], colors[0], colors[0]] mutableCopy];
+    NSUInteger busyLayerCount = [CPUMiner busyLayerCount];
+    for (NSUInteger i = 3; i < [cpuData count]; i++) {
+        // The extra states stack on top in shades of the third color, fading toward the background as they go up.  With
+        // one color, only iowait is faded, so idle time never looks busy.
+        NSColor *color = colors[0];
+        if ([appSettings separateCPUColor]) color = [colors[2] blendedColorWithFraction:0.15 * (i - 2) ofColor:[appSettings graphBGColor]];
+        else if (i >= busyLayerCount) color = [colors[0] blendedColorWithFraction:0.5 ofColor:[appSettings graphBGColor]];
+        
+        // Blending fails for colors that can't be converted to RGB, such as patterns.
+        [graphColors addObject:color ?: colors[[appSettings separateCPUColor] ? 2 : 0]];
+    }
+    size_t historySamples = [self historySampleCount];
+    if (historySamples) {
+        NSMutableArray *historyData = [NSMutableArray arrayWithCapacity:cpuData.count];
+        for (NSUInteger i = 0; i < cpuData.count; i++) {
+            [historyData addObject:[self historyOfDataSet:cpuData[i] lastSamples:historySamples inRect:graphRect slot:i]];
+        }
+        
+        [graphRenderer invalidate];
+        [self drawStackedGraphWithDataSets:historyData colors:graphColors upperBound:100.0 lowerBound:0 inRect:graphRect flipped:NO];
+        [self drawText:cpuData];
+        return;
+    }
+    
+    if ([appSettings incrementalGraphs]) {
+        if (!graphRenderer) graphRenderer = [[XRGScrollingGraphRenderer alloc] init];
+        
+        if ([graphRenderer drawStackedDataSets:cpuData colors:graphColors upperBound:100.0 lowerBound:0 inRect:graphRect flipped:NO antialias:[appSettings antiAliasing] backingScale:self.window.backingScaleFactor]) {
+            [self drawText:cpuData];
+            return;
+        }
+    }
+    else {
+        [graphRenderer invalidate];
+    }
+    
+    [self drawStackedGraphWithDataSets:cpuData colors:graphColors upperBound:100.0 lowerBound:0 inRect:graphRect flipped:NO];
 	
     // draw the text
     [self drawText:cpuData];
 }
 
+- (NSInteger)textLineCount {
+    return 1 + ([appSettings cpuShowAverageUsage] ? 1 : 0) + ([appSettings showLoadAverage] ? 1 : 0) + ([appSettings cpuShowUptime] ? 1 : 0);
+}
+
 - (void)drawText:(NSArray *)cpuData {
-    NSInteger numCPUs = [CPUMiner numberOfCPUs];
     if ([cpuData count] < 3) return;
     
     NSRect textRect = [self paddedTextRect];
@@ -254,7 +326,7 @@
     
     // Draw the first line with the label and current CPU usage
     [leftText setString:@"CPU"];
-    [rightText appendFormat:@"%3.f%%", MAX(0, ([(XRGDataSet *)cpuData[0] currentValue] + [(XRGDataSet *)cpuData[1] currentValue] + [(XRGDataSet *)cpuData[2] currentValue])) * [CPUMiner numberOfCPUs]];
+    [rightText appendFormat:@"%3.f%%", MAX(0, [CPUMiner currentUsage]) * [CPUMiner numberOfCPUs]];
     
     // draw the average usage text
     if ([appSettings cpuShowAverageUsage]) {
@@ -265,15 +337,10 @@
             [leftText appendString:@"\nAvg:"];
         }
         
-        CGFloat usageSum = 0;
-        for (NSInteger i = 0; i < numCPUs; i++) {
-            NSArray *cpuData = [CPUMiner dataForCPU:i];
-            usageSum += [cpuData[0] average];
-            usageSum += [cpuData[1] average];
-            usageSum += [cpuData[2] average];
-        }
+        // The combined data is already averaged across the CPUs.
+        CGFloat usageAverage = [CPUMiner averageUsage];
         
-        [rightText appendFormat:@"\n%3.1f%%", usageSum / (CGFloat)numCPUs];
+        [rightText appendFormat:@"\n%3.1f%%", usageAverage];
     }
     
     // draw the load average text
@@ -322,7 +389,7 @@
 
     NSArray *cpuData = [CPUMiner combinedData];
     if ([cpuData count] < 3) return;
-    NSString *rightLabel = [NSString stringWithFormat:@"%3.f%%", MAX(0, ([(XRGDataSet *)cpuData[0] currentValue] + [(XRGDataSet *)cpuData[1] currentValue] + [(XRGDataSet *)cpuData[2] currentValue])) * [CPUMiner numberOfCPUs]];
+    NSString *rightLabel = [NSString stringWithFormat:@"%3.f%%", MAX(0, [CPUMiner currentUsage]) * [CPUMiner numberOfCPUs]];
     
     [self drawMiniGraphWithValues:sortedValues upperBound:100 lowerBound:0 leftLabel:@"CPU" rightLabel:rightLabel];
 }
@@ -367,6 +434,8 @@
     
     tMI = [[NSMenuItem alloc] initWithTitle:@"Reset Graph" action:@selector(clearData:) keyEquivalent:@""];
     [myMenu addItem:tMI];
+    
+    [myMenu addItem:[self graphSpanMenuItem]];
 
     [myMenu addItem:[NSMenuItem separatorItem]];
     
@@ -410,6 +479,7 @@
 
 - (void)clearData:(NSEvent *)theEvent {
     [CPUMiner reset];
+    [[XRGStatsManager shared] clearHistoryForModule:XRGStatsModuleNameCPU];
 }
 
 - (BOOL) acceptsFirstMouse {
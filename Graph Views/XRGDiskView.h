@@ -29,8 +29,10 @@
 #import <IOKit/storage/IOBlockStorageDriver.h>
 #import "definitions.h"
 #import "XRGGenericView.h"
+#import "XRGStatsManager.h"
+#import "XRGSampler.h"
 
-@interface XRGDiskView : XRGGenericView {
+@interface XRGDiskView : XRGGenericView <XRGSampledView> {
 @private
     NSSize					graphSize;
     int						numSamples;
@@ -50,15 +52,24 @@
 	UInt64					fastReadBytes;
 	UInt64					fastWriteBytes;
 	UInt64					fastMax;
+    
+    // Change generations for redrawing: the graph, the total I/O text, and the mini graph.
+    NSUInteger              graphGeneration;
+    NSUInteger              textGeneration;
+    NSUInteger              fastGeneration;
+    NSInteger               unchangedSamples;       // How many of the newest samples match the one before them.
 	io_stats				fast_i;
 	io_stats				fast_o;
 
     mach_port_t         	masterPort;
-    io_iterator_t       	drivelist;  /* needs release */
-	NSMutableArray			*volumeInfo;
+    io_iterator_t       	drivelist;  /* needs release; only used on the sampler queue after launch */
+	NSArray					*volumeInfo;
 
     io_stats				i_dsk;
     io_stats				o_dsk;
+    
+    XRGStatHandle           readStatHandle;
+    XRGStatHandle           writeStatHandle;
 }
 
 - (void)setGraphSize:(NSSize)newSize;
@@ -68,6 +79,7 @@
 - (void)graphUpdate:(NSTimer *)aTimer;
 - (void)min5Update:(NSTimer *)aTimer;
 - (void)updateVolumeInfo;
+- (NSArray *)currentVolumeInfo;
 
 - (NSString *)readBytesString;
 - (NSString *)writeBytesString;
@@ -25,6 +25,7 @@
 //
 
 #import "XRGDiskView.h"
+#import "XRGDiagnostics.h"
 #import "XRGGraphWindow.h"
 #import "XRGCommon.h"
 #import <CoreFoundation/CoreFoundation.h>
@@ -35,6 +36,16 @@
 
 void getDISKcounters(io_iterator_t drivelist, io_stats *i_dsk, io_stats *o_dsk);
 
+/// What one tick read from the system.  Collected on the sampler queue and never changed afterwards.
+@interface XRGDiskSample : NSObject
+@property UInt64 readBytes;
+@property UInt64 writeBytes;
+@property NSArray *volumeInfo;      // nil for fast samples.
+@end
+
+@implementation XRGDiskSample
+@end
+
 @implementation XRGDiskView
 
 - (void)awakeFromNib {    
@@ -42,6 +53,9 @@ void getDISKcounters(io_iterator_t drivelist, io_stats *i_dsk, io_stats *o_dsk);
     
     currentIndex = 0;
     maxVal       = 1;
+    
+    readStatHandle  = [[XRGStatsManager shared] handleForKey:@"Read" inModule:XRGStatsModuleNameDisk];
+    writeStatHandle = [[XRGStatsManager shared] handleForKey:@"Write" inModule:XRGStatsModuleNameDisk];
 	fastMax      = 1024 * 1024;
               
     parentWindow = (XRGGraphWindow *)[self window];
@@ -62,7 +76,6 @@ void getDISKcounters(io_iterator_t drivelist, io_stats *i_dsk, io_stats *o_dsk);
                                  IOServiceMatching("IOBlockStorageDriver"), 
                                  &drivelist);
 	
-	volumeInfo = [NSMutableArray arrayWithCapacity:10];
 	[self updateVolumeInfo];
     
     // Run through the stats collectors once so we don't have an initial spike.
@@ -105,6 +118,8 @@ void getDISKcounters(io_iterator_t drivelist, io_stats *i_dsk, io_stats *o_dsk);
     int i;
     int newNumSamples = newWidth;
     maxVal = 0;
+    unchangedSamples = 0;
+    graphGeneration++;
     
     if (values) {
         UInt64 *newVals, *newReadVals, *newWriteVals;
@@ -155,15 +170,56 @@ void getDISKcounters(io_iterator_t drivelist, io_stats *i_dsk, io_stats *o_dsk);
 - (void)updateMinSize {
     float width, height;
     height = [appSettings textRectHeight];
-    width = [@"D1023K W" sizeWithAttributes:[appSettings alignRightAttributes]].width + 6;
+    width = [[XRGLabelCache shared] sizeOfString:@"D1023K W" attributes:[appSettings alignRightAttributes]].width + 6;
     
     [m setMinWidth: width];
     [m setMinHeight: height];
 }
 
 - (void)fastUpdate:(NSTimer *)aTimer {
+    [self applyFastSample:[[XRGSampler shared] collectSynchronouslyForModule:XRGStatsModuleNameDisk block:^id{
+        return [self collectFastSample];
+    }]];
+}
+
+- (void)graphUpdate:(NSTimer *)aTimer {
+    [self applyGraphSample:[[XRGSampler shared] collectSynchronouslyForModule:XRGStatsModuleNameDisk block:^id{
+        return [self collectGraphSample];
+    }]];
+}
+
+- (BOOL)wantsFastSample {
+    return [self shouldDrawMiniGraph];
+}
+
+- (XRGStatsModule)samplingModule {
+    return XRGStatsModuleNameDisk;
+}
+
+- (id)collectFastSample {
+    io_stats readStats, writeStats;
+    getDISKcounters(drivelist, &readStats, &writeStats);
+    
+    XRGDiskSample *sample = [[XRGDiskSample alloc] init];
+    sample.readBytes = readStats.bytes;
+    sample.writeBytes = writeStats.bytes;
+    return sample;
+}
+
+- (id)collectGraphSample {
+    XRGDiskSample *sample = [self collectFastSample];
+    sample.volumeInfo = [self currentVolumeInfo];
+    return sample;
+}
+
+- (void)applyFastSample:(XRGDiskSample *)sample {
 	if ([self shouldDrawMiniGraph]) {
-		getDISKcounters(drivelist, &fast_i, &fast_o);    
+        UInt64 lastReadBytes = fastReadBytes;
+        UInt64 lastWriteBytes = fastWriteBytes;
+        UInt64 lastMax = fastMax;
+        
+        fast_i.bytes = sample.readBytes;
+        fast_o.bytes = sample.writeBytes;
 		
 		fast_i.bytes_delta = fast_i.bytes - fast_i.bytes_prev;
 		fast_o.bytes_delta = fast_o.bytes - fast_o.bytes_prev;
@@ -182,17 +238,24 @@ void getDISKcounters(io_iterator_t drivelist, io_stats *i_dsk, io_stats *o_dsk);
             fastMax = [XRGCommon dampedMaxUsingPreviousMax:fastMax currentMax:fastReadBytes + fastWriteBytes baseMax:1024 * 1024];
 		}
 	
-		[self setNeedsDisplay: YES];       
+        // Once the damped rates settle, an idle disk stops redrawing.
+        if (fastReadBytes != lastReadBytes || fastWriteBytes != lastWriteBytes || fastMax != lastMax) fastGeneration++;
+        [self setNeedsDisplayInRect:self.bounds forGeneration:fastGeneration part:XRGRedrawPartFast];
 	}
 }
 
-- (void)graphUpdate:(NSTimer *)aTimer{
+- (void)applyGraphSample:(XRGDiskSample *)sample {
+    [self applyGraphSample:sample span:1];
+}
+
+- (void)applyGraphSample:(XRGDiskSample *)sample span:(NSUInteger)span {
     int i;
-    currentIndex++;
-    if (currentIndex == numSamples)
-        currentIndex = 0;
+    span = MAX(span, 1);
+    UInt64 lastReadBytes = readBytes;
+    UInt64 lastWriteBytes = writeBytes;
     
-    getDISKcounters(drivelist, &i_dsk, &o_dsk);    
+    i_dsk.bytes = sample.readBytes;
+    o_dsk.bytes = sample.writeBytes;
 
     i_dsk.bytes_delta = i_dsk.bytes - i_dsk.bytes_prev;
     o_dsk.bytes_delta = o_dsk.bytes - o_dsk.bytes_prev;
@@ -201,54 +264,82 @@ void getDISKcounters(io_iterator_t drivelist, io_stats *i_dsk, io_stats *o_dsk);
     if (i_dsk.bytes_delta > pow(2, 63)) i_dsk.bytes_delta = 0;
     if (o_dsk.bytes_delta > pow(2, 63)) o_dsk.bytes_delta = 0;
 
-    writeBytes = o_dsk.bytes_delta / [appSettings graphRefresh];
-    readBytes = i_dsk.bytes_delta / [appSettings graphRefresh];
+    writeBytes = o_dsk.bytes_delta / ([appSettings graphRefresh] * span);
+    readBytes = i_dsk.bytes_delta / ([appSettings graphRefresh] * span);
 
     i_dsk.bytes_prev = i_dsk.bytes; 
     o_dsk.bytes_prev = o_dsk.bytes;
     
     totalDiskIO = readBytes + writeBytes;
-	diskIOSinceLaunch += totalDiskIO;
+	diskIOSinceLaunch += totalDiskIO * span;
     
-    readValues[currentIndex] = readBytes;
-    writeValues[currentIndex] = writeBytes;
-    if (totalDiskIO >= maxVal) {
-        maxVal = totalDiskIO;
-        values[currentIndex] = totalDiskIO;
-    } else {
-        if (values[currentIndex] == maxVal) {
-            // set the new sample and find the new maxval
-            values[currentIndex] = totalDiskIO;
-            maxVal = 0;
-            for (i = 0; i < numSamples; i++)
-                if (values[i] > maxVal) maxVal = values[i];
-        }
-        else {
+    [[XRGStatsManager shared] observeStat:readBytes forHandle:readStatHandle];
+    [[XRGStatsManager shared] observeStat:writeBytes forHandle:writeStatHandle];
+    
+    // A stretched tick fills every slot it covers with its average rate.
+    for (NSUInteger slot = 0; slot < span; slot++) {
+        currentIndex++;
+        if (currentIndex == numSamples)
+            currentIndex = 0;
+        
+        readValues[currentIndex] = readBytes;
+        writeValues[currentIndex] = writeBytes;
+        if (totalDiskIO >= maxVal) {
+            maxVal = totalDiskIO;
             values[currentIndex] = totalDiskIO;
+        } else {
+            if (values[currentIndex] == maxVal) {
+                // set the new sample and find the new maxval
+                values[currentIndex] = totalDiskIO;
+                maxVal = 0;
+                for (i = 0; i < numSamples; i++)
+                    if (values[i] > maxVal) maxVal = values[i];
+            }
+            else {
+                values[currentIndex] = totalDiskIO;
+            }
         }
     }
     
 	// Update the volume information.
-	[self updateVolumeInfo];
+	volumeInfo = sample.volumeInfo;
 	//NSLog(@"Volume: %@", volumeInfo);
 	
-    [self setNeedsDisplay: YES];       
+    // The graph only looks different until every sample on it is the same.  A steady nonzero rate still moves the total.
+    if (readBytes == lastReadBytes && writeBytes == lastWriteBytes) unchangedSamples += span;
+    else unchangedSamples = 0;
+    if (unchangedSamples < numSamples) graphGeneration++;
+    if (totalDiskIO > 0) textGeneration++;
+    
+    if ([self shouldDrawMiniGraph]) {
+        [self setNeedsDisplayInRect:self.bounds forGeneration:graphGeneration part:XRGRedrawPartGraph];
+    }
+    else {
+        [self setNeedsDisplayForGeneration:graphGeneration textGeneration:textGeneration textRect:[self textRectForLineCount:3]];
+    }
 }
 
 - (void)min5Update:(NSTimer *)aTimer{
-    /* Obtain the list of all drive objects */
-    if (drivelist) {
-        IOObjectRelease(drivelist);
-        drivelist = IO_OBJECT_NULL;
-    }
-    
-    IOServiceGetMatchingServices(masterPort, 
-                                 IOServiceMatching("IOBlockStorageDriver"), 
-                                 &drivelist);
+    // Collection walks drivelist, so it's replaced between collections.
+    [[XRGSampler shared] performForModule:XRGStatsModuleNameDisk block:^{
+        /* Obtain the list of all drive objects */
+        if (self->drivelist) {
+            IOObjectRelease(self->drivelist);
+            self->drivelist = IO_OBJECT_NULL;
+        }
+        
+        IOServiceGetMatchingServices(self->masterPort,
+                                     IOServiceMatching("IOBlockStorageDriver"),
+                                     &self->drivelist);
+    }];
 }
 
 - (void) updateVolumeInfo {
-	[volumeInfo removeAllObjects];
+	volumeInfo = [self currentVolumeInfo];
+}
+
+- (NSArray *)currentVolumeInfo {
+	NSMutableArray *newVolumeInfo = [NSMutableArray arrayWithCapacity:10];
 	
 	struct statfs *buf;
 	int bufsize = 0;
@@ -273,16 +364,19 @@ void getDISKcounters(io_iterator_t drivelist, io_stats *i_dsk, io_stats *o_dsk);
 		
 		if ([d[@"FS Type"] isEqualToString:@"devfs"]) continue;
 		if ([d[@"FS Type"] isEqualToString:@"autofs"]) continue;
-		[volumeInfo addObject:d];
+		[newVolumeInfo addObject:d];
 	}
 	
-	//printf("%s\n", [[volumeInfo description] lossyCString]);
+	//printf("%s\n", [[newVolumeInfo description] lossyCString]);
 	
 	free(buf);
+	
+	return newVolumeInfo;
 }
 
 - (void)drawRect:(NSRect)rect {
     if ([self isHidden]) return;
+    XRG_DIAGNOSTICS_SCOPE(XRGStatsModuleNameDisk, XRGDiagnosticsPhaseDraw);
 
     #ifdef XRG_DEBUG
         NSLog(@"In Disk DrawRect."); 
@@ -325,7 +419,7 @@ void getDISKcounters(io_iterator_t drivelist, io_stats *i_dsk, io_stats *o_dsk);
     NSMutableString *leftText = [[NSMutableString alloc] init];
     NSMutableString *rightText = [[NSMutableString alloc] init];
 	
-	if ([@"Disk1023.9K W" sizeWithAttributes:[appSettings alignRightAttributes]].width + 6 > [self frame].size.width) {
+	if ([[XRGLabelCache shared] sizeOfString:@"Disk1023.9K W" attributes:[appSettings alignRightAttributes]].width + 6 > [self frame].size.width) {
 		[leftText setString:@"D"];
 	}
 	else {
@@ -348,7 +442,7 @@ void getDISKcounters(io_iterator_t drivelist, io_stats *i_dsk, io_stats *o_dsk);
     if (tmpRect.origin.y - textRectHeight > 0) {
         tmpRect.origin.y -= textRectHeight;
         tmpRect.size.height += textRectHeight;
-        [leftText appendFormat:@"\n%@", [XRGCommon formattedStringForBytes:diskIOSinceLaunch]];
+        [XRGCommon appendBytes:diskIOSinceLaunch toString:leftText prefix:"\n" suffix:NULL];
     }
 
     // Right text is drawn below and can have multiple strings.
@@ -387,7 +481,7 @@ void getDISKcounters(io_iterator_t drivelist, io_stats *i_dsk, io_stats *o_dsk);
 
 - (void)drawMiniGraph:(NSRect)inRect {
     NSString *leftLabel = nil;
-    if ([@"Disk1023.9K W" sizeWithAttributes:[appSettings alignRightAttributes]].width + 6 > [self frame].size.width) {
+    if ([[XRGLabelCache shared] sizeOfString:@"Disk1023.9K W" attributes:[appSettings alignRightAttributes]].width + 6 > [self frame].size.width) {
         leftLabel = @"D";
     }
     else {
@@ -444,6 +538,8 @@ void getDISKcounters(io_iterator_t drivelist, io_stats *i_dsk, io_stats *o_dsk);
     }
 
     maxVal = 1;
+    
+    [[XRGStatsManager shared] clearHistoryForModule:XRGStatsModuleNameDisk];
 }
 
 - (BOOL)acceptsFirstMouse:(NSEvent *)theEvent {       
@@ -463,11 +559,11 @@ void getDISKcounters(io_iterator_t drivelist, io_stats *i_dsk, io_stats *o_dsk);
 }
 
 - (NSString *)readBytesString {
-    return [NSString stringWithFormat:@"%@ R", [XRGCommon formattedStringForBytes:readBytes]];
+    return [XRGCommon formattedStringForBytes:readBytes suffix:" R"];
 }
 
 - (NSString *)writeBytesString {
-    return [NSString stringWithFormat:@"%@ W", [XRGCommon formattedStringForBytes:writeBytes]];
+    return [XRGCommon formattedStringForBytes:writeBytes suffix:" W"];
 }
 
 @end
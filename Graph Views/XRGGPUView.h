@@ -27,8 +27,9 @@
 #import <Foundation/Foundation.h>
 #import "XRGGenericView.h"
 #import "XRGGPUMiner.h"
+#import "XRGSampler.h"
 
-@interface XRGGPUView : XRGGenericView
+@interface XRGGPUView : XRGGenericView <XRGSampledView>
 {
 @private
 	NSSize						graphSize;
@@ -25,6 +25,7 @@
 //
 
 #import "XRGGPUView.h"
+#import "XRGDiagnostics.h"
 #import "XRGGraphWindow.h"
 #import "XRGCommon.h"
 
@@ -77,19 +78,38 @@
 }
 
 - (void)updateMinSize {
-	float width = [@"GPU 9: 9999M" sizeWithAttributes:[appSettings alignRightAttributes]].width + 6;
+	float width = [[XRGLabelCache shared] sizeOfString:@"GPU 9: 9999M" attributes:[appSettings alignRightAttributes]].width + 6;
 	
 	[m setMinWidth: width];
     [m setMinHeight: XRG_MINI_HEIGHT];
 }
 
 - (void)graphUpdate:(NSTimer *)aTimer {
-	[graphicsMiner getLatestGraphicsInfo];
-	[self setNeedsDisplay:YES];
+    [self applyGraphSample:[[XRGSampler shared] collectSynchronouslyForModule:XRGStatsModuleNameGPU block:^id{
+        return [self collectGraphSample];
+    }]];
+}
+
+- (XRGStatsModule)samplingModule {
+    return XRGStatsModuleNameGPU;
+}
+
+- (id)collectGraphSample {
+	return [graphicsMiner collectGraphicsCards];
+}
+
+- (void)applyGraphSample:(NSArray<XRGGraphicsCard *> *)graphicsCards {
+    [self applyGraphSample:graphicsCards span:1];
+}
+
+- (void)applyGraphSample:(NSArray<XRGGraphicsCard *> *)graphicsCards span:(NSUInteger)span {
+	[graphicsMiner applyGraphicsCards:graphicsCards span:span];
+	[self setNeedsDisplayInRect:self.bounds forGeneration:graphicsMiner.changeGeneration part:XRGRedrawPartGraph];
 }
 
 - (void)drawRect:(NSRect)rect {
 	if ([self isHidden]) return;
+	XRG_DIAGNOSTICS_SCOPE(XRGStatsModuleNameGPU, XRGDiagnosticsPhaseDraw);
 	
 	NSGraphicsContext *gc = [NSGraphicsContext currentContext];
 	
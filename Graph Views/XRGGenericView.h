@@ -26,7 +26,6 @@
 
 
 #import <AppKit/AppKit.h>
-#define NOVALUE -1000
 
 #define XRG_MINI_HEIGHT ([appSettings textRectHeight])
 
@@ -35,6 +34,15 @@
 #import "XRGModuleManager.h"
 #import "XRGAppDelegate.h"
 #import "XRGDataSet.h"
+#import "XRGLabelCache.h"
+
+/// The independently invalidated parts of a view, for setNeedsDisplayInRect:forGeneration:part:.
+typedef NS_ENUM(NSInteger, XRGRedrawPart) {
+    XRGRedrawPartGraph,
+    XRGRedrawPartText,
+    XRGRedrawPartFast,
+    XRGRedrawPartCount
+};
 
 @interface XRGGenericView : NSView {
 @protected
@@ -53,8 +61,16 @@
 
 - (void)drawRangedGraphWithData:(CGFloat *)samples size:(NSInteger)nSamples currentIndex:(NSInteger)cIndex upperBound:(CGFloat)max lowerBound:(CGFloat)min inRect:(NSRect)rect flipped:(BOOL)flipped filled:(BOOL)filled color:(NSColor *)color;
 
+- (void)drawRangedGraphWithSpans:(XRGDataSetSpans)spans upperBound:(CGFloat)max lowerBound:(CGFloat)min inRect:(NSRect)rect flipped:(BOOL)flipped filled:(BOOL)filled color:(NSColor *)color;
+
 - (void)drawRangedGraphWithDataFromDataSet:(XRGDataSet *)dataSet upperBound:(CGFloat)max lowerBound:(CGFloat)min inRect:(NSRect)rect flipped:(BOOL)flipped filled:(BOOL)filled color:(NSColor *)color;
 
+/*! Draws dataSets stacked bottom to top as filled bands, each in the matching color, in one pass over the samples.  The data sets must be the same size and advance together, like the series of an XRGDataSetGroup.  Values are expected to be non-negative; NOVALUE counts as 0.
+ */
+- (void)drawStackedGraphWithDataSets:(NSArray<XRGDataSet *> *)dataSets colors:(NSArray<NSColor *> *)colors upperBound:(CGFloat)max lowerBound:(CGFloat)min inRect:(NSRect)rect flipped:(BOOL)flipped;
+/// The largest total of the stacked data sets at any sample, for scaling drawStackedGraphWithDataSets:.
+- (CGFloat)maxOfStackedDataSets:(NSArray<XRGDataSet *> *)dataSets;
+
 - (void)drawMiniGraphWithValues:(NSArray<NSNumber *> *)values upperBound:(double)max lowerBound:(double)min leftLabel:(NSString *)leftLabel printValueBytes:(UInt64)printValue printValueIsRate:(BOOL)isRate;
 
 - (void)drawMiniGraphWithValues:(NSArray<NSNumber *> *)values upperBound:(double)max lowerBound:(double)min leftLabel:(NSString *)leftLabel rightLabel:(NSString *)rightLabel;
@@ -65,6 +81,33 @@
 
 - (BOOL)shouldDrawMiniGraph;
 - (NSRect)paddedTextRect;
+/// The top lineCount lines of text, the full width of the view.
+- (NSRect)textRectForLineCount:(NSInteger)lineCount;
+
+/*! Change-driven invalidation.  A tick passes the generation of whatever a part of the view is drawn from, and rect is only invalidated if it differs from the generation last passed for that part.  The exception is a graph drawn from historyOfDataSet:, which scrolls with its archive or tiers even while the raw values are flat, so the graph part is invalidated every tick.  Skipped redraws are counted in XRGDiagnostics.  Changes the generations don't see, like settings and resizes, still invalidate the view directly.
+ @param rect The area the part covers; the bounds if it's the whole view.
+ @return YES if rect was invalidated.
+ */
+- (BOOL)setNeedsDisplayInRect:(NSRect)rect forGeneration:(NSUInteger)generation part:(XRGRedrawPart)part;
+/// The graph and text parts together: the whole view if generation changed, only textRect if just textGeneration did.
+- (BOOL)setNeedsDisplayForGeneration:(NSUInteger)generation textGeneration:(NSUInteger)textGeneration textRect:(NSRect)textRect;
+/// The generation last passed for the graph part, or NSNotFound if the view doesn't use change-driven invalidation or
+/// its graph is drawn from history.
+- (NSUInteger)graphGeneration;
+
+/// The number of graph intervals the current graphHistorySpan setting covers, or 0 for the usual one-sample-per-point graph.
+- (size_t)historySampleCount;
+
+/*! The newest numSamples samples of dataSet, as a data set the usual drawing methods accept.  If dataSet's archive can hold the whole span, the values are decoded from it as they were recorded.  Otherwise they are summarized from its history tiers into one value per pixel column of rect, the peak of each column.  Either way, the part of the span with no history yet is NOVALUE.  If numSamples is 0, the usual graph, returns dataSet itself.
+ @param slot Which of the view's reusable result data sets to fill, so a view drawing several series keeps each one's result.  The result is only valid until the next call with the same slot.
+ */
+- (XRGDataSet *)historyOfDataSet:(XRGDataSet *)dataSet lastSamples:(size_t)numSamples inRect:(NSRect)rect slot:(NSUInteger)slot;
+
+/// A "Graph Span" submenu item for a view's context menu, choosing the graphHistorySpan setting.
+- (NSMenuItem *)graphSpanMenuItem;
+
+/// Times drawing synthetic graphs into an offscreen bitmap at several widths, for the diagnostics panel.  Main thread only.
++ (NSString *)graphBenchmarkReport;
 
 // The following methods are to be implemented in subclasses.
 - (void)setGraphSize:(NSSize)newSize;
@@ -27,6 +27,25 @@
 #import "XRGGenericView.h"
 #import "XRGCommon.h"
 #import "XRGNonInteractableTextField.h"
+#import "XRGDiagnostics.h"
+#import "XRGDecimation.h"
+#import "XRGVectorKernels.h"
+
+@interface XRGGenericView () {
+    NSUInteger  redrawGenerations[XRGRedrawPartCount];
+    BOOL        hasRedrawGeneration[XRGRedrawPartCount];
+    
+    // Graph points, kept between draws so a frame doesn't allocate.
+    NSPoint     *pointBuffer;
+    size_t      pointBufferCapacity;
+    
+    // Per-slot data sets for historyOfDataSet:, their values and the summary buckets, reused between draws.
+    NSMutableArray<XRGDataSet *>    *historyDataSets;
+    NSMutableArray<NSMutableData *> *historyValues;
+    NSMutableData                   *historyBuckets;
+    BOOL                             drawsHistory;      // historyOfDataSet: has been asked for a span.
+}
+@end
 
 @implementation XRGGenericView
 
@@ -38,9 +57,16 @@
     return self;
 }
 
+- (void)dealloc {
+    free(pointBuffer);
+}
+
 - (void)awakeFromNib {
     [super awakeFromNib];
     
+    // When the background view gives the modules layers (see setModulesLayerBacked:), only redraw this one's when it's invalidated.
+    self.layerContentsRedrawPolicy = NSViewLayerContentsRedrawOnSetNeedsDisplay;
+    
     NSRect textRect = NSInsetRect(self.bounds, 3, 0);
     
     self.leftLabel = [[XRGNonInteractableTextField alloc] initWithFrame:textRect];
@@ -72,55 +98,89 @@
 }
 
 - (void)setLabelRects:(NSRect)newRect {
+    if (NSEqualRects(self.leftLabel.frame, newRect)) return;
+    
     self.leftLabel.frame = newRect;
     self.centerLabel.frame = newRect;
     self.rightLabel.frame = newRect;
 }
 
+// Setting a label's value redisplays it even if nothing changed, which would undo a partial invalidation.
+- (void)setLabel:(NSTextField *)label string:(NSString *)string attributes:(NSDictionary *)attributes {
+    NSAttributedString *attributedString = [[XRGLabelCache shared] attributedString:string ?: @"" attributes:attributes];
+    if ([label.attributedStringValue isEqualToAttributedString:attributedString]) return;
+    
+    label.attributedStringValue = attributedString;
+}
+
 - (void)drawGraphWithData:(CGFloat *)samples size:(NSInteger)nSamples currentIndex:(NSInteger)cIndex maxValue:(CGFloat)max inRect:(NSRect)rect flipped:(BOOL)flipped color:(NSColor *)color {
     // call drawRangedGraphWithData to avoid a lot of code duplication.
     [self drawRangedGraphWithData:samples size:nSamples currentIndex:cIndex upperBound:max lowerBound:0 inRect:rect flipped:flipped filled:YES color:color];
 }
 
 - (void)drawGraphWithDataFromDataSet:(XRGDataSet *)dataSet maxValue:(CGFloat)max inRect:(NSRect)rect flipped:(BOOL)flipped filled:(BOOL)filled color:(NSColor *)color {
-    size_t numVals = [dataSet numValues];
-    CGFloat *values = alloca(numVals * sizeof(CGFloat));
-    [dataSet valuesInOrder:values];
-
-    // call drawRangedGraphWithData to avoid a lot of code duplication.
-    [self drawRangedGraphWithData:values size:numVals currentIndex:numVals - 1 upperBound:max lowerBound:0 inRect:rect flipped:flipped filled:filled color:color];
+    // Draw straight from the data set's storage rather than copying it into order first.
+    [self drawRangedGraphWithSpans:[dataSet orderedSpans] upperBound:max lowerBound:0 inRect:rect flipped:flipped filled:filled color:color];
 }
 
 
 // Adapted from original drawGraphWithData, but added UpperBound and LowerBound in place of Max, and Filled
 - (void)drawRangedGraphWithData:(CGFloat *)samples size:(NSInteger)nSamples currentIndex:(NSInteger)cIndex upperBound:(CGFloat)max lowerBound:(CGFloat)min inRect:(NSRect)rect flipped:(BOOL)flipped filled:(BOOL)filled color:(NSColor *)color {
 	if (nSamples == 0) return;
+    
+    // samples is a ring with the newest value at cIndex, so the oldest values start right after it.
+    XRGDataSetSpans spans;
+    spans.older = samples + cIndex + 1;
+    spans.olderCount = nSamples - cIndex - 1;
+    spans.newer = samples;
+    spans.newerCount = cIndex + 1;
+    
+    [self drawRangedGraphWithSpans:spans upperBound:max lowerBound:min inRect:rect flipped:flipped filled:filled color:color];
+}
+
+// The point for value at x, clamped to rect.  origin is the graph's baseline and scale is negative for a flipped graph.
+static inline NSPoint XRGGraphPoint(CGFloat x, CGFloat value, CGFloat min, CGFloat scale, NSPoint origin, NSRect rect) {
+    CGFloat height = value - min;
+    CGFloat height_scaled = (height >=  0.0f ? height * scale : 0.0f);
+
+    if (height_scaled + origin.y < rect.origin.y) {
+        return NSMakePoint(x, rect.origin.y);
+    }
+    else if (height_scaled + origin.y > rect.origin.y + rect.size.height) {
+        return NSMakePoint(x, rect.origin.y + rect.size.height);
+    }
+    else {
+        return NSMakePoint(x, height_scaled + origin.y);
+    }
+}
+
+- (void)drawRangedGraphWithSpans:(XRGDataSetSpans)spans upperBound:(CGFloat)max lowerBound:(CGFloat)min inRect:(NSRect)rect flipped:(BOOL)flipped filled:(BOOL)filled color:(NSColor *)color {
+    NSInteger nSamples = spans.olderCount + spans.newerCount;
+	if (nSamples == 0) return;
 	
-    NSInteger filledOffset = 0;
     NSInteger currentPointIndex;
 
     NSPoint origin = rect.origin;
     if (flipped) origin.y += rect.size.height;
 
-    NSPoint *points;
-    if (filled) {
-        // Allocate points on to the stack, so we don't have to free (also much cheaper than malloc)
-        points = (NSPoint *)alloca((nSamples+2)*sizeof(NSPoint));
+    // With more samples than pixel columns, reduce them to about one point per column first so the path stays
+    // O(pixels): the max of each column for a filled graph (so spikes still show), LTTB for a line.
+    NSInteger pixelColumns = [self pixelColumnsInRect:rect];
+    BOOL decimate = pixelColumns > 1 && nSamples > pixelColumns;
+    NSInteger nPoints = decimate ? pixelColumns : nSamples;
 
+    NSPoint *points = [self pointBufferWithCount:nPoints + 2];
+    if (!points) return;
+    if (filled) {
         points[0] = origin;
-        points[nSamples+1] = NSMakePoint(origin.x + rect.size.width, origin.y);
+        currentPointIndex = 1;
     }
     else {
-        // Allocate points on to the stack, so we don't have to free (also much cheaper than malloc)
-        points = (NSPoint *)alloca(nSamples * sizeof(NSPoint));
-        filledOffset = 1;
+        currentPointIndex = 0;
     }
 
-    NSInteger i, j;
-    CGFloat height;
-    CGFloat height_scaled;
     CGFloat dx = rect.size.width / nSamples;
-    CGFloat x;
+    CGFloat x = origin.x;
 	
 	if (fabs(max - min) < 0.001) {
 		// Set the difference of max and min to 1 to avoid a divide by 0.
@@ -131,62 +191,274 @@
     CGFloat scale = rect.size.height / (max - min);
     if (flipped) scale *= -1.0f;
 
-    for (i = currentPointIndex = 1 - filledOffset, x= origin.x; i <= nSamples - filledOffset; ++i, x+=dx) {
-        j = (i + cIndex + filledOffset) % nSamples;
+    if (decimate && filled) {
+        XRGDecimationColumn *columns = (XRGDecimationColumn *)alloca(pixelColumns * sizeof(XRGDecimationColumn));
+        XRGDecimateMinMax(spans.older, spans.olderCount, spans.newer, spans.newerCount, NOVALUE, columns, pixelColumns);
         
-        if (samples[j] != NOVALUE) {
-            height = samples[j] - min;
-            height_scaled = (height >=  0.0f ? height * scale : 0.0f);
-
-            if (height_scaled + origin.y < rect.origin.y) {
-                points[currentPointIndex++] = NSMakePoint(x, rect.origin.y);
-            }
-            else if (height_scaled + origin.y > rect.origin.y + rect.size.height) {
-                points[currentPointIndex++] = NSMakePoint(x, rect.origin.y + rect.size.height);
-            }
-            else {
-                points[currentPointIndex++] = NSMakePoint(x, height_scaled + origin.y);
+        CGFloat columnWidth = rect.size.width / pixelColumns;
+        for (NSInteger c = 0; c < pixelColumns; c++, x += columnWidth) {
+            if (columns[c].count) points[currentPointIndex++] = XRGGraphPoint(x, columns[c].max, min, scale, origin, rect);
+        }
+    }
+    else if (decimate) {
+        size_t *indices = (size_t *)alloca(pixelColumns * sizeof(size_t));
+        size_t kept = XRGDecimateLTTB(spans.older, spans.olderCount, spans.newer, spans.newerCount, NOVALUE, pixelColumns, indices);
+        
+        for (size_t k = 0; k < kept; k++) {
+            size_t i = indices[k];
+            CGFloat value = i < spans.olderCount ? spans.older[i] : spans.newer[i - spans.olderCount];
+            points[currentPointIndex++] = XRGGraphPoint(origin.x + i * dx, value, min, scale, origin, rect);
+        }
+    }
+    else {
+        // Walk the older span and then the newer span, oldest value on the left.
+        const CGFloat *segments[2] = { spans.older, spans.newer };
+        size_t segmentCounts[2] = { spans.olderCount, spans.newerCount };
+        for (NSInteger s = 0; s < 2; s++) {
+            const CGFloat *segment = segments[s];
+            
+            for (size_t i = 0; i < segmentCounts[s]; ++i, x += dx) {
+                if (segment[i] != NOVALUE) {
+                    points[currentPointIndex++] = XRGGraphPoint(x, segment[i], min, scale, origin, rect);
+                }
             }
         }
     }
+    if (currentPointIndex == 0) return;
+    
     // close any gap at the edge of the graph resulting from floating point rounding of dx
     points[currentPointIndex - 1].x = origin.x + rect.size.width;
     
     if (filled) points[currentPointIndex] = NSMakePoint(origin.x + rect.size.width, origin.y);
 
     [color set];
-    NSBezierPath *bp = [NSBezierPath bezierPath];
-    [bp appendBezierPathWithPoints:points count:(currentPointIndex + (1 - filledOffset))];
+    [self addPathWithPoints:points count:(currentPointIndex + (filled ? 1 : 0)) filled:filled];
+}
+
+// Fills or strokes the polyline through points in the current context.  Built straight into the CGContext so there's no
+// NSBezierPath to create and throw away each frame.
+- (void)addPathWithPoints:(const NSPoint *)points count:(size_t)count filled:(BOOL)filled {
+    CGContextRef gc = [NSGraphicsContext currentContext].CGContext;
+    
+    CGContextSaveGState(gc);
+    CGContextBeginPath(gc);
+    CGContextAddLines(gc, points, count);
     if (filled) {
-        [bp setLineWidth:0.0f];
-        [bp setFlatness: 0.6f];
-        [bp closePath];
-        [bp fill];
+        CGContextSetFlatness(gc, 0.6f);
+        CGContextClosePath(gc);
+        CGContextFillPath(gc);
     }
     else {
-        [bp setLineWidth:1.2f];
-        [bp setFlatness: 10.0f];
-        [bp setLineCapStyle:NSRoundLineCapStyle];
-        [bp setLineJoinStyle:NSRoundLineJoinStyle];
-        [bp stroke];
-	}
+        CGContextSetLineWidth(gc, 1.2f);
+        CGContextSetFlatness(gc, 10.0f);
+        CGContextSetLineCap(gc, kCGLineCapRound);
+        CGContextSetLineJoin(gc, kCGLineJoinRound);
+        CGContextStrokePath(gc);
+    }
+    CGContextRestoreGState(gc);
+}
+
+- (NSPoint *)pointBufferWithCount:(size_t)count {
+    if (count > pointBufferCapacity) {
+        size_t capacity = MAX(count, pointBufferCapacity * 2);
+        NSPoint *buffer = realloc(pointBuffer, capacity * sizeof(NSPoint));
+        if (!buffer) return NULL;
+        
+        pointBuffer = buffer;
+        pointBufferCapacity = capacity;
+    }
+    return pointBuffer;
+}
+
+- (NSInteger)pixelColumnsInRect:(NSRect)rect {
+    CGFloat backingScale = self.window.backingScaleFactor ?: 1.0;
+    return (NSInteger)ceil(rect.size.width * backingScale);
+}
+
+- (size_t)historySampleCount {
+    switch (appSettings.graphHistorySpan) {
+        case XRGGraphHistorySpanHour:
+            return (size_t)ceil(60 * 60 / MAX(appSettings.graphRefresh, 0.2));
+        case XRGGraphHistorySpanDay:
+            return (size_t)ceil(24 * 60 * 60 / MAX(appSettings.graphRefresh, 0.2));
+        default:
+            return 0;
+    }
+}
+
+- (XRGDataSet *)historyOfDataSet:(XRGDataSet *)dataSet lastSamples:(size_t)numSamples inRect:(NSRect)rect slot:(NSUInteger)slot {
+    NSInteger columns = [self pixelColumnsInRect:rect];
+    if (numSamples) drawsHistory = YES;
+    if (!dataSet || columns <= 0 || numSamples == 0) return dataSet;
+    
+    if (!historyDataSets) {
+        historyDataSets = [NSMutableArray array];
+        historyValues = [NSMutableArray array];
+        historyBuckets = [NSMutableData data];
+    }
+    while (historyDataSets.count <= slot) {
+        [historyDataSets addObject:[[XRGDataSet alloc] init]];
+        [historyValues addObject:[NSMutableData data]];
+    }
+    
+    XRGDataSet *history = historyDataSets[slot];
+    NSMutableData *valueData = historyValues[slot];
+    
+    // An archive that can hold the whole span is decoded losslessly, and the drawing decimates it like any other
+    // data set.  The part of the span from before the archive started is left out of the graph.
+    if (dataSet.archivedSampleCount && dataSet.archiveCapacity >= numSamples) {
+        if (valueData.length < numSamples * sizeof(CGFloat)) valueData.length = numSamples * sizeof(CGFloat);
+        CGFloat *values = valueData.mutableBytes;
+        
+        size_t archived = MIN(numSamples, dataSet.archivedSampleCount);
+        XRGVectorFill(NOVALUE, values, numSamples - archived);
+        [dataSet decodeLastArchivedValues:archived into:values + (numSamples - archived)];
+        
+        [history setExternalValues:values count:numSamples currentIndex:(NSInteger)numSamples - 1];
+        return history;
+    }
+    
+    if (historyBuckets.length < columns * sizeof(XRGDataSetBucket)) historyBuckets.length = columns * sizeof(XRGDataSetBucket);
+    XRGDataSetBucket *buckets = historyBuckets.mutableBytes;
+    [dataSet summarizeLastSamples:numSamples intoBuckets:buckets count:(size_t)columns];
+    
+    if (valueData.length < columns * sizeof(CGFloat)) valueData.length = columns * sizeof(CGFloat);
+    CGFloat *values = valueData.mutableBytes;
+    
+    // The column's peak, so a burst doesn't get averaged away; slices with no history yet are left out of the graph.
+    for (NSInteger c = 0; c < columns; c++) {
+        values[c] = buckets[c].count ? buckets[c].max : NOVALUE;
+    }
+    
+    [history setExternalValues:values count:(size_t)columns currentIndex:columns - 1];
+    return history;
+}
+
+- (NSMenuItem *)graphSpanMenuItem {
+    NSMenu *spanMenu = [[NSMenu alloc] initWithTitle:@"Graph Span"];
+    NSArray *titles = @[@"Window Width", @"Last Hour", @"Last 24 Hours"];
+    NSArray *spans = @[@(XRGGraphHistorySpanWindow), @(XRGGraphHistorySpanHour), @(XRGGraphHistorySpanDay)];
+    for (NSUInteger i = 0; i < titles.count; i++) {
+        NSInteger span = [spans[i] integerValue];
+        NSMenuItem *item = [[NSMenuItem alloc] initWithTitle:titles[i] action:@selector(setGraphHistorySpan:) keyEquivalent:@""];
+        item.target = parentWindow;
+        item.tag = span;
+        item.state = (appSettings.graphHistorySpan == span) ? NSOnState : NSOffState;
+        [spanMenu addItem:item];
+    }
+    
+    NSMenuItem *spanItem = [[NSMenuItem alloc] initWithTitle:@"Graph Span" action:nil keyEquivalent:@""];
+    spanItem.submenu = spanMenu;
+    return spanItem;
+}
+
+- (CGFloat)maxOfStackedDataSets:(NSArray<XRGDataSet *> *)dataSets {
+    NSUInteger layerCount = dataSets.count;
+    if (layerCount == 0) return 0;
+    
+    size_t nSamples = dataSets[0].numValues;
+    XRGDataSetSpans *spans = alloca(layerCount * sizeof(XRGDataSetSpans));
+    for (NSUInteger layer = 0; layer < layerCount; layer++) {
+        if (dataSets[layer].numValues != nSamples) return 0;
+        spans[layer] = [dataSets[layer] orderedSpans];
+    }
+    
+    CGFloat max = 0;
+    for (size_t i = 0; i < nSamples; i++) {
+        CGFloat total = 0;
+        for (NSUInteger layer = 0; layer < layerCount; layer++) {
+            const XRGDataSetSpans *s = &spans[layer];
+            CGFloat value = i < s->olderCount ? s->older[i] : s->newer[i - s->olderCount];
+            if (value != NOVALUE) total += value;
+        }
+        if (total > max) max = total;
+    }
+    return max;
+}
+
+- (void)drawStackedGraphWithDataSets:(NSArray<XRGDataSet *> *)dataSets colors:(NSArray<NSColor *> *)colors upperBound:(CGFloat)max lowerBound:(CGFloat)min inRect:(NSRect)rect flipped:(BOOL)flipped {
+    NSUInteger layerCount = dataSets.count;
+    if (layerCount == 0 || colors.count != layerCount) return;
+    
+    NSInteger nSamples = dataSets[0].numValues;
+    for (XRGDataSet *dataSet in dataSets) {
+        if ((NSInteger)dataSet.numValues != nSamples) return;
+    }
+    if (nSamples == 0) return;
+    
+    XRGDataSetSpans *spans = alloca(layerCount * sizeof(XRGDataSetSpans));
+    for (NSUInteger layer = 0; layer < layerCount; layer++) {
+        spans[layer] = [dataSets[layer] orderedSpans];
+    }
+    
+    NSPoint origin = rect.origin;
+    if (flipped) origin.y += rect.size.height;
+    
+    if (fabs(max - min) < 0.001) {
+        // Set the difference of max and min to 1 to avoid a divide by 0.
+        max += 0.5;
+        min -= 0.5;
+    }
+    
+    CGFloat scale = rect.size.height / (max - min);
+    if (flipped) scale *= -1.0f;
+    
+    // One column per sample, or per pixel if there are more samples than pixels, in which case each layer takes the
+    // max of its running total over the column.
+    NSInteger pixelColumns = [self pixelColumnsInRect:rect];
+    NSInteger nColumns = (pixelColumns > 1 && nSamples > pixelColumns) ? pixelColumns : nSamples;
+    size_t rowLength = nColumns + 2;
+    NSPoint *points = [self pointBufferWithCount:layerCount * rowLength];
+    if (!points) return;
+    
+    CGFloat *totals = alloca(layerCount * sizeof(CGFloat));
+    CGFloat dx = rect.size.width / nColumns;
+    
+    // One pass over the samples fills in every layer's row; the x coordinates are shared.
+    for (NSInteger c = 0; c < nColumns; c++) {
+        CGFloat x = (c == nColumns - 1) ? origin.x + rect.size.width : origin.x + c * dx;
+        for (NSUInteger layer = 0; layer < layerCount; layer++) totals[layer] = -CGFLOAT_MAX;
+        
+        NSInteger start = (NSInteger)((long long)c * nSamples / nColumns);
+        NSInteger end = (NSInteger)((long long)(c + 1) * nSamples / nColumns);
+        for (NSInteger i = start; i < end; i++) {
+            CGFloat runningTotal = 0;
+            for (NSUInteger layer = 0; layer < layerCount; layer++) {
+                const XRGDataSetSpans *s = &spans[layer];
+                CGFloat value = (size_t)i < s->olderCount ? s->older[i] : s->newer[i - s->olderCount];
+                if (value != NOVALUE) runningTotal += value;
+                if (runningTotal > totals[layer]) totals[layer] = runningTotal;
+            }
+        }
         
-    [bp removeAllPoints];
+        for (NSUInteger layer = 0; layer < layerCount; layer++) {
+            points[layer * rowLength + 1 + c] = XRGGraphPoint(x, totals[layer], min, scale, origin, rect);
+        }
+    }
+    
+    // Topmost layer first; each one below paints over its lower part.  A layer the same color as the one above it is
+    // already covered.
+    for (NSInteger layer = (NSInteger)layerCount - 1; layer >= 0; layer--) {
+        if (layer < (NSInteger)layerCount - 1 && [colors[layer] isEqual:colors[layer + 1]]) continue;
+        
+        NSPoint *row = points + layer * rowLength;
+        row[0] = origin;
+        row[nColumns + 1] = NSMakePoint(origin.x + rect.size.width, origin.y);
+        
+        [colors[layer] set];
+        [self addPathWithPoints:row count:rowLength filled:YES];
+    }
 }
 
 - (void)drawRangedGraphWithDataFromDataSet:(XRGDataSet *)dataSet upperBound:(CGFloat)max lowerBound:(CGFloat)min inRect:(NSRect)rect flipped:(BOOL)flipped filled:(BOOL)filled color:(NSColor *)color {
-    size_t numVals = [dataSet numValues];
-    CGFloat *values = alloca(numVals * sizeof(CGFloat));
-    [dataSet valuesInOrder:values];
-	
-    // call drawRangedGraphWithData to avoid a lot of code duplication.
-	[self drawRangedGraphWithData:values size:numVals currentIndex:numVals - 1 upperBound:max lowerBound:min inRect:rect flipped:flipped filled:filled color:color];
+    // call drawRangedGraphWithSpans to avoid a lot of code duplication.
+	[self drawRangedGraphWithSpans:[dataSet orderedSpans] upperBound:max lowerBound:min inRect:rect flipped:flipped filled:filled color:color];
 }
 
 - (void)drawMiniGraphWithValues:(NSArray<NSNumber *> *)values upperBound:(double)max lowerBound:(double)min leftLabel:(NSString *)leftLabel printValueBytes:(UInt64)printValue printValueIsRate:(BOOL)isRate {
     NSString *rightLabel = nil;
     
-    rightLabel = [NSString stringWithFormat:@"%@%@", [XRGCommon formattedStringForBytes:printValue], isRate ? @"/s" : @""];
+    rightLabel = [XRGCommon formattedStringForBytes:printValue suffix:(isRate ? "/s" : NULL)];
 
     [self drawMiniGraphWithValues:values upperBound:max lowerBound:min leftLabel:leftLabel rightLabel:rightLabel];
 }
@@ -259,9 +531,9 @@
         adjustedRect.origin.y -= 0.5 * (rect.size.height - textRectHeight);
         
         [self setLabelRects:adjustedRect];
-        self.leftLabel.attributedStringValue = left ? [[NSAttributedString alloc] initWithString:left attributes:[appSettings alignLeftAttributes]] : nil;
-        self.centerLabel.attributedStringValue = center ? [[NSAttributedString alloc] initWithString:center attributes:[appSettings alignCenterAttributes]] : nil;
-        self.rightLabel.attributedStringValue = right ? [[NSAttributedString alloc] initWithString:right attributes:[appSettings alignRightAttributes]] : nil;
+        [self setLabel:self.leftLabel string:left attributes:[appSettings alignLeftAttributes]];
+        [self setLabel:self.centerLabel string:center attributes:[appSettings alignCenterAttributes]];
+        [self setLabel:self.rightLabel string:right attributes:[appSettings alignRightAttributes]];
     }
     else {
         // Draw as many lines as we can, aligned to the top.
@@ -269,31 +541,12 @@
         
         [self setLabelRects:rect];
 
-        if (leftLines.count > 0) {
-            NSArray<NSString *> *showLines = [leftLines subarrayWithRange:NSMakeRange(0, MIN(leftLines.count, maxDisplayLines))];
-            NSString *joined = [showLines componentsJoinedByString:@"\n"];
-            self.leftLabel.attributedStringValue = [[NSAttributedString alloc] initWithString:joined attributes:[appSettings alignLeftAttributes]];
-        }
-        else {
-            self.leftLabel.stringValue = @"";
-        }
-        
-        if (centerLines.count > 0) {
-            NSArray<NSString *> *showLines = [centerLines subarrayWithRange:NSMakeRange(0, MIN(centerLines.count, maxDisplayLines))];
-            NSString *joined = [showLines componentsJoinedByString:@"\n"];
-            self.centerLabel.attributedStringValue = [[NSAttributedString alloc] initWithString:joined attributes:[appSettings alignCenterAttributes]];
-        }
-        else {
-            self.centerLabel.stringValue = @"";
-        }
-
-        if (rightLines.count > 0) {
-            NSArray<NSString *> *showLines = [rightLines subarrayWithRange:NSMakeRange(0, MIN(rightLines.count, maxDisplayLines))];
-            NSString *joined = [showLines componentsJoinedByString:@"\n"];
-            self.rightLabel.attributedStringValue = [[NSAttributedString alloc] initWithString:joined attributes:[appSettings alignRightAttributes]];
-        } else {
-            self.rightLabel.stringValue = @"";
-        }
+        NSString *left = [[leftLines subarrayWithRange:NSMakeRange(0, MIN(leftLines.count, maxDisplayLines))] componentsJoinedByString:@"\n"];
+        NSString *center = [[centerLines subarrayWithRange:NSMakeRange(0, MIN(centerLines.count, maxDisplayLines))] componentsJoinedByString:@"\n"];
+        NSString *right = [[rightLines subarrayWithRange:NSMakeRange(0, MIN(rightLines.count, maxDisplayLines))] componentsJoinedByString:@"\n"];
+        [self setLabel:self.leftLabel string:left attributes:[appSettings alignLeftAttributes]];
+        [self setLabel:self.centerLabel string:center attributes:[appSettings alignCenterAttributes]];
+        [self setLabel:self.rightLabel string:right attributes:[appSettings alignRightAttributes]];
     }
     
     [gc setShouldAntialias:[appSettings antiAliasing]];
@@ -307,6 +560,64 @@
     return NSInsetRect(self.bounds, 3, 0);
 }
 
+- (NSRect)textRectForLineCount:(NSInteger)lineCount {
+    NSRect bounds = self.bounds;
+    CGFloat height = MIN(bounds.size.height, MAX(lineCount, 0) * [appSettings textRectHeight]);
+    return NSMakeRect(bounds.origin.x, NSMaxY(bounds) - height, bounds.size.width, height);
+}
+
+// A graph drawn from the archive or tiers keeps scrolling while the raw values it's gated on are flat.
+- (BOOL)isDrawingHistory {
+    return drawsHistory && [self historySampleCount] && ![self shouldDrawMiniGraph];
+}
+
+// Remembers generation for part, and returns YES if it's different from last time, or if it's the graph part and the
+// graph is drawn from history.
+- (BOOL)takeRedrawGeneration:(NSUInteger)generation part:(XRGRedrawPart)part {
+    if (part < 0 || part >= XRGRedrawPartCount) return NO;
+    if (hasRedrawGeneration[part] && redrawGenerations[part] == generation && !(part == XRGRedrawPartGraph && [self isDrawingHistory])) return NO;
+    
+    redrawGenerations[part] = generation;
+    hasRedrawGeneration[part] = YES;
+    return YES;
+}
+
+- (void)invalidateChangedRect:(NSRect)rect {
+    BOOL wholeView = NSContainsRect(rect, self.bounds);
+    [[XRGDiagnostics shared] recordRedraw:wholeView ? XRGDiagnosticsRedrawFull : XRGDiagnosticsRedrawPartial module:XRGDiagnosticsModuleForObject(self)];
+    
+    if (wholeView) [self setNeedsDisplay:YES];
+    else           [self setNeedsDisplayInRect:rect];
+}
+
+- (BOOL)setNeedsDisplayInRect:(NSRect)rect forGeneration:(NSUInteger)generation part:(XRGRedrawPart)part {
+    if (![self takeRedrawGeneration:generation part:part]) {
+        [[XRGDiagnostics shared] recordRedraw:XRGDiagnosticsRedrawAvoided module:XRGDiagnosticsModuleForObject(self)];
+        return NO;
+    }
+    
+    [self invalidateChangedRect:rect];
+    return YES;
+}
+
+- (BOOL)setNeedsDisplayForGeneration:(NSUInteger)generation textGeneration:(NSUInteger)textGeneration textRect:(NSRect)textRect {
+    // Both are taken every time so neither is left stale.
+    BOOL graphChanged = [self takeRedrawGeneration:generation part:XRGRedrawPartGraph];
+    BOOL textChanged = [self takeRedrawGeneration:textGeneration part:XRGRedrawPartText];
+    
+    if (graphChanged)     [self invalidateChangedRect:self.bounds];
+    else if (textChanged) [self invalidateChangedRect:textRect];
+    else                  [[XRGDiagnostics shared] recordRedraw:XRGDiagnosticsRedrawAvoided module:XRGDiagnosticsModuleForObject(self)];
+    
+    return graphChanged || textChanged;
+}
+
+- (NSUInteger)graphGeneration {
+    // Redrawn every tick, so there's no generation to tell when it's idle.
+    if ([self isDrawingHistory]) return NSNotFound;
+    return hasRedrawGeneration[XRGRedrawPartGraph] ? redrawGenerations[XRGRedrawPartGraph] : NSNotFound;
+}
+
 // The following methods are to be implemented in subclasses.
 - (void)setGraphSize:(NSSize)newSize {
 #ifdef XRG_DEBUG
@@ -344,4 +655,61 @@
 #endif
 }
 
+#pragma mark - Benchmark
+
++ (NSString *)graphBenchmarkReport {
+    static const NSInteger widths[] = { 100, 200, 400, 800, 1600 };
+    const NSInteger frames = 200;
+    const NSInteger height = 60;
+    NSArray<NSColor *> *colors = @[[NSColor redColor], [NSColor greenColor], [NSColor blueColor]];
+    
+    NSMutableString *report = [NSMutableString stringWithFormat:@"Graph path build and fill, microseconds per frame (%ld frames, %ldpt high)\n", (long)frames, (long)height];
+    [report appendFormat:@"%8s %8s %10s %10s %10s\n", "Width", "Samples", "Filled", "Line", "Stacked x3"];
+    
+    for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); w++) {
+        // One sample per point, then four, which is decimated.
+        for (NSInteger samplesPerPoint = 1; samplesPerPoint <= 4; samplesPerPoint *= 4) {
+            @autoreleasepool {
+                NSInteger width = widths[w];
+                NSInteger numSamples = width * samplesPerPoint;
+                
+                NSMutableArray<XRGDataSet *> *dataSets = [NSMutableArray array];
+                for (NSInteger layer = 0; layer < 3; layer++) {
+                    XRGDataSet *dataSet = [[XRGDataSet alloc] init];
+                    [dataSet resize:numSamples];
+                    for (NSInteger i = 0; i < numSamples; i++) [dataSet setNextValue:arc4random_uniform(3300) / 100.];
+                    [dataSets addObject:dataSet];
+                }
+                
+                NSBitmapImageRep *bitmap = [[NSBitmapImageRep alloc] initWithBitmapDataPlanes:NULL pixelsWide:width pixelsHigh:height bitsPerSample:8 samplesPerPixel:4 hasAlpha:YES isPlanar:NO colorSpaceName:NSCalibratedRGBColorSpace bytesPerRow:0 bitsPerPixel:0];
+                XRGGenericView *view = [[XRGGenericView alloc] initWithFrame:NSMakeRect(0, 0, width, height)];
+                NSRect rect = view.bounds;
+                
+                [NSGraphicsContext saveGraphicsState];
+                [NSGraphicsContext setCurrentContext:[NSGraphicsContext graphicsContextWithBitmapImageRep:bitmap]];
+                
+                double microseconds[3];
+                for (NSInteger kind = 0; kind < 3; kind++) {
+                    uint64_t start = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+                    for (NSInteger frame = 0; frame < frames; frame++) {
+                        if (kind == 2) {
+                            [view drawStackedGraphWithDataSets:dataSets colors:colors upperBound:100 lowerBound:0 inRect:rect flipped:NO];
+                        }
+                        else {
+                            [view drawRangedGraphWithDataFromDataSet:dataSets[0] upperBound:100 lowerBound:0 inRect:rect flipped:NO filled:(kind == 0) color:colors[0]];
+                        }
+                    }
+                    microseconds[kind] = (double)(clock_gettime_nsec_np(CLOCK_UPTIME_RAW) - start) / 1e3 / frames;
+                }
+                
+                [NSGraphicsContext restoreGraphicsState];
+                
+                [report appendFormat:@"%8ld %8ld %10.1f %10.1f %10.1f\n", (long)width, (long)numSamples, microseconds[0], microseconds[1], microseconds[2]];
+            }
+        }
+    }
+    
+    return report;
+}
+
 @end
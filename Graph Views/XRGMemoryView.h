@@ -28,8 +28,9 @@
 #import "XRGGenericView.h"
 #import "XRGMemoryMiner.h"
 #import "XRGProcessMiner.h"
+#import "XRGSampler.h"
 
-@interface XRGMemoryView : XRGGenericView
+@interface XRGMemoryView : XRGGenericView <XRGSampledView>
 {
 @private
     NSSize						graphSize;
@@ -43,5 +44,7 @@
 - (void)setWidth:(int)newWidth;
 - (void)updateMinSize;
 - (void)graphUpdate:(NSTimer *)aTimer;
+/// Tells the miner's history file the current graph refresh.
+- (void)updateHistoryStorage;
 
 @end
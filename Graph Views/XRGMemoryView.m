@@ -26,6 +26,7 @@
 
 
 #import "XRGMemoryView.h"
+#import "XRGDiagnostics.h"
 #import "XRGGraphWindow.h"
 #import "XRGCommon.h"
 
@@ -42,6 +43,7 @@
     [parentWindow initTimers]; 
     appSettings = [parentWindow appSettings]; 
     moduleManager = [parentWindow moduleManager];
+    [self updateHistoryStorage];
                                      
     textRectHeight = [appSettings textRectHeight];
     
@@ -59,6 +61,10 @@
     [self setGraphSize:[m currentSize]];
 }
 
+- (void)updateHistoryStorage {
+    memoryMiner.historyInterval = [appSettings graphRefresh];
+}
+
 - (void)setGraphSize:(NSSize)newSize {
     NSSize tmpSize;
     tmpSize.width = newSize.width;
@@ -79,18 +85,37 @@
 }
 
 - (void)updateMinSize {    
-    [m setMinWidth: [@"W: 9999M" sizeWithAttributes:[appSettings alignRightAttributes]].width + 19 + 6];
+    [m setMinWidth: [[XRGLabelCache shared] sizeOfString:@"W: 9999M" attributes:[appSettings alignRightAttributes]].width + 19 + 6];
     [m setMinHeight: [appSettings textRectHeight]];
 }
 
 - (void)graphUpdate:(NSTimer *)aTimer {
-    [memoryMiner getLatestMemoryInfo];
+    [self applyGraphSample:[[XRGSampler shared] collectSynchronouslyForModule:XRGStatsModuleNameMemory block:^id{
+        return [self collectGraphSample];
+    }]];
+}
+
+- (XRGStatsModule)samplingModule {
+    return XRGStatsModuleNameMemory;
+}
+
+- (id)collectGraphSample {
+    return [memoryMiner collectSample];
+}
+
+- (void)applyGraphSample:(XRGMemorySample *)sample {
+    [self applyGraphSample:sample span:1];
+}
+
+- (void)applyGraphSample:(XRGMemorySample *)sample span:(NSUInteger)span {
+    [memoryMiner applySample:sample span:span];
     
-    [self setNeedsDisplay:YES];
+    [self setNeedsDisplayInRect:self.bounds forGeneration:memoryMiner.changeGeneration part:XRGRedrawPartGraph];
 }
 
 - (void)drawRect:(NSRect)rect {
     if ([self isHidden]) return;
+    XRG_DIAGNOSTICS_SCOPE(XRGStatsModuleNameMemory, XRGDiagnosticsPhaseDraw);
 
     NSGraphicsContext *gc = [NSGraphicsContext currentContext];
 
@@ -118,18 +143,8 @@
         
         NSRect graphRect = NSMakeRect(0, 0, numSamples, graphSize.height);
     
-        XRGDataSet *tmpDataSet = [[XRGDataSet alloc] initWithContentsOfOtherDataSet:[memoryMiner faultData]];
-        [tmpDataSet addOtherDataSetValues:[memoryMiner pageInData]];
-        [tmpDataSet addOtherDataSetValues:[memoryMiner pageOutData]];
-        
-        [self drawGraphWithDataFromDataSet:tmpDataSet maxValue:[tmpDataSet max] inRect:graphRect flipped:NO filled:YES color:colors[2]];
-        
-        [tmpDataSet subtractOtherDataSetValues:[memoryMiner pageOutData]];
-        
-        [self drawGraphWithDataFromDataSet:tmpDataSet maxValue:[tmpDataSet max] inRect:graphRect flipped:NO filled:YES color:colors[1]];
-        
-        [self drawGraphWithDataFromDataSet:[memoryMiner faultData] maxValue:[tmpDataSet max] inRect:graphRect flipped:NO filled:YES color:colors[0]];
-        
+        NSArray *pagingData = @[[memoryMiner faultData], [memoryMiner pageInData], [memoryMiner pageOutData]];
+        [self drawStackedGraphWithDataSets:pagingData colors:@[colors[0], colors[1], colors[2]] upperBound:[self maxOfStackedDataSets:pagingData] lowerBound:0 inRect:graphRect flipped:NO];
     }
     
     // draw the immediate memory status
@@ -177,19 +192,19 @@
     [s setString: @"Memory"];
        
     if ([appSettings memoryShowFree]) {
-        [s appendFormat:@"\nF: %@", [XRGCommon formattedStringForBytes:[memoryMiner freeBytes]]];
+        [XRGCommon appendBytes:[memoryMiner freeBytes] toString:s prefix:"\nF: " suffix:NULL];
     }
     
     if ([appSettings memoryShowInactive]) {
-        [s appendFormat:@"\nI: %@", [XRGCommon formattedStringForBytes:[memoryMiner inactiveBytes]]];
+        [XRGCommon appendBytes:[memoryMiner inactiveBytes] toString:s prefix:"\nI: " suffix:NULL];
     }
     
     if ([appSettings memoryShowActive]) {
-        [s appendFormat:@"\nA: %@", [XRGCommon formattedStringForBytes:[memoryMiner activeBytes]]];
+        [XRGCommon appendBytes:[memoryMiner activeBytes] toString:s prefix:"\nA: " suffix:NULL];
     }
     
     if ([appSettings memoryShowWired]) {
-        [s appendFormat:@"\nW: %@", [XRGCommon formattedStringForBytes:[memoryMiner wiredBytes]]];
+        [XRGCommon appendBytes:[memoryMiner wiredBytes] toString:s prefix:"\nW: " suffix:NULL];
     }
     
     if ([appSettings memoryShowCache]) {
@@ -206,8 +221,8 @@
     }
 	
 	// Draw the VM text.
-    [s appendFormat:@"\nVu: %@", [XRGCommon formattedStringForBytes:[memoryMiner usedSwap]]];
-    [s appendFormat:@"\nVt: %@", [XRGCommon formattedStringForBytes:[memoryMiner totalSwap]]];
+    [XRGCommon appendBytes:[memoryMiner usedSwap] toString:s prefix:"\nVu: " suffix:NULL];
+    [XRGCommon appendBytes:[memoryMiner totalSwap] toString:s prefix:"\nVt: " suffix:NULL];
 
     [self drawLeftText:s centerText:nil rightText:nil inRect:[self paddedTextRect]];
     [gc setShouldAntialias:YES];
@@ -28,8 +28,10 @@
 #import "definitions.h"
 #import "XRGGenericView.h"
 #import "XRGNetMiner.h"
+#import "XRGStatsManager.h"
+#import "XRGSampler.h"
 
-@interface XRGNetView : XRGGenericView {   
+@interface XRGNetView : XRGGenericView <XRGSampledView> {   
 @private
     NSSize                  graphSize;
     NSInteger               numSamples;
@@ -37,6 +39,10 @@
     
     NSInteger				fastRXValue;
     NSInteger				fastTXValue;
+    NSUInteger              fastGeneration;         // Increases when the mini graph's values or scale change.
+    
+    XRGStatHandle           rxStatHandle;
+    XRGStatHandle           txStatHandle;
 }
 
 @property XRGNetMiner *miner;
@@ -47,5 +53,7 @@
 - (void)updateMinSize;
 - (NSInteger)convertHeight:(NSInteger) yComponent;
 - (void)graphUpdate:(NSTimer *)aTimer;
+/// Sizes the miner's history for the graph spans to the current graph refresh.
+- (void)updateHistoryStorage;
 
 @end
@@ -26,6 +26,7 @@
 
 #import "XRGGraphWindow.h"
 #import "XRGNetView.h"
+#import "XRGDiagnostics.h"
 #import "XRGCommon.h"
 
 @implementation XRGNetView
@@ -36,13 +37,18 @@
     graphSize = NSMakeSize(90, 112);
     
     self.miner = [[XRGNetMiner alloc] init];
+    self.miner.historyName = @"Network";
     self.fastMiner = [[XRGNetMiner alloc] init];
     
+    rxStatHandle = [[XRGStatsManager shared] handleForKey:@"Received" inModule:XRGStatsModuleNameNetwork];
+    txStatHandle = [[XRGStatsManager shared] handleForKey:@"Sent" inModule:XRGStatsModuleNameNetwork];
+    
     parentWindow = (XRGGraphWindow *)[self window];
     [parentWindow setNetView:self];
     [parentWindow initTimers];  
     appSettings = [parentWindow appSettings];
     moduleManager = [parentWindow moduleManager];
+    [self updateHistoryStorage];
     
     NSUserDefaults *defs = [NSUserDefaults standardUserDefaults];
     m = [[XRGModule alloc] initWithName:@"Network" andReference:self];
@@ -58,21 +64,76 @@
     [self setGraphSize:[m currentSize]];
 }
 
+- (void)updateHistoryStorage {
+    self.miner.historyInterval = [appSettings graphRefresh];
+    self.miner.historySamplesPerMinute = (NSUInteger)ceil(60. / MAX([appSettings graphRefresh], 0.2));
+}
+
 - (void)graphUpdate:(NSTimer *)aTimer {
-    self.miner.monitorNetworkInterface = [appSettings networkInterface];
-    [self.miner getLatestNetInfo];
-    [self setNeedsDisplay: YES];
+    [self applyGraphSample:[[XRGSampler shared] collectSynchronouslyForModule:XRGStatsModuleNameNetwork block:^id{
+        return [self collectGraphSample];
+    }]];
 }
 
 - (void)fastUpdate:(NSTimer *)aTimer {
+    [self applyFastSample:[[XRGSampler shared] collectSynchronouslyForModule:XRGStatsModuleNameNetwork block:^id{
+        return [self collectFastSample];
+    }]];
+}
+
+- (XRGStatsModule)samplingModule {
+    return XRGStatsModuleNameNetwork;
+}
+
+- (id)collectGraphSample {
+    return [self.miner collectSample];
+}
+
+- (void)applyGraphSample:(XRGNetSample *)sample {
+    [self applyGraphSample:sample span:1];
+}
+
+- (void)applyGraphSample:(XRGNetSample *)sample span:(NSUInteger)span {
+    self.miner.monitorNetworkInterface = [appSettings networkInterface];
+    [self.miner applySample:sample span:span];
+    
+    // Only the graph miner is recorded; the fast miner samples at a different rate.
+    [[XRGStatsManager shared] observeStat:self.miner.currentRX forHandle:rxStatHandle];
+    [[XRGStatsManager shared] observeStat:self.miner.currentTX forHandle:txStatHandle];
+    
+    // The totals at the top can change while the graph doesn't.  The mini graph only shows the current rate.
     if ([self shouldDrawMiniGraph]) {
+        [self setNeedsDisplayInRect:self.bounds forGeneration:self.miner.changeGeneration part:XRGRedrawPartGraph];
+    }
+    else {
+        NSInteger textLines = 2 + ([appSettings showTotalBandwidthSinceBoot] ? 1 : 0) + ([appSettings showTotalBandwidthSinceLoad] ? 1 : 0);
+        [self setNeedsDisplayForGeneration:self.miner.changeGeneration textGeneration:self.miner.textGeneration textRect:[self textRectForLineCount:textLines]];
+    }
+}
+
+- (BOOL)wantsFastSample {
+    return [self shouldDrawMiniGraph];
+}
+
+- (id)collectFastSample {
+    return [self.fastMiner collectSample];
+}
+
+- (void)applyFastSample:(XRGNetSample *)sample {
+    if ([self shouldDrawMiniGraph]) {
+        NSUInteger scaleGeneration = self.fastMiner.changeGeneration;
+        NSInteger lastTXValue = fastTXValue;
+        NSInteger lastRXValue = fastRXValue;
+        
         self.fastMiner.monitorNetworkInterface = [appSettings networkInterface];
-        [self.fastMiner getLatestNetInfo];
+        [self.fastMiner applySample:sample];
         
         fastTXValue = [XRGCommon dampedValueUsingPreviousValue:fastTXValue currentValue:self.fastMiner.currentTX];
         fastRXValue = [XRGCommon dampedValueUsingPreviousValue:fastRXValue currentValue:self.fastMiner.currentRX];
         
-        [self setNeedsDisplay: YES];       
+        // Once the damped rates settle, an idle interface stops redrawing.
+        if (fastTXValue != lastTXValue || fastRXValue != lastRXValue || self.fastMiner.changeGeneration != scaleGeneration) fastGeneration++;
+        [self setNeedsDisplayInRect:self.bounds forGeneration:fastGeneration part:XRGRedrawPartFast];
     }
 }
 
@@ -95,12 +156,13 @@
 }
 
 - (void)updateMinSize {
-    [m setMinWidth: [@"N1023K Rx" sizeWithAttributes:[appSettings alignRightAttributes]].width];
+    [m setMinWidth: [[XRGLabelCache shared] sizeOfString:@"N1023K Rx" attributes:[appSettings alignRightAttributes]].width];
     [m setMinHeight: XRG_MINI_HEIGHT];
 }
 
 - (void)drawRect:(NSRect)rect {
     if ([self isHidden]) return;
+    XRG_DIAGNOSTICS_SCOPE(XRGStatsModuleNameNetwork, XRGDiagnosticsPhaseDraw);
 
     #ifdef XRG_DEBUG
         NSLog(@"In Network DrawRect."); 
@@ -119,7 +181,17 @@
 
     NSInteger max, tx, rx;
     NSInteger textRectHeight = [appSettings textRectHeight];
-    max = MAX([self.miner maxBandwidth], [appSettings netMinGraphScale]);
+    
+    XRGDataSet *totalValues = self.miner.totalValues;
+    XRGDataSet *rxValues = self.miner.rxValues;
+    XRGDataSet *txValues = self.miner.txValues;
+    size_t historySamples = [self historySampleCount];
+    if (historySamples) {
+        totalValues = [self historyOfDataSet:totalValues lastSamples:historySamples inRect:bounds slot:0];
+        rxValues = [self historyOfDataSet:rxValues lastSamples:historySamples inRect:bounds slot:1];
+        txValues = [self historyOfDataSet:txValues lastSamples:historySamples inRect:bounds slot:2];
+    }
+    max = MAX(totalValues.max, [appSettings netMinGraphScale]);
 
     NSRect tmpRect = NSMakeRect(0, 0, graphSize.width, textRectHeight * 2);
     tmpRect.origin.x   += 3;
@@ -132,14 +204,14 @@
 
     /* received data */
     if (netGraphMode == 0) {
-        [self drawGraphWithDataFromDataSet:self.miner.totalValues maxValue:max inRect:bounds flipped:(netGraphMode == 2) filled:YES color:[appSettings graphFG2Color]];
+        [self drawGraphWithDataFromDataSet:totalValues maxValue:max inRect:bounds flipped:(netGraphMode == 2) filled:YES color:[appSettings graphFG2Color]];
     }
     else {
-        [self drawGraphWithDataFromDataSet:self.miner.rxValues maxValue:max inRect:bounds flipped:(netGraphMode == 2) filled:YES color:[appSettings graphFG2Color]];
+        [self drawGraphWithDataFromDataSet:rxValues maxValue:max inRect:bounds flipped:(netGraphMode == 2) filled:YES color:[appSettings graphFG2Color]];
     }
 
     /* sent data */
-    [self drawGraphWithDataFromDataSet:self.miner.txValues maxValue:max inRect:bounds flipped:(netGraphMode == 1) filled:YES color:[appSettings graphFG1Color]];
+    [self drawGraphWithDataFromDataSet:txValues maxValue:max inRect:bounds flipped:(netGraphMode == 1) filled:YES color:[appSettings graphFG1Color]];
 
     [gc setShouldAntialias:YES];
 
@@ -147,7 +219,7 @@
     NSMutableString *leftText = [[NSMutableString alloc] init];
     NSMutableString *rightText = [[NSMutableString alloc] init];
 	
-	if ([@"Net1023K Rx" sizeWithAttributes:[appSettings alignRightAttributes]].width + 6 > [self frame].size.width) {
+	if ([[XRGLabelCache shared] sizeOfString:@"Net1023K Rx" attributes:[appSettings alignRightAttributes]].width + 6 > [self frame].size.width) {
 		[leftText appendFormat:@"N"];
 	}
 	else {
@@ -160,7 +232,7 @@
     if (tmpRect.origin.y - textRectHeight > 0) {
         tmpRect.origin.y -= textRectHeight;
         tmpRect.size.height += textRectHeight;
-        [leftText appendFormat:@"\n%@/s", [XRGCommon formattedStringForBytes:max]];
+        [XRGCommon appendBytes:max toString:leftText prefix:"\n" suffix:"/s"];
     }
     
     // draw the total bandwidth used if there is room
@@ -169,7 +241,7 @@
             tmpRect.origin.y -= textRectHeight;
             tmpRect.size.height += textRectHeight;
             UInt64 totalBytesSinceBoot = self.miner.totalBytesSinceBoot;
-            [leftText appendFormat:@"\n%@", [XRGCommon formattedStringForBytes:totalBytesSinceBoot]];
+            [XRGCommon appendBytes:totalBytesSinceBoot toString:leftText prefix:"\n" suffix:NULL];
         }
     }
     if ([appSettings showTotalBandwidthSinceLoad]) {
@@ -177,7 +249,7 @@
             tmpRect.origin.y -= textRectHeight;
             tmpRect.size.height += textRectHeight;
             UInt64 totalBytesSinceLoad = self.miner.totalBytesSinceLoad;
-            [leftText appendFormat:@"\n%@", [XRGCommon formattedStringForBytes:totalBytesSinceLoad]];
+            [XRGCommon appendBytes:totalBytesSinceLoad toString:leftText prefix:"\n" suffix:NULL];
         }
     }
 
@@ -189,10 +261,10 @@
         tmpRect.size.height = textRectHeight * 2;
         
         rx = [self.miner currentRX];
-        [rightText appendFormat:@"%@ Rx", [XRGCommon formattedStringForBytes:rx]];
+        [XRGCommon appendBytes:rx toString:rightText prefix:NULL suffix:" Rx"];
         
         tx = [self.miner currentTX];
-        [rightText appendFormat:@"\n%@ Tx", [XRGCommon formattedStringForBytes:tx]];
+        [XRGCommon appendBytes:tx toString:rightText prefix:"\n" suffix:" Tx"];
         
         [rightText drawInRect:tmpRect withAttributes:[appSettings alignRightAttributes]];
     }
@@ -201,14 +273,14 @@
         tmpRect.size.height = textRectHeight;
 
         rx = [self.miner currentRX];
-        [rightText appendFormat:@"%@ Rx", [XRGCommon formattedStringForBytes:rx]];
+        [XRGCommon appendBytes:rx toString:rightText prefix:NULL suffix:" Rx"];
 		
         [rightText drawInRect:tmpRect withAttributes:[appSettings alignRightAttributes]];
         
         tmpRect.origin.y = graphSize.height - textRectHeight;
         [rightText setString:@""];
         tx = [self.miner currentTX];
-        [rightText appendFormat:@"%@ Tx", [XRGCommon formattedStringForBytes:tx]];
+        [XRGCommon appendBytes:tx toString:rightText prefix:NULL suffix:" Tx"];
 		
         [rightText drawInRect:tmpRect withAttributes:[appSettings alignRightAttributes]];
     }
@@ -216,14 +288,14 @@
         tmpRect.origin.y = 0;
         tmpRect.size.height = textRectHeight;
         tx = [self.miner currentTX];
-        [rightText appendFormat:@"%@ Tx", [XRGCommon formattedStringForBytes:tx]];
+        [XRGCommon appendBytes:tx toString:rightText prefix:NULL suffix:" Tx"];
 		
         [rightText drawInRect:tmpRect withAttributes:[appSettings alignRightAttributes]];
         
         tmpRect.origin.y = graphSize.height - textRectHeight;
         [rightText setString:@""];
         rx = [self.miner currentRX];
-        [rightText appendFormat:@"%@ Rx", [XRGCommon formattedStringForBytes:rx]];
+        [XRGCommon appendBytes:rx toString:rightText prefix:NULL suffix:" Rx"];
 		
         [rightText drawInRect:tmpRect withAttributes:[appSettings alignRightAttributes]];
     }
@@ -233,7 +305,7 @@
 
 - (void)drawMiniGraph:(NSRect)inRect {
     NSString *leftLabel = nil;
-    if ([@"Net1023K Rx" sizeWithAttributes:[appSettings alignRightAttributes]].width + 6 > [self frame].size.width) {
+    if ([[XRGLabelCache shared] sizeOfString:@"Net1023K Rx" attributes:[appSettings alignRightAttributes]].width + 6 > [self frame].size.width) {
         leftLabel = @"N";
     }
     else {
@@ -270,6 +342,8 @@
     
     tMI = [[NSMenuItem alloc] initWithTitle:@"Reset Graph" action:@selector(clearData:) keyEquivalent:@""];
     [myMenu addItem:tMI];
+    
+    [myMenu addItem:[self graphSpanMenuItem]];
 
     [myMenu addItem:[NSMenuItem separatorItem]];
     
@@ -308,6 +382,7 @@
 
 - (void)clearData:(NSEvent *)theEvent {
     [self.miner reset];
+    [[XRGStatsManager shared] clearHistoryForModule:XRGStatsModuleNameNetwork];
 }
 
 - (BOOL)acceptsFirstMouse:(NSEvent *)theEvent {       
@@ -0,0 +1,51 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGScrollingGraphRenderer.h
+//
+
+#import <Cocoa/Cocoa.h>
+#import "XRGDataSet.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! Keeps a graph rasterized in an offscreen bitmap and updates it as its data sets scroll.  The bitmap is a ring of columns: when new samples arrive, the graph's left edge moves along the ring and only the newest segment is rasterized, so a tick costs the same however wide the graph is.  Anything else that changes the picture (size, colors, bounds, a data set that was rewritten rather than appended to) redraws the whole bitmap, as does a graph whose samples aren't a whole number of pixels wide.
+ */
+@interface XRGScrollingGraphRenderer : NSObject
+
+/*! Draws dataSets stacked bottom to top, each band filled in the matching color, in rect of the current graphics context.  The data sets must be the same size and advance together, like the series of an XRGDataSetGroup.  Values are expected to be non-negative; NOVALUE counts as 0.
+ @param scale The window's backing scale factor, so the bitmap matches the screen's pixels.
+ @return NO if the data sets can't be drawn this way (mismatched sizes or nothing to draw), in which case nothing was drawn.
+ */
+- (BOOL)drawStackedDataSets:(NSArray<XRGDataSet *> *)dataSets colors:(NSArray<NSColor *> *)colors upperBound:(CGFloat)max lowerBound:(CGFloat)min inRect:(NSRect)rect flipped:(BOOL)flipped antialias:(BOOL)antialias backingScale:(CGFloat)scale;
+
+/// Throws the bitmap away, so the next draw redraws everything.
+- (void)invalidate;
+
+/// How many draws rasterized the whole graph and how many only the newest columns.
+@property (readonly) NSUInteger fullRenders;
+@property (readonly) NSUInteger incrementalRenders;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,258 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGScrollingGraphRenderer.m
+//
+
+#import "XRGScrollingGraphRenderer.h"
+#import "XRGGenericView.h"
+
+@interface XRGScrollingGraphRenderer () {
+    CGContextRef    _context;
+    size_t          _pixelWidth;
+    size_t          _pixelHeight;
+    size_t          _originColumn;          // The bitmap column the graph's left edge is in.
+    
+    // What the bitmap was drawn from.
+    CGFloat         _scale;
+    CGFloat         _upperBound;
+    CGFloat         _lowerBound;
+    BOOL            _flipped;
+    BOOL            _antialias;
+    size_t          _numValues;
+    NSUInteger      _dataSetCount;
+    uint64_t       *_appendedCounts;
+    NSUInteger     *_rewriteCounts;
+}
+
+@property (copy) NSArray<XRGDataSet *> *dataSets;
+@property (copy) NSArray<NSColor *> *colors;
+
+@end
+
+@implementation XRGScrollingGraphRenderer
+
+- (void)dealloc {
+    [self invalidate];
+}
+
+- (void)invalidate {
+    CGContextRelease(_context);
+    _context = NULL;
+    
+    free(_appendedCounts);
+    free(_rewriteCounts);
+    _appendedCounts = NULL;
+    _rewriteCounts = NULL;
+    _dataSetCount = 0;
+    self.dataSets = nil;
+}
+
+static CGFloat XRGScrollingGraphValue(const XRGDataSetSpans *spans, size_t index) {
+    CGFloat value = index < spans->olderCount ? spans->older[index] : spans->newer[index - spans->olderCount];
+    return value == NOVALUE ? 0 : value;
+}
+
+- (BOOL)drawStackedDataSets:(NSArray<XRGDataSet *> *)dataSets colors:(NSArray<NSColor *> *)colors upperBound:(CGFloat)max lowerBound:(CGFloat)min inRect:(NSRect)rect flipped:(BOOL)flipped antialias:(BOOL)antialias backingScale:(CGFloat)scale {
+    NSUInteger count = dataSets.count;
+    if (count == 0 || colors.count != count) return NO;
+    
+    size_t numValues = dataSets[0].numValues;
+    if (numValues == 0) return NO;
+    for (XRGDataSet *dataSet in dataSets) {
+        if (dataSet.numValues != numValues) return NO;
+    }
+    
+    if (scale <= 0) scale = 1;
+    size_t pixelWidth = (size_t)lround(rect.size.width * scale);
+    size_t pixelHeight = (size_t)lround(rect.size.height * scale);
+    if (pixelWidth == 0 || pixelHeight == 0) return NO;
+    
+    if (fabs(max - min) < 0.001) {
+        // Set the difference of max and min to 1 to avoid a divide by 0.
+        max += 0.5;
+        min -= 0.5;
+    }
+    
+    BOOL sameSetup = _context && pixelWidth == _pixelWidth && pixelHeight == _pixelHeight && scale == _scale &&
+                     max == _upperBound && min == _lowerBound && flipped == _flipped && antialias == _antialias &&
+                     numValues == _numValues && count == _dataSetCount && [colors isEqualToArray:self.colors];
+    for (NSUInteger d = 0; sameSetup && d < count; d++) {
+        if (dataSets[d] != self.dataSets[d]) sameSetup = NO;
+    }
+    
+    // Only an append on every data set, by the same number of samples, can be scrolled.
+    uint64_t shift = 0;
+    BOOL scrolled = sameSetup;
+    if (sameSetup) {
+        shift = dataSets[0].appendedCount - _appendedCounts[0];
+        for (NSUInteger d = 0; d < count; d++) {
+            if (dataSets[d].rewriteCount != _rewriteCounts[d] || dataSets[d].appendedCount - _appendedCounts[d] != shift) scrolled = NO;
+        }
+    }
+    
+    CGFloat columnWidth = (CGFloat)pixelWidth / (CGFloat)numValues;
+    BOOL wholeColumns = columnWidth >= 1 && fabs(columnWidth - round(columnWidth)) < 0.001;
+    
+    if (!sameSetup) {
+        [self invalidate];
+        if (![self createContextWithWidth:pixelWidth height:pixelHeight]) return NO;
+        
+        _appendedCounts = calloc(count, sizeof(uint64_t));
+        _rewriteCounts = calloc(count, sizeof(NSUInteger));
+        _dataSetCount = count;
+        _scale = scale;
+        _upperBound = max;
+        _lowerBound = min;
+        _flipped = flipped;
+        _antialias = antialias;
+        _numValues = numValues;
+        self.dataSets = dataSets;
+        self.colors = colors;
+    }
+    
+    XRGDataSetSpans *spans = alloca(count * sizeof(XRGDataSetSpans));
+    for (NSUInteger d = 0; d < count; d++) {
+        spans[d] = [dataSets[d] orderedSpans];
+    }
+    
+    if (!scrolled || !wholeColumns || shift >= numValues) {
+        _originColumn = 0;
+        [self fillSamplesFrom:0 to:numValues - 1 clipFrom:0 to:pixelWidth spans:spans columnWidth:columnWidth];
+        _fullRenders++;
+    }
+    else if (shift > 0) {
+        // Move the left edge along the ring, then clear and draw the columns that came around to the right.  The
+        // segment from the previous newest sample is redrawn so the join matches.
+        size_t step = (size_t)round(columnWidth);
+        _originColumn = (_originColumn + (size_t)shift * step) % pixelWidth;
+        
+        size_t first = numValues - 1 - (size_t)shift;
+        [self fillSamplesFrom:first to:numValues - 1 clipFrom:(first + 1) * step to:pixelWidth spans:spans columnWidth:columnWidth];
+        // Left of the oldest sample is blank; it still holds what scrolled off.
+        [self fillSamplesFrom:1 to:0 clipFrom:0 to:step spans:spans columnWidth:columnWidth];
+        _incrementalRenders++;
+    }
+    
+    for (NSUInteger d = 0; d < count; d++) {
+        _appendedCounts[d] = dataSets[d].appendedCount;
+        _rewriteCounts[d] = dataSets[d].rewriteCount;
+    }
+    
+    [self drawBitmapInRect:rect];
+    return YES;
+}
+
+- (BOOL)createContextWithWidth:(size_t)width height:(size_t)height {
+    CGColorSpaceRef colorSpace = CGColorSpaceCreateWithName(kCGColorSpaceSRGB);
+    _context = CGBitmapContextCreate(NULL, width, height, 8, 0, colorSpace, kCGImageAlphaPremultipliedFirst | kCGBitmapByteOrder32Host);
+    CGColorSpaceRelease(colorSpace);
+    if (!_context) return NO;
+    
+    _pixelWidth = width;
+    _pixelHeight = height;
+    _originColumn = 0;
+    return YES;
+}
+
+/*! Clears the columns from x0 to x1 (in pixels from the graph's left edge) and fills the stacked bands over samples first through last, clipped to those columns.  Pass first > last to only clear.  Sample i sits at the right edge of column i, so the newest is at the graph's right edge.
+ */
+- (void)fillSamplesFrom:(size_t)first to:(size_t)last clipFrom:(CGFloat)x0 to:(CGFloat)x1 spans:(const XRGDataSetSpans *)spans columnWidth:(CGFloat)columnWidth {
+    if (x1 <= x0) return;
+    
+    CGFloat height = (CGFloat)_pixelHeight;
+    CGFloat base = _flipped ? height : 0;
+    CGFloat scale = height / (_upperBound - _lowerBound);
+    if (_flipped) scale *= -1;
+    
+    // The columns can wrap around the end of the ring, so draw once at the origin and once a ring's width to the left.
+    CGFloat offsets[2] = { (CGFloat)_originColumn, (CGFloat)_originColumn - (CGFloat)_pixelWidth };
+    for (NSInteger pass = 0; pass < 2; pass++) {
+        CGFloat offset = offsets[pass];
+        CGRect clip = CGRectIntersection(CGRectMake(x0 + offset, 0, x1 - x0, height), CGRectMake(0, 0, _pixelWidth, height));
+        if (CGRectIsEmpty(clip)) continue;
+        
+        CGContextSaveGState(_context);
+        CGContextClipToRect(_context, clip);
+        CGContextClearRect(_context, clip);
+        CGContextTranslateCTM(_context, offset, 0);
+        CGContextSetShouldAntialias(_context, _antialias);
+        
+        // Topmost band first; each band below paints over the part of it that's lower.  A band the same color as the
+        // one above it is already covered.
+        for (NSInteger layer = (NSInteger)_dataSetCount - 1; layer >= 0 && first <= last; layer--) {
+            if (layer < (NSInteger)_dataSetCount - 1 && [self.colors[layer] isEqual:self.colors[layer + 1]]) continue;
+            
+            CGContextBeginPath(_context);
+            CGContextMoveToPoint(_context, (first + 1) * columnWidth, base);
+            for (size_t i = first; i <= last; i++) {
+                CGFloat value = 0;
+                for (NSInteger d = 0; d <= layer; d++) value += XRGScrollingGraphValue(&spans[d], i);
+                
+                CGFloat scaled = MAX(value - _lowerBound, 0) * scale;
+                CGFloat y = MIN(MAX(base + scaled, 0), height);
+                CGContextAddLineToPoint(_context, (i + 1) * columnWidth, y);
+            }
+            CGContextAddLineToPoint(_context, (last + 1) * columnWidth, base);
+            CGContextClosePath(_context);
+            
+            CGContextSetFillColorWithColor(_context, self.colors[layer].CGColor);
+            CGContextFillPath(_context);
+        }
+        
+        CGContextRestoreGState(_context);
+    }
+}
+
+- (void)drawBitmapInRect:(NSRect)rect {
+    CGContextRef gc = [NSGraphicsContext currentContext].CGContext;
+    CGImageRef image = CGBitmapContextCreateImage(_context);
+    if (!image) return;
+    
+    CGFloat pointsPerPixel = rect.size.width / (CGFloat)_pixelWidth;
+    size_t rightWidth = _pixelWidth - _originColumn;
+    
+    CGContextSaveGState(gc);
+    CGContextSetInterpolationQuality(gc, kCGInterpolationNone);
+    
+    // The bitmap from the origin column on is the left part of the graph; whatever wrapped is the right part.
+    CGImageRef left = CGImageCreateWithImageInRect(image, CGRectMake(_originColumn, 0, rightWidth, _pixelHeight));
+    if (left) {
+        CGContextDrawImage(gc, CGRectMake(rect.origin.x, rect.origin.y, rightWidth * pointsPerPixel, rect.size.height), left);
+        CGImageRelease(left);
+    }
+    if (_originColumn > 0) {
+        CGImageRef right = CGImageCreateWithImageInRect(image, CGRectMake(0, 0, _originColumn, _pixelHeight));
+        if (right) {
+            CGContextDrawImage(gc, CGRectMake(rect.origin.x + rightWidth * pointsPerPixel, rect.origin.y, _originColumn * pointsPerPixel, rect.size.height), right);
+            CGImageRelease(right);
+        }
+    }
+    
+    CGContextRestoreGState(gc);
+    
+    // Released before the next update, so the bitmap isn't copied on write.
+    CGImageRelease(image);
+}
+
+@end
@@ -25,6 +25,7 @@
 //
 
 #import "XRGStockView.h"
+#import "XRGDiagnostics.h"
 #import "XRGGraphWindow.h"
 
 @implementation XRGStockView
@@ -67,7 +68,10 @@
     // show the first set of data if the module is displayed
     if ([m isDisplayed]) [self min30Update:nil];
 	
-	[NSTimer scheduledTimerWithTimeInterval:2 target:self selector:@selector(ticker) userInfo:nil repeats:YES];
+	__weak XRGStockView *weakSelf = self;
+	[[XRGScheduler shared] scheduleTaskNamed:@"Stock Ticker" interval:2 block:^{
+		[weakSelf ticker];
+	}];
 }
 
 - (void)setStockSymbolsFromString:(NSString *)s {
@@ -155,7 +159,7 @@
 }
 
 - (void)updateMinSize {
-    CGFloat width = [@"WWWW: $999.99" sizeWithAttributes:[appSettings alignRightAttributes]].width + 6;
+    CGFloat width = [[XRGLabelCache shared] sizeOfString:@"WWWW: $999.99" attributes:[appSettings alignRightAttributes]].width + 6;
     
     [m setMinWidth: width];
     [m setMinHeight: XRG_MINI_HEIGHT];
@@ -171,6 +175,10 @@
 	}
 }
 
+- (XRGStatsModule)samplingModule {
+    return XRGStatsModuleNameStock;
+}
+
 - (void)graphUpdate:(NSTimer *)aTimer {
 }
 
@@ -186,6 +194,7 @@
 
 - (void)drawRect:(NSRect)rect {
     if ([self isHidden]) return;
+    XRG_DIAGNOSTICS_SCOPE(XRGStatsModuleNameStock, XRGDiagnosticsPhaseDraw);
 
     #ifdef XRG_DEBUG
         NSLog(@"In Stock DrawRect."); 
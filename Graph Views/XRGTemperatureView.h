@@ -27,8 +27,9 @@
 #import <Cocoa/Cocoa.h>
 #import "XRGGenericView.h"
 #import "XRGTemperatureMiner.h"
+#import "XRGSampler.h"
 
-@interface XRGTemperatureView : XRGGenericView
+@interface XRGTemperatureView : XRGGenericView <XRGSampledView>
 {
     NSSize                      graphSize;
     
@@ -52,6 +53,8 @@
 //- (int) getWidthForLabel:(NSString *)label;
 
 - (void)graphUpdate:(NSTimer *)aTimer;
+/// Sizes the miner's history for the graph spans to the current graph refresh.
+- (void)updateHistoryStorage;
 - (void)openTemperaturePreferences:(NSEvent *)theEvent;
 
 @end
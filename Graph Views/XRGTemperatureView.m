@@ -26,6 +26,7 @@
 
 #import "XRGGraphWindow.h"
 #import "XRGTemperatureView.h"
+#import "XRGDiagnostics.h"
 #import "XRGStatsManager.h"
 
 @implementation XRGTemperatureView
@@ -49,6 +50,7 @@
     
     appSettings = [parentWindow appSettings];
     moduleManager = [parentWindow moduleManager];
+    [self updateHistoryStorage];
 	
 	locationSizeCache = [[NSMutableDictionary alloc] initWithCapacity:20];
     
@@ -69,6 +71,10 @@
     updateCounter = 0;
 }
 
+- (void)updateHistoryStorage {
+    [XRGTemperatureMiner shared].historySamplesPerMinute = (NSUInteger)ceil(60. / MAX([appSettings graphRefresh], 0.2));
+}
+
 - (void)setGraphSize:(NSSize)newSize {
     NSSize tmpSize;
     tmpSize.width = newSize.width;
@@ -93,9 +99,9 @@
     float width, height;
     height = [appSettings textRectHeight];
     
-    width = [[NSString stringWithFormat:@"CPU 199%CF", (unsigned short)0x00B0] sizeWithAttributes:[appSettings alignRightAttributes]].width;
-    temperatureWidth = [[NSString stringWithFormat:@"199%CF", (unsigned short)0x00B0] sizeWithAttributes:[appSettings alignRightAttributes]].width;
-	rpmWidth = [@"9999 rpm" sizeWithAttributes:[appSettings alignRightAttributes]].width;
+    width = [[XRGLabelCache shared] sizeOfString:[NSString stringWithFormat:@"CPU 199%CF", (unsigned short)0x00B0] attributes:[appSettings alignRightAttributes]].width;
+    temperatureWidth = [[XRGLabelCache shared] sizeOfString:[NSString stringWithFormat:@"199%CF", (unsigned short)0x00B0] attributes:[appSettings alignRightAttributes]].width;
+	rpmWidth = [[XRGLabelCache shared] sizeOfString:@"9999 rpm" attributes:[appSettings alignRightAttributes]].width;
 	
 	[locationSizeCache removeAllObjects];
     
@@ -104,7 +110,21 @@
 }
 
 - (void)graphUpdate:(NSTimer *)aTimer {
-    [[XRGTemperatureMiner shared] updateCurrentTemperatures:[XRGTemperatureView showUnknownSensors]];
+    [self applyGraphSample:[[XRGSampler shared] collectSynchronouslyForModule:XRGStatsModuleNameTemperature block:^id{
+        return [self collectGraphSample];
+    }]];
+}
+
+- (XRGStatsModule)samplingModule {
+    return XRGStatsModuleNameTemperature;
+}
+
+- (id)collectGraphSample {
+    return [[XRGTemperatureMiner shared] collectSample:[XRGTemperatureView showUnknownSensors]];
+}
+
+- (void)applyGraphSample:(XRGTemperatureSample *)sample {
+    [[XRGTemperatureMiner shared] applySample:sample];
     [self checkForConfiguredSensors];
 
     [self setNeedsDisplay: YES];
@@ -114,6 +134,7 @@
     if ([self isHidden]) {
         return;
     }
+    XRG_DIAGNOSTICS_SCOPE(XRGStatsModuleNameTemperature, XRGDiagnosticsPhaseDraw);
     
     #ifdef XRG_DEBUG
         NSLog(@"In Temperature DrawRect."); 
@@ -211,7 +232,7 @@
     
     if ([locations count] == 0) {
         // This machine isn't supported.
-        if ([@"No Sensors Found" sizeWithAttributes:[appSettings alignRightAttributes]].width < paddedTextRect.size.width) {
+        if ([[XRGLabelCache shared] sizeOfString:@"No Sensors Found" attributes:[appSettings alignRightAttributes]].width < paddedTextRect.size.width) {
             [@"No Sensors Found" drawInRect:paddedTextRect withAttributes:[appSettings alignLeftAttributes]];
         }
         else {
@@ -226,7 +247,7 @@
     XRGSensorData *sensor3 = [self sensor3];
 
     if (!sensor1 && !sensor2 && !sensor3) {
-        if ([@"Select Sensors in Prefs" sizeWithAttributes:[appSettings alignRightAttributes]].width < paddedTextRect.size.width) {
+        if ([[XRGLabelCache shared] sizeOfString:@"Select Sensors in Prefs" attributes:[appSettings alignRightAttributes]].width < paddedTextRect.size.width) {
             [@"Select Sensors in Prefs" drawInRect:paddedTextRect withAttributes:[appSettings alignLeftAttributes]];
         }
         else {
@@ -349,26 +370,27 @@
     // Draw the graph.
     [gc setShouldAntialias:[appSettings antiAliasing]];
     NSRect graphRect = NSMakeRect(self.bounds.origin.x, self.bounds.origin.y, self.bounds.size.width, NSMinY(textRect) - self.bounds.origin.y - 2);
+    size_t historySamples = [self historySampleCount];
 
     if (sensor1.dataSet) {
         float min = sensor1IsFan ? 0 : temperatureMin;
         float max = sensor1IsFan ? [[XRGTemperatureMiner shared] maxSpeedForFan:sensor1] : temperatureMax;
 
-		[self drawRangedGraphWithDataFromDataSet:sensor1.dataSet upperBound:max lowerBound:min inRect:graphRect flipped:NO filled:YES color:[appSettings graphFG1Color]];
+		[self drawRangedGraphWithDataFromDataSet:[self historyOfDataSet:sensor1.dataSet lastSamples:historySamples inRect:graphRect slot:0] upperBound:max lowerBound:min inRect:graphRect flipped:NO filled:YES color:[appSettings graphFG1Color]];
     }
     
     if (sensor2.dataSet) {
         float min = sensor2IsFan ? 0 : temperatureMin;
         float max = sensor2IsFan ? [[XRGTemperatureMiner shared] maxSpeedForFan:sensor2] : temperatureMax;
 
-		[self drawRangedGraphWithDataFromDataSet:sensor2.dataSet upperBound:max lowerBound:min inRect:graphRect flipped:NO filled:NO color:[appSettings graphFG2Color]];
+		[self drawRangedGraphWithDataFromDataSet:[self historyOfDataSet:sensor2.dataSet lastSamples:historySamples inRect:graphRect slot:1] upperBound:max lowerBound:min inRect:graphRect flipped:NO filled:NO color:[appSettings graphFG2Color]];
     }
     
     if (sensor3.dataSet) {
         float min = sensor3IsFan ? 0 : temperatureMin;
         float max = sensor3IsFan ? [[XRGTemperatureMiner shared] maxSpeedForFan:sensor3] : temperatureMax;
 
-		[self drawRangedGraphWithDataFromDataSet:sensor3.dataSet upperBound:max lowerBound:min inRect:graphRect flipped:NO filled:NO color:[appSettings graphFG3Color]];
+		[self drawRangedGraphWithDataFromDataSet:[self historyOfDataSet:sensor3.dataSet lastSamples:historySamples inRect:graphRect slot:2] upperBound:max lowerBound:min inRect:graphRect flipped:NO filled:NO color:[appSettings graphFG3Color]];
     }
 }
 
@@ -512,6 +534,8 @@
 
     tMI = [[NSMenuItem alloc] initWithTitle:@"Reset Graph" action:@selector(clearData:) keyEquivalent:@""];
     [myMenu addItem:tMI];
+    
+    [myMenu addItem:[self graphSpanMenuItem]];
 
     [myMenu addItem:[NSMenuItem separatorItem]];
 
@@ -25,6 +25,7 @@
 //
 
 #import "XRGWeatherView.h"
+#import "XRGDiagnostics.h"
 #import "XRGGraphWindow.h"
 #import "NSStringUtil.h"
 #include <stdio.h>
@@ -102,7 +103,10 @@
     // show the first set of data if this module is being displayed
     if ([m isDisplayed]) [parentWindow min30Update:nil];
 	
-	[NSTimer scheduledTimerWithTimeInterval:2 target:self selector:@selector(ticker) userInfo:nil repeats:YES];
+	__weak XRGWeatherView *weakSelf = self;
+	[[XRGScheduler shared] scheduleTaskNamed:@"Weather Ticker" interval:2 block:^{
+		[weakSelf ticker];
+	}];
 }
 
 - (void)setGraphSize:(NSSize)newSize {
@@ -112,33 +116,33 @@
 - (void)updateMinSize {
     NSMutableDictionary *textAttributes = [appSettings alignRightAttributes];
 
-    CGFloat width = [@"H/L:199/99" sizeWithAttributes:textAttributes].width + 6;
+    CGFloat width = [[XRGLabelCache shared] sizeOfString:@"H/L:199/99" attributes:textAttributes].width + 6;
     
     [m setMinWidth: width];
     [m setMinHeight: XRG_MINI_HEIGHT];
     
     // Update the text width cache.
-    STATION_WIDE       = [@"Station: WWWW" sizeWithAttributes:textAttributes].width;	
+    STATION_WIDE       = [[XRGLabelCache shared] sizeOfString:@"Station: WWWW" attributes:textAttributes].width;	
 	
-    TEMPERATURE_WIDE   = [[NSString stringWithFormat:@"Current Temperature: 99.9%CC", (unsigned short)0x00B0] sizeWithAttributes:textAttributes].width;
-    TEMPERATURE_NORMAL = [[NSString stringWithFormat:@"Temperature: 99.9%CC", (unsigned short)0x00B0] sizeWithAttributes:textAttributes].width;
-    TEMPERATURE_SMALL  = [[NSString stringWithFormat:@"Temp: 99.9%CC", (unsigned short)0x00B0] sizeWithAttributes:textAttributes].width;
+    TEMPERATURE_WIDE   = [[XRGLabelCache shared] sizeOfString:[NSString stringWithFormat:@"Current Temperature: 99.9%CC", (unsigned short)0x00B0] attributes:textAttributes].width;
+    TEMPERATURE_NORMAL = [[XRGLabelCache shared] sizeOfString:[NSString stringWithFormat:@"Temperature: 99.9%CC", (unsigned short)0x00B0] attributes:textAttributes].width;
+    TEMPERATURE_SMALL  = [[XRGLabelCache shared] sizeOfString:[NSString stringWithFormat:@"Temp: 99.9%CC", (unsigned short)0x00B0] attributes:textAttributes].width;
                            
-    HL_WIDE            = [[NSString stringWithFormat:@"High/Low: 99.9%CC/99.9%CC", (unsigned short)0x00B0, (unsigned short)0x00B0] sizeWithAttributes:textAttributes].width;
+    HL_WIDE            = [[XRGLabelCache shared] sizeOfString:[NSString stringWithFormat:@"High/Low: 99.9%CC/99.9%CC", (unsigned short)0x00B0, (unsigned short)0x00B0] attributes:textAttributes].width;
 
-    WIND_WIDE          = [@"Wind: WSW 99 Gusts: 99" sizeWithAttributes:textAttributes].width;
-    WIND_NORMAL        = [@"Wind: WSW 99 G: 99" sizeWithAttributes:textAttributes].width;
-    WIND_SMALL         = [@"Wind: WSW 99" sizeWithAttributes:textAttributes].width;
+    WIND_WIDE          = [[XRGLabelCache shared] sizeOfString:@"Wind: WSW 99 Gusts: 99" attributes:textAttributes].width;
+    WIND_NORMAL        = [[XRGLabelCache shared] sizeOfString:@"Wind: WSW 99 G: 99" attributes:textAttributes].width;
+    WIND_SMALL         = [[XRGLabelCache shared] sizeOfString:@"Wind: WSW 99" attributes:textAttributes].width;
 
-    HUMIDITY_WIDE      = [@"Relative Humidity: 100%" sizeWithAttributes:textAttributes].width;
-    HUMIDITY_NORMAL    = [@"Rel Humidity: 100%" sizeWithAttributes:textAttributes].width;
+    HUMIDITY_WIDE      = [[XRGLabelCache shared] sizeOfString:@"Relative Humidity: 100%" attributes:textAttributes].width;
+    HUMIDITY_NORMAL    = [[XRGLabelCache shared] sizeOfString:@"Rel Humidity: 100%" attributes:textAttributes].width;
                        
-    VISIBILITY_WIDE    = [@"Visibility: 99 km" sizeWithAttributes:textAttributes].width;
+    VISIBILITY_WIDE    = [[XRGLabelCache shared] sizeOfString:@"Visibility: 99 km" attributes:textAttributes].width;
 
-    DEWPOINT_WIDE      = [[NSString stringWithFormat:@"Dewpoint: 99.9%CC", (unsigned short)0x00B0] sizeWithAttributes:textAttributes].width;
+    DEWPOINT_WIDE      = [[XRGLabelCache shared] sizeOfString:[NSString stringWithFormat:@"Dewpoint: 99.9%CC", (unsigned short)0x00B0] attributes:textAttributes].width;
 
-    PRESSURE_WIDE      = [@"Barometric Pressure: 1999hPa" sizeWithAttributes:textAttributes].width;
-    PRESSURE_NORMAL    = [@"Pressure: 1999hPa" sizeWithAttributes:textAttributes].width;
+    PRESSURE_WIDE      = [[XRGLabelCache shared] sizeOfString:@"Barometric Pressure: 1999hPa" attributes:textAttributes].width;
+    PRESSURE_NORMAL    = [[XRGLabelCache shared] sizeOfString:@"Pressure: 1999hPa" attributes:textAttributes].width;
 }
 
 - (void)setURL:(NSString *)icao {
@@ -178,6 +182,10 @@
     }	
 }
 
+- (XRGStatsModule)samplingModule {
+    return XRGStatsModuleNameWeather;
+}
+
 - (void)graphUpdate:(NSTimer *)aTimer {
     if ([parentWindow systemJustWokeUp]) {
         [self cancelLoading];
@@ -652,6 +660,7 @@ NSInteger matchRegex(char *pattern, char *inString) {
 
 - (void)drawRect:(NSRect)rect {
     if ([self isHidden]) return;
+    XRG_DIAGNOSTICS_SCOPE(XRGStatsModuleNameWeather, XRGDiagnosticsPhaseDraw);
 
     #ifdef XRG_DEBUG
         NSLog(@"In Weather DrawRect."); 
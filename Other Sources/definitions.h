@@ -67,6 +67,11 @@ typedef struct network_interface_stats {
 #define XRG_minimizeUpDown              @"minimizeUpDown"
 #define XRG_windowIsMinimized			@"windowIsMinimized"
 #define XRG_isDockIconHidden            @"isDockIconHidden"
+#define XRG_synchronousSampling         @"synchronousSampling"    // Hidden; collects on the main thread for comparison.
+#define XRG_adaptiveSampling            @"adaptiveSampling"
+#define XRG_incrementalGraphs           @"incrementalGraphs"
+#define XRG_layerBackedGraphs           @"layerBackedGraphs"
+#define XRG_graphHistorySpan            @"graphHistorySpan"
 
 #define XRG_backgroundColor				@"backgroundColor"
 #define XRG_graphBGColor				@"graphBGColor"
@@ -0,0 +1,54 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGBenchmarks.h
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// The benchmarks and fixture checks behind the diagnostics panel's Run Benchmarks button.  Each section times the
+/// current code against the path it replaced, or replays recorded input and checks the output, and reports what it
+/// found as text.  Main thread only; the graph section draws into an offscreen bitmap.
+@interface XRGBenchmarks : NSObject
+
+/// Every section, one after another: graph drawing (+[XRGGenericView graphBenchmarkReport]), data set min/max and
+/// history gaps, then from XRGKernelBenchmarks.h the vector kernels, the archive codec, decimation, byte formatting
+/// and /proc/stat parsing, and last stat ingest.  A new benchmark goes in here as another section.
++ (NSString *)report;
+
+/// XRGBenchmarkStatIngest on four scratch stats interned in the sampler module.
++ (NSString *)statIngestReport;
+
+/// setNextValue: with the min/max deques against the old rescan whenever an extreme was evicted, on a flat and a
+/// noisy signal at 2k, 20k and 200k samples, checking that both agree on every tick.
++ (NSString *)dataSetExtremaReport;
+
+/// summarizeLastSamples:intoBuckets:count: over a gap of NOVALUE samples in the middle, from the raw values and from a
+/// tier, checking that the gap's slices are empty and that the history on either side stays where it was in time.
++ (NSString *)dataSetHistoryGapReport;
+
+@end
+
+NS_ASSUME_NONNULL_END
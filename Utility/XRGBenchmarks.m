@@ -0,0 +1,197 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGBenchmarks.m
+//
+
+#import "XRGBenchmarks.h"
+#import "XRGDataSet.h"
+#import "XRGGenericView.h"
+#import "XRGStatsManager.h"
+#import "XRGKernelBenchmarks.h"
+
+#include <time.h>
+
+@implementation XRGBenchmarks
+
++ (NSString *)report {
+    NSMutableString *report = [NSMutableString string];
+    for (NSString *section in @[[XRGGenericView graphBenchmarkReport],
+                                [XRGBenchmarks dataSetExtremaReport],
+                                [XRGBenchmarks dataSetHistoryGapReport],
+                                [XRGBenchmarks reportFromSection:XRGBenchmarkVectorKernels],
+                                [XRGBenchmarks reportFromSection:XRGBenchmarkArchiveCodec],
+                                [XRGBenchmarks reportFromSection:XRGBenchmarkDecimation],
+                                [XRGBenchmarks reportFromSection:XRGBenchmarkFormatBytes],
+                                [XRGBenchmarks reportFromSection:XRGBenchmarkProcStat],
+                                [XRGBenchmarks statIngestReport]]) {
+        [report appendFormat:@"%@\n", section];
+    }
+    return report;
+}
+
++ (NSString *)reportFromSection:(void (*)(XRGBenchmarkReport *))section {
+    XRGBenchmarkReport report = { NULL, 0, 0 };
+    section(&report);
+    
+    NSString *text = report.text ? @(report.text) : @"";
+    XRGBenchmarkReportFree(&report);
+    return text;
+}
+
++ (NSString *)statIngestReport {
+    // Scratch stats in the sampler module.  They're cleared afterwards, so they don't show up in keysForModule:.
+    XRGStatHandle handles[4];
+    for (NSUInteger i = 0; i < 4; i++) {
+        handles[i] = [[XRGStatsManager shared] handleForKey:[NSString stringWithFormat:@"Benchmark %lu", (unsigned long)i] inModule:XRGStatsModuleNameSampler];
+        if (handles[i] == XRGStatHandleInvalid) return @"Stat ingest: no free stat handles\n";
+    }
+    
+    XRGBenchmarkReport report = { NULL, 0, 0 };
+    XRGBenchmarkStatIngest(&report, handles, 4);
+    
+    NSString *text = report.text ? @(report.text) : @"";
+    XRGBenchmarkReportFree(&report);
+    return text;
+}
+
+#pragma mark - Data Set Extrema
+
+// The ring and extrema update XRGDataSet used before the deques: keep min and max as values arrive, and rescan the
+// whole ring when the value being overwritten was one of them.
+typedef struct {
+    CGFloat *values;
+    size_t   numValues;
+    size_t   currentIndex;
+    CGFloat  min;
+    CGFloat  max;
+} XRGRescanRing;
+
+static void XRGRescanRingSetNextValue(XRGRescanRing *ring, CGFloat value) {
+    if (++ring->currentIndex == ring->numValues) ring->currentIndex = 0;
+    
+    CGFloat oldValue = ring->values[ring->currentIndex];
+    ring->values[ring->currentIndex] = value;
+    
+    if (oldValue == ring->min || oldValue == ring->max) {
+        ring->min = ring->values[0];
+        ring->max = ring->values[0];
+        for (size_t i = 0; i < ring->numValues; i++) {
+            if (ring->values[i] < ring->min) ring->min = ring->values[i];
+            if (ring->values[i] > ring->max) ring->max = ring->values[i];
+        }
+    }
+    else {
+        if (value < ring->min) ring->min = value;
+        if (value > ring->max) ring->max = value;
+    }
+}
+
++ (NSString *)dataSetExtremaReport {
+    static const size_t sizes[] = { 2000, 20000, 200000 };
+    const NSInteger ticks = 2000;
+    
+    NSMutableString *report = [NSMutableString stringWithFormat:@"Data set min/max update, nanoseconds per sample (%ld samples after a full ring)\n", (long)ticks];
+    [report appendFormat:@"%8s %8s %12s %12s %10s\n", "Samples", "Signal", "Rescan", "Deques", "Mismatches"];
+    
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        size_t numValues = sizes[s];
+        
+        // Idle CPU or disk: almost every evicted value is both the min and the max.  Then a noisy 0-100% signal.
+        for (NSInteger noisy = 0; noisy <= 1; noisy++) {
+            @autoreleasepool {
+                CGFloat *signal = malloc((numValues + ticks) * sizeof(CGFloat));
+                for (size_t i = 0; i < numValues + ticks; i++) signal[i] = noisy ? arc4random_uniform(10001) / 100. : 0;
+                
+                XRGRescanRing ring = { calloc(numValues, sizeof(CGFloat)), numValues, numValues - 1, 0, 0 };
+                for (size_t i = 0; i < numValues; i++) XRGRescanRingSetNextValue(&ring, signal[i]);
+                
+                XRGDataSet *dataSet = [[XRGDataSet alloc] init];
+                [dataSet resize:numValues];
+                for (size_t i = 0; i < numValues; i++) [dataSet setNextValue:signal[i]];
+                
+                uint64_t start = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+                for (NSInteger t = 0; t < ticks; t++) XRGRescanRingSetNextValue(&ring, signal[numValues + t]);
+                double rescanNanoseconds = (double)(clock_gettime_nsec_np(CLOCK_UPTIME_RAW) - start) / ticks;
+                
+                start = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+                for (NSInteger t = 0; t < ticks; t++) [dataSet setNextValue:signal[numValues + t]];
+                double dequeNanoseconds = (double)(clock_gettime_nsec_np(CLOCK_UPTIME_RAW) - start) / ticks;
+                
+                // Run both again tick by tick to check the extrema agree.
+                NSInteger mismatches = 0;
+                for (NSInteger t = 0; t < ticks; t++) {
+                    CGFloat value = signal[(t * 7919) % (numValues + ticks)];
+                    XRGRescanRingSetNextValue(&ring, value);
+                    [dataSet setNextValue:value];
+                    if (ring.min != dataSet.min || ring.max != dataSet.max) mismatches++;
+                }
+                
+                [report appendFormat:@"%8zu %8s %12.1f %12.1f %10ld\n", numValues, noisy ? "noisy" : "flat", rescanNanoseconds, dequeNanoseconds, (long)mismatches];
+                
+                free(ring.values);
+                free(signal);
+            }
+        }
+    }
+    
+    return report;
+}
+
+#pragma mark - Data Set History Gaps
+
++ (NSString *)dataSetHistoryGapReport {
+    // 300 samples at 50, a 100 sample gap, then 300 at 10, summarized into slices of 10 from the raw values and from
+    // a tier of 10 sample buckets.
+    XRGDataSet *raw = [[XRGDataSet alloc] init];
+    [raw resize:700];
+    XRGDataSet *tiered = [[XRGDataSet alloc] init];
+    [tiered resize:60];
+    [tiered addTierWithSamplesPerBucket:10 capacity:200];
+    
+    for (NSInteger i = 0; i < 700; i++) {
+        CGFloat value = (i < 300) ? 50 : (i < 400) ? NOVALUE : 10;
+        [raw setNextValue:value];
+        [tiered setNextValue:value];
+    }
+    
+    // Slice c holds samples 10c through 10c + 9, so the gap is slices 30 to 39 in both.
+    XRGDataSetBucket buckets[70];
+    NSInteger wrongSlices = 0;
+    for (XRGDataSet *dataSet in @[raw, tiered]) {
+        [dataSet summarizeLastSamples:700 intoBuckets:buckets count:70];
+        for (NSInteger c = 0; c < 70; c++) {
+            CGFloat expected = (c < 30) ? 50 : 10;
+            if (c >= 30 && c < 40) {
+                if (buckets[c].count != 0) wrongSlices++;
+            }
+            else if (buckets[c].count != 10 || buckets[c].min != expected || buckets[c].max != expected || buckets[c].sum != 10 * expected) {
+                wrongSlices++;
+            }
+        }
+    }
+    
+    return [NSString stringWithFormat:@"Data set history with a gap in the middle, raw and tiered: %ld wrong slices of 140\n", (long)wrongSlices];
+}
+
+@end
@@ -0,0 +1,309 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGCPUTicks.c
+//
+
+#include "XRGCPUTicks.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static inline uint64_t XRGCPUTicksDelta(uint64_t current, uint64_t previous, bool wraps32) {
+    if (current >= previous) return current - previous;
+    
+    // Mach's counters are 32 bits and wrap.  Anything else going backwards, like iowait and idle on Linux, or a CPU
+    // that was reset, tells us nothing about the interval.
+    if (wraps32 && previous <= UINT32_MAX) return (uint32_t)((uint32_t)current - (uint32_t)previous);
+    return 0;
+}
+
+void XRGCPUTicksPercentages(const XRGCPUTicks *current, const XRGCPUTicks *previous, bool wraps32, double percentages[XRGCPUTickCount]) {
+    uint64_t deltas[XRGCPUTickCount];
+    uint64_t total = 0;
+    
+    for (int state = 0; state < XRGCPUTickCount; state++) {
+        deltas[state] = XRGCPUTicksDelta(current->ticks[state], previous->ticks[state], wraps32);
+        if (state <= XRGCPUTickSteal) total += deltas[state];
+    }
+    
+    for (int state = 0; state < XRGCPUTickCount; state++) {
+        percentages[state] = (total == 0) ? 0 : (double)deltas[state] / (double)total * 100.;
+    }
+}
+
+double XRGCPUTicksLayers(const double percentages[XRGCPUTickCount], const XRGCPUTickState *extras, size_t extraCount, double *layers) {
+    double user = percentages[XRGCPUTickUser];
+    double busy = user + percentages[XRGCPUTickSystem] + percentages[XRGCPUTickNice];
+    
+    for (size_t k = 0; k < extraCount; k++) {
+        double value = percentages[extras[k]];
+        if (extras[k] == XRGCPUTickGuest) {
+            // Already in user, and so already in busy.
+            if (value > user) value = user;
+            user -= value;
+        }
+        else if (extras[k] != XRGCPUTickIOWait) {
+            busy += value;
+        }
+        layers[3 + k] = value;
+    }
+    
+    layers[0] = user;
+    layers[1] = percentages[XRGCPUTickSystem];
+    layers[2] = percentages[XRGCPUTickNice];
+    return busy;
+}
+
+// MARK: - /proc/stat
+
+static inline bool XRGIsDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+size_t XRGProcStatParse(const char *text, size_t length, XRGCPUTicks *ticks, size_t count) {
+    const char *p = text;
+    const char *end = text + length;
+    size_t cpuCount = 0;
+    
+    while (end - p >= 4 && p[0] == 'c' && p[1] == 'p' && p[2] == 'u') {
+        p += 3;
+        
+        // The aggregate line has no number.
+        bool aggregate = !XRGIsDigit(*p);
+        size_t cpu = 0;
+        while (p < end && XRGIsDigit(*p)) cpu = cpu * 10 + (size_t)(*p++ - '0');
+        
+        // Only complete lines count, so one that was cut off doesn't leave half its counters behind.
+        const char *lineEnd = memchr(p, '\n', (size_t)(end - p));
+        if (!lineEnd) break;
+        
+        if (!aggregate && cpu < count) {
+            XRGCPUTicks *cpuTicks = &ticks[cpu];
+            int state = 0;
+            while (p < lineEnd && state < XRGCPUTickCount) {
+                while (p < lineEnd && !XRGIsDigit(*p)) p++;
+                if (p == lineEnd) break;
+                
+                uint64_t value = 0;
+                do {
+                    value = value * 10 + (uint64_t)(*p++ - '0');
+                } while (XRGIsDigit(*p));
+                cpuTicks->ticks[state++] = value;
+            }
+            while (state < XRGCPUTickCount) cpuTicks->ticks[state++] = 0;
+        }
+        p = lineEnd + 1;
+        
+        if (!aggregate && cpu + 1 > cpuCount) cpuCount = cpu + 1;
+    }
+    
+    return cpuCount;
+}
+
+// Reads a non-negative decimal like "0.52" or "12345.67" at the start of the text, after any blanks.
+static double XRGProcParseDecimal(const char *text, size_t length) {
+    const char *p = text;
+    const char *end = text + length;
+    
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    if (p == end || !XRGIsDigit(*p)) return -1;
+    
+    uint64_t whole = 0;
+    while (p < end && XRGIsDigit(*p)) whole = whole * 10 + (uint64_t)(*p++ - '0');
+    
+    uint64_t fraction = 0;
+    uint64_t scale = 1;
+    if (p < end && *p == '.') {
+        p++;
+        // The kernel writes two places; more than 18 wouldn't fit and wouldn't matter.
+        while (p < end && XRGIsDigit(*p) && scale < 1000000000000000000ull) {
+            fraction = fraction * 10 + (uint64_t)(*p++ - '0');
+            scale *= 10;
+        }
+    }
+    
+    return (double)whole + (double)fraction / (double)scale;
+}
+
+double XRGProcLoadAverageParse(const char *text, size_t length) {
+    return XRGProcParseDecimal(text, length);
+}
+
+double XRGProcUptimeParse(const char *text, size_t length) {
+    return XRGProcParseDecimal(text, length);
+}
+
+// MARK: - Reader
+
+#if defined(__linux__)
+
+// Longest a "cpuN" line can be: the name and ten 20-digit counters with their spaces.
+#define XRG_PROC_STAT_LINE_LENGTH 232
+
+// /proc/loadavg and /proc/uptime are each one short line.
+#define XRG_PROC_SHORT_FILE_LENGTH 128
+
+struct XRGProcStatReader {
+    int statFD;
+    int loadAverageFD;
+    int uptimeFD;
+    
+    size_t cpuCount;
+    XRGCPUTicks *ticks;
+    
+    // Big enough for the aggregate line and every CPU line at their longest, so what comes after them (the interrupt
+    // counts can run to tens of kilobytes) is never read.
+    char *buffer;
+    size_t capacity;
+};
+
+static ssize_t XRGProcPread(int fd, char *buffer, size_t capacity) {
+    ssize_t length;
+    do {
+        length = pread(fd, buffer, capacity, 0);
+    } while (length < 0 && errno == EINTR);
+    return length;
+}
+
+static bool XRGProcStatReaderSize(XRGProcStatReader *reader, size_t cpuCount) {
+    size_t capacity = (cpuCount + 1) * XRG_PROC_STAT_LINE_LENGTH;
+    char *buffer = realloc(reader->buffer, capacity);
+    if (!buffer) return false;
+    reader->buffer = buffer;
+    reader->capacity = capacity;
+    
+    XRGCPUTicks *ticks = realloc(reader->ticks, cpuCount * sizeof(XRGCPUTicks));
+    if (!ticks) return false;
+    memset(ticks, 0, cpuCount * sizeof(XRGCPUTicks));
+    reader->ticks = ticks;
+    reader->cpuCount = cpuCount;
+    
+    return true;
+}
+
+XRGProcStatReader *XRGProcStatReaderCreate(void) {
+    XRGProcStatReader *reader = calloc(1, sizeof(XRGProcStatReader));
+    if (!reader) return NULL;
+    
+    reader->statFD = open("/proc/stat", O_RDONLY | O_CLOEXEC);
+    reader->loadAverageFD = open("/proc/loadavg", O_RDONLY | O_CLOEXEC);
+    reader->uptimeFD = open("/proc/uptime", O_RDONLY | O_CLOEXEC);
+    
+    // Start from the number of configured CPUs, and size again if /proc/stat numbers them higher than that.
+    long configured = sysconf(_SC_NPROCESSORS_CONF);
+    size_t cpuCount = configured > 0 ? (size_t)configured : 1;
+    for (int attempt = 0; reader->statFD >= 0 && attempt < 2; attempt++) {
+        if (!XRGProcStatReaderSize(reader, cpuCount)) break;
+        
+        ssize_t length = XRGProcPread(reader->statFD, reader->buffer, reader->capacity);
+        if (length <= 0) break;
+        
+        size_t listed = XRGProcStatParse(reader->buffer, (size_t)length, reader->ticks, reader->cpuCount);
+        if (listed == 0) break;
+        if (listed <= reader->cpuCount) {
+            reader->cpuCount = listed;
+            return reader;
+        }
+        cpuCount = listed;
+    }
+    
+    XRGProcStatReaderFree(reader);
+    return NULL;
+}
+
+void XRGProcStatReaderFree(XRGProcStatReader *reader) {
+    if (!reader) return;
+    
+    if (reader->statFD >= 0) close(reader->statFD);
+    if (reader->loadAverageFD >= 0) close(reader->loadAverageFD);
+    if (reader->uptimeFD >= 0) close(reader->uptimeFD);
+    free(reader->ticks);
+    free(reader->buffer);
+    free(reader);
+}
+
+size_t XRGProcStatReaderCPUCount(const XRGProcStatReader *reader) {
+    return reader ? reader->cpuCount : 0;
+}
+
+const XRGCPUTicks *XRGProcStatReaderReadTicks(XRGProcStatReader *reader) {
+    if (!reader) return NULL;
+    
+    ssize_t length = XRGProcPread(reader->statFD, reader->buffer, reader->capacity);
+    if (length <= 0) return NULL;
+    
+    XRGProcStatParse(reader->buffer, (size_t)length, reader->ticks, reader->cpuCount);
+    return reader->ticks;
+}
+
+static double XRGProcReadDecimalFile(int fd) {
+    if (fd < 0) return -1;
+    
+    char buffer[XRG_PROC_SHORT_FILE_LENGTH];
+    ssize_t length = XRGProcPread(fd, buffer, sizeof(buffer));
+    if (length <= 0) return -1;
+    
+    return XRGProcParseDecimal(buffer, (size_t)length);
+}
+
+double XRGProcStatReaderLoadAverage(XRGProcStatReader *reader) {
+    return reader ? XRGProcReadDecimalFile(reader->loadAverageFD) : -1;
+}
+
+double XRGProcStatReaderUptime(XRGProcStatReader *reader) {
+    return reader ? XRGProcReadDecimalFile(reader->uptimeFD) : -1;
+}
+
+#else
+
+XRGProcStatReader *XRGProcStatReaderCreate(void) {
+    return NULL;
+}
+
+void XRGProcStatReaderFree(XRGProcStatReader *reader) {
+}
+
+size_t XRGProcStatReaderCPUCount(const XRGProcStatReader *reader) {
+    return 0;
+}
+
+const XRGCPUTicks *XRGProcStatReaderReadTicks(XRGProcStatReader *reader) {
+    return NULL;
+}
+
+double XRGProcStatReaderLoadAverage(XRGProcStatReader *reader) {
+    return -1;
+}
+
+double XRGProcStatReaderUptime(XRGProcStatReader *reader) {
+    return -1;
+}
+
+#endif
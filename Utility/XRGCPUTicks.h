@@ -0,0 +1,113 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGCPUTicks.h
+//
+
+#ifndef XRG_CPU_TICKS_H
+#define XRG_CPU_TICKS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Per-CPU tick counters in one layout for every platform, the usage derived from two readings of them, and the
+// Linux /proc backend that fills them in.  The states follow the columns of /proc/stat; Mach only reports user,
+// system, idle and nice, so the others stay 0 there.
+
+typedef enum {
+    XRGCPUTickUser = 0,
+    XRGCPUTickNice,
+    XRGCPUTickSystem,
+    XRGCPUTickIdle,
+    XRGCPUTickIOWait,
+    XRGCPUTickIRQ,
+    XRGCPUTickSoftIRQ,
+    XRGCPUTickSteal,
+    XRGCPUTickGuest,            // Also counted in user.
+    XRGCPUTickGuestNice,        // Also counted in nice.
+    XRGCPUTickCount
+} XRGCPUTickState;
+
+typedef struct {
+    uint64_t ticks[XRGCPUTickCount];
+} XRGCPUTicks;
+
+/// Fills percentages with the share of the ticks between two readings that went to each state, 0 to 100.  The
+/// states up to XRGCPUTickSteal add up to 100; guest time is a part of user (and guest nice of nice), as the kernel
+/// counts it.  Everything is 0 if no ticks went by.
+/// @param wraps32 Whether the counters are Mach's 32-bit ones, so one that went backwards wrapped.  Otherwise, as on
+///                Linux where iowait and idle can go down (see proc(5)), a counter that went backwards counts as 0.
+void XRGCPUTicksPercentages(const XRGCPUTicks *current, const XRGCPUTicks *previous, bool wraps32, double percentages[XRGCPUTickCount]);
+
+/*! Splits percentages into the layers the CPU graph stacks: user, system and nice, then one for each state in extras.
+ When guest is one of the extras it's taken out of user, so no tick is stacked twice.  It's capped at user, since the
+ kernel doesn't update the two counters together.  With no extras, as on Mach, user is left as it is.
+ @param layers Filled with 3 + extraCount values.
+ @return The busy total, which is every layer but iowait.
+ */
+double XRGCPUTicksLayers(const double percentages[XRGCPUTickCount], const XRGCPUTickState *extras, size_t extraCount, double *layers);
+
+// MARK: - /proc/stat
+
+/*! Parses the "cpuN" lines of /proc/stat text into ticks[N].  The aggregate "cpu" line is skipped, CPUs that aren't
+ listed (because they're offline) keep whatever ticks[] already held, and missing columns on older kernels are read
+ as 0.  Parsing stops at the first line that isn't about a CPU, or at the last complete line if the text was cut off.
+ Nothing is allocated.
+ @param count The number of entries in ticks; CPUs numbered at or above it are ignored.
+ @return One more than the highest CPU number seen, which may be more than count; 0 if there were none.
+ */
+size_t XRGProcStatParse(const char *text, size_t length, XRGCPUTicks *ticks, size_t count);
+
+/// Parses the first field of /proc/loadavg, the one-minute load average.  Returns -1 if there isn't one.
+double XRGProcLoadAverageParse(const char *text, size_t length);
+
+/// Parses the first field of /proc/uptime, seconds since boot.  Returns -1 if there isn't one.
+double XRGProcUptimeParse(const char *text, size_t length);
+
+// MARK: - Reader
+
+// Keeps /proc/stat, /proc/loadavg and /proc/uptime open and re-reads them with pread() into buffers sized when it's
+// created, so a sample costs three system calls and no allocation.  A reader must only be used from one thread at a
+// time.  Only available on Linux; everywhere else XRGProcStatReaderCreate() returns NULL.
+
+typedef struct XRGProcStatReader XRGProcStatReader;
+
+/// Returns NULL if /proc/stat can't be read.
+XRGProcStatReader *XRGProcStatReaderCreate(void);
+void XRGProcStatReaderFree(XRGProcStatReader *reader);
+
+/// The number of CPUs /proc/stat listed when the reader was created, counting any offline ones below the highest.
+size_t XRGProcStatReaderCPUCount(const XRGProcStatReader *reader);
+
+/// Re-reads /proc/stat and returns the reader's ticks, XRGProcStatReaderCPUCount() of them, valid until the next
+/// call.  CPUs that have gone offline repeat their last reading.  Returns NULL if the read fails.
+const XRGCPUTicks *XRGProcStatReaderReadTicks(XRGProcStatReader *reader);
+
+/// The one-minute load average, or -1 if it can't be read.
+double XRGProcStatReaderLoadAverage(XRGProcStatReader *reader);
+
+/// Seconds since boot, or -1 if it can't be read.
+double XRGProcStatReaderUptime(XRGProcStatReader *reader);
+
+#endif
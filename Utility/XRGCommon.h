@@ -48,6 +48,17 @@
  */
 + (CGFloat)dampedValueUsingPreviousValue:(CGFloat)previousValue currentValue:(CGFloat)currentValue dampingCoefficient:(CGFloat)dampingCoefficient;
 
+/*! Formats a byte count for a label ("37B", "512K", "1.25M").  The text is built by XRGFormatBytes in a stack buffer, so the returned string is the only allocation.
+ * @param bytes: The byte count.
+ */
 + (NSString *)formattedStringForBytes:(double)bytes;
+/// The same, followed by suffix (e.g. "/s").  suffix may be NULL.
++ (NSString *)formattedStringForBytes:(double)bytes suffix:(const char *)suffix;
+
+/*! Appends a formatted byte count to string without making an intermediate NSString.
+ * @param prefix: Appended before the count, e.g. "\nF: ".  May be NULL.
+ * @param suffix: Appended after the count, e.g. " Rx".  May be NULL.
+ */
++ (void)appendBytes:(double)bytes toString:(NSMutableString *)string prefix:(const char *)prefix suffix:(const char *)suffix;
 
 @end
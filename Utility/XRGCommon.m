@@ -25,6 +25,7 @@
 //
 
 #import "XRGCommon.h"
+#import "XRGFormat.h"
 
 @implementation XRGCommon
 
@@ -41,28 +42,21 @@
 }
 
 + (NSString *)formattedStringForBytes:(double)bytes {
-    if (bytes >= 112589990684262400.)
-        return [NSString stringWithFormat:@"%.1fP", (bytes / 1125899906842624.)];
-    else if (bytes >= 1125899906842624.)
-        return [NSString stringWithFormat:@"%.2fP", (bytes / 1125899906842624.)];
-    else if (bytes >= 109951162777600.)
-        return [NSString stringWithFormat:@"%.1fT", (bytes / 1099511627776.)];
-    else if (bytes >= 1099511627776.)
-        return [NSString stringWithFormat:@"%.2fT", (bytes / 1099511627776.)];
-    else if (bytes >= 107374182400.)
-        return [NSString stringWithFormat:@"%.1fG", (bytes / 1073741824.)];
-    else if (bytes >= 1073741824.)
-        return [NSString stringWithFormat:@"%.2fG", (bytes / 1073741824.)];
-    else if (bytes >= 104857600.)
-        return [NSString stringWithFormat:@"%.1fM", (bytes / 1048576.)];
-    else if (bytes >= 1048576.)
-        return [NSString stringWithFormat:@"%.2fM", (bytes / 1048576.)];
-    else if (bytes >= 102400.)
-        return [NSString stringWithFormat:@"%.0fK", (bytes / 1024.)];
-    else if (bytes >= 1024.)
-        return [NSString stringWithFormat:@"%.1fK", (bytes / 1024.)];
-    else
-        return [NSString stringWithFormat:@"%ldB", (long)bytes];
+    return [XRGCommon formattedStringForBytes:bytes suffix:NULL];
+}
+
++ (NSString *)formattedStringForBytes:(double)bytes suffix:(const char *)suffix {
+    char buffer[XRG_FORMAT_BYTES_LENGTH];
+    size_t length = XRGFormatBytes(bytes, suffix, buffer, sizeof(buffer));
+    return [[NSString alloc] initWithBytes:buffer length:length encoding:NSUTF8StringEncoding];
+}
+
++ (void)appendBytes:(double)bytes toString:(NSMutableString *)string prefix:(const char *)prefix suffix:(const char *)suffix {
+    char buffer[XRG_FORMAT_BYTES_LENGTH];
+    XRGFormatBytes(bytes, suffix, buffer, sizeof(buffer));
+    
+    if (prefix) CFStringAppendCString((__bridge CFMutableStringRef)string, prefix, kCFStringEncodingUTF8);
+    CFStringAppendCString((__bridge CFMutableStringRef)string, buffer, kCFStringEncodingUTF8);
 }
 
 @end
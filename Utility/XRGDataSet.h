@@ -26,6 +26,26 @@
 
 #import <Foundation/Foundation.h>
 
+/// Marks a sample with no data, such as time XRG wasn't running.  The graphs leave it out, and so do a data set's min, max, sum and average.
+#define NOVALUE -1000
+
+/// Summary of a run of consecutive samples.  A bucket with a count of 0 holds no data.
+typedef struct {
+    CGFloat    min;
+    CGFloat    max;
+    CGFloat    sum;
+    NSUInteger count;
+} XRGDataSetBucket;
+
+/// Read-only, in-order view of a data set's values without copying.  The values run from older[0] through
+/// older[olderCount - 1] and continue from newer[0] through newer[newerCount - 1], the current value.
+typedef struct {
+    const CGFloat *older;
+    size_t         olderCount;
+    const CGFloat *newer;
+    size_t         newerCount;
+} XRGDataSetSpans;
+
 @interface XRGDataSet : NSObject
 
 @property (nonatomic, assign) CGFloat *values;
@@ -38,10 +58,29 @@
 
 - (id) initWithContentsOfOtherDataSet:(XRGDataSet *)otherDataSet;
 
+/*! Initializes a data set over storage owned by someone else, such as an XRGDataSetGroup.  The data set reads and writes the values in place but never frees or reallocates them, so resize: does nothing; the owner re-points it with setExternalValues:count:currentIndex: instead.
+ */
+- (instancetype) initWithExternalValues:(CGFloat *)values count:(size_t)numValues currentIndex:(NSInteger)currentIndex;
+- (void) setExternalValues:(CGFloat *)values count:(size_t)numValues currentIndex:(NSInteger)currentIndex;
+
+/// NO if the values are owned by someone else (see initWithExternalValues:count:currentIndex:).
+@property (nonatomic, readonly) BOOL ownsValues;
+
+/// Increases whenever a graph of the values would look different.  setNextValue: leaves it alone when every value in the ring already equals the new one, so an idle series that has gone flat stops asking to be redrawn.
+@property (nonatomic, readonly) NSUInteger changeGeneration;
+
+/// The number of values passed to setNextValue: since the data set was created.
+@property (nonatomic, readonly) uint64_t appendedCount;
+/// Increases whenever the ring is rewritten in place (reset, resize, the arithmetic methods, new external storage) rather than appended to, so a cache of the drawn graph knows it can't just scroll.
+@property (nonatomic, readonly) NSUInteger rewriteCount;
+
 - (CGFloat) average;
 - (CGFloat) currentValue;
 - (void) valuesInOrder:(CGFloat *)destinationArray;
 
+/// The oldest-to-newest view of the ring.  Valid until the next call that modifies or resizes the data set.
+- (XRGDataSetSpans) orderedSpans;
+
 - (void) reset;
 - (void) resize:(size_t)newNumValues;
 - (void) setNextValue:(CGFloat)nextVal;
@@ -50,4 +89,50 @@
 - (void) subtractOtherDataSetValues:(XRGDataSet *)otherDataSet;
 - (void) divideAllValuesBy:(CGFloat)dividend;
 
+#pragma mark - History Tiers
+
+/// Number of downsampled tiers kept in addition to the raw values.
+@property (nonatomic, readonly) NSUInteger numTiers;
+
+/*! Adds a downsampled history tier.  Each bucket summarizes samplesPerBucket consecutive values passed to setNextValue: (min/max/sum/count), and the tier keeps the newest numBuckets buckets.  NOVALUE samples take up their time in a bucket but are left out of its summary, so a gap doesn't shift older history.  Tiers are updated incrementally as values arrive and are independent of numValues, so a long history costs numBuckets entries rather than one value per sample.  The whole-buffer arithmetic methods only operate on the raw values.
+ @param samplesPerBucket The number of raw samples in each bucket, e.g. 60 for one minute buckets at a one second graph refresh.
+ @param numBuckets The number of buckets of history to keep.
+ */
+- (void) addTierWithSamplesPerBucket:(NSUInteger)samplesPerBucket capacity:(size_t)numBuckets;
+- (void) removeAllTiers;
+
+/*! Summarizes the newest numSamples samples into numBuckets equal slices of time, oldest first, using the finest of the raw values and the tiers that covers the range.  NOVALUE samples are left out, so slices with no recorded history, or only gaps, have a count of 0.
+ @param numSamples The span to summarize, in raw samples (e.g. 86400 for 24 hours at a one second graph refresh).
+ @param buckets Destination array, assumed to be alloced already with room for numBuckets entries.
+ @param numBuckets The number of slices to produce, typically the graph width in pixels.
+ */
+- (void) summarizeLastSamples:(size_t)numSamples intoBuckets:(XRGDataSetBucket *)buckets count:(size_t)numBuckets;
+
+#pragma mark - Graph Span History
+
+/*! Replaces the data set's tiers and archive with the ones the graph spans draw from (see XRGGraphHistorySpan): a tier of 1440 one-minute buckets for the last day, and an archive holding at least the last hour of values.
+ @param samplesPerMinute How many values are added a minute, at the graph refresh.  0 removes both.
+ */
+- (void) keepHistoryWithSamplesPerMinute:(NSUInteger)samplesPerMinute;
+
+#pragma mark - Archive
+
+/*! Keeps a compressed archive of the values passed to setNextValue:, independent of the ring size.  New values go into an uncompressed live block, so appending stays O(1); each full block is sealed into an XOR-compressed chunk (see XRGGorillaCodec.h) and the oldest chunks are dropped once there are more than maxChunks.
+ @param samplesPerBlock The number of values in each sealed chunk.
+ @param maxChunks The number of sealed chunks to keep.
+ */
+- (void) enableArchiveWithSamplesPerBlock:(size_t)samplesPerBlock maxChunks:(NSUInteger)maxChunks;
+- (void) disableArchive;
+
+/// Number of values in the archive, sealed and live.
+@property (nonatomic, readonly) size_t archivedSampleCount;
+/// Bytes used by the archive: compressed chunks plus the live block.
+@property (nonatomic, readonly) size_t archiveByteCount;
+
+/// The number of values the archive is sure to hold once it has filled: every sealed chunk it keeps.  0 if it's disabled.
+@property (nonatomic, readonly) size_t archiveCapacity;
+
+/// Decodes the newest count archived values, oldest first, into destination (assumed to be alloced already).  Returns the number of values written, which is less than count if the archive is shorter.
+- (size_t) decodeLastArchivedValues:(size_t)count into:(CGFloat *)destination;
+
 @end
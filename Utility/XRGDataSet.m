@@ -25,18 +25,222 @@
 //  
 
 #import "XRGDataSet.h"
-#import <Accelerate/Accelerate.h>
+#import "XRGVectorKernels.h"
+#import "XRGGorillaCodec.h"
 
-#define USE_ACCELERATE CGFLOAT_IS_DOUBLE
-#define UPDATE_EXTREMA() { \
-    double min, max, sum; \
-    vDSP_minvD(self.values, 1, &min, self.numValues ); \
-    vDSP_maxvD(self.values, 1, &max, self.numValues ); \
-    vDSP_sveD( self.values, 1, &sum, self.numValues ); \
-    self.min = min; \
-    self.max = max; \
-    self.sum = sum; }
+// The vector kernels work on doubles, which CGFloat is on every 64-bit target.
+_Static_assert(sizeof(CGFloat) == sizeof(double), "XRGDataSet expects CGFloat to be a double");
 
+#pragma mark - Extrema Deques
+
+// A monotonic deque of (sequence, value) pairs.  The min deque keeps values strictly increasing from front
+// to back and the max deque keeps them strictly decreasing, so the front is always the extreme value of
+// the samples still in the window.  Every sample is pushed and popped at most once, which makes the
+// extrema amortized O(1) per sample instead of a rescan of the ring whenever the evicted value was an extreme.
+typedef struct {
+    uint64_t *sequences;
+    CGFloat  *values;
+    size_t    capacity;
+    size_t    head;
+    size_t    count;
+} XRGExtremaDeque;
+
+static void XRGExtremaDequeResize(XRGExtremaDeque *deque, size_t capacity) {
+    if (deque->capacity != capacity) {
+        free(deque->sequences);
+        free(deque->values);
+        deque->sequences = capacity ? malloc(capacity * sizeof(uint64_t)) : NULL;
+        deque->values = capacity ? malloc(capacity * sizeof(CGFloat)) : NULL;
+        deque->capacity = capacity;
+    }
+    deque->head = 0;
+    deque->count = 0;
+}
+
+static inline size_t XRGExtremaDequeSlot(const XRGExtremaDeque *deque, size_t offset) {
+    size_t slot = deque->head + offset;
+    return slot >= deque->capacity ? slot - deque->capacity : slot;
+}
+
+// Drop everything at or before oldestExpired from the front.
+static inline void XRGExtremaDequeExpire(XRGExtremaDeque *deque, uint64_t oldestExpired) {
+    while (deque->count && deque->sequences[deque->head] <= oldestExpired) {
+        deque->head = XRGExtremaDequeSlot(deque, 1);
+        deque->count--;
+    }
+}
+
+// Expire old entries, then drop every entry from the back that the new value dominates.  isMax selects which
+// ordering the deque maintains.
+static inline void XRGExtremaDequePush(XRGExtremaDeque *deque, uint64_t sequence, uint64_t oldestExpired, CGFloat value, BOOL isMax) {
+    XRGExtremaDequeExpire(deque, oldestExpired);
+
+    while (deque->count) {
+        CGFloat back = deque->values[XRGExtremaDequeSlot(deque, deque->count - 1)];
+        if (isMax ? (back > value) : (back < value)) break;
+        deque->count--;
+    }
+
+    size_t slot = XRGExtremaDequeSlot(deque, deque->count);
+    deque->sequences[slot] = sequence;
+    deque->values[slot] = value;
+    deque->count++;
+}
+
+// Rebuild the min and max deques from a whole ring at once, newest value first, and return the ring's sum and how
+// many NOVALUE samples it holds, all in one pass.  A value survives repeated pushes only if it beats everything newer
+// than it, and the newest value kept so far is the best of everything newer, so one comparison per value is enough.
+// The value at age a (0 being the newest) gets sequence count - a.  NOVALUE samples are never pushed.
+static CGFloat XRGExtremaDequesRebuild(XRGExtremaDeque *minDeque, XRGExtremaDeque *maxDeque, const CGFloat *values, size_t count, NSInteger newestIndex, size_t *missing) {
+    XRGExtremaDequeResize(minDeque, count);
+    XRGExtremaDequeResize(maxDeque, count);
+    *missing = 0;
+    if (count == 0) return 0;
+    
+    size_t minSlot = count;
+    size_t maxSlot = count;
+    NSInteger i = newestIndex;
+    CGFloat bestMin = 0;
+    CGFloat bestMax = 0;
+    CGFloat sum = 0;
+    for (size_t age = 0; age < count; age++) {
+        CGFloat value = values[i];
+        if (--i < 0) i = (NSInteger)count - 1;
+        
+        if (value == NOVALUE) {
+            (*missing)++;
+            continue;
+        }
+        
+        BOOL first = minSlot == count;
+        if (first || value < bestMin) {
+            minSlot--;
+            minDeque->sequences[minSlot] = count - age;
+            minDeque->values[minSlot] = value;
+            bestMin = value;
+        }
+        if (first || value > bestMax) {
+            maxSlot--;
+            maxDeque->sequences[maxSlot] = count - age;
+            maxDeque->values[maxSlot] = value;
+            bestMax = value;
+        }
+        sum += value;
+    }
+    
+    // A ring of nothing but NOVALUE leaves both deques empty, starting from slot 0.
+    minDeque->head = minSlot % count;
+    minDeque->count = count - minSlot;
+    maxDeque->head = maxSlot % count;
+    maxDeque->count = count - maxSlot;
+    return sum;
+}
+
+static inline CGFloat XRGExtremaDequeFront(const XRGExtremaDeque *deque) {
+    return deque->count ? deque->values[deque->head] : 0;
+}
+
+#pragma mark - History Tiers
+
+// A ring of buckets, each covering samplesPerBucket raw samples.  The bucket at index is the one
+// currently filling, and filled counts the buckets that hold data.  samples counts the sample periods a bucket
+// has covered so far and counts the ones that had a value, so a gap still takes up its time.
+typedef struct {
+    NSUInteger  samplesPerBucket;
+    size_t      capacity;
+    size_t      index;
+    size_t      filled;
+    CGFloat    *mins;
+    CGFloat    *maxs;
+    CGFloat    *sums;
+    NSUInteger *counts;
+    NSUInteger *samples;
+} XRGDataSetTier;
+
+static void XRGDataSetTierClear(XRGDataSetTier *tier) {
+    memset(tier->counts, 0, tier->capacity * sizeof(NSUInteger));
+    memset(tier->samples, 0, tier->capacity * sizeof(NSUInteger));
+    tier->index = 0;
+    tier->filled = 0;
+}
+
+// NOVALUE advances the bucket without adding to its summary.
+static inline void XRGDataSetTierAddValue(XRGDataSetTier *tier, CGFloat value) {
+    size_t i = tier->index;
+    if (tier->samples[i] == tier->samplesPerBucket) {
+        i = (i + 1 == tier->capacity) ? 0 : i + 1;
+        tier->index = i;
+        tier->counts[i] = 0;
+        tier->samples[i] = 0;
+        if (tier->filled < tier->capacity) tier->filled++;
+    }
+    if (tier->filled == 0) tier->filled = 1;
+    
+    tier->samples[i]++;
+    if (value == NOVALUE) return;
+    
+    if (tier->counts[i] == 0) {
+        tier->mins[i] = value;
+        tier->maxs[i] = value;
+        tier->sums[i] = value;
+    }
+    else {
+        if (value < tier->mins[i]) tier->mins[i] = value;
+        if (value > tier->maxs[i]) tier->maxs[i] = value;
+        tier->sums[i] += value;
+    }
+    tier->counts[i]++;
+}
+
+static inline void XRGDataSetBucketMerge(XRGDataSetBucket *bucket, CGFloat min, CGFloat max, CGFloat sum, NSUInteger count) {
+    if (count == 0) return;
+    
+    if (bucket->count == 0) {
+        bucket->min = min;
+        bucket->max = max;
+        bucket->sum = sum;
+    }
+    else {
+        if (min < bucket->min) bucket->min = min;
+        if (max > bucket->max) bucket->max = max;
+        bucket->sum += sum;
+    }
+    bucket->count += count;
+}
+
+#pragma mark - Archive Chunks
+
+// A sealed block of archived values, compressed with XRGGorillaEncode().
+typedef struct {
+    uint8_t *bytes;
+    size_t   byteCount;
+    size_t   sampleCount;
+} XRGArchiveChunk;
+
+#pragma mark - XRGDataSet
+
+@interface XRGDataSet () {
+    XRGExtremaDeque _minDeque;
+    XRGExtremaDeque _maxDeque;
+    uint64_t        _sequence;
+    size_t          _missingCount;      // NOVALUE samples in the window.
+    
+    XRGDataSetTier *_tiers;
+    
+    XRGArchiveChunk *_chunks;           // ring of maxChunks sealed chunks, oldest at _chunkHead.
+    NSUInteger       _maxChunks;
+    NSUInteger       _chunkHead;
+    NSUInteger       _chunkCount;
+    size_t           _chunkBytes;
+    size_t           _chunkSamples;
+    CGFloat         *_liveBlock;
+    size_t           _liveCount;
+    size_t           _samplesPerBlock;
+}
+
+- (void) rebuildExtrema;
+
+@end
 
 @implementation XRGDataSet
 
@@ -52,11 +256,32 @@
 			
 		_currentIndex = 0;
 		_numValues = 0;
+        _ownsValues = YES;
 	}
     
     return self;
 }
 
+- (instancetype) initWithExternalValues:(CGFloat *)values count:(size_t)numValues currentIndex:(NSInteger)currentIndex {
+    self = [self init];
+    if (self) {
+        [self setExternalValues:values count:numValues currentIndex:currentIndex];
+    }
+    
+    return self;
+}
+
+- (void) setExternalValues:(CGFloat *)values count:(size_t)numValues currentIndex:(NSInteger)currentIndex {
+    if (_ownsValues && _values) free(_values);
+    
+    _ownsValues = NO;
+    _values = values;
+    _numValues = values ? numValues : 0;
+    _currentIndex = currentIndex;
+    
+    [self rebuildExtrema];
+}
+
 - (instancetype) initWithContentsOfOtherDataSet:(XRGDataSet *)otherDataSet {
     if (!otherDataSet) return nil;
     
@@ -72,16 +297,15 @@
 		self.currentIndex = otherDataSet.currentIndex;
 		
 		// Set the other class variables.
-		_max = otherDataSet.max;
-		_min = otherDataSet.min;
-		_sum = otherDataSet.sum;
+		[self rebuildExtrema];
 	}
     
     return self;
 }
 
 - (CGFloat) average {
-    return self.sum / (CGFloat)self.numValues;
+    size_t present = _numValues - _missingCount;
+    return present ? _sum / (CGFloat)present : 0;
 }
 
 - (CGFloat) currentValue {
@@ -93,43 +317,63 @@
 
 // return an ordered list of values into the destinationArray given, assumed to be alloced already.
 - (void) valuesInOrder:(CGFloat *)destinationArray {
-    NSInteger index = (NSInteger)self.numValues - 1;
+    XRGDataSetSpans spans = [self orderedSpans];
     
-    for (NSInteger i = self.currentIndex; i >= 0; i--) {
-        if (index < 0) break;
-        
-        destinationArray[index] = self.values[i];
-        index--;
-    }
+    if (spans.olderCount) memcpy(destinationArray, spans.older, spans.olderCount * sizeof(CGFloat));
+    if (spans.newerCount) memcpy(destinationArray + spans.olderCount, spans.newer, spans.newerCount * sizeof(CGFloat));
+}
+
+- (XRGDataSetSpans) orderedSpans {
+    XRGDataSetSpans spans = { NULL, 0, NULL, 0 };
+    if (_values == NULL || _numValues == 0) return spans;
     
-    for (NSInteger i = self.numValues - 1; i > self.currentIndex; i--) {
-        if (index < 0) break;
-      
-        destinationArray[index] = self.values[i];
-        index--;
-    }
+    // Everything after the current index is older than everything up to and including it.
+    size_t split = (size_t)_currentIndex + 1;
+    spans.older = _values + split;
+    spans.olderCount = _numValues - split;
+    spans.newer = _values;
+    spans.newerCount = split;
+    
+    return spans;
+}
+
+// Rebuild the extrema deques and the sum from the ring.  Used after any operation that rewrites the whole
+// buffer, so it is O(n) once rather than per sample.
+- (void) rebuildExtrema {
+    _changeGeneration++;
+    _rewriteCount++;
+    _sum = XRGExtremaDequesRebuild(&_minDeque, &_maxDeque, _values, _values ? _numValues : 0, _currentIndex, &_missingCount);
+    _sequence = _numValues;
+    
+    // The deque fronts are the extrema of the whole ring.
+    _min = XRGExtremaDequeFront(&_minDeque);
+    _max = XRGExtremaDequeFront(&_maxDeque);
 }
 
 - (void) reset {
-    for (NSInteger i = 0; i < self.numValues; i++) {
-        _values[i] = 0;
+    if (_values) XRGVectorFill(0, _values, _numValues);
+    
+    [self rebuildExtrema];
+    
+    for (NSUInteger t = 0; t < _numTiers; t++) {
+        XRGDataSetTierClear(&_tiers[t]);
     }
+    
+    [self clearArchive];
 }
 
 - (void) resize:(size_t)newNumValues {
+    // External storage is resized by its owner.
+    if (!_ownsValues) return;
+    
     if (newNumValues == 0) {
-        self.min = 0;
-        self.max = 0;
-        self.sum = 0;
-        
         free(self.values);
         self.values = NULL;
 		self.numValues = newNumValues;
+        [self rebuildExtrema];
 		return;
     }
     
-    self.sum = 0;
-    
     if (self.values) {
         CGFloat *tmpValues;
         NSInteger newValIndex = (NSInteger)newNumValues - 1;
@@ -139,7 +383,6 @@
             if (newValIndex < 0) break;
             
             tmpValues[newValIndex] = self.values[i];
-            self.sum += tmpValues[newValIndex];
             newValIndex--;
         }
         
@@ -147,7 +390,6 @@
             if (newValIndex < 0) break;
           
             tmpValues[newValIndex] = self.values[i];
-            self.sum += tmpValues[newValIndex];
             newValIndex--;
         }
                 
@@ -160,46 +402,57 @@
         self.currentIndex = 0;
     }
     self.numValues = newNumValues;
+    
+    [self rebuildExtrema];
 }
 
 - (void) setNextValue:(CGFloat)nextVal {
-    if (!self.numValues) return;
+    if (!_numValues) return;
+    _appendedCount++;
 
-    self.currentIndex++;
-    if (self.currentIndex == self.numValues) self.currentIndex = 0;
+    _currentIndex++;
+    if (_currentIndex == _numValues) _currentIndex = 0;
     
-	CGFloat oldValue = self.values[self.currentIndex];
-	
-    self.sum -= self.values[self.currentIndex];
-	self.values[self.currentIndex] = nextVal;
-	self.sum += self.values[self.currentIndex];
-
-    if (oldValue == self.min || oldValue == self.max) {
-#if USE_ACCELERATE
-        UPDATE_EXTREMA();
-#else
-        self.max = self.values[0];
-		self.min = self.values[0];
-        
-        for (NSInteger i = 0; i < self.numValues; i++) {
-            if (self.values[i] < self.min) self.min = self.values[i];
-            if (self.values[i] > self.max) self.max = self.values[i];
-        }
-#endif
-    } else {
-        if (self.values[self.currentIndex] < self.min) self.min = self.values[self.currentIndex];
-        if (self.values[self.currentIndex] > self.max) self.max = self.values[self.currentIndex];
+    // The window was already flat at this value with no gaps, so it still is and the graph doesn't move.
+    if (_min != _max || nextVal != _max || _missingCount) _changeGeneration++;
+    
+    // NOVALUE samples are left out of the sum and the extrema.
+    CGFloat oldVal = _values[_currentIndex];
+    if (oldVal == NOVALUE) _missingCount--;
+    else _sum -= oldVal;
+	_values[_currentIndex] = nextVal;
+    if (nextVal == NOVALUE) _missingCount++;
+    else _sum += nextVal;
+
+    // The value just overwritten has sequence (_sequence + 1 - _numValues), so anything at or before it has left the window.
+    _sequence++;
+    uint64_t oldestExpired = _sequence > _numValues ? _sequence - _numValues : 0;
+    if (nextVal == NOVALUE) {
+        XRGExtremaDequeExpire(&_minDeque, oldestExpired);
+        XRGExtremaDequeExpire(&_maxDeque, oldestExpired);
+    }
+    else {
+        XRGExtremaDequePush(&_minDeque, _sequence, oldestExpired, nextVal, NO);
+        XRGExtremaDequePush(&_maxDeque, _sequence, oldestExpired, nextVal, YES);
+    }
+    
+    for (NSUInteger t = 0; t < _numTiers; t++) {
+        XRGDataSetTierAddValue(&_tiers[t], nextVal);
+    }
+
+    _min = XRGExtremaDequeFront(&_minDeque);
+    _max = XRGExtremaDequeFront(&_maxDeque);
+    
+    if (_liveBlock) {
+        _liveBlock[_liveCount++] = nextVal;
+        if (_liveCount == _samplesPerBlock) [self sealLiveBlock];
     }
 }
 
 - (void) setAllValues:(CGFloat)value {
-	dispatch_apply(self.numValues, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
-		self.values[i] = value;
-	});
+    if (_values) XRGVectorFill(value, _values, _numValues);
 	
-	self.min = value;
-	self.max = value;
-	self.sum = (CGFloat)self.numValues * value;
+	[self rebuildExtrema];
 }
 
 // Set the current values equal to the sum of the current plus the other data set values.
@@ -209,22 +462,8 @@
     if (self.numValues != otherDataSet.numValues) return;
         
     if (otherDataSet.values) {
-#if USE_ACCELERATE
-        vDSP_vaddD(self.values, 1, otherDataSet.values, 1, self.values, 1, self.numValues);
-        UPDATE_EXTREMA();
-#else
-        self.max = self.values[0] + otherDataSet.values[0];
-		self.min = self.values[0] + otherDataSet.values[0];
-        self.sum = 0;
-        
-        for (NSInteger i = 0; i < self.numValues; i++) {
-            self.values[i] += otherDataSet.values[i];
-            
-            if (self.max < self.values[i]) self.max = self.values[i];
-            if (self.min > self.values[i]) self.min = self.values[i];
-            self.sum += self.values[i];
-        }
-#endif
+        XRGVectorAdd(self.values, otherDataSet.values, self.values, self.numValues);
+        [self rebuildExtrema];
     }
 }
 
@@ -235,47 +474,224 @@
     if (self.numValues != otherDataSet.numValues) return;
     
     if (otherDataSet.values) {
-#if USE_ACCELERATE
-        vDSP_vsubD(otherDataSet.values, 1, self.values, 1, self.values, 1, self.numValues);
-        UPDATE_EXTREMA();
-#else
-        self.max = self.values[0] - otherDataSet.values[0];
-		self.min = self.values[0] - otherDataSet.values[0];
-        self.sum = 0;
-
-        for (NSInteger i = 0; i < self.numValues; i++) {
-            self.values[i] -= otherDataSet.values[i];
-            
-            if (self.max < self.values[i]) self.max = self.values[i];
-            if (self.min > self.values[i]) self.min = self.values[i];
-            self.sum += self.values[i];
-        }
-#endif
+        XRGVectorSubtract(self.values, otherDataSet.values, self.values, self.numValues);
+        [self rebuildExtrema];
     }
 }
 
 - (void) divideAllValuesBy:(CGFloat)dividend {
 	if (dividend == 0) return;
 	
-#if USE_ACCELERATE
-    vDSP_vsdivD(self.values, 1, &dividend, self.values, 1, self.numValues);
-    self.max = self.max / dividend;
-    self.min = self.min / dividend;
-#else
-    self.max = self.values[0] / dividend;
-    self.min = self.values[0] / dividend;
-    
-	for (NSInteger i = 0; i < self.numValues; i++) {
-		self.values[i] /= dividend;
-		
-		if (self.max < self.values[i]) self.max = self.values[i];
-		if (self.min > self.values[i]) self.min = self.values[i];
-	}
-#endif
+    if (_values) XRGVectorScale(_values, 1. / dividend, _values, _numValues);
+    [self rebuildExtrema];
+}
+
+#pragma mark - History Tiers
+
+- (void) addTierWithSamplesPerBucket:(NSUInteger)samplesPerBucket capacity:(size_t)numBuckets {
+    if (samplesPerBucket == 0 || numBuckets == 0) return;
+    
+    _tiers = realloc(_tiers, (_numTiers + 1) * sizeof(XRGDataSetTier));
+    
+    // Keep the tiers sorted from finest to coarsest.
+    NSUInteger t = _numTiers;
+    while (t > 0 && _tiers[t - 1].samplesPerBucket > samplesPerBucket) {
+        _tiers[t] = _tiers[t - 1];
+        t--;
+    }
+    
+    XRGDataSetTier *tier = &_tiers[t];
+    tier->samplesPerBucket = samplesPerBucket;
+    tier->capacity = numBuckets;
+    tier->mins = malloc(numBuckets * sizeof(CGFloat));
+    tier->maxs = malloc(numBuckets * sizeof(CGFloat));
+    tier->sums = malloc(numBuckets * sizeof(CGFloat));
+    tier->counts = malloc(numBuckets * sizeof(NSUInteger));
+    tier->samples = malloc(numBuckets * sizeof(NSUInteger));
+    XRGDataSetTierClear(tier);
+    
+    _numTiers++;
+}
+
+- (void) removeAllTiers {
+    for (NSUInteger t = 0; t < _numTiers; t++) {
+        free(_tiers[t].mins);
+        free(_tiers[t].maxs);
+        free(_tiers[t].sums);
+        free(_tiers[t].counts);
+        free(_tiers[t].samples);
+    }
+    free(_tiers);
+    _tiers = NULL;
+    _numTiers = 0;
+}
+
+- (void) summarizeLastSamples:(size_t)numSamples intoBuckets:(XRGDataSetBucket *)buckets count:(size_t)numBuckets {
+    if (numBuckets == 0) return;
+    memset(buckets, 0, numBuckets * sizeof(XRGDataSetBucket));
+    if (numSamples == 0) return;
+    
+    // Samples per output slice.  A source bucket lands in the slice holding its newest sample.
+    CGFloat sliceWidth = (CGFloat)numSamples / (CGFloat)numBuckets;
+    
+    // The raw values are the finest tier, with one sample per bucket.  NOVALUE samples are gaps.
+    if (numSamples <= _numValues || _numTiers == 0) {
+        size_t n = MIN(numSamples, _numValues);
+        NSInteger i = _currentIndex;
+        for (size_t age = 0; age < n; age++) {
+            if (_values[i] != NOVALUE) {
+                size_t slice = numBuckets - 1 - MIN((size_t)(age / sliceWidth), numBuckets - 1);
+                XRGDataSetBucketMerge(&buckets[slice], _values[i], _values[i], _values[i], 1);
+            }
+            if (--i < 0) i = (NSInteger)_numValues - 1;
+        }
+        return;
+    }
+    
+    // Otherwise use the finest tier that covers the range, or the coarsest one if none do.
+    XRGDataSetTier *tier = &_tiers[_numTiers - 1];
+    for (NSUInteger t = 0; t < _numTiers; t++) {
+        if (_tiers[t].samplesPerBucket * _tiers[t].capacity >= numSamples) {
+            tier = &_tiers[t];
+            break;
+        }
+    }
+    
+    size_t i = tier->index;
+    size_t age = 0;
+    for (size_t k = 0; k < tier->filled && age < numSamples; k++) {
+        size_t slice = numBuckets - 1 - MIN((size_t)(age / sliceWidth), numBuckets - 1);
+        XRGDataSetBucketMerge(&buckets[slice], tier->mins[i], tier->maxs[i], tier->sums[i], tier->counts[i]);
+        
+        // Gaps count toward the age, so older buckets stay where they were in time.
+        age += tier->samples[i];
+        i = (i == 0) ? tier->capacity - 1 : i - 1;
+    }
+}
+
+#pragma mark - Graph Span History
+
+// Values per sealed archive chunk for keepHistoryWithSamplesPerMinute:.
+#define XRGDataSetHistoryBlockSamples 256
+
+- (void) keepHistoryWithSamplesPerMinute:(NSUInteger)samplesPerMinute {
+    [self removeAllTiers];
+    [self disableArchive];
+    if (samplesPerMinute == 0) return;
+    
+    [self addTierWithSamplesPerBucket:samplesPerMinute capacity:24 * 60];
+    
+    size_t hourSamples = 60 * samplesPerMinute;
+    [self enableArchiveWithSamplesPerBlock:XRGDataSetHistoryBlockSamples maxChunks:(hourSamples + XRGDataSetHistoryBlockSamples - 1) / XRGDataSetHistoryBlockSamples];
+}
+
+#pragma mark - Archive
+
+- (void) enableArchiveWithSamplesPerBlock:(size_t)samplesPerBlock maxChunks:(NSUInteger)maxChunks {
+    if (samplesPerBlock == 0 || maxChunks == 0) return;
+    
+    [self disableArchive];
+    
+    _samplesPerBlock = samplesPerBlock;
+    _maxChunks = maxChunks;
+    _liveBlock = malloc(samplesPerBlock * sizeof(CGFloat));
+    _chunks = calloc(maxChunks, sizeof(XRGArchiveChunk));
+}
+
+- (void) disableArchive {
+    [self clearArchive];
+    
+    free(_liveBlock);
+    free(_chunks);
+    _liveBlock = NULL;
+    _chunks = NULL;
+    _samplesPerBlock = 0;
+    _maxChunks = 0;
+}
+
+- (void) clearArchive {
+    for (NSUInteger c = 0; c < _chunkCount; c++) {
+        free(_chunks[(_chunkHead + c) % _maxChunks].bytes);
+    }
+    
+    _chunkHead = 0;
+    _chunkCount = 0;
+    _chunkBytes = 0;
+    _chunkSamples = 0;
+    _liveCount = 0;
+}
+
+- (void) sealLiveBlock {
+    XRGArchiveChunk chunk;
+    chunk.byteCount = XRGGorillaEncode(_liveBlock, _liveCount, &chunk.bytes);
+    chunk.sampleCount = _liveCount;
+    _liveCount = 0;
+    
+    if (chunk.byteCount == 0) return;
+    
+    // Drop the oldest chunk if we're full.
+    if (_chunkCount == _maxChunks) {
+        XRGArchiveChunk *oldest = &_chunks[_chunkHead];
+        _chunkBytes -= oldest->byteCount;
+        _chunkSamples -= oldest->sampleCount;
+        free(oldest->bytes);
+        
+        _chunkHead = (_chunkHead + 1) % _maxChunks;
+        _chunkCount--;
+    }
+    
+    _chunks[(_chunkHead + _chunkCount) % _maxChunks] = chunk;
+    _chunkCount++;
+    _chunkBytes += chunk.byteCount;
+    _chunkSamples += chunk.sampleCount;
+}
+
+- (size_t) archivedSampleCount {
+    return _chunkSamples + _liveCount;
+}
+
+- (size_t) archiveCapacity {
+    return _maxChunks * _samplesPerBlock;
+}
+
+- (size_t) archiveByteCount {
+    return _chunkBytes + _samplesPerBlock * sizeof(CGFloat);
+}
+
+- (size_t) decodeLastArchivedValues:(size_t)count into:(CGFloat *)destination {
+    size_t total = self.archivedSampleCount;
+    if (count > total) count = total;
+    
+    // Skip whole chunks that are older than what was asked for, then part of the first chunk we need.
+    size_t skip = total - count;
+    CGFloat *out = destination;
+    for (NSUInteger c = 0; c < _chunkCount; c++) {
+        XRGArchiveChunk *chunk = &_chunks[(_chunkHead + c) % _maxChunks];
+        if (skip >= chunk->sampleCount) {
+            skip -= chunk->sampleCount;
+            continue;
+        }
+        
+        XRGGorillaDecode(chunk->bytes, chunk->byteCount, chunk->sampleCount, skip, out);
+        out += chunk->sampleCount - skip;
+        skip = 0;
+    }
+    
+    if (_liveCount > skip) {
+        memcpy(out, _liveBlock + skip, (_liveCount - skip) * sizeof(CGFloat));
+    }
+    
+    return count;
 }
 
 - (void) dealloc {
-    if (_values) free(_values);
+    if (_values && _ownsValues) free(_values);
+    [self removeAllTiers];
+    [self disableArchive];
+    free(_minDeque.sequences);
+    free(_minDeque.values);
+    free(_maxDeque.sequences);
+    free(_maxDeque.values);
 }
 
 
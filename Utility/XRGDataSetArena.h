@@ -0,0 +1,71 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGDataSetArena.h
+//
+
+#import <Foundation/Foundation.h>
+#import "XRGDataSet.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// One contiguous block holding every ring for a module, numSeries rows of capacity values each.  Rows are reserved
+/// with room to spare, so resizing a window within the capacity reorders each ring in place without allocating, and
+/// growing past it doubles the capacity, so a drag-resize costs O(1) amortized allocations instead of one per data
+/// set per step.  The block only moves when the capacity changes, never while values are being added or drawn.
+///
+/// The arena doesn't track a current index; the caller passes the rings' index to resize: and gets the new one back.
+@interface XRGDataSetArena : NSObject
+
+/// Identifies the arena when debugging.
+@property (nonatomic, copy) NSString *name;
+@property (nonatomic, readonly) NSUInteger numSeries;
+@property (nonatomic, readonly) size_t numValues;
+
+/// Values reserved per row.  Row n starts at valuesForSeries:0 + n * capacity.
+@property (nonatomic, readonly) size_t capacity;
+
+/// Bytes currently allocated.
+@property (nonatomic, readonly) size_t footprint;
+
+- (instancetype)initWithName:(NSString *)name numberOfSeries:(NSUInteger)numSeries numValues:(size_t)numValues;
+
+- (nullable CGFloat *)valuesForSeries:(NSUInteger)series;
+
+/*! Changes the ring length, keeping the newest values of each row and leaving the newest in the last slot, the same as XRGDataSet.  Returns the new current index.
+ @param currentIndex The index of the newest value in every row before the resize.
+ */
+- (NSInteger)resize:(size_t)newNumValues currentIndex:(NSInteger)currentIndex;
+
+/// Adds or removes rows at the end, keeping the rest.  New rows start at 0.
+- (void)setNumberOfSeries:(NSUInteger)numSeries;
+
+/// Points dataSets[n] at row n.  Needed after anything that can move the block: resize:currentIndex: and setNumberOfSeries:.
+- (void)attachDataSets:(NSArray<XRGDataSet *> *)dataSets currentIndex:(NSInteger)currentIndex;
+
+/// The bytes held by every arena.  Shown in the XRGDiagnostics report.
++ (size_t)totalFootprint;
+
+@end
+
+NS_ASSUME_NONNULL_END
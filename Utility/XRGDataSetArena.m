@@ -0,0 +1,183 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGDataSetArena.m
+//
+
+#import "XRGDataSetArena.h"
+#import "XRGVectorKernels.h"
+
+#include <stdatomic.h>
+
+static _Atomic size_t XRGArenaTotalFootprint = 0;
+
+static void XRGReverseValues(CGFloat *values, size_t count) {
+    for (size_t i = 0, j = count; i + 1 < j; i++, j--) {
+        CGFloat temp = values[i];
+        values[i] = values[j - 1];
+        values[j - 1] = temp;
+    }
+}
+
+// Reorder a ring of oldCount values with the newest at oldIndex so it holds the newest newCount of them, oldest first and
+// newest at newCount - 1, zero-filling the front if the ring grew.  The row must have room for both counts.
+static void XRGReorderRingInPlace(CGFloat *row, size_t oldCount, NSInteger oldIndex, size_t newCount) {
+    if (oldCount) {
+        // Rotate left by oldIndex + 1 with three reversals so the oldest value is first.
+        size_t split = (size_t)(oldIndex + 1) % oldCount;
+        if (split) {
+            XRGReverseValues(row, split);
+            XRGReverseValues(row + split, oldCount - split);
+            XRGReverseValues(row, oldCount);
+        }
+    }
+    
+    if (newCount <= oldCount) {
+        memmove(row, row + (oldCount - newCount), newCount * sizeof(CGFloat));
+    }
+    else {
+        memmove(row + (newCount - oldCount), row, oldCount * sizeof(CGFloat));
+        XRGVectorFill(0, row, newCount - oldCount);
+    }
+}
+
+@interface XRGDataSetArena () {
+    CGFloat *_block;
+}
+@end
+
+@implementation XRGDataSetArena
+
++ (size_t)totalFootprint {
+    return atomic_load(&XRGArenaTotalFootprint);
+}
+
+- (instancetype)initWithName:(NSString *)name numberOfSeries:(NSUInteger)numSeries numValues:(size_t)numValues {
+    self = [super init];
+    if (self) {
+        _name = [name copy];
+        _numSeries = numSeries;
+        _numValues = 0;
+        _capacity = 0;
+        _block = NULL;
+        
+        [self resize:numValues currentIndex:0];
+    }
+    
+    return self;
+}
+
+- (void)dealloc {
+    free(_block);
+    atomic_fetch_sub(&XRGArenaTotalFootprint, _footprint);
+}
+
+- (CGFloat *)valuesForSeries:(NSUInteger)series {
+    return (_block && series < _numSeries) ? _block + series * _capacity : NULL;
+}
+
+- (NSInteger)resize:(size_t)newNumValues currentIndex:(NSInteger)currentIndex {
+    size_t oldNumValues = _numValues;
+    
+    if (newNumValues > _capacity) {
+        // Grow geometrically so a window being dragged wider reallocates a handful of times, not every step.
+        [self setCapacity:MAX(newNumValues, _capacity * 2) numSeries:_numSeries];
+        if (newNumValues > _capacity) newNumValues = _capacity;
+    }
+    
+    for (NSUInteger s = 0; s < _numSeries; s++) {
+        XRGReorderRingInPlace(_block + s * _capacity, oldNumValues, currentIndex, newNumValues);
+    }
+    _numValues = newNumValues;
+    
+    // Give memory back if the window shrank a lot.
+    if (newNumValues * 4 < _capacity) {
+        [self setCapacity:newNumValues * 2 numSeries:_numSeries];
+    }
+    
+    // Match XRGDataSet: the newest value ends up in the last slot, unless there was no history to keep.
+    return (oldNumValues && newNumValues) ? (NSInteger)newNumValues - 1 : 0;
+}
+
+- (void)setNumberOfSeries:(NSUInteger)numSeries {
+    if (numSeries == _numSeries) return;
+    
+    NSUInteger oldNumSeries = _numSeries;
+    [self setCapacity:_capacity numSeries:numSeries];
+    
+    // If the block couldn't grow, _numSeries is unchanged and there are no new rows to clear.
+    for (NSUInteger s = oldNumSeries; s < _numSeries; s++) {
+        XRGVectorFill(0, _block + s * _capacity, _capacity);
+    }
+}
+
+- (void)attachDataSets:(NSArray<XRGDataSet *> *)dataSets currentIndex:(NSInteger)currentIndex {
+    for (NSUInteger s = 0; s < dataSets.count; s++) {
+        [dataSets[s] setExternalValues:[self valuesForSeries:s] count:_numValues currentIndex:currentIndex];
+    }
+}
+
+#pragma mark - Private
+
+// Reallocate for a new row capacity and/or row count, moving the first _numValues of every row that is kept.  If the
+// allocation fails, the block, capacity and row count are left as they were.
+- (void)setCapacity:(size_t)newCapacity numSeries:(NSUInteger)newNumSeries {
+    size_t oldCapacity = _capacity;
+    NSUInteger keptSeries = MIN(_numSeries, newNumSeries);
+    size_t newCount = newCapacity * newNumSeries;
+    
+    if (newCount && newCapacity < oldCapacity && keptSeries > 1) {
+        // Pack the rows into a new block rather than in place, so the arena is untouched if the allocation fails.
+        CGFloat *newBlock = malloc(newCount * sizeof(CGFloat));
+        if (!newBlock) return;
+        for (NSUInteger s = 0; s < keptSeries; s++) {
+            memcpy(newBlock + s * newCapacity, _block + s * oldCapacity, _numValues * sizeof(CGFloat));
+        }
+        free(_block);
+        _block = newBlock;
+    }
+    else {
+        // A failed realloc leaves the old block as it was, so nothing is moved until it succeeds.
+        CGFloat *newBlock = newCount ? realloc(_block, newCount * sizeof(CGFloat)) : NULL;
+        if (newCount && !newBlock) return;
+        if (!newCount) free(_block);
+        _block = newBlock;
+        
+        if (newCapacity > oldCapacity) {
+            // Spread rows out after growing; each row moves toward the end, so go last to first.
+            for (NSUInteger s = keptSeries; s-- > 1; ) {
+                memmove(_block + s * newCapacity, _block + s * oldCapacity, _numValues * sizeof(CGFloat));
+            }
+        }
+    }
+    
+    _capacity = newCapacity;
+    _numSeries = newNumSeries;
+    
+    size_t oldFootprint = _footprint;
+    _footprint = newCount * sizeof(CGFloat);
+    atomic_fetch_add(&XRGArenaTotalFootprint, _footprint);
+    atomic_fetch_sub(&XRGArenaTotalFootprint, oldFootprint);
+}
+
+@end
@@ -0,0 +1,79 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGDataSetGroup.h
+//
+
+#import <Foundation/Foundation.h>
+#import "XRGDataSet.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// A set of series that are always sampled together, such as one per CPU core or one per GPU.  The series share
+/// one contiguous block of storage (an XRGDataSetArena unless the storage is external) and one current index, and
+/// the group keeps a running per-slot average across all series so a combined view costs nothing extra at draw time.
+@interface XRGDataSetGroup : NSObject
+
+/// Names the group's storage for footprint reporting (see XRGDataSetArena).
+@property (nonatomic, copy) NSString *name;
+
+@property (nonatomic, readonly) NSUInteger numSeries;
+@property (nonatomic, readonly) size_t numValues;
+@property (nonatomic, readonly) NSInteger currentIndex;
+
+/// One data set per series, backed by the group's storage.  Values should be added through the group so the average stays current.
+@property (nonatomic, readonly) NSArray<XRGDataSet *> *dataSets;
+
+/// The per-slot average of all the series.
+@property (nonatomic, readonly) XRGDataSet *averageDataSet;
+
+/// Increases whenever any series' changeGeneration does, or the storage is rewritten.
+@property (nonatomic, readonly) NSUInteger changeGeneration;
+
+- (instancetype)initWithNumberOfSeries:(NSUInteger)numSeries numValues:(size_t)numValues;
+
+/*! Initializes a group over storage owned by someone else, such as an XRGHistoryStore.  The storage holds numSeries rings of numValues values, series-major.  The group never frees or reallocates it, so setNumberOfSeries: and resize: do nothing; the owner re-points the group with setExternalStorage:numValues:currentIndex: instead.
+ */
+- (instancetype)initWithExternalStorage:(nullable CGFloat *)storage numberOfSeries:(NSUInteger)numSeries numValues:(size_t)numValues currentIndex:(NSInteger)currentIndex;
+- (void)setExternalStorage:(nullable CGFloat *)storage numValues:(size_t)numValues currentIndex:(NSInteger)currentIndex;
+
+/// NO if the storage is owned by someone else (see initWithExternalStorage:numberOfSeries:numValues:currentIndex:).
+@property (nonatomic, readonly) BOOL ownsStorage;
+
+/// Adds or removes series at the end of the group, keeping the history of the series that remain.  New series start at 0.
+- (void)setNumberOfSeries:(NSUInteger)numSeries;
+- (void)resize:(size_t)newNumValues;
+- (void)reset;
+
+/// Adds the next sample for every series.  values holds numSeries entries, in series order.
+- (void)setNextValues:(const CGFloat *)values;
+- (void)setAllValues:(CGFloat)value forSeries:(NSUInteger)series;
+
+/*! Computes the per-slot average across every series in ring order, along with the min, max and sum of those averages.  The series are accumulated with the vector kernels, one contiguous row at a time, and the extrema and sum come from a single fused pass.
+ @param destination Assumed to be alloced already with room for numValues values.
+ */
+- (void)getAverageValues:(CGFloat *)destination min:(nullable CGFloat *)min max:(nullable CGFloat *)max sum:(nullable CGFloat *)sum;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,223 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGDataSetGroup.m
+//
+
+#import "XRGDataSetGroup.h"
+#import "XRGDataSetArena.h"
+#import "XRGVectorKernels.h"
+
+@interface XRGDataSetGroup () {
+    XRGDataSetArena *_arena;    // Row 0 backs averageDataSet.  If the group owns its storage, rows 1 through numSeries are the series.
+    CGFloat *_storage;          // numSeries rows of _stride values, one row per series.
+    size_t   _stride;
+}
+
+@property (nonatomic) NSMutableArray<XRGDataSet *> *mutableDataSets;
+
+@end
+
+@implementation XRGDataSetGroup
+
+- (instancetype)initWithNumberOfSeries:(NSUInteger)numSeries numValues:(size_t)numValues {
+    self = [super init];
+    if (self) {
+        _numValues = numValues;
+        _numSeries = numSeries;
+        _currentIndex = 0;
+        
+        _ownsStorage = YES;
+        _arena = [[XRGDataSetArena alloc] initWithName:@"XRGDataSetGroup" numberOfSeries:numSeries + 1 numValues:numValues];
+        [self arenaChanged];
+        
+        _mutableDataSets = [NSMutableArray arrayWithCapacity:numSeries];
+        for (NSUInteger s = 0; s < numSeries; s++) {
+            [_mutableDataSets addObject:[[XRGDataSet alloc] initWithExternalValues:[self rowForSeries:s] count:numValues currentIndex:0]];
+        }
+        _averageDataSet = [[XRGDataSet alloc] initWithExternalValues:[_arena valuesForSeries:0] count:numValues currentIndex:0];
+    }
+    
+    return self;
+}
+
+- (instancetype)initWithExternalStorage:(CGFloat *)storage numberOfSeries:(NSUInteger)numSeries numValues:(size_t)numValues currentIndex:(NSInteger)currentIndex {
+    self = [self initWithNumberOfSeries:numSeries numValues:0];
+    if (self) {
+        [self setExternalStorage:storage numValues:numValues currentIndex:currentIndex];
+    }
+    
+    return self;
+}
+
+- (void)setExternalStorage:(CGFloat *)storage numValues:(size_t)numValues currentIndex:(NSInteger)currentIndex {
+    if (!storage) numValues = 0;
+    
+    // Keep only the averages row in the arena.
+    if (_ownsStorage) [_arena setNumberOfSeries:1];
+    [_arena resize:numValues currentIndex:0];
+    
+    _ownsStorage = NO;
+    _storage = storage;
+    _stride = numValues;
+    _numValues = numValues;
+    _currentIndex = currentIndex;
+    
+    [self storageChanged];
+}
+
+- (NSString *)name {
+    return _arena.name;
+}
+
+- (void)setName:(NSString *)name {
+    _arena.name = name;
+}
+
+- (NSArray<XRGDataSet *> *)dataSets {
+    return self.mutableDataSets;
+}
+
+- (CGFloat *)rowForSeries:(NSUInteger)series {
+    return _storage ? _storage + series * _stride : NULL;
+}
+
+// Pick up the arena's layout after it resizes.  Only used when the group owns its storage.
+- (void)arenaChanged {
+    _storage = _numSeries ? [_arena valuesForSeries:1] : NULL;
+    _stride = _arena.capacity;
+}
+
+// Point every data set back at the storage and recompute the averages.  Used after anything that rewrites the storage.
+- (void)storageChanged {
+    _changeGeneration++;
+    
+    for (NSUInteger s = 0; s < _numSeries; s++) {
+        [self.mutableDataSets[s] setExternalValues:[self rowForSeries:s] count:_numValues currentIndex:_currentIndex];
+    }
+    
+    // The average data set's extrema come from its own rebuild, so don't scan for them here too.
+    CGFloat *averages = [_arena valuesForSeries:0];
+    if (averages) [self getAverageValues:averages min:NULL max:NULL sum:NULL];
+    [self.averageDataSet setExternalValues:averages count:_numValues currentIndex:_currentIndex];
+}
+
+- (void)setNumberOfSeries:(NSUInteger)numSeries {
+    // External storage is resized by its owner.
+    if (numSeries == _numSeries || !_ownsStorage) return;
+    
+    [_arena setNumberOfSeries:numSeries + 1];
+    
+    while (self.mutableDataSets.count > numSeries) {
+        [self.mutableDataSets removeLastObject];
+    }
+    while (self.mutableDataSets.count < numSeries) {
+        [self.mutableDataSets addObject:[[XRGDataSet alloc] init]];
+    }
+    _numSeries = numSeries;
+    
+    [self arenaChanged];
+    [self storageChanged];
+}
+
+- (void)resize:(size_t)newNumValues {
+    if (newNumValues == _numValues || !_ownsStorage) return;
+    
+    _currentIndex = [_arena resize:newNumValues currentIndex:_currentIndex];
+    _numValues = _arena.numValues;
+    
+    [self arenaChanged];
+    [self storageChanged];
+}
+
+- (void)reset {
+    for (NSUInteger s = 0; s < _numSeries; s++) {
+        CGFloat *row = [self rowForSeries:s];
+        if (row) XRGVectorFill(0, row, _numValues);
+    }
+    
+    [self storageChanged];
+}
+
+- (void)setNextValues:(const CGFloat *)values {
+    if (_numValues == 0) return;
+    
+    _currentIndex++;
+    if (_currentIndex == _numValues) _currentIndex = 0;
+    
+    // Each data set advances to the same index as the group, so this keeps their extrema and sums current too.
+    CGFloat slotSum = 0;
+    BOOL changed = NO;
+    for (NSUInteger s = 0; s < _numSeries; s++) {
+        XRGDataSet *dataSet = self.mutableDataSets[s];
+        NSUInteger generation = dataSet.changeGeneration;
+        [dataSet setNextValue:values[s]];
+        changed |= dataSet.changeGeneration != generation;
+        slotSum += values[s];
+    }
+    if (changed) _changeGeneration++;
+    
+    [self.averageDataSet setNextValue:_numSeries ? slotSum / (CGFloat)_numSeries : 0];
+}
+
+- (void)setAllValues:(CGFloat)value forSeries:(NSUInteger)series {
+    if (series >= _numSeries) return;
+    
+    CGFloat *row = [self rowForSeries:series];
+    if (row) XRGVectorFill(value, row, _numValues);
+    
+    [self storageChanged];
+}
+
+- (void)getAverageValues:(CGFloat *)destination min:(CGFloat *)min max:(CGFloat *)max sum:(CGFloat *)sum {
+    if (_numValues == 0) return;
+    
+    if (_numSeries == 0) {
+        memset(destination, 0, _numValues * sizeof(CGFloat));
+        if (min) *min = 0;
+        if (max) *max = 0;
+        if (sum) *sum = 0;
+        return;
+    }
+    
+    // Accumulate one contiguous row at a time.
+    memcpy(destination, _storage, _numValues * sizeof(CGFloat));
+    for (NSUInteger s = 1; s < _numSeries; s++) {
+        XRGVectorAdd(destination, _storage + s * _stride, destination, _numValues);
+    }
+    
+    // Divide rather than scale by the reciprocal, so a slot that is NOVALUE in every series, like a history gap,
+    // averages to exactly NOVALUE.  Then one fused pass for the extrema and sum if they're wanted.
+    CGFloat numSeries = (CGFloat)_numSeries;
+    for (size_t i = 0; i < _numValues; i++) destination[i] /= numSeries;
+    if (!min && !max && !sum) return;
+    
+    CGFloat newMin, newMax, newSum;
+    XRGVectorMinMaxSum(destination, _numValues, &newMin, &newMax, &newSum);
+    
+    if (min) *min = newMin;
+    if (max) *max = newMax;
+    if (sum) *sum = newSum;
+}
+
+@end
@@ -0,0 +1,173 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGDecimation.c
+//
+
+#include "XRGDecimation.h"
+
+#include <math.h>
+
+// MARK: - Min/Max
+
+static void XRGDecimationAccumulate(XRGDecimationColumn *column, const double *values, size_t count, double skipValue) {
+    for (size_t i = 0; i < count; i++) {
+        double value = values[i];
+        if (value == skipValue) continue;
+        
+        if (column->count == 0) {
+            column->min = value;
+            column->max = value;
+            column->first = value;
+        }
+        else {
+            if (value < column->min) column->min = value;
+            if (value > column->max) column->max = value;
+        }
+        column->last = value;
+        column->count++;
+    }
+}
+
+void XRGDecimateMinMax(const double *older, size_t olderCount, const double *newer, size_t newerCount, double skipValue, XRGDecimationColumn *columns, size_t columnCount) {
+    size_t total = olderCount + newerCount;
+    
+    for (size_t c = 0; c < columnCount; c++) {
+        XRGDecimationColumn *column = &columns[c];
+        column->min = column->max = column->first = column->last = 0;
+        column->count = 0;
+        
+        // Column c covers [start, end).  When there are fewer samples than columns, some columns are empty.
+        size_t start = (size_t)((unsigned long long)c * total / columnCount);
+        size_t end = (size_t)((unsigned long long)(c + 1) * total / columnCount);
+        
+        if (start < olderCount) {
+            size_t olderEnd = end < olderCount ? end : olderCount;
+            XRGDecimationAccumulate(column, older + start, olderEnd - start, skipValue);
+        }
+        if (end > olderCount) {
+            size_t newerStart = start > olderCount ? start - olderCount : 0;
+            XRGDecimationAccumulate(column, newer + newerStart, end - olderCount - newerStart, skipValue);
+        }
+    }
+}
+
+// MARK: - LTTB
+
+typedef struct {
+    const double *older;
+    size_t olderCount;
+    const double *newer;
+    double skipValue;
+} XRGDecimationSpans;
+
+static inline double XRGDecimationValue(const XRGDecimationSpans *spans, size_t i) {
+    return i < spans->olderCount ? spans->older[i] : spans->newer[i - spans->olderCount];
+}
+
+size_t XRGDecimateLTTB(const double *older, size_t olderCount, const double *newer, size_t newerCount, double skipValue, size_t threshold, size_t *indices) {
+    XRGDecimationSpans spans = { older, olderCount, newer, skipValue };
+    size_t total = olderCount + newerCount;
+    size_t kept = 0;
+    
+    if (threshold >= total || threshold < 3) {
+        for (size_t i = 0; i < total; i++) {
+            if (XRGDecimationValue(&spans, i) != skipValue) indices[kept++] = i;
+        }
+        
+        // Too few points to pick from buckets; the ends are the most that can be kept.
+        if (threshold < 3 && kept > threshold) {
+            if (threshold == 0) return 0;
+            if (threshold == 2) indices[1] = indices[kept - 1];
+            return threshold;
+        }
+        return kept;
+    }
+    
+    size_t first = 0;
+    while (first < total && XRGDecimationValue(&spans, first) == skipValue) first++;
+    if (first == total) return 0;
+    size_t last = total - 1;
+    while (XRGDecimationValue(&spans, last) == skipValue) last--;
+    
+    indices[kept++] = first;
+    if (last == first) return kept;
+    
+    // The threshold - 2 buckets share the samples strictly between first and last.
+    size_t bucketCount = threshold - 2;
+    double bucketSize = (double)(last - first - 1) / (double)bucketCount;
+    size_t selected = first;
+    
+    for (size_t b = 0; b < bucketCount; b++) {
+        size_t start = first + 1 + (size_t)floor((double)b * bucketSize);
+        size_t end = first + 1 + (size_t)floor((double)(b + 1) * bucketSize);
+        if (end > last) end = last;
+        
+        // The third corner of the triangle is the average of the next bucket, or the last sample after the final bucket.
+        size_t nextStart = end;
+        size_t nextEnd = b + 1 < bucketCount ? first + 1 + (size_t)floor((double)(b + 2) * bucketSize) : last + 1;
+        if (nextEnd > last + 1) nextEnd = last + 1;
+        double averageX = 0, averageY = 0;
+        size_t averageCount = 0;
+        for (size_t i = nextStart; i < nextEnd; i++) {
+            double value = XRGDecimationValue(&spans, i);
+            if (value == skipValue) continue;
+            averageX += (double)i;
+            averageY += value;
+            averageCount++;
+        }
+        if (averageCount) {
+            averageX /= (double)averageCount;
+            averageY /= (double)averageCount;
+        }
+        else {
+            averageX = (double)last;
+            averageY = XRGDecimationValue(&spans, last);
+        }
+        
+        double selectedX = (double)selected;
+        double selectedY = XRGDecimationValue(&spans, selected);
+        double largestArea = -1;
+        size_t largestIndex = selected;
+        for (size_t i = start; i < end; i++) {
+            double value = XRGDecimationValue(&spans, i);
+            if (value == skipValue) continue;
+            
+            // Twice the triangle's area; only the comparison matters.
+            double area = fabs((selectedX - averageX) * (value - selectedY) - (selectedX - (double)i) * (averageY - selectedY));
+            if (area > largestArea) {
+                largestArea = area;
+                largestIndex = i;
+            }
+        }
+        
+        // A bucket of missing samples contributes nothing.
+        if (largestArea >= 0) {
+            indices[kept++] = largestIndex;
+            selected = largestIndex;
+        }
+    }
+    
+    indices[kept++] = last;
+    return kept;
+}
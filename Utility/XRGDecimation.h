@@ -0,0 +1,56 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGDecimation.h
+//
+
+#ifndef XRG_DECIMATION_H
+#define XRG_DECIMATION_H
+
+#include <stddef.h>
+
+// Reduces a run of samples to about one point per pixel before it's turned into a path, so drawing costs O(pixels)
+// however long the history is.  The samples are passed as two spans, older then newer, the same way XRGDataSetSpans
+// lays out a ring.  Samples equal to skipValue (NOVALUE for the graphs) are treated as missing.
+
+/// Summary of the samples that fall in one pixel column.  A column with a count of 0 holds no samples.
+typedef struct {
+    double min;
+    double max;
+    double first;       // The oldest sample in the column.
+    double last;        // The newest sample in the column.
+    size_t count;
+} XRGDecimationColumn;
+
+/// Splits the samples into columnCount equal slices, oldest first, and summarizes each one.  Keeping the min and max of
+/// every column means a one-sample spike is still drawn however many samples share its pixel.
+void XRGDecimateMinMax(const double *older, size_t olderCount, const double *newer, size_t newerCount, double skipValue, XRGDecimationColumn *columns, size_t columnCount);
+
+/// Largest-Triangle-Three-Buckets (Steinarsson): keeps the first and last samples and, from each of threshold - 2 equal
+/// buckets in between, the sample that makes the largest triangle with the previous pick and the average of the next
+/// bucket.  That keeps the shape of a line graph with far fewer points than min/max pairs.  Writes the positions
+/// (0 is the oldest sample) of the samples kept to indices, in order, and returns how many there are: at most
+/// threshold, or every sample that isn't missing if there are no more than threshold of them.
+size_t XRGDecimateLTTB(const double *older, size_t olderCount, const double *newer, size_t newerCount, double skipValue, size_t threshold, size_t *indices);
+
+#endif
@@ -0,0 +1,105 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGDiagnostics.h
+//
+
+#import <Foundation/Foundation.h>
+#import "XRGStatsManager.h"
+
+typedef NS_ENUM(NSInteger, XRGDiagnosticsPhase) {
+    XRGDiagnosticsPhaseCollect,     // On the module's sampler queue.
+    XRGDiagnosticsPhaseGraph,       // Applying a graph tick, or graphUpdate: for views that collect in place.
+    XRGDiagnosticsPhaseFast,
+    XRGDiagnosticsPhaseMin5,
+    XRGDiagnosticsPhaseMin30,
+    XRGDiagnosticsPhaseDraw,
+    XRGDiagnosticsPhaseFrame,       // Every view's draw time between two graph ticks, recorded under the sampler.
+    XRGDiagnosticsPhaseCount
+};
+
+typedef NS_ENUM(NSInteger, XRGDiagnosticsRedraw) {
+    XRGDiagnosticsRedrawFull,       // The whole view was invalidated.
+    XRGDiagnosticsRedrawPartial,    // Only the part that changed, e.g. the text.
+    XRGDiagnosticsRedrawAvoided,    // Nothing it draws from changed, so it wasn't invalidated.
+    XRGDiagnosticsRedrawCount
+};
+
+/// One timed call.  Use XRG_DIAGNOSTICS_SCOPE rather than filling this in.
+typedef struct {
+    XRGStatsModule module;
+    XRGDiagnosticsPhase phase;
+    uint64_t start;
+    int64_t blocksInUse;            // -1 if allocations aren't being counted for this call.
+    int64_t bytesInUse;
+} XRGDiagnosticsScope;
+
+/// The module object says it samples for, or XRGStatsModuleNameSampler if it doesn't say.
+XRGStatsModule XRGDiagnosticsModuleForObject(id object);
+
+XRGDiagnosticsScope XRGDiagnosticsBegin(XRGStatsModule module, XRGDiagnosticsPhase phase);
+void XRGDiagnosticsEnd(XRGDiagnosticsScope *scope);
+
+/// Times the rest of the enclosing block, however it's left, as one call of phase for module.
+#define XRG_DIAGNOSTICS_SCOPE(module, phase) \
+    XRGDiagnosticsScope xrgDiagnosticsScope __attribute__((cleanup(XRGDiagnosticsEnd), unused)) = XRGDiagnosticsBegin((module), (phase))
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// Where XRG's own CPU time goes: a latency histogram for every module and phase, plus, while countsAllocations is
+/// on, the malloc blocks and bytes each main thread call leaves behind.  The allocation figures come from
+/// malloc_zone_statistics, which reports what's in use rather than a running count of allocations, so they're the
+/// net change over the call and include anything another thread allocated or freed meanwhile.
+@interface XRGDiagnostics : NSObject
+
+@property (class, readonly) XRGDiagnostics *shared;
+
+/// Off by default; reading the malloc zone statistics takes the zone locks, so it costs more than the timing.
+@property BOOL countsAllocations;
+
+/// Records a call that was timed some other way, e.g. on a queue where a scope doesn't fit.  Safe from any thread.
+- (void)recordDuration:(uint64_t)nanoseconds module:(XRGStatsModule)module phase:(XRGDiagnosticsPhase)phase;
+
+/// Counts one change-driven invalidation decision (see XRGGenericView's setNeedsDisplayInRect:forGeneration:part:).  Main thread only.
+- (void)recordRedraw:(XRGDiagnosticsRedraw)redraw module:(XRGStatsModule)module;
+
+/// Records the draw time of every view since the last call as one Frame.  Called at each graph tick.  Main thread only.
+- (void)finishFrame;
+
+- (void)reset;
+
+/// A table of every module and phase that has been timed: count, mean, p50, p90, p99, p99.9 and max in ms, and the
+/// average net allocations per call.  Followed by each module's full, partial and avoided redraws, the label cache
+/// and the memory held by the data set arenas.
+- (NSString *)report;
+
+/// The report followed by every histogram's non-empty buckets, for comparing runs.
+- (NSString *)dump;
+
+- (BOOL)writeDumpToURL:(NSURL *)url error:(NSError **)error;
+
++ (NSString *)nameForPhase:(XRGDiagnosticsPhase)phase;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,264 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGDiagnostics.m
+//
+
+#import "XRGDiagnostics.h"
+#import "XRGLatencyHistogram.h"
+#import "XRGSampler.h"
+#import "XRGLabelCache.h"
+#import "XRGDataSetArena.h"
+
+#include <malloc/malloc.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#define XRG_DIAGNOSTICS_MODULE_COUNT (XRGStatsModuleNameSampler + 1)
+
+static XRGLatencyHistogram *XRGDiagnosticsHistograms[XRG_DIAGNOSTICS_MODULE_COUNT][XRGDiagnosticsPhaseCount];
+static atomic_bool XRGDiagnosticsCountsAllocations;
+
+// Only touched on the main thread.
+typedef struct {
+    uint64_t calls;
+    int64_t blocks;
+    int64_t bytes;
+} XRGDiagnosticsAllocations;
+static XRGDiagnosticsAllocations XRGDiagnosticsAllocationTotals[XRG_DIAGNOSTICS_MODULE_COUNT][XRGDiagnosticsPhaseCount];
+static uint64_t XRGDiagnosticsRedraws[XRG_DIAGNOSTICS_MODULE_COUNT][XRGDiagnosticsRedrawCount];
+static uint64_t XRGDiagnosticsFrameNanoseconds;
+
+static BOOL XRGDiagnosticsIsValid(XRGStatsModule module, XRGDiagnosticsPhase phase) {
+    return module >= 0 && module < XRG_DIAGNOSTICS_MODULE_COUNT && phase >= 0 && phase < XRGDiagnosticsPhaseCount;
+}
+
+// Views can draw before anything has asked for the shared instance, so the histograms are set up on first use.
+static void XRGDiagnosticsSetUp(void) {
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        for (NSInteger module = 0; module < XRG_DIAGNOSTICS_MODULE_COUNT; module++) {
+            for (NSInteger phase = 0; phase < XRGDiagnosticsPhaseCount; phase++) {
+                XRGDiagnosticsHistograms[module][phase] = XRGLatencyHistogramCreate();
+            }
+        }
+    });
+}
+
+XRGStatsModule XRGDiagnosticsModuleForObject(id object) {
+    return [object respondsToSelector:@selector(samplingModule)] ? [object samplingModule] : XRGStatsModuleNameSampler;
+}
+
+XRGDiagnosticsScope XRGDiagnosticsBegin(XRGStatsModule module, XRGDiagnosticsPhase phase) {
+    XRGDiagnosticsScope scope = { module, phase, 0, -1, -1 };
+    XRGDiagnosticsSetUp();
+    
+    if (atomic_load_explicit(&XRGDiagnosticsCountsAllocations, memory_order_relaxed) && pthread_main_np()) {
+        malloc_statistics_t statistics;
+        malloc_zone_statistics(NULL, &statistics);
+        scope.blocksInUse = statistics.blocks_in_use;
+        scope.bytesInUse = (int64_t)statistics.size_in_use;
+    }
+    
+    // Last, so the malloc statistics aren't counted in the time.
+    scope.start = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+    return scope;
+}
+
+void XRGDiagnosticsEnd(XRGDiagnosticsScope *scope) {
+    uint64_t end = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+    if (!XRGDiagnosticsIsValid(scope->module, scope->phase)) return;
+    
+    XRGLatencyHistogramRecord(XRGDiagnosticsHistograms[scope->module][scope->phase], end - scope->start);
+    if (scope->phase == XRGDiagnosticsPhaseDraw && pthread_main_np()) XRGDiagnosticsFrameNanoseconds += end - scope->start;
+    
+    if (scope->blocksInUse >= 0) {
+        malloc_statistics_t statistics;
+        malloc_zone_statistics(NULL, &statistics);
+        
+        XRGDiagnosticsAllocations *totals = &XRGDiagnosticsAllocationTotals[scope->module][scope->phase];
+        totals->calls++;
+        totals->blocks += (int64_t)statistics.blocks_in_use - scope->blocksInUse;
+        totals->bytes += (int64_t)statistics.size_in_use - scope->bytesInUse;
+    }
+}
+
+
+@implementation XRGDiagnostics
+
++ (XRGDiagnostics *)shared {
+    static XRGDiagnostics *sharedDiagnostics = nil;
+
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedDiagnostics = [[XRGDiagnostics alloc] init];
+    });
+
+    return sharedDiagnostics;
+}
+
++ (void)initialize {
+    if (self == [XRGDiagnostics class]) XRGDiagnosticsSetUp();
+}
+
++ (NSString *)nameForPhase:(XRGDiagnosticsPhase)phase {
+    switch (phase) {
+        case XRGDiagnosticsPhaseCollect:    return @"Collect";
+        case XRGDiagnosticsPhaseGraph:      return @"Graph";
+        case XRGDiagnosticsPhaseFast:       return @"Fast";
+        case XRGDiagnosticsPhaseMin5:       return @"5 Min";
+        case XRGDiagnosticsPhaseMin30:      return @"30 Min";
+        case XRGDiagnosticsPhaseDraw:       return @"Draw";
+        case XRGDiagnosticsPhaseFrame:      return @"Frame";
+        case XRGDiagnosticsPhaseCount:      break;
+    }
+    return @"Unknown";
+}
+
+- (BOOL)countsAllocations {
+    return atomic_load_explicit(&XRGDiagnosticsCountsAllocations, memory_order_relaxed);
+}
+
+- (void)setCountsAllocations:(BOOL)countsAllocations {
+    atomic_store_explicit(&XRGDiagnosticsCountsAllocations, countsAllocations, memory_order_relaxed);
+}
+
+- (void)recordDuration:(uint64_t)nanoseconds module:(XRGStatsModule)module phase:(XRGDiagnosticsPhase)phase {
+    if (!XRGDiagnosticsIsValid(module, phase)) return;
+    
+    XRGLatencyHistogramRecord(XRGDiagnosticsHistograms[module][phase], nanoseconds);
+}
+
+- (void)recordRedraw:(XRGDiagnosticsRedraw)redraw module:(XRGStatsModule)module {
+    if (module < 0 || module >= XRG_DIAGNOSTICS_MODULE_COUNT || redraw < 0 || redraw >= XRGDiagnosticsRedrawCount) return;
+    
+    XRGDiagnosticsRedraws[module][redraw]++;
+}
+
+- (void)finishFrame {
+    XRGLatencyHistogramRecord(XRGDiagnosticsHistograms[XRGStatsModuleNameSampler][XRGDiagnosticsPhaseFrame], XRGDiagnosticsFrameNanoseconds);
+    XRGDiagnosticsFrameNanoseconds = 0;
+}
+
+- (void)reset {
+    for (NSInteger module = 0; module < XRG_DIAGNOSTICS_MODULE_COUNT; module++) {
+        for (NSInteger phase = 0; phase < XRGDiagnosticsPhaseCount; phase++) {
+            XRGLatencyHistogramReset(XRGDiagnosticsHistograms[module][phase]);
+        }
+    }
+    memset(XRGDiagnosticsAllocationTotals, 0, sizeof(XRGDiagnosticsAllocationTotals));
+    memset(XRGDiagnosticsRedraws, 0, sizeof(XRGDiagnosticsRedraws));
+    XRGDiagnosticsFrameNanoseconds = 0;
+}
+
+- (NSString *)report {
+    NSMutableString *report = [NSMutableString string];
+    [report appendFormat:@"%-12s %-8s %9s %9s %9s %9s %9s %9s %9s %11s %11s\n", "Module", "Phase", "Count", "Mean", "p50", "p90", "p99", "p99.9", "Max", "Blocks/Call", "Bytes/Call"];
+    
+    const double percentiles[] = { 50, 90, 99, 99.9 };
+    uint64_t values[4];
+    for (NSInteger module = 0; module < XRG_DIAGNOSTICS_MODULE_COUNT; module++) {
+        for (NSInteger phase = 0; phase < XRGDiagnosticsPhaseCount; phase++) {
+            XRGLatencyHistogram *histogram = XRGDiagnosticsHistograms[module][phase];
+            uint64_t count = XRGLatencyHistogramCount(histogram);
+            if (!count) continue;
+            
+            XRGLatencyHistogramPercentiles(histogram, percentiles, values, 4);
+            [report appendFormat:@"%-12s %-8s %9llu %9.3f %9.3f %9.3f %9.3f %9.3f %9.3f",
+                [XRGStatsManager nameForModule:module].UTF8String,
+                [XRGDiagnostics nameForPhase:phase].UTF8String,
+                count,
+                XRGLatencyHistogramMean(histogram) / 1e6,
+                values[0] / 1e6, values[1] / 1e6, values[2] / 1e6, values[3] / 1e6,
+                XRGLatencyHistogramMax(histogram) / 1e6];
+            
+            XRGDiagnosticsAllocations totals = XRGDiagnosticsAllocationTotals[module][phase];
+            if (totals.calls) {
+                [report appendFormat:@" %11.1f %11.0f\n", (double)totals.blocks / totals.calls, (double)totals.bytes / totals.calls];
+            }
+            else {
+                [report appendFormat:@" %11s %11s\n", "-", "-"];
+            }
+        }
+    }
+    [report appendString:@"Times in ms.\n"];
+    
+    [report appendFormat:@"\n%-12s %9s %9s %9s %9s\n", "Module", "Full", "Partial", "Avoided", "Avoided%"];
+    for (NSInteger module = 0; module < XRG_DIAGNOSTICS_MODULE_COUNT; module++) {
+        uint64_t *redraws = XRGDiagnosticsRedraws[module];
+        uint64_t total = redraws[XRGDiagnosticsRedrawFull] + redraws[XRGDiagnosticsRedrawPartial] + redraws[XRGDiagnosticsRedrawAvoided];
+        if (!total) continue;
+        
+        [report appendFormat:@"%-12s %9llu %9llu %9llu %8.1f%%\n",
+            [XRGStatsManager nameForModule:module].UTF8String,
+            redraws[XRGDiagnosticsRedrawFull],
+            redraws[XRGDiagnosticsRedrawPartial],
+            redraws[XRGDiagnosticsRedrawAvoided],
+            100. * redraws[XRGDiagnosticsRedrawAvoided] / total];
+    }
+    
+    XRGLabelCache *labelCache = [XRGLabelCache shared];
+    [report appendFormat:@"\nLabel cache: %lu of %lu entries, %llu hits, %llu misses, %.1f%% hit rate\n", (unsigned long)labelCache.count, (unsigned long)labelCache.capacity, labelCache.hits, labelCache.misses, 100. * labelCache.hitRate];
+    [report appendFormat:@"Data set arenas: %.1f KB\n", [XRGDataSetArena totalFootprint] / 1024.];
+    
+    return report;
+}
+
+- (NSString *)dump {
+    NSMutableString *dump = [NSMutableString string];
+    
+    NSString *appVersion = [NSBundle mainBundle].infoDictionary[@"CFBundleShortVersionString"] ?: @"";
+    [dump appendFormat:@"XRG %@ diagnostics, %@\n", appVersion, [NSDate date]];
+    [dump appendFormat:@"Running macOS %@\n\n", [[NSProcessInfo processInfo] operatingSystemVersionString]];
+    [dump appendString:[self report]];
+    [dump appendString:@"\nHistograms (bucket lower bound in ns, count):\n"];
+    
+    size_t capacity = XRGLatencyHistogramBucketCount();
+    uint64_t *lowerBounds = malloc(capacity * sizeof(uint64_t));
+    uint64_t *counts = malloc(capacity * sizeof(uint64_t));
+    if (!lowerBounds || !counts) capacity = 0;
+    
+    for (NSInteger module = 0; module < XRG_DIAGNOSTICS_MODULE_COUNT; module++) {
+        for (NSInteger phase = 0; phase < XRGDiagnosticsPhaseCount; phase++) {
+            size_t buckets = XRGLatencyHistogramNonEmptyBuckets(XRGDiagnosticsHistograms[module][phase], lowerBounds, counts, capacity);
+            if (!buckets) continue;
+            
+            [dump appendFormat:@"%@ %@:\n", [XRGStatsManager nameForModule:module], [XRGDiagnostics nameForPhase:phase]];
+            for (size_t i = 0; i < buckets; i++) {
+                [dump appendFormat:@"\t%llu\t%llu\n", lowerBounds[i], counts[i]];
+            }
+        }
+    }
+    
+    free(lowerBounds);
+    free(counts);
+    
+    return dump;
+}
+
+- (BOOL)writeDumpToURL:(NSURL *)url error:(NSError **)error {
+    return [[self dump] writeToURL:url atomically:YES encoding:NSUTF8StringEncoding error:error];
+}
+
+@end
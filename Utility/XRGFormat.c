@@ -0,0 +1,154 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGFormat.c
+//
+
+#include "XRGFormat.h"
+
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef struct {
+    double divisor;
+    char   unit;
+    int    decimals;            // Below 100 of the unit.
+    int    decimalsFrom100;     // At 100 or more.
+} XRGByteUnit;
+
+// Indexed by the binary exponent of the value divided by 10, so picking a unit is a table lookup rather than a chain
+// of comparisons.  Everything past P stays in P.
+static const XRGByteUnit XRGByteUnits[] = {
+    { 1.,                  'B', 0, 0 },
+    { 1024.,               'K', 1, 0 },
+    { 1048576.,            'M', 2, 1 },
+    { 1073741824.,         'G', 2, 1 },
+    { 1099511627776.,      'T', 2, 1 },
+    { 1125899906842624.,   'P', 2, 1 },
+};
+#define XRG_BYTE_UNIT_MAX ((int)(sizeof(XRGByteUnits) / sizeof(XRGByteUnits[0])) - 1)
+
+static const double XRGPowersOf10[] = { 1., 10., 100. };
+static const uint64_t XRGIntegerPowersOf10[] = { 1, 10, 100 };
+
+// MARK: - Writing
+
+typedef struct {
+    char *buffer;
+    size_t capacity;
+    size_t length;
+} XRGFormatOutput;
+
+static inline void XRGFormatPutChar(XRGFormatOutput *output, char c) {
+    if (output->length + 1 < output->capacity) output->buffer[output->length] = c;
+    output->length++;
+}
+
+static void XRGFormatPutUnsigned(XRGFormatOutput *output, uint64_t value, int minimumDigits) {
+    char digits[20];
+    int count = 0;
+    do {
+        digits[count++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+    while (count < minimumDigits) digits[count++] = '0';
+    
+    while (count) XRGFormatPutChar(output, digits[--count]);
+}
+
+static size_t XRGFormatFinish(XRGFormatOutput *output, const char *suffix) {
+    if (suffix) {
+        while (*suffix) XRGFormatPutChar(output, *suffix++);
+    }
+    
+    if (output->capacity) {
+        size_t end = output->length < output->capacity ? output->length : output->capacity - 1;
+        output->buffer[end] = '\0';
+        return end;
+    }
+    return 0;
+}
+
+// MARK: - Rounding
+
+// value * scale rounded to the nearest integer, ties to even, the way printf rounds the exact decimal value.  The
+// product can round to exactly x.5 when the true product is a hair above or below it; fma recovers the part that was
+// rounded off so those cases go the right way.
+static double XRGFormatRoundScaled(double value, double scale) {
+    double product = value * scale;
+    double rounded = rint(product);
+    
+    if (fabs(product - rounded) == 0.5) {
+        double error = fma(value, scale, -product);
+        if (error > 0) rounded = ceil(product);
+        else if (error < 0) rounded = floor(product);
+    }
+    return rounded;
+}
+
+// MARK: - Bytes
+
+size_t XRGFormatBytes(double bytes, const char *suffix, char *buffer, size_t capacity) {
+    XRGFormatOutput output = { buffer, capacity, 0 };
+    
+    if (!(bytes >= 1024.)) {
+        // A whole number of bytes, truncated like the (long) cast it replaces.
+        long whole = isnan(bytes) ? 0 : (bytes <= (double)LONG_MIN ? LONG_MIN : (long)bytes);
+        uint64_t magnitude = whole < 0 ? (uint64_t)0 - (uint64_t)whole : (uint64_t)whole;
+        
+        if (whole < 0) XRGFormatPutChar(&output, '-');
+        XRGFormatPutUnsigned(&output, magnitude, 1);
+        XRGFormatPutChar(&output, 'B');
+        return XRGFormatFinish(&output, suffix);
+    }
+    
+    int unitIndex = ilogb(bytes) / 10;
+    if (unitIndex > XRG_BYTE_UNIT_MAX) unitIndex = XRG_BYTE_UNIT_MAX;
+    const XRGByteUnit *unit = &XRGByteUnits[unitIndex];
+    
+    // The divisors are powers of 2, so this is exact and the 100 test matches comparing bytes against 100 units.
+    double value = bytes / unit->divisor;
+    int decimals = value >= 100. ? unit->decimalsFrom100 : unit->decimals;
+    
+    double scaled = XRGFormatRoundScaled(value, XRGPowersOf10[decimals]);
+    if (!(scaled < 18446744073709551616.)) {
+        // Past 16 million P (or infinite); not worth a fixed-point path.
+        char overflow[XRG_FORMAT_BYTES_LENGTH];
+        int length = snprintf(overflow, sizeof(overflow), "%.*f%c", decimals, value, unit->unit);
+        for (int i = 0; i < length && i < (int)sizeof(overflow) - 1; i++) XRGFormatPutChar(&output, overflow[i]);
+        return XRGFormatFinish(&output, suffix);
+    }
+    
+    uint64_t fixed = (uint64_t)scaled;
+    uint64_t divisor = XRGIntegerPowersOf10[decimals];
+    XRGFormatPutUnsigned(&output, fixed / divisor, 1);
+    if (decimals) {
+        XRGFormatPutChar(&output, '.');
+        XRGFormatPutUnsigned(&output, fixed % divisor, decimals);
+    }
+    XRGFormatPutChar(&output, unit->unit);
+    
+    return XRGFormatFinish(&output, suffix);
+}
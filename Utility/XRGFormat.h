@@ -0,0 +1,45 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGFormat.h
+//
+
+#ifndef XRG_FORMAT_H
+#define XRG_FORMAT_H
+
+#include <stddef.h>
+
+// Number formatting for labels that are rebuilt every tick, written into a caller's buffer with no format string
+// parsing and no allocation.  The output matches what the printf formats it replaces would produce.
+
+/// Room for any byte count plus a short suffix; a good size for a buffer on the stack.
+#define XRG_FORMAT_BYTES_LENGTH 48
+
+/*! Writes bytes in binary units the way XRG labels show them: "37B", "1.5K", "512K", "1.25M", "103.4G" and so on up to P.  Values from 1 to 100 of a unit get two decimal places (one for K), values of 100 or more get one (none for K), and anything under 1K is a whole number of bytes.
+ @param suffix Appended after the unit, e.g. "/s" or " Rx".  May be NULL.
+ @param buffer Where the NUL-terminated result goes.  Output that doesn't fit is cut off.
+ @return The length written, not counting the NUL.
+ */
+size_t XRGFormatBytes(double bytes, const char *suffix, char *buffer, size_t capacity);
+
+#endif
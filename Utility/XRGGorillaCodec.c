@@ -0,0 +1,175 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGGorillaCodec.c
+//
+
+#include "XRGGorillaCodec.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Each value is one of:
+//   '0'                                      same as the previous value
+//   '10' + meaningful bits                   XOR fits inside the previous leading/trailing zero window
+//   '11' + 5 bits leading + 6 bits length    new window, then the meaningful bits (a length of 64 is stored as 0)
+// The first value is stored as a raw 64 bit word.
+#define XRG_GORILLA_MAX_BITS_PER_VALUE (2 + 5 + 6 + 64)
+
+typedef struct {
+    uint8_t *bytes;
+    size_t   bitPosition;
+} XRGBitWriter;
+
+typedef struct {
+    const uint8_t *bytes;
+    size_t         byteCount;
+    size_t         bitPosition;
+} XRGBitReader;
+
+static inline uint64_t XRGDoubleBits(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static inline double XRGBitsDouble(uint64_t bits) {
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Write the low numBits of value, most significant bit first.  The buffer is zeroed up front, so only 1 bits need setting.
+static inline void XRGBitWrite(XRGBitWriter *writer, uint64_t value, unsigned numBits) {
+    while (numBits) {
+        size_t byte = writer->bitPosition >> 3;
+        unsigned used = writer->bitPosition & 7;
+        unsigned room = 8 - used;
+        unsigned take = numBits < room ? numBits : room;
+        
+        uint8_t chunk = (uint8_t)((value >> (numBits - take)) & ((1u << take) - 1));
+        writer->bytes[byte] |= (uint8_t)(chunk << (room - take));
+        
+        writer->bitPosition += take;
+        numBits -= take;
+    }
+}
+
+static inline uint64_t XRGBitRead(XRGBitReader *reader, unsigned numBits) {
+    uint64_t value = 0;
+    
+    while (numBits) {
+        size_t byte = reader->bitPosition >> 3;
+        if (byte >= reader->byteCount) return numBits < 64 ? value << numBits : 0;    // Truncated input reads as zeros.
+        
+        unsigned used = reader->bitPosition & 7;
+        unsigned room = 8 - used;
+        unsigned take = numBits < room ? numBits : room;
+        
+        uint8_t chunk = (uint8_t)((reader->bytes[byte] >> (room - take)) & ((1u << take) - 1));
+        value = (value << take) | chunk;
+        
+        reader->bitPosition += take;
+        numBits -= take;
+    }
+    
+    return value;
+}
+
+size_t XRGGorillaEncode(const double *values, size_t count, uint8_t **bytes) {
+    *bytes = NULL;
+    if (count == 0) return 0;
+    
+    size_t maxBytes = (64 + (count - 1) * XRG_GORILLA_MAX_BITS_PER_VALUE + 7) / 8;
+    XRGBitWriter writer = { calloc(maxBytes, 1), 0 };
+    if (!writer.bytes) return 0;
+    
+    uint64_t previous = XRGDoubleBits(values[0]);
+    XRGBitWrite(&writer, previous, 64);
+    
+    unsigned windowLeading = 65;        // No window yet.
+    unsigned windowTrailing = 0;
+    
+    for (size_t i = 1; i < count; i++) {
+        uint64_t current = XRGDoubleBits(values[i]);
+        uint64_t xor = current ^ previous;
+        previous = current;
+        
+        if (xor == 0) {
+            XRGBitWrite(&writer, 0, 1);
+            continue;
+        }
+        
+        unsigned leading = (unsigned)__builtin_clzll(xor);
+        unsigned trailing = (unsigned)__builtin_ctzll(xor);
+        if (leading > 31) leading = 31;
+        
+        if (windowLeading <= 64 && leading >= windowLeading && trailing >= windowTrailing) {
+            XRGBitWrite(&writer, 2, 2);
+            XRGBitWrite(&writer, xor >> windowTrailing, 64 - windowLeading - windowTrailing);
+        }
+        else {
+            unsigned length = 64 - leading - trailing;
+            XRGBitWrite(&writer, 3, 2);
+            XRGBitWrite(&writer, leading, 5);
+            XRGBitWrite(&writer, length & 63, 6);
+            XRGBitWrite(&writer, xor >> trailing, length);
+            
+            windowLeading = leading;
+            windowTrailing = trailing;
+        }
+    }
+    
+    size_t byteCount = (writer.bitPosition + 7) / 8;
+    uint8_t *shrunk = realloc(writer.bytes, byteCount);
+    *bytes = shrunk ? shrunk : writer.bytes;
+    
+    return byteCount;
+}
+
+void XRGGorillaDecode(const uint8_t *bytes, size_t byteCount, size_t count, size_t skip, double *destination) {
+    if (count == 0) return;
+    
+    XRGBitReader reader = { bytes, byteCount, 0 };
+    
+    uint64_t previous = XRGBitRead(&reader, 64);
+    if (skip == 0) *destination++ = XRGBitsDouble(previous);
+    
+    unsigned windowLeading = 0;
+    unsigned windowLength = 64;
+    
+    for (size_t i = 1; i < count; i++) {
+        if (XRGBitRead(&reader, 1)) {
+            if (XRGBitRead(&reader, 1)) {
+                windowLeading = (unsigned)XRGBitRead(&reader, 5);
+                windowLength = (unsigned)XRGBitRead(&reader, 6);
+                if (windowLength == 0) windowLength = 64;
+            }
+            
+            uint64_t meaningful = XRGBitRead(&reader, windowLength);
+            previous ^= meaningful << (64 - windowLeading - windowLength);
+        }
+        
+        if (i >= skip) *destination++ = XRGBitsDouble(previous);
+    }
+}
@@ -0,0 +1,43 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGGorillaCodec.h
+//
+
+#ifndef XRG_GORILLA_CODEC_H
+#define XRG_GORILLA_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// XOR compression for runs of doubles, after the value encoding in Facebook's Gorilla paper.  Each value is
+// XORed with the one before it; a repeat costs one bit and a small change costs a few control bits plus the
+// bits that actually changed.  XRGDataSet samples are evenly spaced, so there are no timestamps to encode.
+
+/// Compresses count values into a new malloc'd buffer returned in *bytes (caller frees).  Returns the number of bytes, or 0 on failure.
+size_t XRGGorillaEncode(const double *values, size_t count, uint8_t **bytes);
+
+/// Decodes an encoded run of count values, discarding the first skip values and writing the rest to destination.
+void XRGGorillaDecode(const uint8_t *bytes, size_t byteCount, size_t count, size_t skip, double *destination);
+
+#endif
@@ -0,0 +1,85 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGHistoryStore.h
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// Graph history kept in a memory-mapped file, one file per module, so it survives a relaunch or a crash.  The
+/// file is a fixed header followed by numSeries rings of numValues doubles, series-major, which is the same layout
+/// XRGDataSetGroup uses.  Data sets and groups are pointed straight at the mapped rings with their external storage
+/// initializers, so a sample is just a store into shared memory and the kernel writes the pages back on its own.
+///
+/// Reattaching is a header check and an mmap; nothing is parsed.  If the header does not match this build's layout,
+/// the module's number of series or the graph refresh, the history is discarded and the file starts over.
+///
+/// Gaps: the header records the wall time of the newest sample and the measured sample interval.  On reattach, each
+/// interval missed while XRG was not running is filled with NOVALUE for every series, so the graph leaves the
+/// downtime blank at the right width.  If the gap is as long as the whole ring, the whole ring is NOVALUE instead.
+///
+/// If the file can't be resized or remapped later on, the store keeps the rings in memory for the rest of the run.
+@interface XRGHistoryStore : NSObject
+
+@property (nonatomic, readonly) NSString *name;
+@property (nonatomic, readonly) NSUInteger numSeries;
+@property (nonatomic, readonly) size_t numValues;
+
+/// The index of the newest sample, as of the last call to noteSampleAtIndex: (or the gap fill on reattach).
+@property (nonatomic, readonly) NSInteger currentIndex;
+
+/// YES if history from a previous run was reattached.
+@property (nonatomic, readonly) BOOL restored;
+
+/// YES once a failed resize has moved the rings into memory; nothing more is written to the file.
+@property (nonatomic, readonly) BOOL inMemory;
+
+/// The graph refresh the samples are recorded at.  Set it when the refresh changes, so the next launch reattaches.
+@property (nonatomic) NSTimeInterval graphInterval;
+
+/// ~/Library/Application Support/XRG/History
++ (NSURL *)historyDirectory;
+
+/*! Opens or creates the history file for a module.  Returns nil if the file can't be created or mapped, or if another
+ process already has it open; callers should fall back to in-memory data sets in that case.
+ @param name The file name, without an extension, e.g. @"CPU".
+ @param graphInterval The graph refresh, in seconds.  History recorded at a different refresh is discarded, since its samples would be drawn at the wrong width.  0 accepts any.
+ */
+- (nullable instancetype)initWithName:(NSString *)name numberOfSeries:(NSUInteger)numSeries numValues:(size_t)numValues graphInterval:(NSTimeInterval)graphInterval;
+
+/// The ring for a series, numValues long.  The rings are contiguous, so valuesForSeries:0 is the start of the whole block.  NULL if the store could not be mapped.
+- (nullable CGFloat *)valuesForSeries:(NSUInteger)series;
+
+/// Records that a sample was written at currentIndex.  This only touches the mapped header, so it is safe to call every tick.
+- (void)noteSampleAtIndex:(NSInteger)currentIndex;
+
+/*! Changes the ring length, keeping the newest values of each series and leaving the newest in the last slot, the same
+ as XRGDataSet.  The rings move, so anything pointed at valuesForSeries: has to be pointed at them again.
+ */
+- (void)resize:(size_t)newNumValues;
+
+@end
+
+NS_ASSUME_NONNULL_END
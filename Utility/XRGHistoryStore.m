@@ -0,0 +1,310 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGHistoryStore.m
+//
+
+#import "XRGHistoryStore.h"
+#import "XRGDataSet.h"
+#import "XRGVectorKernels.h"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define XRG_HISTORY_MAGIC   0x48475258      // "XRGH"
+#define XRG_HISTORY_VERSION 2
+
+// The on-disk layout.  Bump XRG_HISTORY_VERSION for any change; older files are discarded rather than converted.
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t numSeries;
+    uint64_t numValues;
+    int64_t  currentIndex;
+    double   lastSampleTime;        // CFAbsoluteTime of the newest sample, 0 if there isn't one.
+    double   sampleInterval;        // Measured seconds between samples, 0 if unknown.
+    double   graphInterval;         // The graph refresh the samples were recorded at, 0 if unknown.
+    uint8_t  reserved[8];
+} XRGHistoryHeader;
+
+_Static_assert(sizeof(XRGHistoryHeader) == 64, "The history header is part of the file format");
+_Static_assert(sizeof(CGFloat) == sizeof(double), "History files store doubles");
+
+static size_t XRGHistoryFileSize(NSUInteger numSeries, size_t numValues) {
+    return sizeof(XRGHistoryHeader) + numSeries * numValues * sizeof(CGFloat);
+}
+
+// Copy a ring of oldCount values with the newest at oldIndex into newCount slots, oldest first and newest at the end.
+static void XRGHistoryCopyRing(const CGFloat *oldValues, size_t oldCount, NSInteger oldIndex, CGFloat *newValues, size_t newCount) {
+    NSInteger newIndex = (NSInteger)newCount - 1;
+    
+    for (NSInteger i = oldIndex; i >= 0 && newIndex >= 0; i--) {
+        newValues[newIndex--] = oldValues[i];
+    }
+    for (NSInteger i = (NSInteger)oldCount - 1; i > oldIndex && newIndex >= 0; i--) {
+        newValues[newIndex--] = oldValues[i];
+    }
+}
+
+@interface XRGHistoryStore () {
+    int                 _fd;
+    void                *_map;
+    size_t              _mapSize;
+    XRGHistoryHeader    *_header;
+    CGFloat             *_values;
+    CFAbsoluteTime      _lastNoteTime;      // Only samples from this run are used to measure the interval.
+    CGFloat             *_memoryValues;     // The rings once the store has fallen back to memory (see inMemory).
+}
+@end
+
+@implementation XRGHistoryStore
+
++ (NSURL *)historyDirectory {
+    NSURL *supportURL = [[[NSFileManager defaultManager] URLsForDirectory:NSApplicationSupportDirectory inDomains:NSUserDomainMask] firstObject];
+    return [[supportURL URLByAppendingPathComponent:@"XRG" isDirectory:YES] URLByAppendingPathComponent:@"History" isDirectory:YES];
+}
+
+- (instancetype)initWithName:(NSString *)name numberOfSeries:(NSUInteger)numSeries numValues:(size_t)numValues graphInterval:(NSTimeInterval)graphInterval {
+    self = [super init];
+    if (self) {
+        _name = [name copy];
+        _numSeries = numSeries;
+        _graphInterval = graphInterval;
+        _fd = -1;
+        
+        NSURL *directoryURL = [XRGHistoryStore historyDirectory];
+        if (![[NSFileManager defaultManager] createDirectoryAtURL:directoryURL withIntermediateDirectories:YES attributes:nil error:nil]) return nil;
+        
+        NSURL *fileURL = [directoryURL URLByAppendingPathComponent:[name stringByAppendingPathExtension:@"xrghist"]];
+        _fd = open(fileURL.fileSystemRepresentation, O_RDWR | O_CREAT, 0644);
+        if (_fd < 0) return nil;
+        
+        // Two processes writing the same rings would interleave samples, so a second copy of XRG keeps its history in memory.
+        if (flock(_fd, LOCK_EX | LOCK_NB) != 0) return nil;
+        
+        struct stat fileInfo;
+        if (fstat(_fd, &fileInfo) != 0) return nil;
+        
+        if (![self mapExistingFileOfSize:(size_t)fileInfo.st_size]) {
+            if (![self mapNewFileWithNumValues:numValues]) return nil;
+        }
+        
+        [self resize:numValues];
+    }
+    
+    return self;
+}
+
+- (void)dealloc {
+    [self unmap];
+    free(_memoryValues);
+    if (_fd >= 0) close(_fd);
+}
+
+- (CGFloat *)valuesForSeries:(NSUInteger)series {
+    return (_values && series < _numSeries) ? _values + series * _numValues : NULL;
+}
+
+- (void)noteSampleAtIndex:(NSInteger)currentIndex {
+    _currentIndex = currentIndex;
+    if (!_header) return;
+    
+    CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+    if (_lastNoteTime > 0 && now > _lastNoteTime) {
+        // Smooth the interval, and limit how far one late tick (or a sleep) can move it.
+        CFTimeInterval delta = now - _lastNoteTime;
+        CFTimeInterval interval = _header->sampleInterval;
+        if (interval > 0) {
+            delta = MIN(MAX(delta, interval * 0.5), interval * 2.);
+            interval = 0.75 * interval + 0.25 * delta;
+        }
+        else {
+            interval = delta;
+        }
+        _header->sampleInterval = interval;
+    }
+    _lastNoteTime = now;
+    
+    _header->currentIndex = currentIndex;
+    _header->lastSampleTime = now;
+}
+
+- (void)setGraphInterval:(NSTimeInterval)graphInterval {
+    _graphInterval = graphInterval;
+    if (_header) _header->graphInterval = graphInterval;
+}
+
+- (void)resize:(size_t)newNumValues {
+    if ((!_header && !_inMemory) || newNumValues == _numValues) return;
+    
+    size_t oldNumValues = _numValues;
+    CGFloat *newValues = NULL;
+    if (_numSeries && newNumValues) {
+        newValues = calloc(_numSeries * newNumValues, sizeof(CGFloat));
+        if (!newValues) return;
+        
+        for (NSUInteger s = 0; s < _numSeries; s++) {
+            XRGHistoryCopyRing(_values + s * oldNumValues, oldNumValues, _currentIndex, newValues + s * newNumValues, newNumValues);
+        }
+    }
+    
+    if (!_inMemory) {
+        [self unmap];
+        
+        // If the file can't be resized or remapped, keep the rings in memory for the rest of the run rather than
+        // leaving the data sets without storage.  The file is left alone; a size that no longer matches its header
+        // is discarded on the next launch.
+        size_t fileSize = XRGHistoryFileSize(_numSeries, newNumValues);
+        if (ftruncate(_fd, (off_t)fileSize) != 0 || ![self mapFileOfSize:fileSize]) {
+            [self unmap];
+            _inMemory = YES;
+        }
+    }
+    
+    if (_inMemory) {
+        free(_memoryValues);
+        _memoryValues = newValues;
+        _values = newValues;
+    }
+    else {
+        if (newValues) memcpy(_values, newValues, _numSeries * newNumValues * sizeof(CGFloat));
+        free(newValues);
+    }
+    
+    // Match XRGDataSet: the newest value ends up in the last slot, unless there was no history to keep.
+    _numValues = newNumValues;
+    _currentIndex = (oldNumValues && newNumValues) ? (NSInteger)newNumValues - 1 : 0;
+    if (_header) {
+        _header->numValues = newNumValues;
+        _header->currentIndex = _currentIndex;
+    }
+}
+
+#pragma mark - Mapping
+
+- (BOOL)mapFileOfSize:(size_t)fileSize {
+    void *map = mmap(NULL, fileSize, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+    if (map == MAP_FAILED) return NO;
+    
+    _map = map;
+    _mapSize = fileSize;
+    _header = (XRGHistoryHeader *)map;
+    _values = (CGFloat *)((uint8_t *)map + sizeof(XRGHistoryHeader));
+    
+    return YES;
+}
+
+- (void)unmap {
+    if (_map) munmap(_map, _mapSize);
+    
+    _map = NULL;
+    _mapSize = 0;
+    _header = NULL;
+    _values = NULL;
+}
+
+- (BOOL)mapExistingFileOfSize:(size_t)fileSize {
+    if (fileSize < sizeof(XRGHistoryHeader)) return NO;
+    if (![self mapFileOfSize:fileSize]) return NO;
+    
+    XRGHistoryHeader *header = _header;
+    BOOL valid = header->magic == XRG_HISTORY_MAGIC &&
+                 header->version == XRG_HISTORY_VERSION &&
+                 header->headerSize == sizeof(XRGHistoryHeader) &&
+                 header->numSeries == _numSeries &&
+                 (_graphInterval <= 0 || fabs(header->graphInterval - _graphInterval) < 0.001) &&
+                 fileSize == XRGHistoryFileSize(_numSeries, (size_t)header->numValues) &&
+                 header->currentIndex >= 0 &&
+                 (header->currentIndex == 0 || (uint64_t)header->currentIndex < header->numValues);
+    if (!valid) {
+        [self unmap];
+        return NO;
+    }
+    
+    _numValues = (size_t)header->numValues;
+    _currentIndex = (NSInteger)header->currentIndex;
+    _restored = YES;
+    
+    [self fillGap];
+    
+    return YES;
+}
+
+- (BOOL)mapNewFileWithNumValues:(size_t)numValues {
+    // Truncating to 0 first means the whole file reads back as zeros.
+    size_t fileSize = XRGHistoryFileSize(_numSeries, numValues);
+    if (ftruncate(_fd, 0) != 0 || ftruncate(_fd, (off_t)fileSize) != 0) return NO;
+    if (![self mapFileOfSize:fileSize]) return NO;
+    
+    _header->magic = XRG_HISTORY_MAGIC;
+    _header->version = XRG_HISTORY_VERSION;
+    _header->headerSize = sizeof(XRGHistoryHeader);
+    _header->numSeries = (uint32_t)_numSeries;
+    _header->numValues = numValues;
+    _header->currentIndex = 0;
+    _header->lastSampleTime = 0;
+    _header->sampleInterval = 0;
+    _header->graphInterval = _graphInterval;
+    
+    _numValues = numValues;
+    _currentIndex = 0;
+    _restored = NO;
+    
+    return YES;
+}
+
+// Account for the time XRG wasn't running.  Every interval missed gets NOVALUE in each series, so the newest slot lines
+// up with now and the graphs leave the downtime blank; if the whole ring was missed there's nothing worth keeping.
+- (void)fillGap {
+    CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+    CFAbsoluteTime lastSampleTime = _header->lastSampleTime;
+    CFTimeInterval interval = _header->sampleInterval;
+    if (_numValues == 0 || lastSampleTime <= 0 || interval <= 0 || now <= lastSampleTime) return;
+    
+    // The first sample from this run lands one interval from now, so the slots in between are the ones missed.
+    double missed = floor((now - lastSampleTime) / interval);
+    if (missed >= (double)_numValues) {
+        XRGVectorFill(NOVALUE, _values, _numSeries * _numValues);
+        _currentIndex = 0;
+        _restored = NO;
+    }
+    else {
+        for (size_t i = 0; i < (size_t)missed; i++) {
+            _currentIndex++;
+            if (_currentIndex == (NSInteger)_numValues) _currentIndex = 0;
+            
+            for (NSUInteger s = 0; s < _numSeries; s++) {
+                _values[s * _numValues + _currentIndex] = NOVALUE;
+            }
+        }
+    }
+    
+    _header->currentIndex = _currentIndex;
+    _header->lastSampleTime = now;
+}
+
+@end
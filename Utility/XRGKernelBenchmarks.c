@@ -0,0 +1,1038 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGKernelBenchmarks.c
+//
+
+#include "XRGKernelBenchmarks.h"
+#include "XRGVectorKernels.h"
+#include "XRGGorillaCodec.h"
+#include "XRGDecimation.h"
+#include "XRGCPUTicks.h"
+#include "XRGFormat.h"
+#include "XRGQuantileSketch.h"
+#include "XRGStatShards.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__APPLE__)
+#include <Accelerate/Accelerate.h>
+#endif
+
+// MARK: - Report
+
+void XRGBenchmarkReportAppend(XRGBenchmarkReport *report, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int needed = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    if (needed <= 0) return;
+    
+    size_t required = report->length + (size_t)needed + 1;
+    if (required > report->capacity) {
+        size_t capacity = report->capacity ? report->capacity * 2 : 1024;
+        while (capacity < required) capacity *= 2;
+        char *text = realloc(report->text, capacity);
+        if (!text) return;
+        
+        report->text = text;
+        report->capacity = capacity;
+    }
+    
+    va_start(args, format);
+    vsnprintf(report->text + report->length, report->capacity - report->length, format, args);
+    va_end(args);
+    report->length += (size_t)needed;
+}
+
+void XRGBenchmarkReportFree(XRGBenchmarkReport *report) {
+    free(report->text);
+    report->text = NULL;
+    report->length = 0;
+    report->capacity = 0;
+}
+
+uint64_t XRGBenchmarkNanoseconds(void) {
+#if defined(__APPLE__)
+    return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+#endif
+}
+
+// A small, seeded generator so every run times the same input.
+static uint64_t XRGBenchmarkRandom(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+// Whatever the timed loops compute ends up here, so the compiler can't drop them.
+static volatile double XRGBenchmarkSink;
+
+// MARK: - Vector Kernels
+
+#define XRG_KERNEL_BENCH_BACKENDS 5     // Scalar, SSE2, AVX2, NEON, then vDSP
+
+typedef struct {
+    double minMaxSum;
+    double add;
+    double subtract;
+    double scale;
+    double fill;
+} XRGKernelTimes;
+
+// Bytes each operation reads and writes per element, for turning its time into memory throughput.
+static const XRGKernelTimes XRGKernelBytes = { 8, 24, 24, 16, 8 };
+
+// Nanoseconds per element for each operation on the current backend, or vDSP, repeated enough to cover about 4M
+// elements.  Returns the number of results that differ from what the plain C expressions give.
+static size_t XRGTimeKernels(int useVDSP, const double *a, const double *b, double *result, size_t count, const double *reference, const double referenceStats[3], XRGKernelTimes *times) {
+    size_t repeats = 4000000 / count + 1;
+    double lo = 0, hi = 0, total = 0;
+    size_t mismatches = 0;
+#if !defined(__APPLE__)
+    (void)useVDSP;
+#endif
+    
+    uint64_t start = XRGBenchmarkNanoseconds();
+    for (size_t r = 0; r < repeats; r++) {
+#if defined(__APPLE__)
+        if (useVDSP) {
+            vDSP_minvD(a, 1, &lo, count);
+            vDSP_maxvD(a, 1, &hi, count);
+            vDSP_sveD(a, 1, &total, count);
+        }
+        else
+#endif
+        XRGVectorMinMaxSum(a, count, &lo, &hi, &total);
+        XRGBenchmarkSink = total;
+    }
+    times->minMaxSum = (double)(XRGBenchmarkNanoseconds() - start) / (double)(repeats * count);
+    // Sums added in a different order can differ in the last bits.
+    if (lo != referenceStats[0] || hi != referenceStats[1] || fabs(total - referenceStats[2]) > fabs(referenceStats[2]) * 1e-12) mismatches++;
+    
+    start = XRGBenchmarkNanoseconds();
+    for (size_t r = 0; r < repeats; r++) {
+#if defined(__APPLE__)
+        if (useVDSP) vDSP_vaddD(a, 1, b, 1, result, 1, count);
+        else
+#endif
+        XRGVectorAdd(a, b, result, count);
+        XRGBenchmarkSink = result[r % count];
+    }
+    times->add = (double)(XRGBenchmarkNanoseconds() - start) / (double)(repeats * count);
+    for (size_t i = 0; i < count; i++) {
+        if (result[i] != a[i] + b[i]) mismatches++;
+    }
+    
+    start = XRGBenchmarkNanoseconds();
+    for (size_t r = 0; r < repeats; r++) {
+#if defined(__APPLE__)
+        // vDSP takes the subtrahend first.
+        if (useVDSP) vDSP_vsubD(b, 1, a, 1, result, 1, count);
+        else
+#endif
+        XRGVectorSubtract(a, b, result, count);
+        XRGBenchmarkSink = result[r % count];
+    }
+    times->subtract = (double)(XRGBenchmarkNanoseconds() - start) / (double)(repeats * count);
+    for (size_t i = 0; i < count; i++) {
+        if (result[i] != a[i] - b[i]) mismatches++;
+    }
+    
+    double scale = 0.25;
+    start = XRGBenchmarkNanoseconds();
+    for (size_t r = 0; r < repeats; r++) {
+#if defined(__APPLE__)
+        if (useVDSP) vDSP_vsmulD(a, 1, &scale, result, 1, count);
+        else
+#endif
+        XRGVectorScale(a, scale, result, count);
+        XRGBenchmarkSink = result[r % count];
+    }
+    times->scale = (double)(XRGBenchmarkNanoseconds() - start) / (double)(repeats * count);
+    for (size_t i = 0; i < count; i++) {
+        if (result[i] != reference[i]) mismatches++;
+    }
+    
+    double fill = 42.5;
+    start = XRGBenchmarkNanoseconds();
+    for (size_t r = 0; r < repeats; r++) {
+#if defined(__APPLE__)
+        if (useVDSP) vDSP_vfillD(&fill, result, 1, count);
+        else
+#endif
+        XRGVectorFill(fill, result, count);
+        XRGBenchmarkSink = result[r % count];
+    }
+    times->fill = (double)(XRGBenchmarkNanoseconds() - start) / (double)(repeats * count);
+    for (size_t i = 0; i < count; i++) {
+        if (result[i] != fill) mismatches++;
+    }
+    
+    return mismatches;
+}
+
+void XRGBenchmarkVectorKernels(XRGBenchmarkReport *report) {
+    static const size_t sizes[] = { 300, 4096, 200000 };
+    static const char *const names[XRG_KERNEL_BENCH_BACKENDS] = { "Scalar", "SSE2", "AVX2", "NEON", "vDSP" };
+    
+    XRGVectorBackend original = XRGVectorCurrentBackend();
+    
+    XRGBenchmarkReportAppend(report, "Vector kernels, GB/s read and written (current backend %s)\n", XRGVectorBackendName(original));
+    XRGBenchmarkReportAppend(report, "%8s %8s %10s %10s %10s %10s %10s %10s\n", "Length", "Backend", "MinMaxSum", "Add", "Subtract", "Scale", "Fill", "Mismatches");
+    
+    uint64_t seed = 0x2545F4914F6CDD1Dull;
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        size_t count = sizes[s];
+        double *a = malloc(count * sizeof(double));
+        double *b = malloc(count * sizeof(double));
+        double *result = malloc(count * sizeof(double));
+        double *reference = malloc(count * sizeof(double));
+        if (!a || !b || !result || !reference) {
+            free(a);
+            free(b);
+            free(result);
+            free(reference);
+            return;
+        }
+        
+        // Percentages, like the CPU and disk graphs.
+        for (size_t i = 0; i < count; i++) {
+            a[i] = (double)(XRGBenchmarkRandom(&seed) % 10001) / 100.;
+            b[i] = (double)(XRGBenchmarkRandom(&seed) % 10001) / 100.;
+            reference[i] = a[i] * 0.25;
+        }
+        double referenceStats[3] = { a[0], a[0], 0 };
+        for (size_t i = 0; i < count; i++) {
+            if (a[i] < referenceStats[0]) referenceStats[0] = a[i];
+            if (a[i] > referenceStats[1]) referenceStats[1] = a[i];
+            referenceStats[2] += a[i];
+        }
+        
+        for (int backend = 0; backend < XRG_KERNEL_BENCH_BACKENDS; backend++) {
+            int useVDSP = backend == XRG_KERNEL_BENCH_BACKENDS - 1;
+#if !defined(__APPLE__)
+            if (useVDSP) continue;
+#endif
+            if (!useVDSP && !XRGVectorSetBackend((XRGVectorBackend)backend)) continue;
+            
+            XRGKernelTimes times;
+            size_t mismatches = XRGTimeKernels(useVDSP, a, b, result, count, reference, referenceStats, &times);
+            // Bytes per nanosecond is GB/s.
+            XRGBenchmarkReportAppend(report, "%8zu %8s %10.2f %10.2f %10.2f %10.2f %10.2f %10zu\n", count, names[backend],
+                                     XRGKernelBytes.minMaxSum / times.minMaxSum, XRGKernelBytes.add / times.add,
+                                     XRGKernelBytes.subtract / times.subtract, XRGKernelBytes.scale / times.scale,
+                                     XRGKernelBytes.fill / times.fill, mismatches);
+        }
+        
+        free(a);
+        free(b);
+        free(result);
+        free(reference);
+    }
+    
+    XRGVectorSetBackend(original);
+}
+
+// MARK: - Archive Codec
+
+// Matches XRGDataSetHistoryBlockSamples in XRGDataSet.m.
+#define XRG_CODEC_BENCH_BLOCK 256
+#define XRG_CODEC_BENCH_SAMPLES (XRG_CODEC_BENCH_BLOCK * 400)
+
+typedef enum {
+    XRGCodecTraceCPU,
+    XRGCodecTraceNetwork,
+    XRGCodecTraceTemperature,
+    XRGCodecTraceIdle,
+    XRGCodecTraceCount
+} XRGCodecTrace;
+
+// Traces shaped like what the miners record, one sample per graph refresh.
+static void XRGFillCodecTrace(XRGCodecTrace trace, double *values, size_t count, uint64_t *seed) {
+    double level = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint64_t r = XRGBenchmarkRandom(seed);
+        switch (trace) {
+            case XRGCodecTraceCPU: {
+                // The average of four CPUs' busy ticks out of 100 a second, on a wandering load.
+                level += (double)(r % 41) - 20.;
+                if (level < 0) level = 0;
+                if (level > 400) level = 400;
+                values[i] = (double)(long)level / 4.;
+                break;
+            }
+            case XRGCodecTraceNetwork:
+                // Mostly quiet, with background chatter and the occasional transfer.
+                if (r % 50 == 0) level = (double)(r % 5000000);
+                else if (r % 7 == 0) level = 0;
+                values[i] = (r % 3 == 0) ? (double)((r >> 8) % 1500) : level;
+                break;
+            case XRGCodecTraceTemperature:
+                // SMC fixed point, 1/256 of a degree, drifting slowly.
+                if (r % 4 == 0) level += (double)((int)(r >> 8) % 5 - 2);
+                values[i] = 45. + level / 256.;
+                break;
+            default:
+                values[i] = 0;
+                break;
+        }
+    }
+}
+
+void XRGBenchmarkArchiveCodec(XRGBenchmarkReport *report) {
+    static const char *const names[XRGCodecTraceCount] = { "CPU", "Network", "Temp", "Idle" };
+    const size_t count = XRG_CODEC_BENCH_SAMPLES;
+    const size_t blocks = count / XRG_CODEC_BENCH_BLOCK;
+    
+    double *values = malloc(count * sizeof(double));
+    double *decoded = malloc(count * sizeof(double));
+    uint8_t **encoded = calloc(blocks, sizeof(uint8_t *));
+    size_t *encodedBytes = calloc(blocks, sizeof(size_t));
+    if (!values || !decoded || !encoded || !encodedBytes) {
+        free(values);
+        free(decoded);
+        free(encoded);
+        free(encodedBytes);
+        return;
+    }
+    
+    XRGBenchmarkReportAppend(report, "Archive codec, %zu samples in blocks of %d\n", count, XRG_CODEC_BENCH_BLOCK);
+    XRGBenchmarkReportAppend(report, "%8s %12s %12s %12s %10s\n", "Trace", "Bytes/sample", "Encode ns", "Decode ns", "Mismatches");
+    
+    uint64_t seed = 0x9E3779B97F4A7C15ull;
+    for (int trace = 0; trace < XRGCodecTraceCount; trace++) {
+        XRGFillCodecTrace((XRGCodecTrace)trace, values, count, &seed);
+        
+        size_t totalBytes = 0;
+        uint64_t start = XRGBenchmarkNanoseconds();
+        for (size_t b = 0; b < blocks; b++) {
+            encodedBytes[b] = XRGGorillaEncode(values + b * XRG_CODEC_BENCH_BLOCK, XRG_CODEC_BENCH_BLOCK, &encoded[b]);
+            totalBytes += encodedBytes[b];
+        }
+        double encodeNanoseconds = (double)(XRGBenchmarkNanoseconds() - start) / (double)count;
+        
+        start = XRGBenchmarkNanoseconds();
+        for (size_t b = 0; b < blocks; b++) {
+            XRGGorillaDecode(encoded[b], encodedBytes[b], XRG_CODEC_BENCH_BLOCK, 0, decoded + b * XRG_CODEC_BENCH_BLOCK);
+        }
+        double decodeNanoseconds = (double)(XRGBenchmarkNanoseconds() - start) / (double)count;
+        
+        size_t mismatches = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (memcmp(&values[i], &decoded[i], sizeof(double)) != 0) mismatches++;
+        }
+        
+        XRGBenchmarkReportAppend(report, "%8s %12.2f %12.1f %12.1f %10zu\n", names[trace], (double)totalBytes / (double)count, encodeNanoseconds, decodeNanoseconds, mismatches);
+        
+        for (size_t b = 0; b < blocks; b++) {
+            free(encoded[b]);
+            encoded[b] = NULL;
+        }
+    }
+    
+    free(values);
+    free(decoded);
+    free(encoded);
+    free(encodedBytes);
+}
+
+// MARK: - Stat Ingest
+
+#define XRG_STAT_BENCH_THREADS      8
+#define XRG_STAT_BENCH_OBSERVATIONS 10000000
+#define XRG_STAT_BENCH_MAX_HANDLES  16
+#define XRG_STAT_BENCH_READS        1000
+
+// What XRGStatsManager did before the shards: one lock around every stat's summary and sketch.
+typedef struct {
+    double             min;
+    double             max;
+    double             sum;
+    double             last;
+    uint64_t           count;
+    XRGQuantileSketch *sketch;
+} XRGLockedStat;
+
+typedef struct {
+    pthread_mutex_t *lock;          // NULL to observe through the shards.
+    XRGLockedStat   *lockedStats;
+    const uint32_t  *handles;
+    size_t           handleCount;
+    size_t           observations;
+    uint64_t         seed;
+} XRGStatBenchThread;
+
+static double XRGStatBenchValue(uint64_t *seed) {
+    return (double)(XRGBenchmarkRandom(seed) % 100000) / 1000.;
+}
+
+static void *XRGStatBenchWorker(void *argument) {
+    XRGStatBenchThread *thread = argument;
+    uint64_t seed = thread->seed;
+    
+    for (size_t i = 0; i < thread->observations; i++) {
+        size_t h = i % thread->handleCount;
+        double value = XRGStatBenchValue(&seed);
+        
+        if (!thread->lock) {
+            XRGStatObserve(thread->handles[h], value);
+            continue;
+        }
+        
+        pthread_mutex_lock(thread->lock);
+        XRGLockedStat *stat = &thread->lockedStats[h];
+        if (stat->count == 0 || value < stat->min) stat->min = value;
+        if (stat->count == 0 || value > stat->max) stat->max = value;
+        stat->sum += value;
+        stat->last = value;
+        stat->count++;
+        XRGQuantileSketchInsert(stat->sketch, value);
+        pthread_mutex_unlock(thread->lock);
+    }
+    
+    return NULL;
+}
+
+// Runs every thread to completion and returns the wall clock nanoseconds per observation, or 0 if a thread couldn't start.
+static double XRGStatBenchRun(XRGStatBenchThread *threads) {
+    pthread_t ids[XRG_STAT_BENCH_THREADS];
+    size_t started = 0;
+    
+    uint64_t start = XRGBenchmarkNanoseconds();
+    for (; started < XRG_STAT_BENCH_THREADS; started++) {
+        if (pthread_create(&ids[started], NULL, XRGStatBenchWorker, &threads[started]) != 0) break;
+    }
+    for (size_t t = 0; t < started; t++) pthread_join(ids[t], NULL);
+    uint64_t elapsed = XRGBenchmarkNanoseconds() - start;
+    
+    return started == XRG_STAT_BENCH_THREADS ? (double)elapsed / XRG_STAT_BENCH_OBSERVATIONS : 0;
+}
+
+void XRGBenchmarkStatIngest(XRGBenchmarkReport *report, const uint32_t *handles, size_t handleCount) {
+    if (handleCount == 0) return;
+    if (handleCount > XRG_STAT_BENCH_MAX_HANDLES) handleCount = XRG_STAT_BENCH_MAX_HANDLES;
+    
+    static const double quantiles[3] = { 0.5, 0.95, 0.99 };
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    XRGLockedStat lockedStats[XRG_STAT_BENCH_MAX_HANDLES] = { { 0 } };
+    for (size_t h = 0; h < handleCount; h++) {
+        lockedStats[h].sketch = XRGQuantileSketchCreate(XRG_QUANTILE_DEFAULT_ACCURACY);
+        if (!lockedStats[h].sketch) {
+            for (size_t f = 0; f < h; f++) XRGQuantileSketchFree(lockedStats[f].sketch);
+            return;
+        }
+        XRGStatClear(handles[h]);
+    }
+    
+    XRGStatBenchThread threads[XRG_STAT_BENCH_THREADS];
+    for (size_t t = 0; t < XRG_STAT_BENCH_THREADS; t++) {
+        threads[t] = (XRGStatBenchThread){ NULL, lockedStats, handles, handleCount, XRG_STAT_BENCH_OBSERVATIONS / XRG_STAT_BENCH_THREADS, 0x9E3779B97F4A7C15ull + t };
+    }
+    
+    uint64_t stallsBefore = XRGStatRingStallCount();
+    double shardNanoseconds = XRGStatBenchRun(threads);
+    uint64_t stalls = XRGStatRingStallCount() - stallsBefore;
+    
+    for (size_t t = 0; t < XRG_STAT_BENCH_THREADS; t++) threads[t].lock = &lock;
+    double lockedNanoseconds = XRGStatBenchRun(threads);
+    
+    XRGBenchmarkReportAppend(report, "Stat ingest, %d observations of %zu stats across %d threads, ns per observation\n", XRG_STAT_BENCH_OBSERVATIONS, handleCount, XRG_STAT_BENCH_THREADS);
+    XRGBenchmarkReportAppend(report, "%12s %12s %12s\n", "Shards", "One lock", "Ring stalls");
+    XRGBenchmarkReportAppend(report, "%12.1f %12.1f %12llu\n", shardNanoseconds, lockedNanoseconds, (unsigned long long)stalls);
+    
+    // Both saw the same values, so the counts and extremes should agree exactly, and the quantiles within the sketch's accuracy.
+    // Everything was observed in the last minute or so, so the one and five minute windows' quantiles should agree too;
+    // the five minute window's come from the one minute slices rolled up into its own.
+    size_t mismatches = 0;
+    double worstError = 0;
+    double worstWindowError = 0;
+    for (size_t h = 0; h < handleCount; h++) {
+        XRGStatSummary summary;
+        XRGStatRead(handles[h], &summary);
+        if (summary.count != lockedStats[h].count || summary.min != lockedStats[h].min || summary.max != lockedStats[h].max) mismatches++;
+        
+        double shardQuantiles[3], windowQuantiles[2][3], lockedQuantiles[3];
+        XRGStatQuantiles(handles[h], quantiles, shardQuantiles, 3);
+        if (!XRGStatReadWindowQuantiles(handles[h], XRGStatWindowOneMinute, quantiles, windowQuantiles[0], 3)) mismatches++;
+        if (!XRGStatReadWindowQuantiles(handles[h], XRGStatWindowFiveMinutes, quantiles, windowQuantiles[1], 3)) mismatches++;
+        XRGQuantileSketchQuantiles(lockedStats[h].sketch, quantiles, lockedQuantiles, 3);
+        for (int q = 0; q < 3; q++) {
+            double scale = lockedQuantiles[q] > 0 ? lockedQuantiles[q] : 1;
+            double error = fabs(shardQuantiles[q] - lockedQuantiles[q]) / scale;
+            if (error > worstError) worstError = error;
+            for (int w = 0; w < 2; w++) {
+                double windowError = fabs(windowQuantiles[w][q] - lockedQuantiles[q]) / scale;
+                if (windowError > worstWindowError) worstWindowError = windowError;
+            }
+        }
+    }
+    XRGBenchmarkReportAppend(report, "Summary mismatches: %zu, largest quantile difference: %.2f%% for the session, %.2f%% for the windows\n", mismatches, 100. * worstError, 100. * worstWindowError);
+    
+    // Reading p50/p95/p99 again with nothing new reuses the merged sketch; after an observation it merges the shards again.
+    double results[3];
+    uint64_t start = XRGBenchmarkNanoseconds();
+    for (int r = 0; r < XRG_STAT_BENCH_READS; r++) {
+        XRGStatQuantiles(handles[0], quantiles, results, 3);
+        XRGBenchmarkSink = results[1];
+    }
+    double cachedNanoseconds = (double)(XRGBenchmarkNanoseconds() - start) / XRG_STAT_BENCH_READS;
+    
+    uint64_t seed = 1;
+    start = XRGBenchmarkNanoseconds();
+    for (int r = 0; r < XRG_STAT_BENCH_READS; r++) {
+        XRGStatObserve(handles[0], XRGStatBenchValue(&seed));
+        XRGStatQuantiles(handles[0], quantiles, results, 3);
+        XRGBenchmarkSink = results[1];
+    }
+    double mergedNanoseconds = (double)(XRGBenchmarkNanoseconds() - start) / XRG_STAT_BENCH_READS;
+    
+    start = XRGBenchmarkNanoseconds();
+    for (int r = 0; r < XRG_STAT_BENCH_READS; r++) {
+        XRGStatReadWindowQuantiles(handles[0], XRGStatWindowFiveMinutes, quantiles, results, 3);
+        XRGBenchmarkSink = results[1];
+    }
+    double windowNanoseconds = (double)(XRGBenchmarkNanoseconds() - start) / XRG_STAT_BENCH_READS;
+    
+    XRGBenchmarkReportAppend(report, "Quantile read, ns: %.0f unchanged, %.0f after a new value, %.0f for the five minute window\n", cachedNanoseconds, mergedNanoseconds, windowNanoseconds);
+    
+    for (size_t h = 0; h < handleCount; h++) {
+        XRGStatClear(handles[h]);
+        XRGQuantileSketchFree(lockedStats[h].sketch);
+    }
+    pthread_mutex_destroy(&lock);
+}
+
+// MARK: - Decimation
+
+#define XRG_DECIMATION_BENCH_COLUMNS 1000
+#define XRG_DECIMATION_BENCH_MISSING -1000     // NOVALUE
+
+// A wandering 0-60% load, missing for the first tenth like a ring that hasn't filled, with one sample-wide spike.
+static void XRGFillDecimationTrace(double *values, size_t count, size_t spikeIndex, uint64_t *seed) {
+    double level = 20;
+    for (size_t i = 0; i < count; i++) {
+        level += (double)(XRGBenchmarkRandom(seed) % 21) - 10.;
+        if (level < 0) level = 0;
+        if (level > 60) level = 60;
+        values[i] = i < count / 10 ? XRG_DECIMATION_BENCH_MISSING : level;
+    }
+    values[spikeIndex] = 100;
+}
+
+// Counts the columns XRGDecimateMinMax got wrong, recomputing each one sample by sample from the joined spans.
+static size_t XRGCheckDecimatedColumns(const double *values, size_t count, const XRGDecimationColumn *columns, size_t columnCount) {
+    size_t mismatches = 0;
+    for (size_t c = 0; c < columnCount; c++) {
+        XRGDecimationColumn expected = { 0, 0, 0, 0, 0 };
+        size_t start = c * count / columnCount;
+        size_t end = (c + 1) * count / columnCount;
+        for (size_t i = start; i < end; i++) {
+            if (values[i] == XRG_DECIMATION_BENCH_MISSING) continue;
+            if (expected.count == 0 || values[i] < expected.min) expected.min = values[i];
+            if (expected.count == 0 || values[i] > expected.max) expected.max = values[i];
+            if (expected.count == 0) expected.first = values[i];
+            expected.last = values[i];
+            expected.count++;
+        }
+        
+        const XRGDecimationColumn *column = &columns[c];
+        if (column->count != expected.count || (expected.count && (column->min != expected.min || column->max != expected.max || column->first != expected.first || column->last != expected.last))) mismatches++;
+    }
+    return mismatches;
+}
+
+void XRGBenchmarkDecimation(XRGBenchmarkReport *report) {
+    static const size_t lengths[] = { 3600, 86400, 604800 };
+    const size_t columnCount = XRG_DECIMATION_BENCH_COLUMNS;
+    const size_t maxCount = lengths[sizeof(lengths) / sizeof(lengths[0]) - 1];
+    
+    double *values = malloc(maxCount * sizeof(double));
+    double *points = malloc(2 * maxCount * sizeof(double));
+    size_t *indices = malloc(columnCount * sizeof(size_t));
+    XRGDecimationColumn *columns = malloc(columnCount * sizeof(XRGDecimationColumn));
+    if (!values || !points || !indices || !columns) {
+        free(values);
+        free(points);
+        free(indices);
+        free(columns);
+        return;
+    }
+    
+    XRGBenchmarkReportAppend(report, "Graph decimation into %zu columns, ns per sample; Full is one point per sample, as before decimation\n", columnCount);
+    XRGBenchmarkReportAppend(report, "%8s %10s %10s %10s %12s %10s %8s\n", "Samples", "Full", "Min/max", "LTTB", "LTTB points", "Mismatches", "Spike");
+    
+    uint64_t seed = 0x2545F4914F6CDD1Dull;
+    for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+        size_t count = lengths[l];
+        size_t spikeIndex = count / 2 + XRGBenchmarkRandom(&seed) % (count / 3);
+        XRGFillDecimationTrace(values, count, spikeIndex, &seed);
+        
+        // Split the samples where a ring's current index might be.
+        size_t olderCount = (size_t)(XRGBenchmarkRandom(&seed) % count);
+        const double *older = values;
+        const double *newer = values + olderCount;
+        size_t newerCount = count - olderCount;
+        
+        // Shorter traces are run more times, so each length is timed over about the same number of samples.
+        size_t runs = maxCount / count;
+        
+        // The path the graphs built before: an x and clamped y for every sample that isn't missing.
+        uint64_t start = XRGBenchmarkNanoseconds();
+        for (size_t r = 0; r < runs; r++) {
+            size_t pointCount = 0;
+            for (size_t i = 0; i < count; i++) {
+                if (values[i] == XRG_DECIMATION_BENCH_MISSING) continue;
+                points[2 * pointCount] = (double)i * (double)columnCount / (double)count;
+                points[2 * pointCount + 1] = values[i] > 100 ? 100 : (values[i] < 0 ? 0 : values[i]);
+                pointCount++;
+            }
+            XRGBenchmarkSink = points[2 * pointCount - 1];
+        }
+        double fullNanoseconds = (double)(XRGBenchmarkNanoseconds() - start) / (double)(count * runs);
+        
+        start = XRGBenchmarkNanoseconds();
+        for (size_t r = 0; r < runs; r++) {
+            XRGDecimateMinMax(older, olderCount, newer, newerCount, XRG_DECIMATION_BENCH_MISSING, columns, columnCount);
+        }
+        double minMaxNanoseconds = (double)(XRGBenchmarkNanoseconds() - start) / (double)(count * runs);
+        
+        size_t kept = 0;
+        start = XRGBenchmarkNanoseconds();
+        for (size_t r = 0; r < runs; r++) {
+            kept = XRGDecimateLTTB(older, olderCount, newer, newerCount, XRG_DECIMATION_BENCH_MISSING, columnCount, indices);
+        }
+        double lttbNanoseconds = (double)(XRGBenchmarkNanoseconds() - start) / (double)(count * runs);
+        
+        // Both reductions must keep the spike: as a column's max, and as one of the points LTTB picks.
+        bool spikeKept = false, spikePicked = false;
+        for (size_t c = 0; c < columnCount; c++) spikeKept |= columns[c].count && columns[c].max == 100;
+        for (size_t k = 0; k < kept; k++) spikePicked |= indices[k] == spikeIndex;
+        
+        size_t mismatches = XRGCheckDecimatedColumns(values, count, columns, columnCount);
+        XRGBenchmarkReportAppend(report, "%8zu %10.2f %10.2f %10.2f %12zu %10zu %8s\n", count, fullNanoseconds, minMaxNanoseconds, lttbNanoseconds, kept, mismatches, spikeKept && spikePicked ? "kept" : "LOST");
+    }
+    
+    free(values);
+    free(points);
+    free(indices);
+    free(columns);
+}
+
+// MARK: - Byte Formatting
+
+#define XRG_FORMAT_BENCH_VALUES 1000000
+
+// +[XRGCommon formattedStringForBytes:] before XRGFormatBytes, with snprintf standing in for stringWithFormat:.
+static void XRGOldFormatBytes(double bytes, char *buffer, size_t capacity) {
+    if (bytes >= 112589990684262400.)
+        snprintf(buffer, capacity, "%.1fP", (bytes / 1125899906842624.));
+    else if (bytes >= 1125899906842624.)
+        snprintf(buffer, capacity, "%.2fP", (bytes / 1125899906842624.));
+    else if (bytes >= 109951162777600.)
+        snprintf(buffer, capacity, "%.1fT", (bytes / 1099511627776.));
+    else if (bytes >= 1099511627776.)
+        snprintf(buffer, capacity, "%.2fT", (bytes / 1099511627776.));
+    else if (bytes >= 107374182400.)
+        snprintf(buffer, capacity, "%.1fG", (bytes / 1073741824.));
+    else if (bytes >= 1073741824.)
+        snprintf(buffer, capacity, "%.2fG", (bytes / 1073741824.));
+    else if (bytes >= 104857600.)
+        snprintf(buffer, capacity, "%.1fM", (bytes / 1048576.));
+    else if (bytes >= 1048576.)
+        snprintf(buffer, capacity, "%.2fM", (bytes / 1048576.));
+    else if (bytes >= 102400.)
+        snprintf(buffer, capacity, "%.0fK", (bytes / 1024.));
+    else if (bytes >= 1024.)
+        snprintf(buffer, capacity, "%.1fK", (bytes / 1024.));
+    else
+        snprintf(buffer, capacity, "%ldB", (long)bytes);
+}
+
+typedef struct {
+    double      bytes;
+    bool        justBelow;      // Check the largest double below bytes instead.
+    const char *expected;
+} XRGFormatCase;
+
+// Either side of 1 and of 100 of every unit, where the old chain switched formats, plus a few values in between.
+static const XRGFormatCase XRGFormatCases[] = {
+    { 0.,                     false, "0B" },
+    { 1.,                     false, "1B" },
+    { -1.5,                   false, "-1B" },
+    { 1536.,                  false, "1.5K" },
+    { 102348.8,               false, "100.0K" },
+    { 104852357.12,           false, "100.00M" },
+    
+    { 1024.,                  true,  "1023B" },
+    { 1024.,                  false, "1.0K" },
+    { 102400.,                true,  "100.0K" },
+    { 102400.,                false, "100K" },
+    
+    { 1048576.,               true,  "1024K" },
+    { 1048576.,               false, "1.00M" },
+    { 104857600.,             true,  "100.00M" },
+    { 104857600.,             false, "100.0M" },
+    
+    { 1073741824.,            true,  "1024.0M" },
+    { 1073741824.,            false, "1.00G" },
+    { 107374182400.,          true,  "100.00G" },
+    { 107374182400.,          false, "100.0G" },
+    
+    { 1099511627776.,         true,  "1024.0G" },
+    { 1099511627776.,         false, "1.00T" },
+    { 109951162777600.,       true,  "100.00T" },
+    { 109951162777600.,       false, "100.0T" },
+    
+    { 1125899906842624.,      true,  "1024.0T" },
+    { 1125899906842624.,      false, "1.00P" },
+    { 112589990684262400.,    true,  "100.00P" },
+    { 112589990684262400.,    false, "100.0P" },
+};
+
+void XRGBenchmarkFormatBytes(XRGBenchmarkReport *report) {
+    char formatted[XRG_FORMAT_BYTES_LENGTH], old[XRG_FORMAT_BYTES_LENGTH];
+    
+    // Every case has to come out of both formatters as the string in the table.
+    size_t caseCount = sizeof(XRGFormatCases) / sizeof(XRGFormatCases[0]);
+    size_t caseFailures = 0;
+    for (size_t i = 0; i < caseCount; i++) {
+        const XRGFormatCase *formatCase = &XRGFormatCases[i];
+        double bytes = formatCase->justBelow ? nextafter(formatCase->bytes, 0) : formatCase->bytes;
+        
+        XRGFormatBytes(bytes, NULL, formatted, sizeof(formatted));
+        XRGOldFormatBytes(bytes, old, sizeof(old));
+        if (strcmp(formatted, formatCase->expected) != 0 || strcmp(old, formatCase->expected) != 0) {
+            if (caseFailures++ == 0) XRGBenchmarkReportAppend(report, "Byte formatting case failed: %.17g gave \"%s\", the old chain \"%s\", expected \"%s\"\n", bytes, formatted, old, formatCase->expected);
+        }
+    }
+    
+    // Spread evenly over the exponents up to about 2^60 bytes, so every unit gets as many values as the small ones.
+    double *values = malloc(XRG_FORMAT_BENCH_VALUES * sizeof(double));
+    if (!values) return;
+    uint64_t seed = 0xD1B54A32D192ED03ull;
+    for (size_t i = 0; i < XRG_FORMAT_BENCH_VALUES; i++) {
+        uint64_t r = XRGBenchmarkRandom(&seed);
+        values[i] = ldexp((double)(r >> 11) / 9007199254740992., (int)(r % 61));
+        if (r & 1) values[i] = floor(values[i]);
+    }
+    
+    size_t mismatches = 0;
+    for (size_t i = 0; i < XRG_FORMAT_BENCH_VALUES; i++) {
+        XRGFormatBytes(values[i], NULL, formatted, sizeof(formatted));
+        XRGOldFormatBytes(values[i], old, sizeof(old));
+        if (strcmp(formatted, old) != 0) mismatches++;
+    }
+    
+    size_t length = 0;
+    uint64_t start = XRGBenchmarkNanoseconds();
+    for (size_t i = 0; i < XRG_FORMAT_BENCH_VALUES; i++) {
+        XRGOldFormatBytes(values[i], old, sizeof(old));
+        length += (size_t)old[0];
+    }
+    double oldNanoseconds = (double)(XRGBenchmarkNanoseconds() - start) / XRG_FORMAT_BENCH_VALUES;
+    
+    start = XRGBenchmarkNanoseconds();
+    for (size_t i = 0; i < XRG_FORMAT_BENCH_VALUES; i++) {
+        length += XRGFormatBytes(values[i], NULL, formatted, sizeof(formatted));
+    }
+    double formatNanoseconds = (double)(XRGBenchmarkNanoseconds() - start) / XRG_FORMAT_BENCH_VALUES;
+    XRGBenchmarkSink = (double)length;
+    
+    XRGBenchmarkReportAppend(report, "Byte formatting, %d values, ns per call\n", XRG_FORMAT_BENCH_VALUES);
+    XRGBenchmarkReportAppend(report, "%12s %12s %12s %14s\n", "printf chain", "XRGFormat", "Mismatches", "Boundary cases");
+    XRGBenchmarkReportAppend(report, "%12.1f %12.1f %12zu %7zu failed\n", oldNanoseconds, formatNanoseconds, mismatches, caseFailures);
+    
+    free(values);
+}
+
+// MARK: - /proc/stat
+
+#define XRG_PROC_BENCH_CPUS     256
+#define XRG_PROC_BENCH_SAMPLES  2000
+#define XRG_PROC_BENCH_TEXT     (XRG_PROC_BENCH_CPUS * 220 + 256)
+
+// Two readings of a five CPU box with cpu2 offline.  cpu4's line comes from a kernel without the guest columns, and
+// the second reading was cut off partway through cpu4.
+static const char XRGProcStatFixtureFirst[] =
+    "cpu  5422859 133733 2147494 53536985 16683 0 25195 0 132426 0\n"
+    "cpu0 1393280 32966 572056 13343292 6130 0 17875 0 23933 0\n"
+    "cpu1 1335008 33148 514066 13551632 6112 0 4195 0 48393 0\n"
+    "cpu3 1289140 27406 499283 13334540 1910 0 1250 0 60100 0\n"
+    "cpu4 1405431 40213 562089 13307521 2531 0 1875 0\n"
+    "intr 199292 9 0 0 0 0 0 0 0 1 0\n"
+    "ctxt 3712899\n";
+
+static const char XRGProcStatFixtureSecond[] =
+    "cpu  5423059 133733 2147554 53537285 16703 0 25205 0 132456 0\n"
+    "cpu0 1393340 32966 572076 13343392 6140 0 17885 0 23963 0\n"
+    "cpu1 1335108 33148 514086 13551732 6112 0 4195 0 48393 0\n"
+    "cpu3 1289180 27406 499303 13334640 1920 0 1250 0 60100 0\n"
+    "cpu4 1405531 40213 56";
+
+// A third reading for cpu1 in which iowait went down by a tick, which proc(5) says can happen: 50 user, 20 system and
+// 130 idle ticks.
+static const char XRGProcStatFixtureThird[] =
+    "cpu  5423159 133733 2147574 53537415 16702 0 25205 0 132456 0\n"
+    "cpu1 1335158 33148 514106 13551862 6111 0 4195 0 48393 0\n";
+
+static const double XRGProcStatFixtureCPU1Percentages[XRGCPUTickCount] = { 25, 0, 10, 65, 0, 0, 0, 0, 0, 0 };
+
+typedef struct {
+    size_t   cpu;
+    uint64_t ticks[XRGCPUTickCount];
+} XRGProcStatFixtureCPU;
+
+static const XRGProcStatFixtureCPU XRGProcStatFixtureFirstTicks[] = {
+    { 0, { 1393280, 32966, 572056, 13343292, 6130, 0, 17875, 0, 23933, 0 } },
+    { 1, { 1335008, 33148, 514066, 13551632, 6112, 0, 4195, 0, 48393, 0 } },
+    { 2, { 7, 7, 7, 7, 7, 7, 7, 7, 7, 7 } },        // Offline: keeps what was there.
+    { 3, { 1289140, 27406, 499283, 13334540, 1910, 0, 1250, 0, 60100, 0 } },
+    { 4, { 1405431, 40213, 562089, 13307521, 2531, 0, 1875, 0, 0, 0 } },
+};
+
+// cpu0 between the readings: 60 user ticks (30 of them guest), 20 system, 100 idle, 10 iowait and 10 softirq.
+static const double XRGProcStatFixtureCPU0Percentages[XRGCPUTickCount] = { 30, 0, 10, 50, 5, 0, 5, 0, 15, 0 };
+
+// The layers the CPU graph stacks for cpu0 on Linux: user without its guest time, system, nice, then irq, softirq,
+// steal, guest and iowait.  45% busy.
+static const XRGCPUTickState XRGProcStatFixtureExtras[] = { XRGCPUTickIRQ, XRGCPUTickSoftIRQ, XRGCPUTickSteal, XRGCPUTickGuest, XRGCPUTickIOWait };
+static const double XRGProcStatFixtureCPU0Layers[] = { 15, 10, 0, 0, 5, 0, 15, 5 };
+
+// Two Mach readings, which only have user, nice, system and idle, with user wrapping past 32 bits: 60 user, 40 system
+// and 100 idle ticks.
+static const XRGCPUTicks XRGMachFixtureFirst = { { UINT32_MAX - 9, 500, 2000, 90000 } };
+static const XRGCPUTicks XRGMachFixtureSecond = { { 50, 500, 2040, 90100 } };
+
+// Counts what XRGProcStatParse, XRGCPUTicksPercentages, XRGCPUTicksLayers and the /proc/loadavg and /proc/uptime
+// parsers get wrong on the fixtures, appending a line for the first failure.
+static size_t XRGCheckProcStatFixture(XRGBenchmarkReport *report) {
+    XRGCPUTicks first[5], second[5];
+    for (size_t c = 0; c < 5; c++) {
+        for (int s = 0; s < XRGCPUTickCount; s++) first[c].ticks[s] = 7;
+    }
+    
+    size_t failures = 0;
+    const char *failure = NULL;
+    
+    if (XRGProcStatParse(XRGProcStatFixtureFirst, sizeof(XRGProcStatFixtureFirst) - 1, first, 5) != 5) {
+        failures++;
+        if (!failure) failure = "wrong CPU count in the first reading";
+    }
+    for (size_t i = 0; i < sizeof(XRGProcStatFixtureFirstTicks) / sizeof(XRGProcStatFixtureFirstTicks[0]); i++) {
+        const XRGProcStatFixtureCPU *expected = &XRGProcStatFixtureFirstTicks[i];
+        if (memcmp(first[expected->cpu].ticks, expected->ticks, sizeof(expected->ticks)) != 0) {
+            failures++;
+            if (!failure) failure = "wrong ticks in the first reading";
+        }
+    }
+    
+    // The cut off cpu4 line is left alone, so it still holds the first reading.
+    memcpy(second, first, sizeof(first));
+    if (XRGProcStatParse(XRGProcStatFixtureSecond, sizeof(XRGProcStatFixtureSecond) - 1, second, 5) != 4 || memcmp(&second[4], &first[4], sizeof(XRGCPUTicks)) != 0) {
+        failures++;
+        if (!failure) failure = "the cut off line wasn't ignored";
+    }
+    
+    double percentages[XRGCPUTickCount];
+    XRGCPUTicksPercentages(&second[0], &first[0], false, percentages);
+    for (int s = 0; s < XRGCPUTickCount; s++) {
+        if (fabs(percentages[s] - XRGProcStatFixtureCPU0Percentages[s]) > 1e-9) {
+            failures++;
+            if (!failure) failure = "wrong usage for cpu0";
+        }
+    }
+    
+    // A counter that goes down on Linux is an interval with none of that state, not a 32-bit wrap.
+    XRGCPUTicks third[5];
+    memcpy(third, second, sizeof(second));
+    XRGProcStatParse(XRGProcStatFixtureThird, sizeof(XRGProcStatFixtureThird) - 1, third, 5);
+    XRGCPUTicksPercentages(&third[1], &second[1], false, percentages);
+    double sum = 0;
+    for (int s = 0; s < XRGCPUTickCount; s++) {
+        if (percentages[s] < 0 || percentages[s] > 100 || fabs(percentages[s] - XRGProcStatFixtureCPU1Percentages[s]) > 1e-9) {
+            failures++;
+            if (!failure) failure = "wrong usage for cpu1 when iowait went down";
+        }
+        if (s <= XRGCPUTickSteal) sum += percentages[s];
+    }
+    if (fabs(sum - 100) > 1e-9) {
+        failures++;
+        if (!failure) failure = "cpu1's usage doesn't add up to 100 when iowait went down";
+    }
+    
+    XRGCPUTicksPercentages(&second[0], &first[0], false, percentages);
+    
+    size_t extraCount = sizeof(XRGProcStatFixtureExtras) / sizeof(XRGProcStatFixtureExtras[0]);
+    double layers[3 + sizeof(XRGProcStatFixtureExtras) / sizeof(XRGProcStatFixtureExtras[0])];
+    double busy = XRGCPUTicksLayers(percentages, XRGProcStatFixtureExtras, extraCount, layers);
+    double stacked = 0;
+    for (size_t l = 0; l < 3 + extraCount; l++) {
+        if (fabs(layers[l] - XRGProcStatFixtureCPU0Layers[l]) > 1e-9) {
+            failures++;
+            if (!failure) failure = "wrong layers for cpu0";
+        }
+        if (l != 3 + extraCount - 1) stacked += layers[l];
+    }
+    if (fabs(busy - 45) > 1e-9 || fabs(stacked - busy) > 1e-9) {
+        failures++;
+        if (!failure) failure = "the busy layers don't add up for cpu0";
+    }
+    
+    // Guest read ahead of user is capped, rather than stacking more than user had.
+    percentages[XRGCPUTickGuest] = percentages[XRGCPUTickUser] + 3;
+    XRGCPUTicksLayers(percentages, XRGProcStatFixtureExtras, extraCount, layers);
+    if (layers[0] != 0 || layers[6] != percentages[XRGCPUTickUser]) {
+        failures++;
+        if (!failure) failure = "guest wasn't capped at user";
+    }
+    
+    // On Mach there are no extra layers and nothing is taken out of user.
+    XRGCPUTicksPercentages(&XRGMachFixtureSecond, &XRGMachFixtureFirst, true, percentages);
+    busy = XRGCPUTicksLayers(percentages, NULL, 0, layers);
+    if (fabs(layers[0] - 30) > 1e-9 || fabs(layers[1] - 20) > 1e-9 || layers[2] != 0 || fabs(busy - 50) > 1e-9) {
+        failures++;
+        if (!failure) failure = "wrong layers for a Mach reading";
+    }
+    
+    if (XRGProcLoadAverageParse("0.52 0.58 0.59 1/123 4567\n", 26) != 0.52 || XRGProcUptimeParse("12345.67 54321.00\n", 18) != 12345.67) {
+        failures++;
+        if (!failure) failure = "wrong load average or uptime";
+    }
+    
+    if (failure) XRGBenchmarkReportAppend(report, "/proc/stat fixture: %s\n", failure);
+    return failures;
+}
+
+// Writes a /proc/stat of cpuCount CPUs with ten columns of digits-long counters, each previous[c] plus up to 100.
+static size_t XRGFillProcStatText(char *text, size_t capacity, const XRGCPUTicks *previous, XRGCPUTicks *ticks, size_t cpuCount, uint64_t *seed) {
+    size_t length = (size_t)snprintf(text, capacity, "cpu  0 0 0 0 0 0 0 0 0 0\n");
+    for (size_t c = 0; c < cpuCount && length < capacity; c++) {
+        length += (size_t)snprintf(text + length, capacity - length, "cpu%zu", c);
+        for (int s = 0; s < XRGCPUTickCount && length < capacity; s++) {
+            ticks[c].ticks[s] = previous[c].ticks[s] + XRGBenchmarkRandom(seed) % 100;
+            length += (size_t)snprintf(text + length, capacity - length, " %llu", (unsigned long long)ticks[c].ticks[s]);
+        }
+        if (length < capacity) length += (size_t)snprintf(text + length, capacity - length, "\n");
+    }
+    if (length < capacity) length += (size_t)snprintf(text + length, capacity - length, "intr 0\nctxt 0\n");
+    return length < capacity ? length : capacity - 1;
+}
+
+// The straightforward parser: one sscanf per "cpuN" line.
+static void XRGScanProcStat(const char *text, XRGCPUTicks *ticks, size_t count) {
+    const char *line = text;
+    while (strncmp(line, "cpu", 3) == 0) {
+        unsigned cpu;
+        unsigned long long values[XRGCPUTickCount] = { 0 };
+        if (sscanf(line, "cpu%u %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu", &cpu, &values[0], &values[1], &values[2], &values[3], &values[4], &values[5], &values[6], &values[7], &values[8], &values[9]) >= 5 && cpu < count) {
+            for (int s = 0; s < XRGCPUTickCount; s++) ticks[cpu].ticks[s] = values[s];
+        }
+        
+        const char *next = strchr(line, '\n');
+        if (!next) break;
+        line = next + 1;
+    }
+}
+
+void XRGBenchmarkProcStat(XRGBenchmarkReport *report) {
+    size_t fixtureFailures = XRGCheckProcStatFixture(report);
+    
+    const size_t cpuCount = XRG_PROC_BENCH_CPUS;
+    char *text = malloc(XRG_PROC_BENCH_TEXT);
+    XRGCPUTicks *previous = calloc(cpuCount, sizeof(XRGCPUTicks));
+    XRGCPUTicks *expected = calloc(cpuCount, sizeof(XRGCPUTicks));
+    XRGCPUTicks *parsed = calloc(cpuCount, sizeof(XRGCPUTicks));
+    XRGCPUTicks *scanned = calloc(cpuCount, sizeof(XRGCPUTicks));
+    if (!text || !previous || !expected || !parsed || !scanned) {
+        free(text);
+        free(previous);
+        free(expected);
+        free(parsed);
+        free(scanned);
+        return;
+    }
+    
+    // Counters a day or so into uptime on a busy box, then a second reading a tick later.
+    uint64_t seed = 0x6A09E667F3BCC909ull;
+    for (size_t c = 0; c < cpuCount; c++) {
+        for (int s = 0; s < XRGCPUTickCount; s++) previous[c].ticks[s] = XRGBenchmarkRandom(&seed) % 100000000;
+    }
+    size_t length = XRGFillProcStatText(text, XRG_PROC_BENCH_TEXT, previous, expected, cpuCount, &seed);
+    
+    size_t mismatches = 0;
+    XRGProcStatParse(text, length, parsed, cpuCount);
+    XRGScanProcStat(text, scanned, cpuCount);
+    for (size_t c = 0; c < cpuCount; c++) {
+        if (memcmp(&parsed[c], &expected[c], sizeof(XRGCPUTicks)) != 0 || memcmp(&scanned[c], &expected[c], sizeof(XRGCPUTicks)) != 0) mismatches++;
+    }
+    
+    double percentages[XRGCPUTickCount];
+    uint64_t start = XRGBenchmarkNanoseconds();
+    for (int r = 0; r < XRG_PROC_BENCH_SAMPLES; r++) {
+        XRGScanProcStat(text, scanned, cpuCount);
+        for (size_t c = 0; c < cpuCount; c++) XRGCPUTicksPercentages(&scanned[c], &previous[c], false, percentages);
+        XRGBenchmarkSink = percentages[0];
+    }
+    double scanMicroseconds = (double)(XRGBenchmarkNanoseconds() - start) / 1000. / XRG_PROC_BENCH_SAMPLES;
+    
+    start = XRGBenchmarkNanoseconds();
+    for (int r = 0; r < XRG_PROC_BENCH_SAMPLES; r++) {
+        XRGProcStatParse(text, length, parsed, cpuCount);
+        for (size_t c = 0; c < cpuCount; c++) XRGCPUTicksPercentages(&parsed[c], &previous[c], false, percentages);
+        XRGBenchmarkSink = percentages[0];
+    }
+    double parseMicroseconds = (double)(XRGBenchmarkNanoseconds() - start) / 1000. / XRG_PROC_BENCH_SAMPLES;
+    
+    XRGBenchmarkReportAppend(report, "/proc/stat parsing and usage, %d CPUs (%zu bytes), us per sample\n", XRG_PROC_BENCH_CPUS, length);
+    XRGBenchmarkReportAppend(report, "%10s %10s %10s %16s\n", "sscanf", "Parser", "Mismatches", "Fixture failures");
+    XRGBenchmarkReportAppend(report, "%10.1f %10.1f %10zu %16zu\n", scanMicroseconds, parseMicroseconds, mismatches, fixtureFailures);
+    
+    // Only on Linux: the live files, read with pread().
+    XRGProcStatReader *reader = XRGProcStatReaderCreate();
+    if (reader) {
+        start = XRGBenchmarkNanoseconds();
+        for (int r = 0; r < XRG_PROC_BENCH_SAMPLES; r++) XRGProcStatReaderReadTicks(reader);
+        double readMicroseconds = (double)(XRGBenchmarkNanoseconds() - start) / 1000. / XRG_PROC_BENCH_SAMPLES;
+        XRGBenchmarkReportAppend(report, "Live /proc/stat read and parse, %zu CPUs: %.1f us\n", XRGProcStatReaderCPUCount(reader), readMicroseconds);
+        XRGProcStatReaderFree(reader);
+    }
+    
+    free(text);
+    free(previous);
+    free(expected);
+    free(parsed);
+    free(scanned);
+}
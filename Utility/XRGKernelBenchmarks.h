@@ -0,0 +1,81 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGKernelBenchmarks.h
+//
+
+#ifndef XRG_KERNEL_BENCHMARKS_H
+#define XRG_KERNEL_BENCHMARKS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// The plain C sections of the diagnostics panel's benchmarks (see XRGBenchmarks.h).  Each one times a C module
+// against the path it replaced, or replays recorded input through it and checks the output, and appends what it
+// found to a text report.
+
+typedef struct {
+    char   *text;
+    size_t  length;
+    size_t  capacity;
+} XRGBenchmarkReport;
+
+void XRGBenchmarkReportAppend(XRGBenchmarkReport *report, const char *format, ...) __attribute__((format(printf, 2, 3)));
+void XRGBenchmarkReportFree(XRGBenchmarkReport *report);
+
+/// A monotonic clock in nanoseconds, for timing the sections.
+uint64_t XRGBenchmarkNanoseconds(void);
+
+// MARK: - Sections
+
+/// Every vector kernel backend this CPU supports, and vDSP on Apple platforms, at several lengths: GB/s read and
+/// written by min/max/sum, add, subtract, scale and fill, with each backend's results checked against the scalar
+/// reference.
+void XRGBenchmarkVectorKernels(XRGBenchmarkReport *report);
+
+/// XRGGorillaEncode and XRGGorillaDecode on synthetic CPU, network, temperature and idle traces, in blocks the size
+/// the data set archives use: bytes per sample, encode and decode time, and a check that every value round-trips.
+void XRGBenchmarkArchiveCodec(XRGBenchmarkReport *report);
+
+/// XRGDecimateMinMax and XRGDecimateLTTB on an hour, a day and a week of one-second samples into 1000 columns,
+/// against building a point for every sample, with the columns checked sample by sample and a one-sample spike that
+/// both have to keep.
+void XRGBenchmarkDecimation(XRGBenchmarkReport *report);
+
+/// XRGFormatBytes against the printf chain it replaced in +[XRGCommon formattedStringForBytes:]: a table of values either
+/// side of 1 and 100 of every unit that both have to format as listed, then a million values spread over every unit,
+/// compared and timed.
+void XRGBenchmarkFormatBytes(XRGBenchmarkReport *report);
+
+/// XRGProcStatParse, XRGCPUTicksPercentages and XRGCPUTicksLayers: recorded /proc/stat readings with an offline CPU,
+/// a kernel without the guest columns, a cut off line and an iowait counter going down, and a pair of Mach readings
+/// that wrap, checked against the ticks, usage and graph layers they should give; then a 256 CPU reading parsed and
+/// turned into usage, against one sscanf per line.  On Linux, also the live read.
+void XRGBenchmarkProcStat(XRGBenchmarkReport *report);
+
+/// 10 million XRGStatObserve calls from eight threads against the single lock XRGStatsManager used to take, with the
+/// summaries and quantiles compared afterwards, then how long a quantile read takes with and without a new value.
+/// handles are used as scratch stats and are cleared before and after.
+void XRGBenchmarkStatIngest(XRGBenchmarkReport *report, const uint32_t *handles, size_t handleCount);
+
+#endif
@@ -0,0 +1,57 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGLabelCache.h
+//
+
+#import <Cocoa/Cocoa.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! A bounded LRU cache of laid-out label text, keyed by the string and the contents of its attributes, so a label that shows the same text as last tick isn't rebuilt and a template string isn't re-measured.  Attribute dictionaries from XRGSettings are changed in place when a color or font changes, so entries keep a copy of the attributes and the old ones simply age out.  Main thread only.
+ */
+@interface XRGLabelCache : NSObject
+
+@property (class, readonly) XRGLabelCache *shared;
+
+- (instancetype)initWithCapacity:(NSUInteger)capacity;
+
+/// string with attributes applied, shared with every other caller asking for the same text.
+- (NSAttributedString *)attributedString:(NSString *)string attributes:(NSDictionary<NSAttributedStringKey, id> *)attributes;
+
+/// What sizeWithAttributes: would return for string.
+- (NSSize)sizeOfString:(NSString *)string attributes:(NSDictionary<NSAttributedStringKey, id> *)attributes;
+
+/// Called when the graph font changes.  Also clears the hit and miss counts.
+- (void)removeAllEntries;
+
+@property (readonly) NSUInteger capacity;
+@property (readonly) NSUInteger count;
+@property (readonly) uint64_t hits;
+@property (readonly) uint64_t misses;
+/// Hits as a fraction of all lookups, 0 if there haven't been any.
+@property (readonly) double hitRate;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,209 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGLabelCache.m
+//
+
+#import "XRGLabelCache.h"
+
+#define XRG_LABEL_CACHE_DEFAULT_CAPACITY 256
+
+#pragma mark - XRGLabelCacheKey
+@interface XRGLabelCacheKey : NSObject <NSCopying>
+
+@property (readonly) NSString *string;
+@property (readonly) NSDictionary *attributes;
+
+@end
+
+@implementation XRGLabelCacheKey {
+    NSUInteger _hash;
+}
+
+- (instancetype)initWithString:(NSString *)string attributes:(NSDictionary *)attributes {
+    if (self = [super init]) {
+        _string = string;
+        _attributes = attributes;
+        
+        // NSDictionary's hash is only its count, so mix in the font.
+        _hash = string.hash ^ ([attributes[NSFontAttributeName] hash] * 31);
+    }
+    return self;
+}
+
+// Keys are used for lookups with whatever the caller passed in, and only copied when they're stored.
+- (id)copyWithZone:(NSZone *)zone {
+    return [[XRGLabelCacheKey alloc] initWithString:[_string copy] attributes:[_attributes copy]];
+}
+
+- (NSUInteger)hash {
+    return _hash;
+}
+
+- (BOOL)isEqual:(id)object {
+    if (object == self) return YES;
+    if (![object isKindOfClass:[XRGLabelCacheKey class]]) return NO;
+    
+    XRGLabelCacheKey *other = object;
+    return _hash == other->_hash && [_string isEqualToString:other->_string] && (_attributes == other->_attributes || [_attributes isEqualToDictionary:other->_attributes]);
+}
+
+@end
+
+#pragma mark - XRGLabelCacheEntry
+@interface XRGLabelCacheEntry : NSObject {
+@public
+    XRGLabelCacheKey *key;
+    NSAttributedString *attributedString;
+    NSSize size;
+    BOOL hasSize;
+    
+    // Most recently used first.
+    __weak XRGLabelCacheEntry *previous;
+    XRGLabelCacheEntry *next;
+}
+@end
+
+@implementation XRGLabelCacheEntry
+@end
+
+#pragma mark - XRGLabelCache
+@implementation XRGLabelCache {
+    NSMutableDictionary<XRGLabelCacheKey *, XRGLabelCacheEntry *> *_entries;
+    XRGLabelCacheEntry *_head;
+    __weak XRGLabelCacheEntry *_tail;
+}
+
++ (XRGLabelCache *)shared {
+    static XRGLabelCache *sharedCache = nil;
+
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedCache = [[XRGLabelCache alloc] initWithCapacity:XRG_LABEL_CACHE_DEFAULT_CAPACITY];
+    });
+
+    return sharedCache;
+}
+
+- (instancetype)init {
+    return [self initWithCapacity:XRG_LABEL_CACHE_DEFAULT_CAPACITY];
+}
+
+- (instancetype)initWithCapacity:(NSUInteger)capacity {
+    if (self = [super init]) {
+        _capacity = MAX(capacity, 1);
+        _entries = [NSMutableDictionary dictionaryWithCapacity:_capacity];
+    }
+    return self;
+}
+
+- (NSUInteger)count {
+    return _entries.count;
+}
+
+- (double)hitRate {
+    uint64_t lookups = _hits + _misses;
+    return lookups ? (double)_hits / (double)lookups : 0;
+}
+
+- (void)removeAllEntries {
+    // Unlink from the head so a long list isn't released recursively.
+    while (_head) {
+        XRGLabelCacheEntry *next = _head->next;
+        _head->next = nil;
+        _head = next;
+    }
+    _tail = nil;
+    [_entries removeAllObjects];
+    
+    _hits = 0;
+    _misses = 0;
+}
+
+- (NSAttributedString *)attributedString:(NSString *)string attributes:(NSDictionary<NSAttributedStringKey, id> *)attributes {
+    XRGLabelCacheEntry *entry = [self entryForString:string attributes:attributes];
+    if (!entry->attributedString) {
+        entry->attributedString = [[NSAttributedString alloc] initWithString:entry->key.string attributes:entry->key.attributes];
+    }
+    return entry->attributedString;
+}
+
+- (NSSize)sizeOfString:(NSString *)string attributes:(NSDictionary<NSAttributedStringKey, id> *)attributes {
+    XRGLabelCacheEntry *entry = [self entryForString:string attributes:attributes];
+    if (!entry->hasSize) {
+        entry->size = [entry->key.string sizeWithAttributes:entry->key.attributes];
+        entry->hasSize = YES;
+    }
+    return entry->size;
+}
+
+// The entry for the key, moved to the front, or a new empty one if there wasn't one.
+- (XRGLabelCacheEntry *)entryForString:(NSString *)string attributes:(NSDictionary *)attributes {
+    XRGLabelCacheKey *key = [[XRGLabelCacheKey alloc] initWithString:string ?: @"" attributes:attributes ?: @{}];
+    XRGLabelCacheEntry *entry = _entries[key];
+    
+    if (entry) {
+        _hits++;
+        if (entry != _head) {
+            [self unlinkEntry:entry];
+            [self pushEntry:entry];
+        }
+        return entry;
+    }
+    
+    _misses++;
+    if (_entries.count >= _capacity && _tail) {
+        XRGLabelCacheEntry *oldest = _tail;
+        [self unlinkEntry:oldest];
+        [_entries removeObjectForKey:oldest->key];
+    }
+    
+    entry = [[XRGLabelCacheEntry alloc] init];
+    entry->key = [key copy];
+    _entries[entry->key] = entry;
+    [self pushEntry:entry];
+    return entry;
+}
+
+- (void)unlinkEntry:(XRGLabelCacheEntry *)entry {
+    XRGLabelCacheEntry *previous = entry->previous;
+    XRGLabelCacheEntry *next = entry->next;
+    
+    if (previous) previous->next = next;
+    else _head = next;
+    
+    if (next) next->previous = previous;
+    else _tail = previous;
+    
+    entry->previous = nil;
+    entry->next = nil;
+}
+
+- (void)pushEntry:(XRGLabelCacheEntry *)entry {
+    entry->next = _head;
+    if (_head) _head->previous = entry;
+    _head = entry;
+    if (!_tail) _tail = entry;
+}
+
+@end
@@ -0,0 +1,175 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGLatencyHistogram.c
+//
+
+#include "XRGLatencyHistogram.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#define XRG_LATENCY_SUB_BUCKET_BITS     4
+#define XRG_LATENCY_SUB_BUCKETS         (1 << XRG_LATENCY_SUB_BUCKET_BITS)
+// Values up to 2^(XRG_LATENCY_MAX_BIT + 1) - 1 ns get their own bucket.
+#define XRG_LATENCY_MAX_BIT             36
+#define XRG_LATENCY_BUCKETS             ((XRG_LATENCY_MAX_BIT - XRG_LATENCY_SUB_BUCKET_BITS + 2) * XRG_LATENCY_SUB_BUCKETS)
+
+struct XRGLatencyHistogram {
+    _Atomic uint64_t count;
+    _Atomic uint64_t sum;
+    _Atomic uint64_t max;
+    _Atomic uint32_t buckets[XRG_LATENCY_BUCKETS];
+};
+
+// MARK: - Buckets
+
+// Values under 16 are one bucket each.  Above that, a value whose top bit is b falls in the group of 16 buckets for
+// b, indexed by the 4 bits below the top bit.
+static size_t XRGLatencyBucketIndex(uint64_t value) {
+    if (value < XRG_LATENCY_SUB_BUCKETS) return (size_t)value;
+    
+    unsigned topBit = 63 - (unsigned)__builtin_clzll(value);
+    if (topBit > XRG_LATENCY_MAX_BIT) return XRG_LATENCY_BUCKETS - 1;
+    
+    unsigned shift = topBit - XRG_LATENCY_SUB_BUCKET_BITS;
+    size_t subBucket = (size_t)(value >> shift) & (XRG_LATENCY_SUB_BUCKETS - 1);
+    return (shift + 1) * XRG_LATENCY_SUB_BUCKETS + subBucket;
+}
+
+static uint64_t XRGLatencyBucketLowerBound(size_t index) {
+    if (index < XRG_LATENCY_SUB_BUCKETS) return index;
+    
+    unsigned shift = (unsigned)(index / XRG_LATENCY_SUB_BUCKETS) - 1;
+    uint64_t subBucket = index % XRG_LATENCY_SUB_BUCKETS;
+    return (XRG_LATENCY_SUB_BUCKETS + subBucket) << shift;
+}
+
+static uint64_t XRGLatencyBucketMidpoint(size_t index) {
+    if (index < XRG_LATENCY_SUB_BUCKETS) return index;
+    
+    unsigned shift = (unsigned)(index / XRG_LATENCY_SUB_BUCKETS) - 1;
+    return XRGLatencyBucketLowerBound(index) + ((1ULL << shift) >> 1);
+}
+
+// MARK: - Public
+
+XRGLatencyHistogram *XRGLatencyHistogramCreate(void) {
+    XRGLatencyHistogram *histogram = calloc(1, sizeof(XRGLatencyHistogram));
+    return histogram;
+}
+
+void XRGLatencyHistogramFree(XRGLatencyHistogram *histogram) {
+    free(histogram);
+}
+
+void XRGLatencyHistogramReset(XRGLatencyHistogram *histogram) {
+    if (!histogram) return;
+    
+    for (size_t i = 0; i < XRG_LATENCY_BUCKETS; i++) {
+        atomic_store_explicit(&histogram->buckets[i], 0, memory_order_relaxed);
+    }
+    atomic_store_explicit(&histogram->count, 0, memory_order_relaxed);
+    atomic_store_explicit(&histogram->sum, 0, memory_order_relaxed);
+    atomic_store_explicit(&histogram->max, 0, memory_order_relaxed);
+}
+
+void XRGLatencyHistogramRecord(XRGLatencyHistogram *histogram, uint64_t nanoseconds) {
+    if (!histogram) return;
+    
+    atomic_fetch_add_explicit(&histogram->buckets[XRGLatencyBucketIndex(nanoseconds)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->sum, nanoseconds, memory_order_relaxed);
+    
+    uint64_t max = atomic_load_explicit(&histogram->max, memory_order_relaxed);
+    while (nanoseconds > max && !atomic_compare_exchange_weak_explicit(&histogram->max, &max, nanoseconds, memory_order_relaxed, memory_order_relaxed)) {}
+}
+
+uint64_t XRGLatencyHistogramCount(const XRGLatencyHistogram *histogram) {
+    return histogram ? atomic_load_explicit(&histogram->count, memory_order_relaxed) : 0;
+}
+
+uint64_t XRGLatencyHistogramMax(const XRGLatencyHistogram *histogram) {
+    return histogram ? atomic_load_explicit(&histogram->max, memory_order_relaxed) : 0;
+}
+
+double XRGLatencyHistogramMean(const XRGLatencyHistogram *histogram) {
+    uint64_t count = XRGLatencyHistogramCount(histogram);
+    if (!count) return 0;
+    
+    return (double)atomic_load_explicit(&histogram->sum, memory_order_relaxed) / (double)count;
+}
+
+void XRGLatencyHistogramPercentiles(const XRGLatencyHistogram *histogram, const double *percentiles, uint64_t *results, size_t count) {
+    if (!count) return;
+    
+    // Walk a snapshot so every percentile is read from the same counts.
+    uint32_t snapshot[XRG_LATENCY_BUCKETS];
+    uint64_t total = 0;
+    for (size_t i = 0; histogram && i < XRG_LATENCY_BUCKETS; i++) {
+        snapshot[i] = atomic_load_explicit(&histogram->buckets[i], memory_order_relaxed);
+        total += snapshot[i];
+    }
+    
+    uint64_t max = XRGLatencyHistogramMax(histogram);
+    for (size_t p = 0; p < count; p++) {
+        if (!total) {
+            results[p] = 0;
+            continue;
+        }
+        if (percentiles[p] >= 100) {
+            results[p] = max;
+            continue;
+        }
+        
+        // The smallest bucket whose cumulative count reaches the percentile's rank.
+        double rankDouble = percentiles[p] / 100. * (double)total;
+        uint64_t rank = rankDouble < 1 ? 1 : (uint64_t)rankDouble + (rankDouble > (double)(uint64_t)rankDouble ? 1 : 0);
+        uint64_t seen = 0;
+        size_t i = 0;
+        for (; i < XRG_LATENCY_BUCKETS - 1; i++) {
+            seen += snapshot[i];
+            if (seen >= rank) break;
+        }
+        
+        uint64_t value = XRGLatencyBucketMidpoint(i);
+        results[p] = value < max ? value : max;
+    }
+}
+
+size_t XRGLatencyHistogramNonEmptyBuckets(const XRGLatencyHistogram *histogram, uint64_t *lowerBounds, uint64_t *counts, size_t capacity) {
+    size_t copied = 0;
+    for (size_t i = 0; histogram && i < XRG_LATENCY_BUCKETS && copied < capacity; i++) {
+        uint32_t bucketCount = atomic_load_explicit(&histogram->buckets[i], memory_order_relaxed);
+        if (!bucketCount) continue;
+        
+        lowerBounds[copied] = XRGLatencyBucketLowerBound(i);
+        counts[copied] = bucketCount;
+        copied++;
+    }
+    return copied;
+}
+
+size_t XRGLatencyHistogramBucketCount(void) {
+    return XRG_LATENCY_BUCKETS;
+}
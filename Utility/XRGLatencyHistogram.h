@@ -0,0 +1,66 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGLatencyHistogram.h
+//
+
+#ifndef XRG_LATENCY_HISTOGRAM_H
+#define XRG_LATENCY_HISTOGRAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// A log-linear latency histogram in the style of HdrHistogram.  Every power of two is split into 16 equal buckets,
+// so any recorded value lands in a bucket no wider than 1/16 (6.25%) of it, from 1 ns up to about 137 s; longer
+// values go in the last bucket.  Recording is a few shifts and one relaxed atomic add per counter, so one thread can
+// record while another reads or resets; a reader racing a writer may see the newest value in some totals but not
+// others.
+
+typedef struct XRGLatencyHistogram XRGLatencyHistogram;
+
+/// Returns NULL if the allocation fails.
+XRGLatencyHistogram *XRGLatencyHistogramCreate(void);
+void XRGLatencyHistogramFree(XRGLatencyHistogram *histogram);
+void XRGLatencyHistogramReset(XRGLatencyHistogram *histogram);
+
+void XRGLatencyHistogramRecord(XRGLatencyHistogram *histogram, uint64_t nanoseconds);
+
+uint64_t XRGLatencyHistogramCount(const XRGLatencyHistogram *histogram);
+uint64_t XRGLatencyHistogramMax(const XRGLatencyHistogram *histogram);
+/// Exact, from the running sum rather than the buckets.  0 if nothing has been recorded.
+double XRGLatencyHistogramMean(const XRGLatencyHistogram *histogram);
+
+/// The value at each of count percentiles (0 to 100, e.g. 99.9), as the midpoint of the bucket it falls in.  A
+/// percentile of 100 is the exact max.  Every result is 0 if nothing has been recorded.
+void XRGLatencyHistogramPercentiles(const XRGLatencyHistogram *histogram, const double *percentiles, uint64_t *results, size_t count);
+
+/*! Copies out the buckets that have anything in them, lowest first.
+ @param lowerBounds Smallest value, in nanoseconds, that each bucket holds.
+ @return The number of buckets copied, at most capacity.
+ */
+size_t XRGLatencyHistogramNonEmptyBuckets(const XRGLatencyHistogram *histogram, uint64_t *lowerBounds, uint64_t *counts, size_t capacity);
+
+/// The most buckets XRGLatencyHistogramNonEmptyBuckets can return.
+size_t XRGLatencyHistogramBucketCount(void);
+
+#endif
@@ -60,6 +60,8 @@
 - (void)min30Update;
 - (void)min5Update;
 - (void)graphUpdate;
+- (BOOL)graphUpdateWithSpan:(NSUInteger)span;   // span: graph intervals since the last graph update.  NO if the tick was dropped.
+- (NSUInteger)graphGeneration;                  // changes when a displayed graph does; NSNotFound if one can't tell
 - (void)fastUpdate;
 
 - (float) resizeModuleNumber:(int)index byDelta:(float)delta;
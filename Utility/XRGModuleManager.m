@@ -26,6 +26,9 @@
 
 #import "XRGModuleManager.h"
 #import "XRGGraphWindow.h"
+#import "XRGSampler.h"
+#import "XRGDiagnostics.h"
+#import "XRGLabelCache.h"
 
 @implementation XRGModuleManager
 
@@ -470,6 +473,8 @@
 }
 
 - (void)graphFontChanged {
+    [[XRGLabelCache shared] removeAllEntries];
+    
     // go through the displayed modules and reset the min size.
     NSInteger i, n = [displayModules count];
     
@@ -498,6 +503,7 @@
     for (i = 0; i < N; i++) {
         module = displayModules[i];
         if ([module doesMin30Update] && [module reference] != nil) {
+            XRG_DIAGNOSTICS_SCOPE(XRGDiagnosticsModuleForObject([module reference]), XRGDiagnosticsPhaseMin30);
             [[module reference] min30Update:nil];
         }
     }
@@ -512,44 +518,60 @@
     for (i = 0; i < N; i++) {
         module = displayModules[i];
         if ([module doesMin5Update] && [module reference] != nil) {
+            XRG_DIAGNOSTICS_SCOPE(XRGDiagnosticsModuleForObject([module reference]), XRGDiagnosticsPhaseMin5);
             [[module reference] min5Update:nil];
         }
     }
 }
 
 - (void)graphUpdate {
+    [self graphUpdateWithSpan:1];
+}
+
+- (BOOL)graphUpdateWithSpan:(NSUInteger)span {
 //    NSLog(@"graph");
 
-    NSInteger i;
-    NSInteger N = [displayModules count];
-    id obj;
-    for (i = 0; i < N; i++) {
-        obj = displayModules[i];
-        if ([obj doesGraphUpdate] && [obj reference] != nil) {
-            [[obj reference] graphUpdate:nil];
+    NSMutableArray<XRGGenericView *> *views = [NSMutableArray arrayWithCapacity:[displayModules count] + [alwaysUpdateModules count]];
+    for (XRGModule *module in displayModules) {
+        if ([module doesGraphUpdate] && [module reference] != nil) {
+            [views addObject:[module reference]];
         }
     }
     
-    for (i = 0; i < [alwaysUpdateModules count]; i++) {
-        obj = alwaysUpdateModules[i];
-        if (![obj isDisplayed] && [obj reference] != nil) {
-            [[obj reference] graphUpdate:nil];
+    for (XRGModule *module in alwaysUpdateModules) {
+        if (![module isDisplayed] && [module reference] != nil) {
+            [views addObject:[module reference]];
         }
     }
+    
+    return [[XRGSampler shared] sample:XRGSampleKindGraph views:views span:span];
+}
+
+- (NSUInteger)graphGeneration {
+    // The sum changes whenever one of the generations does, since each only ever increases.
+    NSUInteger generation = 0;
+    for (XRGModule *module in displayModules) {
+        if (![module doesGraphUpdate] || [module reference] == nil) continue;
+        
+        NSUInteger viewGeneration = [[module reference] graphGeneration];
+        if (viewGeneration == NSNotFound) return NSNotFound;
+        generation += viewGeneration;
+    }
+    
+    return generation;
 }
 
 - (void)fastUpdate {
     //NSLog(@"fast");
     
-    NSInteger i;
-    NSInteger N = [displayModules count];
-    id obj;
-    for (i = 0; i < N; i++) {
-        obj = displayModules[i];
-        if ([obj doesFastUpdate] && [obj reference] != nil) {
-            [[obj reference] fastUpdate:nil];
+    NSMutableArray<XRGGenericView *> *views = [NSMutableArray arrayWithCapacity:[displayModules count]];
+    for (XRGModule *module in displayModules) {
+        if ([module doesFastUpdate] && [module reference] != nil) {
+            [views addObject:[module reference]];
         }
     }
+    
+    [[XRGSampler shared] sample:XRGSampleKindFast views:views];
 }
 
 - (float) resizeModuleNumber:(int)index byDelta:(float)delta {	
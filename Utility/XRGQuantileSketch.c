@@ -0,0 +1,265 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGQuantileSketch.c
+//
+
+#include "XRGQuantileSketch.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// 2^64 values at the top level's weight is more than any session will see.
+#define XRG_QUANTILE_MAX_LEVELS 64
+
+typedef struct {
+    double   *items;
+    uint32_t count;
+    uint32_t allocated;
+} XRGQuantileLevel;
+
+struct XRGQuantileSketch {
+    uint32_t         k;
+    uint32_t         numLevels;
+    uint64_t         count;
+    uint64_t         random;        // xorshift state for picking which half of a level to promote.
+    double           min;
+    double           max;
+    uint32_t         capacities[XRG_QUANTILE_MAX_LEVELS];   // Per level, recomputed when numLevels changes.
+    XRGQuantileLevel levels[XRG_QUANTILE_MAX_LEVELS];
+};
+
+typedef struct {
+    double   value;
+    uint64_t weight;
+} XRGWeightedValue;
+
+static int XRGCompareDoubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static int XRGCompareWeightedValues(const void *a, const void *b) {
+    double x = ((const XRGWeightedValue *)a)->value, y = ((const XRGWeightedValue *)b)->value;
+    return (x > y) - (x < y);
+}
+
+static uint64_t XRGQuantileRandomBit(XRGQuantileSketch *sketch) {
+    uint64_t x = sketch->random;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    sketch->random = x;
+    return x & 1;
+}
+
+// The top level holds k values and each level below it holds 2/3 as many, with a floor of 2.  Once the sketch is
+// deep, level 0 compacts every other insert, so the capacities are worked out here once per new level rather than on
+// every compaction.
+static void XRGQuantileSetLevelCount(XRGQuantileSketch *sketch, uint32_t numLevels) {
+    sketch->numLevels = numLevels;
+    
+    double capacity = sketch->k;
+    for (uint32_t h = numLevels; h > 0; h--) {
+        uint32_t rounded = (uint32_t)(capacity + 0.999);
+        sketch->capacities[h - 1] = rounded < 2 ? 2 : rounded;
+        if (capacity > 2) capacity *= 2. / 3.;
+    }
+}
+
+static uint32_t XRGQuantileLevelCapacity(const XRGQuantileSketch *sketch, uint32_t level) {
+    return sketch->capacities[level];
+}
+
+static int XRGQuantileLevelAppend(XRGQuantileLevel *level, double value) {
+    if (level->count == level->allocated) {
+        uint32_t newAllocated = level->allocated ? level->allocated * 2 : 8;
+        double *newItems = realloc(level->items, newAllocated * sizeof(double));
+        if (!newItems) return 0;
+        level->items = newItems;
+        level->allocated = newAllocated;
+    }
+    
+    level->items[level->count++] = value;
+    return 1;
+}
+
+// Compact every level that is at or over its capacity, lowest first, so promotions can cascade upward.
+static void XRGQuantileSketchCompress(XRGQuantileSketch *sketch) {
+    for (uint32_t h = 0; h < sketch->numLevels; h++) {
+        XRGQuantileLevel *level = &sketch->levels[h];
+        if (level->count < XRGQuantileLevelCapacity(sketch, h)) continue;
+        
+        if (h + 1 == sketch->numLevels) {
+            if (sketch->numLevels == XRG_QUANTILE_MAX_LEVELS) return;
+            XRGQuantileSetLevelCount(sketch, sketch->numLevels + 1);
+        }
+        
+        qsort(level->items, level->count, sizeof(double), XRGCompareDoubles);
+        
+        // With an odd count, the smallest value stays behind so the total weight is unchanged.
+        uint32_t start = level->count & 1;
+        uint32_t offset = (uint32_t)XRGQuantileRandomBit(sketch);
+        XRGQuantileLevel *next = &sketch->levels[h + 1];
+        for (uint32_t i = start + offset; i < level->count; i += 2) {
+            if (!XRGQuantileLevelAppend(next, level->items[i])) break;
+        }
+        level->count = start;
+    }
+}
+
+XRGQuantileSketch *XRGQuantileSketchCreate(uint32_t k) {
+    if (k < 8) return NULL;
+    
+    XRGQuantileSketch *sketch = calloc(1, sizeof(XRGQuantileSketch));
+    if (!sketch) return NULL;
+    
+    sketch->k = k;
+    XRGQuantileSketchReset(sketch);
+    
+    return sketch;
+}
+
+void XRGQuantileSketchFree(XRGQuantileSketch *sketch) {
+    if (!sketch) return;
+    
+    for (uint32_t h = 0; h < XRG_QUANTILE_MAX_LEVELS; h++) {
+        free(sketch->levels[h].items);
+    }
+    free(sketch);
+}
+
+void XRGQuantileSketchReset(XRGQuantileSketch *sketch) {
+    if (!sketch) return;
+    
+    for (uint32_t h = 0; h < XRG_QUANTILE_MAX_LEVELS; h++) {
+        sketch->levels[h].count = 0;
+    }
+    XRGQuantileSetLevelCount(sketch, 1);
+    sketch->count = 0;
+    sketch->random = 0x9E3779B97F4A7C15ULL;
+    sketch->min = 0;
+    sketch->max = 0;
+}
+
+void XRGQuantileSketchInsert(XRGQuantileSketch *sketch, double value) {
+    if (!sketch) return;
+    
+    if (!XRGQuantileLevelAppend(&sketch->levels[0], value)) return;
+    
+    if (sketch->count == 0 || value < sketch->min) sketch->min = value;
+    if (sketch->count == 0 || value > sketch->max) sketch->max = value;
+    sketch->count++;
+    
+    if (sketch->levels[0].count >= XRGQuantileLevelCapacity(sketch, 0)) {
+        XRGQuantileSketchCompress(sketch);
+    }
+}
+
+void XRGQuantileSketchMerge(XRGQuantileSketch *destination, const XRGQuantileSketch *source) {
+    if (!destination || !source || source->count == 0) return;
+    
+    if (source->numLevels > destination->numLevels) XRGQuantileSetLevelCount(destination, source->numLevels);
+    
+    for (uint32_t h = 0; h < source->numLevels; h++) {
+        const XRGQuantileLevel *level = &source->levels[h];
+        for (uint32_t i = 0; i < level->count; i++) {
+            XRGQuantileLevelAppend(&destination->levels[h], level->items[i]);
+        }
+    }
+    
+    if (destination->count == 0 || source->min < destination->min) destination->min = source->min;
+    if (destination->count == 0 || source->max > destination->max) destination->max = source->max;
+    destination->count += source->count;
+    
+    // Merged levels can be up to twice their capacity, so one pass may leave the next level full.
+    XRGQuantileSketchCompress(destination);
+    XRGQuantileSketchCompress(destination);
+}
+
+uint64_t XRGQuantileSketchCount(const XRGQuantileSketch *sketch) {
+    return sketch ? sketch->count : 0;
+}
+
+void XRGQuantileSketchQuantiles(const XRGQuantileSketch *sketch, const double *quantiles, double *results, size_t count) {
+    if (count == 0) return;
+    if (!sketch || sketch->count == 0) {
+        memset(results, 0, count * sizeof(double));
+        return;
+    }
+    
+    size_t numItems = 0;
+    for (uint32_t h = 0; h < sketch->numLevels; h++) {
+        numItems += sketch->levels[h].count;
+    }
+    
+    XRGWeightedValue *items = malloc(numItems * sizeof(XRGWeightedValue));
+    if (!items) {
+        memset(results, 0, count * sizeof(double));
+        return;
+    }
+    
+    size_t n = 0;
+    uint64_t totalWeight = 0;
+    for (uint32_t h = 0; h < sketch->numLevels; h++) {
+        const XRGQuantileLevel *level = &sketch->levels[h];
+        for (uint32_t i = 0; i < level->count; i++) {
+            items[n].value = level->items[i];
+            items[n].weight = (uint64_t)1 << h;
+            totalWeight += items[n].weight;
+            n++;
+        }
+    }
+    qsort(items, n, sizeof(XRGWeightedValue), XRGCompareWeightedValues);
+    
+    for (size_t q = 0; q < count; q++) {
+        double quantile = quantiles[q];
+        if (quantile <= 0) {
+            results[q] = sketch->min;
+            continue;
+        }
+        if (quantile >= 1) {
+            results[q] = sketch->max;
+            continue;
+        }
+        
+        double targetWeight = quantile * (double)totalWeight;
+        uint64_t cumulativeWeight = 0;
+        results[q] = items[n - 1].value;
+        for (size_t i = 0; i < n; i++) {
+            cumulativeWeight += items[i].weight;
+            if ((double)cumulativeWeight >= targetWeight) {
+                results[q] = items[i].value;
+                break;
+            }
+        }
+    }
+    
+    free(items);
+}
+
+double XRGQuantileSketchQuantile(const XRGQuantileSketch *sketch, double quantile) {
+    double result;
+    XRGQuantileSketchQuantiles(sketch, &quantile, &result, 1);
+    return result;
+}
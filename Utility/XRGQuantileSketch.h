@@ -0,0 +1,63 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGQuantileSketch.h
+//
+
+#ifndef XRG_QUANTILE_SKETCH_H
+#define XRG_QUANTILE_SKETCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// A KLL streaming quantile sketch (Karnin, Lang and Liberty).  Values go into level 0; when a level fills up it is
+// sorted and every other value is promoted to the next level at twice the weight.  Level capacities shrink by 2/3
+// going down from the top, so the sketch holds about 3k values no matter how many it has seen, inserts are O(1)
+// amortized, and two sketches merge by concatenating their levels and compacting.  Rank error is roughly 1.7/k.
+
+typedef struct XRGQuantileSketch XRGQuantileSketch;
+
+/// A k of 200 keeps about 600 values (under 5KB) for a rank error around 1%.
+#define XRG_QUANTILE_DEFAULT_ACCURACY 200
+
+/// Returns NULL if k is less than 8 or the allocation fails.
+XRGQuantileSketch *XRGQuantileSketchCreate(uint32_t k);
+void XRGQuantileSketchFree(XRGQuantileSketch *sketch);
+void XRGQuantileSketchReset(XRGQuantileSketch *sketch);
+
+void XRGQuantileSketchInsert(XRGQuantileSketch *sketch, double value);
+
+/// Adds everything source has seen to destination.  source is not changed.
+void XRGQuantileSketchMerge(XRGQuantileSketch *destination, const XRGQuantileSketch *source);
+
+/// Number of values inserted, including those merged in.
+uint64_t XRGQuantileSketchCount(const XRGQuantileSketch *sketch);
+
+/// Estimates the value at each of count quantiles (0 to 1, e.g. 0.95) with one sort.  Quantiles of 0 and 1 are the
+/// exact min and max.  Every result is 0 if the sketch is empty.
+void XRGQuantileSketchQuantiles(const XRGQuantileSketch *sketch, const double *quantiles, double *results, size_t count);
+
+/// A single quantile; use XRGQuantileSketchQuantiles for several.
+double XRGQuantileSketchQuantile(const XRGQuantileSketch *sketch, double quantile);
+
+#endif
@@ -0,0 +1,119 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGSampler.h
+//
+
+#import <Foundation/Foundation.h>
+#import "XRGStatsManager.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef NS_ENUM(NSInteger, XRGSampleKind) {
+    XRGSampleKindGraph,
+    XRGSampleKindFast
+};
+
+/// Adopted by graph views whose data comes from system calls that can block: host_processor_info, sysctl, IOKit
+/// registry walks, getfsstat, SMC reads.  Collection runs on the module's sampler queue and returns an immutable
+/// snapshot; the main thread only applies the snapshot to the view's data and marks the view for display.
+@protocol XRGSampledView <NSObject>
+
+/// The module this view samples for.  Each module collects on its own serial queue, so different modules collect
+/// concurrently while one module's collections never overlap each other.
+- (XRGStatsModule)samplingModule;
+
+/// Called on the module's sampler queue.  Reads the system and returns what it read, without touching anything the
+/// main thread reads or writes.  Returns nil if there is nothing new this tick.
+- (nullable id)collectGraphSample;
+
+/// Called on the main thread with the result of collectGraphSample.
+- (void)applyGraphSample:(nullable id)sample;
+
+@optional
+/// Called instead of applyGraphSample: if implemented.  span is the number of graph intervals the sample covers, more
+/// than 1 when adaptive sampling has stretched the tick; the view fills that many slots so its history keeps its
+/// time scale.
+- (void)applyGraphSample:(nullable id)sample span:(NSUInteger)span;
+
+/// The same, for the fast (mini graph) timer.
+- (nullable id)collectFastSample;
+- (void)applyFastSample:(nullable id)sample;
+
+/// Asked on the main thread before each fast tick.  A view that answers NO is skipped for that tick.
+- (BOOL)wantsFastSample;
+
+@end
+
+
+/// Runs a tick's collection off the main thread.  Every module's collection starts at once on that module's queue, and
+/// the tick waits at a barrier for all of them before applying the snapshots together in one main thread pass, so
+/// the views always publish a coherent tick.  Views that don't adopt XRGSampledView get their graphUpdate: or
+/// fastUpdate: in that same pass.
+///
+/// The barrier gives up after the tick's budget.  A module that misses it is applied with the next tick that
+/// finds its snapshot ready, isn't collected again until the late collection finishes, and then backs off for 1, 3,
+/// 7 and finally 15 ticks while it keeps overrunning.  One collection finishing within budget clears the backoff.
+///
+/// The main thread time spent on each tick, every module's collection time and the rate ticks arrive at are recorded in XRGStatsManager under
+/// XRGStatsModuleNameSampler, so they can be compared with synchronousSampling turned on, which collects every
+/// module one after another on the main thread as XRG used to.
+@interface XRGSampler : NSObject
+
+@property (class, readonly) XRGSampler *shared;
+
+/// Read from the XRG_synchronousSampling default at launch.  Not in the preferences window.
+@property (readonly) BOOL synchronous;
+
+/// How long a tick waits for its slowest module, in seconds.  0 waits for every module however long it takes.
+/// Whoever owns the timers keeps these at a fraction of the timer interval.
+@property NSTimeInterval graphBudget;
+@property NSTimeInterval fastBudget;
+
+/// Ticks dropped because the previous tick of the same kind was still waiting at its barrier.
+@property (readonly) NSUInteger skippedGraphTicks;
+@property (readonly) NSUInteger skippedFastTicks;
+
+/// Module collections that missed their tick's budget.
+@property (readonly) NSUInteger lateGraphSamples;
+@property (readonly) NSUInteger lateFastSamples;
+
+/*! Collects from every view that adopts XRGSampledView for this kind of tick, then, on the main thread, applies the
+ snapshots and sends graphUpdate: or fastUpdate: to the rest.  Must be called on the main thread.
+ @return NO, without doing anything, if the previous tick of this kind hasn't been applied yet.
+ */
+- (BOOL)sample:(XRGSampleKind)kind views:(NSArray *)views;
+
+/// The same, for a graph tick that covers span graph intervals.
+- (BOOL)sample:(XRGSampleKind)kind views:(NSArray *)views span:(NSUInteger)span;
+
+/// Runs a collection block on a module's queue and waits for its result.  For the occasional update outside a tick,
+/// such as after a preference change, so it can't race that module's collection.
+- (nullable id)collectSynchronouslyForModule:(XRGStatsModule)module block:(id _Nullable (^)(void))block;
+
+/// Runs a block on a module's queue between its collections, e.g. to replace state that collection reads.
+- (void)performForModule:(XRGStatsModule)module block:(dispatch_block_t)block;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,340 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGSampler.m
+//
+
+#import "XRGSampler.h"
+#import "XRGStatsManager.h"
+#import "XRGDiagnostics.h"
+#import "XRGGenericView.h"
+#import "definitions.h"
+
+#include <time.h>
+
+#define XRG_SAMPLER_MODULE_COUNT (XRGStatsModuleNameSampler + 1)
+#define XRG_SAMPLER_MAX_BACKOFF_SHIFT 4
+
+/// One module's collection for one kind of tick.  Everything but the queue is only touched on the main thread.
+@interface XRGSamplerChannel : NSObject
+
+@property (readonly) dispatch_queue_t queue;
+@property (readonly) XRGStatHandle collectHandle;
+
+@property BOOL inFlight;
+@property NSUInteger startedTick;
+
+/// The snapshot waiting to be applied, NSNull if the collection returned nil, nil if nothing is waiting.
+@property (nullable) id pending;
+
+@property NSUInteger overruns;
+@property NSUInteger backoffTicks;
+
+- (instancetype)initWithQueue:(dispatch_queue_t)queue collectHandle:(XRGStatHandle)collectHandle;
+
+/// Counts one more overrun in a row and sets how many ticks to sit out once the late collection is in.
+- (void)noteOverrun;
+
+@end
+
+@implementation XRGSamplerChannel
+
+- (instancetype)initWithQueue:(dispatch_queue_t)queue collectHandle:(XRGStatHandle)collectHandle {
+    self = [super init];
+    if (self) {
+        _queue = queue;
+        _collectHandle = collectHandle;
+    }
+    return self;
+}
+
+- (void)noteOverrun {
+    self.overruns++;
+    self.backoffTicks = (1 << MIN(self.overruns - 1, XRG_SAMPLER_MAX_BACKOFF_SHIFT)) - 1;
+}
+
+@end
+
+
+@interface XRGSampler ()
+
+@property (readonly) NSArray<dispatch_queue_t> *moduleQueues;
+@property (readonly) NSArray<XRGSamplerChannel *> *graphChannels;
+@property (readonly) NSArray<XRGSamplerChannel *> *fastChannels;
+
+// Only touched on the main thread.
+@property BOOL graphInFlight;
+@property BOOL fastInFlight;
+@property NSUInteger tickCount;
+@property NSUInteger skippedGraphTicks;
+@property NSUInteger skippedFastTicks;
+@property NSUInteger lateGraphSamples;
+@property NSUInteger lateFastSamples;
+
+@property XRGStatHandle graphMainHandle;
+@property XRGStatHandle graphCollectHandle;
+@property XRGStatHandle fastMainHandle;
+@property XRGStatHandle fastCollectHandle;
+@property XRGStatHandle graphRateHandle;
+@property XRGStatHandle fastRateHandle;
+@property uint64_t lastGraphTick;
+@property uint64_t lastFastTick;
+
+@end
+
+@implementation XRGSampler
+
++ (XRGSampler *)shared {
+    static XRGSampler *sharedSampler = nil;
+
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedSampler = [[XRGSampler alloc] init];
+    });
+
+    return sharedSampler;
+}
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _synchronous = [[NSUserDefaults standardUserDefaults] boolForKey:XRG_synchronousSampling];
+        _graphBudget = 0.5;
+        _fastBudget = 0.0625;
+
+        XRGStatsManager *statsManager = [XRGStatsManager shared];
+        self.graphMainHandle = [statsManager handleForKey:@"Graph Tick Main Thread (ms)" inModule:XRGStatsModuleNameSampler];
+        self.graphCollectHandle = [statsManager handleForKey:@"Graph Tick Collect (ms)" inModule:XRGStatsModuleNameSampler];
+        self.fastMainHandle = [statsManager handleForKey:@"Fast Tick Main Thread (ms)" inModule:XRGStatsModuleNameSampler];
+        self.fastCollectHandle = [statsManager handleForKey:@"Fast Tick Collect (ms)" inModule:XRGStatsModuleNameSampler];
+        self.graphRateHandle = [statsManager handleForKey:@"Graph Sampling Rate (Hz)" inModule:XRGStatsModuleNameSampler];
+        self.fastRateHandle = [statsManager handleForKey:@"Fast Sampling Rate (Hz)" inModule:XRGStatsModuleNameSampler];
+        
+        // Serial per module, all feeding the utility QoS global queue, so modules run side by side.
+        dispatch_queue_attr_t attr = dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, QOS_CLASS_UTILITY, 0);
+        NSMutableArray *queues = [NSMutableArray arrayWithCapacity:XRG_SAMPLER_MODULE_COUNT];
+        NSMutableArray *graphChannels = [NSMutableArray arrayWithCapacity:XRG_SAMPLER_MODULE_COUNT];
+        NSMutableArray *fastChannels = [NSMutableArray arrayWithCapacity:XRG_SAMPLER_MODULE_COUNT];
+        for (XRGStatsModule module = 0; module < XRG_SAMPLER_MODULE_COUNT; module++) {
+            NSString *name = [XRGStatsManager nameForModule:module];
+            NSString *label = [@"com.gauchosoft.XRG.sampler." stringByAppendingString:name.lowercaseString];
+            dispatch_queue_t queue = dispatch_queue_create(label.UTF8String, attr);
+            [queues addObject:queue];
+            
+            XRGStatHandle graphHandle = [statsManager handleForKey:[name stringByAppendingString:@" Graph Collect (ms)"] inModule:XRGStatsModuleNameSampler];
+            XRGStatHandle fastHandle = [statsManager handleForKey:[name stringByAppendingString:@" Fast Collect (ms)"] inModule:XRGStatsModuleNameSampler];
+            [graphChannels addObject:[[XRGSamplerChannel alloc] initWithQueue:queue collectHandle:graphHandle]];
+            [fastChannels addObject:[[XRGSamplerChannel alloc] initWithQueue:queue collectHandle:fastHandle]];
+        }
+        _moduleQueues = queues;
+        _graphChannels = graphChannels;
+        _fastChannels = fastChannels;
+    }
+    return self;
+}
+
+static double XRGSamplerMilliseconds(uint64_t start) {
+    return (double)(clock_gettime_nsec_np(CLOCK_UPTIME_RAW) - start) / 1e6;
+}
+
+static void XRGSamplerApplyGraphSample(id<XRGSampledView> view, id sample, NSUInteger span) {
+    if ([view respondsToSelector:@selector(applyGraphSample:span:)]) {
+        [view applyGraphSample:sample span:span];
+    }
+    else {
+        [view applyGraphSample:sample];
+    }
+}
+
+- (dispatch_queue_t)queueForModule:(XRGStatsModule)module {
+    if (module < 0 || module >= XRG_SAMPLER_MODULE_COUNT) module = XRGStatsModuleNameSampler;
+    return self.moduleQueues[module];
+}
+
+- (BOOL)sample:(XRGSampleKind)kind views:(NSArray *)views {
+    return [self sample:kind views:views span:1];
+}
+
+- (BOOL)sample:(XRGSampleKind)kind views:(NSArray *)views span:(NSUInteger)span {
+    BOOL isGraph = kind == XRGSampleKindGraph;
+    if (!isGraph || span < 1) span = 1;
+    
+    if (isGraph ? self.graphInFlight : self.fastInFlight) {
+        if (isGraph) self.skippedGraphTicks++;
+        else         self.skippedFastTicks++;
+        return NO;
+    }
+    
+    // Ticks per second actually being taken, which adaptive sampling moves around.
+    uint64_t now = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+    uint64_t lastTick = isGraph ? self.lastGraphTick : self.lastFastTick;
+    if (lastTick && now > lastTick) {
+        [[XRGStatsManager shared] observeStat:1e9 / (double)(now - lastTick) forHandle:isGraph ? self.graphRateHandle : self.fastRateHandle];
+    }
+    if (isGraph) self.lastGraphTick = now;
+    else         self.lastFastTick = now;
+    
+    SEL collectSelector = isGraph ? @selector(collectGraphSample) : @selector(collectFastSample);
+    NSMutableArray<id<XRGSampledView>> *sampledViews = [NSMutableArray arrayWithCapacity:views.count];
+    NSMutableArray<XRGGenericView *> *otherViews = [NSMutableArray arrayWithCapacity:views.count];
+    for (id view in views) {
+        if ([view conformsToProtocol:@protocol(XRGSampledView)] && [view respondsToSelector:collectSelector]) {
+            if (!isGraph && [view respondsToSelector:@selector(wantsFastSample)] && ![view wantsFastSample]) continue;
+            [sampledViews addObject:view];
+        }
+        else {
+            [otherViews addObject:view];
+        }
+    }
+    
+    XRGStatHandle mainHandle = isGraph ? self.graphMainHandle : self.fastMainHandle;
+    XRGStatHandle collectHandle = isGraph ? self.graphCollectHandle : self.fastCollectHandle;
+    XRGDiagnosticsPhase phase = isGraph ? XRGDiagnosticsPhaseGraph : XRGDiagnosticsPhaseFast;
+    
+    void (^updateOtherViews)(void) = ^{
+        for (XRGGenericView *view in otherViews) {
+            XRG_DIAGNOSTICS_SCOPE(XRGDiagnosticsModuleForObject(view), phase);
+            if (isGraph) [view graphUpdate:nil];
+            else         [view fastUpdate:nil];
+        }
+    };
+    
+    // Collecting here is the old behavior, so the main thread time includes the collection.
+    if (self.synchronous || sampledViews.count == 0) {
+        uint64_t start = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+        for (id<XRGSampledView> view in sampledViews) {
+            XRG_DIAGNOSTICS_SCOPE([view samplingModule], phase);
+            if (isGraph) XRGSamplerApplyGraphSample(view, [view collectGraphSample], span);
+            else         [view applyFastSample:[view collectFastSample]];
+        }
+        updateOtherViews();
+        [[XRGStatsManager shared] observeStat:XRGSamplerMilliseconds(start) forHandle:mainHandle];
+        return YES;
+    }
+    
+    if (isGraph) self.graphInFlight = YES;
+    else         self.fastInFlight = YES;
+    
+    NSUInteger tick = ++self.tickCount;
+    uint64_t tickStart = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+    dispatch_group_t barrier = dispatch_group_create();
+    NSArray<XRGSamplerChannel *> *allChannels = isGraph ? self.graphChannels : self.fastChannels;
+    NSMutableArray<XRGSamplerChannel *> *channels = [NSMutableArray arrayWithCapacity:sampledViews.count];
+    
+    for (id<XRGSampledView> view in sampledViews) {
+        XRGStatsModule module = [view samplingModule];
+        if (module < 0 || module >= XRG_SAMPLER_MODULE_COUNT) module = XRGStatsModuleNameSampler;
+        XRGSamplerChannel *channel = allChannels[module];
+        [channels addObject:channel];
+        
+        // Still working on an earlier tick, or backing off after overrunning.  Whatever it has ready is applied below.
+        if (channel.inFlight) continue;
+        if (channel.backoffTicks > 0) {
+            channel.backoffTicks--;
+            continue;
+        }
+        
+        channel.inFlight = YES;
+        channel.startedTick = tick;
+        dispatch_group_enter(barrier);
+        dispatch_async(channel.queue, ^{
+            uint64_t start = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+            id sample = isGraph ? [view collectGraphSample] : [view collectFastSample];
+            [[XRGStatsManager shared] observeStat:XRGSamplerMilliseconds(start) forHandle:channel.collectHandle];
+            [[XRGDiagnostics shared] recordDuration:clock_gettime_nsec_np(CLOCK_UPTIME_RAW) - start module:module phase:XRGDiagnosticsPhaseCollect];
+            
+            dispatch_async(dispatch_get_main_queue(), ^{
+                channel.pending = sample ?: [NSNull null];
+                channel.inFlight = NO;
+                dispatch_group_leave(barrier);
+            });
+        });
+    }
+    
+    // Runs once, on the main queue, when either every collection is in or the budget runs out.
+    __block BOOL published = NO;
+    dispatch_block_t publish = ^{
+        if (published) return;
+        published = YES;
+        
+        uint64_t start = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+        [[XRGStatsManager shared] observeStat:XRGSamplerMilliseconds(tickStart) forHandle:collectHandle];
+        
+        for (NSUInteger i = 0; i < sampledViews.count; i++) {
+            XRGSamplerChannel *channel = channels[i];
+            if (channel.startedTick == tick) {
+                if (channel.inFlight) {
+                    [channel noteOverrun];
+                    if (isGraph) self.lateGraphSamples++;
+                    else         self.lateFastSamples++;
+                }
+                else {
+                    channel.overruns = 0;
+                }
+            }
+            
+            id sample = channel.pending;
+            if (!sample) continue;
+            channel.pending = nil;
+            if (sample == [NSNull null]) sample = nil;
+            
+            XRG_DIAGNOSTICS_SCOPE([sampledViews[i] samplingModule], phase);
+            if (isGraph) XRGSamplerApplyGraphSample(sampledViews[i], sample, span);
+            else         [sampledViews[i] applyFastSample:sample];
+        }
+        updateOtherViews();
+        [[XRGStatsManager shared] observeStat:XRGSamplerMilliseconds(start) forHandle:mainHandle];
+        
+        if (isGraph) self.graphInFlight = NO;
+        else         self.fastInFlight = NO;
+    };
+    
+    dispatch_group_notify(barrier, dispatch_get_main_queue(), publish);
+    NSTimeInterval budget = isGraph ? self.graphBudget : self.fastBudget;
+    if (budget > 0) {
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(budget * NSEC_PER_SEC)), dispatch_get_main_queue(), publish);
+    }
+    
+    return YES;
+}
+
+- (id)collectSynchronouslyForModule:(XRGStatsModule)module block:(id (^)(void))block {
+    if (self.synchronous) return block();
+    
+    __block id result = nil;
+    dispatch_sync([self queueForModule:module], ^{
+        result = block();
+    });
+    return result;
+}
+
+- (void)performForModule:(XRGStatsModule)module block:(dispatch_block_t)block {
+    if (self.synchronous) {
+        block();
+    }
+    else {
+        dispatch_async([self queueForModule:module], block);
+    }
+}
+
+@end
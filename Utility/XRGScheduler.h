@@ -0,0 +1,88 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGScheduler.h
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class XRGScheduler;
+
+/// A periodic task driven by XRGScheduler.  Everything here is main thread only.
+@interface XRGScheduledTask : NSObject
+
+@property (readonly) NSString *name;
+
+/// Seconds between fires.  Setting it keeps the task aligned to the scheduler's clock: the next fire is the next
+/// multiple of the new interval, not the interval from now.
+@property (nonatomic) NSTimeInterval interval;
+
+/// How late the system may run the task to coalesce it with other wakeups.  Defaults to 10% of the interval, and
+/// follows the interval when it changes until it's set explicitly.
+@property (nonatomic) NSTimeInterval tolerance;
+
+/// nil once the task has been invalidated, and while it's paused.
+@property (readonly, nullable) NSDate *nextFireDate;
+
+/// How late, in seconds, the last fire ran after its deadline.
+@property (readonly) NSTimeInterval lastOverrun;
+
+/// Deadlines passed over entirely, e.g. while the main thread was blocked.  Missed fires aren't made up.
+@property (readonly) NSUInteger missedFires;
+
+@property (readonly, getter=isValid) BOOL valid;
+
+/// A paused task keeps its place in the scheduler but doesn't fire or wake the process.  Resuming fires it at the
+/// next multiple of its interval.
+@property (nonatomic, getter=isPaused) BOOL paused;
+
+- (void)invalidate;
+
+@end
+
+
+/// Drives every periodic task in XRG from one dispatch timer source on the main queue.  All deadlines are multiples
+/// of their task's interval from a common origin, so a task never drifts by the time its handler takes, and tasks
+/// whose intervals divide each other (the 0.125 s fast tick and a whole second graph tick) come due on the same
+/// wakeup.  The source is armed one shot at a time for the earliest deadline, with that task's tolerance as leeway.
+@interface XRGScheduler : NSObject
+
+@property (class, readonly) XRGScheduler *shared;
+
+/// Live tasks, in the order they were scheduled.
+@property (readonly) NSArray<XRGScheduledTask *> *tasks;
+
+/// How many times the timer source has fired.
+@property (readonly) NSUInteger wakeups;
+
+/*! Starts a repeating task on the main thread.  The first fire is the first multiple of interval on the scheduler's
+ clock, so it can come sooner than interval from now.  The scheduler keeps the block until the task is invalidated.
+ @param name Shown in the sensor window's export.
+ */
+- (XRGScheduledTask *)scheduleTaskNamed:(NSString *)name interval:(NSTimeInterval)interval block:(dispatch_block_t)block;
+
+@end
+
+NS_ASSUME_NONNULL_END
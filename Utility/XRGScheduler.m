@@ -0,0 +1,230 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGScheduler.m
+//
+
+#import "XRGScheduler.h"
+#import "XRGStatsManager.h"
+
+#include <time.h>
+
+static uint64_t XRGSchedulerNow(void) {
+    return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+}
+
+static uint64_t XRGSchedulerNanoseconds(NSTimeInterval seconds) {
+    return seconds > 0 ? (uint64_t)(seconds * NSEC_PER_SEC) : 0;
+}
+
+@interface XRGScheduler ()
+
+@property (readonly) dispatch_source_t timer;
+@property (readonly) uint64_t origin;
+@property (readonly) NSMutableArray<XRGScheduledTask *> *liveTasks;
+@property NSUInteger wakeups;
+@property XRGStatHandle latenessHandle;
+
+- (void)rearm;
+- (void)removeTask:(XRGScheduledTask *)task;
+
+@end
+
+@interface XRGScheduledTask ()
+
+@property (weak) XRGScheduler *scheduler;
+@property (copy, nullable) dispatch_block_t block;
+@property uint64_t intervalNanoseconds;
+@property uint64_t toleranceNanoseconds;
+@property BOOL toleranceSet;            // Once set explicitly, the tolerance no longer follows the interval.
+@property uint64_t deadline;
+@property NSTimeInterval lastOverrun;
+@property NSUInteger missedFires;
+
+- (instancetype)initWithName:(NSString *)name scheduler:(XRGScheduler *)scheduler interval:(NSTimeInterval)interval block:(dispatch_block_t)block;
+
+/// Moves the deadline to the first multiple of the interval, counted from the scheduler's origin, that's after now.
+- (void)alignAfter:(uint64_t)now;
+
+@end
+
+@implementation XRGScheduledTask
+
+- (instancetype)initWithName:(NSString *)name scheduler:(XRGScheduler *)scheduler interval:(NSTimeInterval)interval block:(dispatch_block_t)block {
+    self = [super init];
+    if (self) {
+        _name = [name copy];
+        _scheduler = scheduler;
+        _block = [block copy];
+        _interval = interval;
+        _tolerance = interval * 0.1;
+        _intervalNanoseconds = MAX(XRGSchedulerNanoseconds(interval), 1);
+        _toleranceNanoseconds = XRGSchedulerNanoseconds(_tolerance);
+    }
+    return self;
+}
+
+- (void)alignAfter:(uint64_t)now {
+    uint64_t origin = self.scheduler.origin;
+    uint64_t elapsed = now > origin ? now - origin : 0;
+    self.deadline = origin + (elapsed / self.intervalNanoseconds + 1) * self.intervalNanoseconds;
+}
+
+- (void)setInterval:(NSTimeInterval)interval {
+    _interval = interval;
+    self.intervalNanoseconds = MAX(XRGSchedulerNanoseconds(interval), 1);
+    if (!self.toleranceSet) {
+        _tolerance = interval * 0.1;
+        self.toleranceNanoseconds = XRGSchedulerNanoseconds(_tolerance);
+    }
+    
+    if (self.valid) {
+        [self alignAfter:XRGSchedulerNow()];
+        [self.scheduler rearm];
+    }
+}
+
+- (void)setPaused:(BOOL)paused {
+    if (_paused == paused) return;
+    
+    _paused = paused;
+    if (!paused) [self alignAfter:XRGSchedulerNow()];
+    if (self.valid) [self.scheduler rearm];
+}
+
+- (void)setTolerance:(NSTimeInterval)tolerance {
+    _tolerance = tolerance;
+    self.toleranceSet = YES;
+    self.toleranceNanoseconds = XRGSchedulerNanoseconds(tolerance);
+    if (self.valid) [self.scheduler rearm];
+}
+
+- (BOOL)isValid {
+    return self.block != nil;
+}
+
+- (NSDate *)nextFireDate {
+    if (!self.valid || self.paused) return nil;
+    
+    uint64_t now = XRGSchedulerNow();
+    NSTimeInterval remaining = self.deadline > now ? (double)(self.deadline - now) / NSEC_PER_SEC : 0;
+    return [NSDate dateWithTimeIntervalSinceNow:remaining];
+}
+
+- (void)invalidate {
+    if (!self.valid) return;
+    
+    self.block = nil;
+    [self.scheduler removeTask:self];
+}
+
+@end
+
+
+@implementation XRGScheduler
+
++ (XRGScheduler *)shared {
+    static XRGScheduler *sharedScheduler = nil;
+
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedScheduler = [[XRGScheduler alloc] init];
+    });
+
+    return sharedScheduler;
+}
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _origin = XRGSchedulerNow();
+        _liveTasks = [NSMutableArray array];
+        self.latenessHandle = [[XRGStatsManager shared] handleForKey:@"Timer Lateness (ms)" inModule:XRGStatsModuleNameSampler];
+        
+        _timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, dispatch_get_main_queue());
+        __weak XRGScheduler *weakSelf = self;
+        dispatch_source_set_event_handler(_timer, ^{
+            [weakSelf fire];
+        });
+        dispatch_source_set_timer(_timer, DISPATCH_TIME_FOREVER, DISPATCH_TIME_FOREVER, 0);
+        dispatch_resume(_timer);
+    }
+    return self;
+}
+
+- (NSArray<XRGScheduledTask *> *)tasks {
+    return [self.liveTasks copy];
+}
+
+- (XRGScheduledTask *)scheduleTaskNamed:(NSString *)name interval:(NSTimeInterval)interval block:(dispatch_block_t)block {
+    XRGScheduledTask *task = [[XRGScheduledTask alloc] initWithName:name scheduler:self interval:interval block:block];
+    [task alignAfter:XRGSchedulerNow()];
+    [self.liveTasks addObject:task];
+    [self rearm];
+    
+    return task;
+}
+
+- (void)removeTask:(XRGScheduledTask *)task {
+    [self.liveTasks removeObjectIdenticalTo:task];
+    [self rearm];
+}
+
+- (void)rearm {
+    XRGScheduledTask *earliest = nil;
+    for (XRGScheduledTask *task in self.liveTasks) {
+        if (task.paused) continue;
+        if (!earliest || task.deadline < earliest.deadline) earliest = task;
+    }
+    
+    if (!earliest) {
+        dispatch_source_set_timer(self.timer, DISPATCH_TIME_FOREVER, DISPATCH_TIME_FOREVER, 0);
+        return;
+    }
+    
+    uint64_t now = XRGSchedulerNow();
+    int64_t delay = earliest.deadline > now ? (int64_t)(earliest.deadline - now) : 0;
+    dispatch_source_set_timer(self.timer, dispatch_time(DISPATCH_TIME_NOW, delay), DISPATCH_TIME_FOREVER, earliest.toleranceNanoseconds);
+}
+
+- (void)fire {
+    self.wakeups++;
+    
+    uint64_t now = XRGSchedulerNow();
+    for (XRGScheduledTask *task in [self.liveTasks copy]) {
+        if (!task.valid || task.paused || task.deadline > now) continue;
+        
+        uint64_t late = now - task.deadline;
+        task.lastOverrun = (double)late / NSEC_PER_SEC;
+        task.missedFires += late / task.intervalNanoseconds;
+        [[XRGStatsManager shared] observeStat:(double)late / 1e6 forHandle:self.latenessHandle];
+        
+        // Aligned before the block runs, so a block that changes the interval isn't undone here.
+        [task alignAfter:now];
+        task.block();
+    }
+    
+    [self rearm];
+}
+
+@end
@@ -31,6 +31,13 @@ typedef NS_ENUM(NSInteger, XRGTemperatureUnits) {
     XRGTemperatureUnitsC
 };
 
+/// How much history the graphs that support it show.
+typedef NS_ENUM(NSInteger, XRGGraphHistorySpan) {
+    XRGGraphHistorySpanWindow = 0,      // One sample per point of width, the usual graph.
+    XRGGraphHistorySpanDay,             // The last 24 hours, from the data sets' history tiers.
+    XRGGraphHistorySpanHour             // The last hour, decoded from the data sets' archives.
+};
+
 @interface XRGSettings : NSObject
 
 // Colors
@@ -107,6 +114,10 @@ typedef NS_ENUM(NSInteger, XRGTemperatureUnits) {
 @property NSString		*tempFG2Location;
 @property NSString		*tempFG3Location;
 @property BOOL          isDockIconHidden;
+@property BOOL          adaptiveSampling;
+@property BOOL          incrementalGraphs;
+@property BOOL          layerBackedGraphs;
+@property XRGGraphHistorySpan graphHistorySpan;
 
 - (void) readXTFDictionary:(NSDictionary *)xtfD;
 
@@ -92,6 +92,10 @@
 		self.memoryShowCache             = YES;
 		self.memoryShowPage              = YES;
 		self.graphRefresh                = 1;
+		self.adaptiveSampling            = YES;
+		self.incrementalGraphs           = YES;
+		self.layerBackedGraphs           = YES;
+		self.graphHistorySpan            = XRGGraphHistorySpanWindow;
 		self.showLoadAverage             = YES;
 		self.netMinGraphScale            = 1024;
 		self.stockSymbols                = @"AAPL";
@@ -0,0 +1,684 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGStatShards.c
+//
+
+#include "XRGStatShards.h"
+#include "XRGQuantileSketch.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Shard entries are allocated a page at a time as handles are used, so a thread that only records a few stats stays small.
+#define XRG_STAT_PAGE_SIZE  64
+#define XRG_STAT_PAGES      (XRG_STAT_MAX_HANDLES / XRG_STAT_PAGE_SIZE)
+#define XRG_STAT_RING_SIZE  1024
+
+// About 200 values (under 2KB) per window slice, for a rank error around 3%.
+#define XRG_STAT_WINDOW_ACCURACY 64
+
+// MARK: - Shards
+
+typedef struct {
+    uint64_t index;                 // Which bucket-length slice of time, counted from the monotonic clock's origin.
+    uint64_t count;
+    double   last;
+    double   min;
+    double   max;
+    double   sum;
+} XRGStatBucket;
+
+typedef struct {
+    uint64_t           index;       // Which slice-length span of time, like XRGStatBucket's index.
+    XRGQuantileSketch *sketch;      // Created the first time the slice is observed into.
+} XRGStatSlice;
+
+typedef struct {
+    uint32_t generation;
+    size_t   count;
+    double   timeConstants[XRG_STAT_MAX_EWMA];
+} XRGStatEWMAConfig;
+
+// Everything built from drained samples.  Allocated the first time one of an entry's samples is drained.
+typedef struct {
+    uint32_t          epoch;
+    XRGQuantileSketch *sketch;
+    XRGStatBucket     buckets[XRGStatWindowCount][XRG_STAT_WINDOW_BUCKETS];
+    XRGStatSlice      slices[XRGStatWindowCount][XRG_STAT_WINDOW_SLICES];
+    uint64_t          sliceIndex;   // The shortest window's newest slice, not yet merged into the longer windows.
+    
+    // Weighted sums and weights as of ewmaTime; the average is their ratio.
+    uint32_t          ewmaGeneration;
+    uint64_t          ewmaTime;
+    double            ewmaSum[XRG_STAT_MAX_EWMA];
+    double            ewmaWeight[XRG_STAT_MAX_EWMA];
+} XRGStatHistory;
+
+typedef struct {
+    _Atomic uint32_t  sequence;     // Odd while the owning thread is writing.
+    uint32_t          epoch;
+    uint64_t          count;
+    double            last;
+    double            min;
+    double            max;
+    double            sum;
+    uint64_t          lastTime;     // Monotonic nanoseconds, to pick the newest "last" across shards.
+    
+    // Guarded by the shard's drainLock rather than the sequence count.
+    XRGStatHistory    *history;
+} XRGStatEntry;
+
+typedef struct {
+    uint32_t handle;
+    uint32_t epoch;
+    double   value;
+    uint64_t time;
+} XRGStatSample;
+
+typedef struct XRGStatShard {
+    _Atomic(XRGStatEntry *)      pages[XRG_STAT_PAGES];
+    
+    // Values waiting to go into the entries' sketches.  The owning thread produces; whoever holds drainLock consumes.
+    XRGStatSample                ring[XRG_STAT_RING_SIZE];
+    _Atomic uint64_t             head;
+    _Atomic uint64_t             tail;
+    pthread_mutex_t              drainLock;
+    
+    _Atomic bool                 inUse;
+    struct XRGStatShard          *next;
+} XRGStatShard;
+
+static _Atomic(XRGStatShard *) XRGStatShardList = NULL;
+static _Atomic uint32_t        XRGStatEpochs[XRG_STAT_MAX_HANDLES];
+static _Atomic uint64_t        XRGStatRingStalls = 0;
+
+static const double            XRGStatWindowLengths[XRGStatWindowCount] = { 60, 300, 3600 };
+
+// Replaced configurations are never freed, since a drain may still be reading one.  They only change when the user
+// changes a setting.
+static const XRGStatEWMAConfig XRGStatEWMADefault = { 0, 3, { 60, 300, 900 } };
+static _Atomic(const XRGStatEWMAConfig *) XRGStatEWMA = &XRGStatEWMADefault;
+
+// The shards' sketches merged for the last quantile read of each handle, kept until the next read finds that a shard
+// has drained more values or the handle has been cleared.  Allocated the first time a handle's quantiles are read.
+typedef struct {
+    uint32_t           epoch;
+    uint64_t           drained;     // Values in the shards' sketches when they were merged.
+    XRGQuantileSketch *sketch;
+} XRGStatMerged;
+
+static XRGStatMerged          *XRGStatMergedSketches[XRG_STAT_MAX_HANDLES];
+static pthread_mutex_t         XRGStatMergedLock = PTHREAD_MUTEX_INITIALIZER;
+
+// Scratch for merging a window's slices, which are read far less often than they're written.  Guarded by
+// XRGStatMergedLock and created on the first window quantile read.
+static XRGQuantileSketch      *XRGStatWindowSketch = NULL;
+
+static pthread_once_t          XRGStatShardKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t           XRGStatShardKey;
+static _Thread_local XRGStatShard *XRGStatCurrentShard = NULL;
+
+// A shard outlives its thread so nothing it recorded is lost; the next new thread takes it over.
+static void XRGStatShardRelease(void *shard) {
+    atomic_store_explicit(&((XRGStatShard *)shard)->inUse, false, memory_order_release);
+}
+
+static void XRGStatShardKeyCreate(void) {
+    pthread_key_create(&XRGStatShardKey, XRGStatShardRelease);
+}
+
+static XRGStatShard *XRGStatShardForCurrentThread(void) {
+    XRGStatShard *shard = XRGStatCurrentShard;
+    if (shard) return shard;
+    
+    pthread_once(&XRGStatShardKeyOnce, XRGStatShardKeyCreate);
+    
+    for (shard = atomic_load_explicit(&XRGStatShardList, memory_order_acquire); shard; shard = shard->next) {
+        bool expected = false;
+        if (atomic_compare_exchange_strong_explicit(&shard->inUse, &expected, true, memory_order_acquire, memory_order_relaxed)) break;
+    }
+    
+    if (!shard) {
+        shard = calloc(1, sizeof(XRGStatShard));
+        if (!shard) return NULL;
+        pthread_mutex_init(&shard->drainLock, NULL);
+        atomic_store_explicit(&shard->inUse, true, memory_order_relaxed);
+        
+        XRGStatShard *head = atomic_load_explicit(&XRGStatShardList, memory_order_relaxed);
+        do {
+            shard->next = head;
+        } while (!atomic_compare_exchange_weak_explicit(&XRGStatShardList, &head, shard, memory_order_release, memory_order_relaxed));
+    }
+    
+    pthread_setspecific(XRGStatShardKey, shard);
+    XRGStatCurrentShard = shard;
+    return shard;
+}
+
+static uint64_t XRGStatNow(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+static uint64_t XRGStatBucketLength(XRGStatWindow window) {
+    return (uint64_t)(XRGStatWindowLengths[window] * 1e9) / XRG_STAT_WINDOW_BUCKETS;
+}
+
+static uint64_t XRGStatSliceLength(XRGStatWindow window) {
+    return (uint64_t)(XRGStatWindowLengths[window] * 1e9) / XRG_STAT_WINDOW_SLICES;
+}
+
+// MARK: - History
+
+// Returns the entry's history, created or reset for the given epoch.  Caller holds the shard's drainLock.
+static XRGStatHistory *XRGStatHistoryForEntry(XRGStatEntry *entry, uint32_t epoch) {
+    XRGStatHistory *history = entry->history;
+    if (!history) {
+        history = calloc(1, sizeof(XRGStatHistory));
+        if (!history) return NULL;
+        history->sketch = XRGQuantileSketchCreate(XRG_QUANTILE_DEFAULT_ACCURACY);
+        if (!history->sketch) {
+            free(history);
+            return NULL;
+        }
+        history->epoch = epoch;
+        entry->history = history;
+    }
+    else if (history->epoch != epoch) {
+        // The sketches are emptied and kept, so clearing a stat doesn't allocate them all again.
+        XRGQuantileSketch *sketch = history->sketch;
+        XRGQuantileSketch *sliceSketches[XRGStatWindowCount][XRG_STAT_WINDOW_SLICES];
+        XRGQuantileSketchReset(sketch);
+        for (int window = 0; window < XRGStatWindowCount; window++) {
+            for (int i = 0; i < XRG_STAT_WINDOW_SLICES; i++) {
+                sliceSketches[window][i] = history->slices[window][i].sketch;
+                if (sliceSketches[window][i]) XRGQuantileSketchReset(sliceSketches[window][i]);
+            }
+        }
+        
+        memset(history, 0, sizeof(XRGStatHistory));
+        history->sketch = sketch;
+        for (int window = 0; window < XRGStatWindowCount; window++) {
+            for (int i = 0; i < XRG_STAT_WINDOW_SLICES; i++) history->slices[window][i].sketch = sliceSketches[window][i];
+        }
+        history->epoch = epoch;
+    }
+    
+    return history;
+}
+
+// The sketch for one of a window's slices, emptied if its place in the ring last held an older slice.  NULL if the
+// slice has already been overwritten by a newer one, or its sketch couldn't be created.
+static XRGQuantileSketch *XRGStatSliceSketch(XRGStatHistory *history, XRGStatWindow window, uint64_t index) {
+    XRGStatSlice *slice = &history->slices[window][index % XRG_STAT_WINDOW_SLICES];
+    if (slice->index > index) return NULL;
+    
+    if (!slice->sketch) slice->sketch = XRGQuantileSketchCreate(XRG_STAT_WINDOW_ACCURACY);
+    if (!slice->sketch) return NULL;
+    
+    if (slice->index != index) {
+        XRGQuantileSketchReset(slice->sketch);
+        slice->index = index;
+    }
+    return slice->sketch;
+}
+
+// Values are only inserted into the shortest window's slices.  When one of those ends, it's merged into the slice of
+// each longer window that contains it (the slice lengths divide evenly), so a value costs one sketch insert however
+// many windows there are, and the merges happen once per slice rather than once per value.
+static void XRGStatHistoryRollSlice(XRGStatHistory *history) {
+    XRGStatSlice *finished = &history->slices[0][history->sliceIndex % XRG_STAT_WINDOW_SLICES];
+    if (!finished->sketch || finished->index != history->sliceIndex || XRGQuantileSketchCount(finished->sketch) == 0) return;
+    
+    for (int window = 1; window < XRGStatWindowCount; window++) {
+        uint64_t index = history->sliceIndex * XRGStatSliceLength(0) / XRGStatSliceLength(window);
+        XRGQuantileSketch *sketch = XRGStatSliceSketch(history, window, index);
+        if (sketch) XRGQuantileSketchMerge(sketch, finished->sketch);
+    }
+}
+
+static void XRGStatHistoryAdd(XRGStatHistory *history, const XRGStatSample *sample, const XRGStatEWMAConfig *ewma) {
+    XRGQuantileSketchInsert(history->sketch, sample->value);
+    
+    for (int window = 0; window < XRGStatWindowCount; window++) {
+        uint64_t index = sample->time / XRGStatBucketLength(window);
+        XRGStatBucket *bucket = &history->buckets[window][index % XRG_STAT_WINDOW_BUCKETS];
+        
+        if (bucket->count == 0 || bucket->index != index) {
+            *bucket = (XRGStatBucket){ index, 1, sample->value, sample->value, sample->value, sample->value };
+            continue;
+        }
+        
+        if (sample->value < bucket->min) bucket->min = sample->value;
+        if (sample->value > bucket->max) bucket->max = sample->value;
+        bucket->sum += sample->value;
+        bucket->last = sample->value;
+        bucket->count++;
+    }
+    
+    uint64_t index = sample->time / XRGStatSliceLength(0);
+    if (index > history->sliceIndex) {
+        XRGStatHistoryRollSlice(history);
+        history->sliceIndex = index;
+    }
+    else if (index < history->sliceIndex) {
+        // Already rolled up, so the longer windows need it directly.
+        for (int window = 1; window < XRGStatWindowCount; window++) {
+            uint64_t windowIndex = index * XRGStatSliceLength(0) / XRGStatSliceLength(window);
+            XRGQuantileSketchInsert(XRGStatSliceSketch(history, window, windowIndex), sample->value);
+        }
+    }
+    XRGQuantileSketchInsert(XRGStatSliceSketch(history, 0, index), sample->value);
+    
+    if (history->ewmaGeneration != ewma->generation || history->ewmaTime == 0) {
+        memset(history->ewmaSum, 0, sizeof(history->ewmaSum));
+        memset(history->ewmaWeight, 0, sizeof(history->ewmaWeight));
+        history->ewmaGeneration = ewma->generation;
+        history->ewmaTime = sample->time;
+    }
+    
+    double elapsed = sample->time > history->ewmaTime ? (double)(sample->time - history->ewmaTime) / 1e9 : 0;
+    for (size_t i = 0; i < ewma->count; i++) {
+        double decay = elapsed > 0 ? exp(-elapsed / ewma->timeConstants[i]) : 1;
+        history->ewmaSum[i] = history->ewmaSum[i] * decay + sample->value;
+        history->ewmaWeight[i] = history->ewmaWeight[i] * decay + 1;
+    }
+    history->ewmaTime = sample->time;
+}
+
+// MARK: - Reading
+
+// Copies an entry with the sequence count retry loop.  Returns false if it is empty or from an older epoch.
+static bool XRGStatEntryRead(XRGStatEntry *entry, uint32_t epoch, XRGStatEntry *copy) {
+    uint32_t before, after;
+    do {
+        before = atomic_load_explicit(&entry->sequence, memory_order_acquire);
+        if (before & 1) continue;
+        
+        copy->epoch = entry->epoch;
+        copy->count = entry->count;
+        copy->last = entry->last;
+        copy->min = entry->min;
+        copy->max = entry->max;
+        copy->sum = entry->sum;
+        copy->lastTime = entry->lastTime;
+        
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&entry->sequence, memory_order_relaxed);
+    } while ((before & 1) || before != after);
+    
+    return copy->epoch == epoch && copy->count > 0;
+}
+
+// Moves a shard's queued samples into its entries' sketches.  Caller holds the shard's drainLock.
+static void XRGStatShardDrainLocked(XRGStatShard *shard) {
+    uint64_t tail = atomic_load_explicit(&shard->tail, memory_order_relaxed);
+    uint64_t head = atomic_load_explicit(&shard->head, memory_order_acquire);
+    if (tail == head) return;
+    
+    const XRGStatEWMAConfig *ewma = atomic_load_explicit(&XRGStatEWMA, memory_order_acquire);
+    
+    for (; tail != head; tail++) {
+        XRGStatSample sample = shard->ring[tail % XRG_STAT_RING_SIZE];
+        uint32_t epoch = atomic_load_explicit(&XRGStatEpochs[sample.handle], memory_order_relaxed);
+        if (sample.epoch != epoch) continue;
+        
+        // The page exists: the sample was queued after its entry was written.
+        XRGStatEntry *page = atomic_load_explicit(&shard->pages[sample.handle / XRG_STAT_PAGE_SIZE], memory_order_acquire);
+        XRGStatHistory *history = XRGStatHistoryForEntry(&page[sample.handle % XRG_STAT_PAGE_SIZE], epoch);
+        if (history) XRGStatHistoryAdd(history, &sample, ewma);
+    }
+    
+    atomic_store_explicit(&shard->tail, tail, memory_order_release);
+}
+
+bool XRGStatRead(uint32_t handle, XRGStatSummary *summary) {
+    memset(summary, 0, sizeof(XRGStatSummary));
+    if (handle >= XRG_STAT_MAX_HANDLES) return false;
+    
+    uint32_t epoch = atomic_load_explicit(&XRGStatEpochs[handle], memory_order_acquire);
+    uint64_t lastTime = 0;
+    double sum = 0;
+    
+    for (XRGStatShard *shard = atomic_load_explicit(&XRGStatShardList, memory_order_acquire); shard; shard = shard->next) {
+        XRGStatEntry *page = atomic_load_explicit(&shard->pages[handle / XRG_STAT_PAGE_SIZE], memory_order_acquire);
+        if (!page) continue;
+        
+        XRGStatEntry copy;
+        if (!XRGStatEntryRead(&page[handle % XRG_STAT_PAGE_SIZE], epoch, &copy)) continue;
+        
+        if (summary->count == 0 || copy.min < summary->min) summary->min = copy.min;
+        if (summary->count == 0 || copy.max > summary->max) summary->max = copy.max;
+        if (summary->count == 0 || copy.lastTime >= lastTime) {
+            summary->last = copy.last;
+            lastTime = copy.lastTime;
+        }
+        summary->count += copy.count;
+        sum += copy.sum;
+    }
+    
+    if (summary->count) summary->average = sum / (double)summary->count;
+    return summary->count > 0;
+}
+
+// Drains every shard's samples for a handle and returns how many values its sketches hold for the epoch, merging
+// each sketch into merged if that's not NULL.  Within an epoch the count only grows, so it tells a reader whether the
+// merged sketch it last built is still current.
+static uint64_t XRGStatMergeSketches(uint32_t handle, uint32_t epoch, XRGQuantileSketch *merged) {
+    uint64_t drained = 0;
+    
+    for (XRGStatShard *shard = atomic_load_explicit(&XRGStatShardList, memory_order_acquire); shard; shard = shard->next) {
+        XRGStatEntry *page = atomic_load_explicit(&shard->pages[handle / XRG_STAT_PAGE_SIZE], memory_order_acquire);
+        if (!page) continue;
+        
+        pthread_mutex_lock(&shard->drainLock);
+        XRGStatShardDrainLocked(shard);
+        
+        XRGStatHistory *history = page[handle % XRG_STAT_PAGE_SIZE].history;
+        if (history && history->epoch == epoch) {
+            drained += XRGQuantileSketchCount(history->sketch);
+            if (merged) XRGQuantileSketchMerge(merged, history->sketch);
+        }
+        pthread_mutex_unlock(&shard->drainLock);
+    }
+    
+    return drained;
+}
+
+void XRGStatQuantiles(uint32_t handle, const double *quantiles, double *results, size_t count) {
+    if (handle >= XRG_STAT_MAX_HANDLES) {
+        memset(results, 0, count * sizeof(double));
+        return;
+    }
+    
+    uint32_t epoch = atomic_load_explicit(&XRGStatEpochs[handle], memory_order_acquire);
+    uint64_t drained = XRGStatMergeSketches(handle, epoch, NULL);
+    
+    pthread_mutex_lock(&XRGStatMergedLock);
+    
+    XRGStatMerged *merged = XRGStatMergedSketches[handle];
+    if (!merged) {
+        // Starts out as the merge of nothing from epoch 0, which is what an empty sketch is.
+        merged = calloc(1, sizeof(XRGStatMerged));
+        if (merged) merged->sketch = XRGQuantileSketchCreate(XRG_QUANTILE_DEFAULT_ACCURACY);
+        if (!merged || !merged->sketch) {
+            free(merged);
+            pthread_mutex_unlock(&XRGStatMergedLock);
+            memset(results, 0, count * sizeof(double));
+            return;
+        }
+        XRGStatMergedSketches[handle] = merged;
+    }
+    
+    // Only merge again if a shard has drained more values or the stat was cleared since the last read.
+    if (merged->epoch != epoch || merged->drained != drained) {
+        XRGQuantileSketchReset(merged->sketch);
+        merged->drained = XRGStatMergeSketches(handle, epoch, merged->sketch);
+        merged->epoch = epoch;
+    }
+    
+    XRGQuantileSketchQuantiles(merged->sketch, quantiles, results, count);
+    pthread_mutex_unlock(&XRGStatMergedLock);
+}
+
+bool XRGStatReadWindow(uint32_t handle, XRGStatWindow window, XRGStatSummary *summary) {
+    memset(summary, 0, sizeof(XRGStatSummary));
+    if (handle >= XRG_STAT_MAX_HANDLES || window < 0 || window >= XRGStatWindowCount) return false;
+    
+    uint32_t epoch = atomic_load_explicit(&XRGStatEpochs[handle], memory_order_acquire);
+    uint64_t newestIndex = XRGStatNow() / XRGStatBucketLength(window);
+    uint64_t lastIndex = 0;
+    double sum = 0;
+    
+    for (XRGStatShard *shard = atomic_load_explicit(&XRGStatShardList, memory_order_acquire); shard; shard = shard->next) {
+        XRGStatEntry *page = atomic_load_explicit(&shard->pages[handle / XRG_STAT_PAGE_SIZE], memory_order_acquire);
+        if (!page) continue;
+        
+        pthread_mutex_lock(&shard->drainLock);
+        XRGStatShardDrainLocked(shard);
+        
+        XRGStatHistory *history = page[handle % XRG_STAT_PAGE_SIZE].history;
+        if (history && history->epoch == epoch) {
+            for (int i = 0; i < XRG_STAT_WINDOW_BUCKETS; i++) {
+                XRGStatBucket *bucket = &history->buckets[window][i];
+                if (bucket->count == 0 || bucket->index > newestIndex || newestIndex - bucket->index >= XRG_STAT_WINDOW_BUCKETS) continue;
+                
+                if (summary->count == 0 || bucket->min < summary->min) summary->min = bucket->min;
+                if (summary->count == 0 || bucket->max > summary->max) summary->max = bucket->max;
+                if (summary->count == 0 || bucket->index >= lastIndex) {
+                    summary->last = bucket->last;
+                    lastIndex = bucket->index;
+                }
+                summary->count += bucket->count;
+                sum += bucket->sum;
+            }
+        }
+        pthread_mutex_unlock(&shard->drainLock);
+    }
+    
+    if (summary->count) summary->average = sum / (double)summary->count;
+    return summary->count > 0;
+}
+
+bool XRGStatReadWindowQuantiles(uint32_t handle, XRGStatWindow window, const double *quantiles, double *results, size_t count) {
+    memset(results, 0, count * sizeof(double));
+    if (handle >= XRG_STAT_MAX_HANDLES || window < 0 || window >= XRGStatWindowCount) return false;
+    
+    uint32_t epoch = atomic_load_explicit(&XRGStatEpochs[handle], memory_order_acquire);
+    uint64_t newestIndex = XRGStatNow() / XRGStatSliceLength(window);
+    
+    pthread_mutex_lock(&XRGStatMergedLock);
+    if (!XRGStatWindowSketch) XRGStatWindowSketch = XRGQuantileSketchCreate(XRG_QUANTILE_DEFAULT_ACCURACY);
+    if (!XRGStatWindowSketch) {
+        pthread_mutex_unlock(&XRGStatMergedLock);
+        return false;
+    }
+    XRGQuantileSketchReset(XRGStatWindowSketch);
+    
+    for (XRGStatShard *shard = atomic_load_explicit(&XRGStatShardList, memory_order_acquire); shard; shard = shard->next) {
+        XRGStatEntry *page = atomic_load_explicit(&shard->pages[handle / XRG_STAT_PAGE_SIZE], memory_order_acquire);
+        if (!page) continue;
+        
+        pthread_mutex_lock(&shard->drainLock);
+        XRGStatShardDrainLocked(shard);
+        
+        XRGStatHistory *history = page[handle % XRG_STAT_PAGE_SIZE].history;
+        if (history && history->epoch == epoch) {
+            for (int i = 0; i < XRG_STAT_WINDOW_SLICES; i++) {
+                XRGStatSlice *slice = &history->slices[window][i];
+                if (!slice->sketch || slice->index > newestIndex || newestIndex - slice->index >= XRG_STAT_WINDOW_SLICES) continue;
+                XRGQuantileSketchMerge(XRGStatWindowSketch, slice->sketch);
+            }
+            
+            // The shortest window's newest slice hasn't been merged into the longer ones yet.
+            XRGStatSlice *pending = &history->slices[0][history->sliceIndex % XRG_STAT_WINDOW_SLICES];
+            uint64_t pendingIndex = history->sliceIndex * XRGStatSliceLength(0) / XRGStatSliceLength(window);
+            if (window > 0 && pending->sketch && pending->index == history->sliceIndex && pendingIndex <= newestIndex && newestIndex - pendingIndex < XRG_STAT_WINDOW_SLICES) {
+                XRGQuantileSketchMerge(XRGStatWindowSketch, pending->sketch);
+            }
+        }
+        pthread_mutex_unlock(&shard->drainLock);
+    }
+    
+    bool observed = XRGQuantileSketchCount(XRGStatWindowSketch) > 0;
+    if (observed) XRGQuantileSketchQuantiles(XRGStatWindowSketch, quantiles, results, count);
+    pthread_mutex_unlock(&XRGStatMergedLock);
+    return observed;
+}
+
+double XRGStatWindowSeconds(XRGStatWindow window) {
+    return (window >= 0 && window < XRGStatWindowCount) ? XRGStatWindowLengths[window] : 0;
+}
+
+size_t XRGStatReadEWMA(uint32_t handle, double *results, size_t count) {
+    if (handle >= XRG_STAT_MAX_HANDLES) return 0;
+    
+    const XRGStatEWMAConfig *ewma = atomic_load_explicit(&XRGStatEWMA, memory_order_acquire);
+    uint32_t epoch = atomic_load_explicit(&XRGStatEpochs[handle], memory_order_acquire);
+    if (count > ewma->count) count = ewma->count;
+    
+    // Each shard's sums are as of its own last sample, so the older of the running total and the shard's sums is
+    // decayed to the newer one's time before they're added.
+    double sums[XRG_STAT_MAX_EWMA] = { 0 };
+    double weights[XRG_STAT_MAX_EWMA] = { 0 };
+    uint64_t newestTime = 0;
+    
+    for (XRGStatShard *shard = atomic_load_explicit(&XRGStatShardList, memory_order_acquire); shard; shard = shard->next) {
+        XRGStatEntry *page = atomic_load_explicit(&shard->pages[handle / XRG_STAT_PAGE_SIZE], memory_order_acquire);
+        if (!page) continue;
+        
+        pthread_mutex_lock(&shard->drainLock);
+        XRGStatShardDrainLocked(shard);
+        
+        XRGStatHistory *history = page[handle % XRG_STAT_PAGE_SIZE].history;
+        if (history && history->epoch == epoch && history->ewmaGeneration == ewma->generation && history->ewmaTime) {
+            uint64_t time = history->ewmaTime;
+            double elapsed = (double)(time > newestTime ? time - newestTime : newestTime - time) / 1e9;
+            
+            for (size_t i = 0; i < count; i++) {
+                double decay = exp(-elapsed / ewma->timeConstants[i]);
+                if (time > newestTime) {
+                    sums[i] = sums[i] * decay + history->ewmaSum[i];
+                    weights[i] = weights[i] * decay + history->ewmaWeight[i];
+                }
+                else {
+                    sums[i] += history->ewmaSum[i] * decay;
+                    weights[i] += history->ewmaWeight[i] * decay;
+                }
+            }
+            if (time > newestTime) newestTime = time;
+        }
+        pthread_mutex_unlock(&shard->drainLock);
+    }
+    
+    if (newestTime == 0) return 0;
+    
+    for (size_t i = 0; i < count; i++) {
+        results[i] = weights[i] > 0 ? sums[i] / weights[i] : 0;
+    }
+    return count;
+}
+
+bool XRGStatSetEWMATimeConstants(const double *seconds, size_t count) {
+    if (count == 0 || count > XRG_STAT_MAX_EWMA) return false;
+    for (size_t i = 0; i < count; i++) {
+        if (!(seconds[i] > 0) || isinf(seconds[i])) return false;
+    }
+    
+    XRGStatEWMAConfig *config = calloc(1, sizeof(XRGStatEWMAConfig));
+    if (!config) return false;
+    config->count = count;
+    memcpy(config->timeConstants, seconds, count * sizeof(double));
+    
+    const XRGStatEWMAConfig *current = atomic_load_explicit(&XRGStatEWMA, memory_order_acquire);
+    do {
+        config->generation = current->generation + 1;
+    } while (!atomic_compare_exchange_weak_explicit(&XRGStatEWMA, &current, config, memory_order_acq_rel, memory_order_acquire));
+    
+    return true;
+}
+
+size_t XRGStatGetEWMATimeConstants(double *seconds, size_t count) {
+    const XRGStatEWMAConfig *ewma = atomic_load_explicit(&XRGStatEWMA, memory_order_acquire);
+    memcpy(seconds, ewma->timeConstants, (count < ewma->count ? count : ewma->count) * sizeof(double));
+    return ewma->count;
+}
+
+uint64_t XRGStatRingStallCount(void) {
+    return atomic_load_explicit(&XRGStatRingStalls, memory_order_relaxed);
+}
+
+// MARK: - Writing
+
+void XRGStatObserve(uint32_t handle, double value) {
+    if (handle >= XRG_STAT_MAX_HANDLES) return;
+    
+    XRGStatShard *shard = XRGStatShardForCurrentThread();
+    if (!shard) return;
+    
+    // Only this thread stores to its pages, so a relaxed load is enough to see its own writes.
+    _Atomic(XRGStatEntry *) *pageSlot = &shard->pages[handle / XRG_STAT_PAGE_SIZE];
+    XRGStatEntry *page = atomic_load_explicit(pageSlot, memory_order_relaxed);
+    if (!page) {
+        page = calloc(XRG_STAT_PAGE_SIZE, sizeof(XRGStatEntry));
+        if (!page) return;
+        atomic_store_explicit(pageSlot, page, memory_order_release);
+    }
+    
+    XRGStatEntry *entry = &page[handle % XRG_STAT_PAGE_SIZE];
+    uint32_t epoch = atomic_load_explicit(&XRGStatEpochs[handle], memory_order_acquire);
+    
+    uint32_t sequence = atomic_load_explicit(&entry->sequence, memory_order_relaxed);
+    atomic_store_explicit(&entry->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    
+    if (entry->epoch != epoch || entry->count == 0) {
+        entry->epoch = epoch;
+        entry->count = 0;
+        entry->min = value;
+        entry->max = value;
+        entry->sum = 0;
+    }
+    if (value < entry->min) entry->min = value;
+    if (value > entry->max) entry->max = value;
+    entry->sum += value;
+    entry->count++;
+    entry->last = value;
+    uint64_t now = XRGStatNow();
+    entry->lastTime = now;
+    
+    atomic_store_explicit(&entry->sequence, sequence + 2, memory_order_release);
+    
+    // Queue the value for the quantile sketch.  Past half full, drain unless a reader is merging this shard right
+    // now; only a full ring waits for the reader to finish.
+    uint64_t head = atomic_load_explicit(&shard->head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&shard->tail, memory_order_acquire);
+    if (head - tail >= XRG_STAT_RING_SIZE / 2) {
+        if (head - tail >= XRG_STAT_RING_SIZE) {
+            pthread_mutex_lock(&shard->drainLock);
+            XRGStatShardDrainLocked(shard);
+            pthread_mutex_unlock(&shard->drainLock);
+            atomic_fetch_add_explicit(&XRGStatRingStalls, 1, memory_order_relaxed);
+        }
+        else if (pthread_mutex_trylock(&shard->drainLock) == 0) {
+            XRGStatShardDrainLocked(shard);
+            pthread_mutex_unlock(&shard->drainLock);
+        }
+    }
+    
+    shard->ring[head % XRG_STAT_RING_SIZE] = (XRGStatSample){ handle, epoch, value, now };
+    atomic_store_explicit(&shard->head, head + 1, memory_order_release);
+}
+
+void XRGStatClear(uint32_t handle) {
+    if (handle >= XRG_STAT_MAX_HANDLES) return;
+    
+    // Entries and queued samples from the old epoch are ignored from here on, and reset by their writers when next used.
+    atomic_fetch_add_explicit(&XRGStatEpochs[handle], 1, memory_order_acq_rel);
+}
@@ -0,0 +1,119 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGStatShards.h
+//
+
+#ifndef XRG_STAT_SHARDS_H
+#define XRG_STAT_SHARDS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Lock-free ingestion for XRGStatsManager.  Stats are addressed by small integer handles, and every thread that
+// observes a stat writes to its own shard: a flat array of plain structs, indexed by handle, guarded by a per-entry
+// sequence count so readers can copy an entry without stopping the writer.  Each observation is also queued on the
+// shard's ring, and the queued values are fed to the shard's own quantile sketches in batches.  Reads merge the
+// shards, including their sketches.
+//
+// The drained values also feed each entry's rolling windows and EWMAs.  A window is a ring of
+// XRG_STAT_WINDOW_BUCKETS time buckets, plus a coarser ring of XRG_STAT_WINDOW_SLICES quantile sketches, so updating
+// one and reading one each take a fixed amount of work no matter how long XRG has been running.  Values only go into
+// the shortest window's sketches; each of its slices is merged into the longer windows' slices when it ends.
+//
+// Observing doesn't take a lock.  The only shared state a writer reads is the handle's epoch, which changes when the
+// stat is cleared.  Once its ring is half full a writer drains it into its sketches if the shard isn't being read at
+// that moment; only a completely full ring, hundreds of observations later, waits for a reader to finish.
+
+/// Handles run from 0 to XRG_STAT_MAX_HANDLES - 1.
+#define XRG_STAT_MAX_HANDLES 4096
+
+/// Buckets per rolling window; each bucket covers 1/XRG_STAT_WINDOW_BUCKETS of its window.
+#define XRG_STAT_WINDOW_BUCKETS 30
+
+/// Quantile sketches per rolling window; each covers 1/XRG_STAT_WINDOW_SLICES of its window.  Fewer than the buckets,
+/// since a sketch takes a couple of KB where a bucket takes 48 bytes.
+#define XRG_STAT_WINDOW_SLICES 6
+
+/// Most EWMA time constants that can be tracked at once.
+#define XRG_STAT_MAX_EWMA 4
+
+typedef enum {
+    XRGStatWindowOneMinute = 0,
+    XRGStatWindowFiveMinutes,
+    XRGStatWindowOneHour,
+    XRGStatWindowCount
+} XRGStatWindow;
+
+typedef struct {
+    double   last;
+    double   min;
+    double   max;
+    double   average;
+    uint64_t count;
+} XRGStatSummary;
+
+/// Records a value.  Safe to call from any thread.  Out of range handles are ignored.
+void XRGStatObserve(uint32_t handle, double value);
+
+/// Forgets everything observed for a handle so far.  Safe to call from any thread.
+void XRGStatClear(uint32_t handle);
+
+/// Merges every shard's entry for a handle.  Returns false, with a zeroed summary, if nothing has been observed since the last clear.
+bool XRGStatRead(uint32_t handle, XRGStatSummary *summary);
+
+/// Estimates count quantiles (0 to 1) of everything observed since the last clear.  Every result is 0 if nothing has been.
+/// The merged sketch is kept between reads, so reading again before any new values are drained doesn't merge again.
+void XRGStatQuantiles(uint32_t handle, const double *quantiles, double *results, size_t count);
+
+/// Merges the buckets of a rolling window that have been observed into, ending now.  The window's oldest bucket may
+/// be partly expired, so it covers up to one bucket more than its nominal length.  Returns false, with a zeroed
+/// summary, if nothing in the window has been observed since the last clear.
+bool XRGStatReadWindow(uint32_t handle, XRGStatWindow window, XRGStatSummary *summary);
+
+/// Estimates count quantiles (0 to 1) of the values in a rolling window ending now.  The window's oldest slice may be
+/// partly expired, so it covers up to one slice more than its nominal length.  Returns false, with every result 0, if
+/// nothing in the window has been observed since the last clear.
+bool XRGStatReadWindowQuantiles(uint32_t handle, XRGStatWindow window, const double *quantiles, double *results, size_t count);
+
+/// Length of a rolling window in seconds.
+double XRGStatWindowSeconds(XRGStatWindow window);
+
+/// Exponentially weighted moving averages of a handle, one per configured time constant, as of the last observation.
+/// Weights decay with elapsed time, not with the number of samples, so irregular sampling doesn't skew them.  Writes
+/// at most count results and returns how many were written; 0 if nothing has been observed since the last clear.
+size_t XRGStatReadEWMA(uint32_t handle, double *results, size_t count);
+
+/// Replaces the EWMA time constants (in seconds, at most XRG_STAT_MAX_EWMA of them, each greater than 0).  Every
+/// EWMA restarts from the next observation.  Returns false and keeps the current ones if the constants are invalid.
+bool XRGStatSetEWMATimeConstants(const double *seconds, size_t count);
+
+/// Copies up to count of the EWMA time constants, in seconds, and returns how many there are.  The defaults are
+/// 60, 300 and 900 seconds, like the load averages.
+size_t XRGStatGetEWMATimeConstants(double *seconds, size_t count);
+
+/// Number of times a writer had to wait for a drain because its ring was full.
+uint64_t XRGStatRingStallCount(void);
+
+#endif
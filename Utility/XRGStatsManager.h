@@ -36,34 +36,70 @@ typedef NS_ENUM(NSInteger, XRGStatsModule) {
     XRGStatsModuleNameDisk,
     XRGStatsModuleNameNetwork,
     XRGStatsModuleNameWeather,
-    XRGStatsModuleNameStock
+    XRGStatsModuleNameStock,
+    XRGStatsModuleNameSampler
 };
 
+typedef NS_ENUM(NSInteger, XRGStatsWindow) {
+    XRGStatsWindowOneMinute,
+    XRGStatsWindowFiveMinutes,
+    XRGStatsWindowOneHour
+};
+
+/// A stat's interned key.  Handles are stable for the life of the process, so callers that record a stat every tick
+/// should look the handle up once and use observeStat:forHandle:.
+typedef uint32_t XRGStatHandle;
+static const XRGStatHandle XRGStatHandleInvalid = UINT32_MAX;
+
 NS_ASSUME_NONNULL_BEGIN
 
-#pragma mark - XRGStatsContentItem
-@interface XRGStatsContentItem: NSObject
+#pragma mark - XRGStatsWindowSummary
+/// A stat over one rolling window, which forgets values as they age out instead of only ever widening.
+@interface XRGStatsWindowSummary: NSObject
 
-@property NSString *key;
+@property (readonly) XRGStatsWindow window;
+@property (readonly) NSTimeInterval duration;
 
-@property double last;
-@property double min;
-@property double max;
-@property double average;
+@property (readonly) double last;
+@property (readonly) double min;
+@property (readonly) double max;
+@property (readonly) double average;
+@property (readonly) NSUInteger count;
 
-- (instancetype)initWithKey:(NSString *)key initialValue:(double)initialValue;
-- (void)observeStat:(double)value;
+// Estimated from sketches of the window's slices, so the oldest slice may reach back a little past the window's start.
+@property (readonly) double p50;
+@property (readonly) double p95;
+@property (readonly) double p99;
 
 @end
 
 
-#pragma mark - XRGStatsModuleContent
-@interface XRGStatsModuleContent: NSObject
+#pragma mark - XRGStatsContentItem
+/// A snapshot of one stat, merged from every thread that recorded it.
+@interface XRGStatsContentItem: NSObject
+
+@property (readonly) NSString *key;
+@property (readonly) XRGStatHandle handle;
+
+@property (readonly) double last;
+@property (readonly) double min;
+@property (readonly) double max;
+@property (readonly) double average;
+@property (readonly) NSUInteger count;
 
-- (NSArray<NSString *> *)keys;
+// Estimated from streaming quantile sketches of every observed value, so they cover the whole session in a few KB.
+@property (readonly) double p50;
+@property (readonly) double p95;
+@property (readonly) double p99;
 
-- (nullable XRGStatsContentItem *)statsForKey:(NSString *)key;
-- (void)observeStat:(double)value forKey:(NSString *)key;
+/// The current estimated quantile (0 to 1) of the observed values.
+- (double)quantile:(double)quantile;
+
+/// The stat over a rolling window ending now, or nil if nothing was observed in it.
+- (nullable XRGStatsWindowSummary *)summaryForWindow:(XRGStatsWindow)window;
+
+/// The current exponentially weighted moving averages, in the order of XRGStatsManager's ewmaTimeConstants.
+- (NSArray<NSNumber *> *)ewmaValues;
 
 @end
 
@@ -73,10 +109,28 @@ NS_ASSUME_NONNULL_BEGIN
 
 + (instancetype)shared;
 
+/// A module's name for display and exports, e.g. "Network".
++ (NSString *)nameForModule:(XRGStatsModule)module;
+
+/// Time constants, in seconds, of the EWMAs kept for every stat.  Defaults to 60, 300 and 900, like the load averages.
+/// Setting them restarts every EWMA; invalid values (none, more than 4, or any not greater than 0) are ignored.
+@property (nonatomic, copy) NSArray<NSNumber *> *ewmaTimeConstants;
+
 - (void)clearHistory;
 - (void)clearHistoryForModule:(XRGStatsModule)module;
 
+/// Interns a key.  Returns XRGStatHandleInvalid if the table of handles (XRG_STAT_MAX_HANDLES) is full.
+- (XRGStatHandle)handleForKey:(NSString *)key inModule:(XRGStatsModule)module;
+
+/// Keys in a module that have been observed since they were last cleared.
+- (NSArray<NSString *> *)keysForModule:(XRGStatsModule)module;
+
 - (nullable XRGStatsContentItem *)statForKey:(NSString *)key inModule:(XRGStatsModule)module;
+
+/// Records a value without taking a lock; safe to call from any thread.
+- (void)observeStat:(double)value forHandle:(XRGStatHandle)handle;
+
+/// Convenience for observeStat:forHandle:, which interns the key on every call.
 - (void)observeStat:(double)value forKey:(NSString *)key inModule:(XRGStatsModule)module;
 
 @end
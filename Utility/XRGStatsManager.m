@@ -25,11 +25,26 @@
 //
 
 #import "XRGStatsManager.h"
+#import "XRGStatShards.h"
+
+#pragma mark - XRGStatsWindowSummary
+@interface XRGStatsWindowSummary ()
+- (nullable instancetype)initWithHandle:(XRGStatHandle)handle window:(XRGStatsWindow)window;
+@end
+
+
+#pragma mark - XRGStatsContentItem
+@interface XRGStatsContentItem ()
+- (nullable instancetype)initWithKey:(NSString *)key handle:(XRGStatHandle)handle;
+@end
+
 
 #pragma mark - XRGStatsManager
 @interface XRGStatsManager ()
 
-@property NSDictionary<NSString *, XRGStatsModuleContent *> *modulesContent;
+// Module name -> key -> handle.  Only touched while interning or listing keys, under @synchronized(self).
+@property NSMutableDictionary<NSString *, NSMutableDictionary<NSString *, NSNumber *> *> *handlesByModule;
+@property XRGStatHandle nextHandle;
 
 @end
 
@@ -63,6 +78,9 @@
 
         case XRGStatsModuleNameStock:
             return @"XRG_Stock";
+
+        case XRGStatsModuleNameSampler:
+            return @"XRG_Sampler";
             
     }
 }
@@ -78,132 +96,219 @@
     return sharedManager;
 }
 
++ (NSString *)nameForModule:(XRGStatsModule)module {
+    switch (module) {
+        case XRGStatsModuleNameCPU:         return @"CPU";
+        case XRGStatsModuleNameGPU:         return @"GPU";
+        case XRGStatsModuleNameMemory:      return @"Memory";
+        case XRGStatsModuleNameTemperature: return @"Temperature";
+        case XRGStatsModuleNameBattery:     return @"Battery";
+        case XRGStatsModuleNameDisk:        return @"Disk";
+        case XRGStatsModuleNameNetwork:     return @"Network";
+        case XRGStatsModuleNameWeather:     return @"Weather";
+        case XRGStatsModuleNameStock:       return @"Stock";
+        case XRGStatsModuleNameSampler:     return @"Sampler";
+    }
+    return @"Unknown";
+}
+
 - (instancetype)init {
     self = [super init];
     if (self) {
-        self.modulesContent = [NSDictionary dictionary];
+        self.handlesByModule = [NSMutableDictionary dictionary];
+        self.nextHandle = 0;
     }
     return self;
 }
 
-- (void)clearHistory {
-    self.modulesContent = [NSDictionary dictionary];
+- (NSArray<NSNumber *> *)ewmaTimeConstants {
+    double seconds[XRG_STAT_MAX_EWMA];
+    size_t count = XRGStatGetEWMATimeConstants(seconds, XRG_STAT_MAX_EWMA);
+
+    NSMutableArray<NSNumber *> *constants = [NSMutableArray arrayWithCapacity:count];
+    for (size_t i = 0; i < count; i++) {
+        [constants addObject:@(seconds[i])];
+    }
+    return constants;
 }
 
-- (void)clearHistoryForModule:(XRGStatsModule)module {
-    NSString *moduleName = [XRGStatsManager nameOfModule:module];
+- (void)setEwmaTimeConstants:(NSArray<NSNumber *> *)ewmaTimeConstants {
+    if (ewmaTimeConstants.count > XRG_STAT_MAX_EWMA) return;
 
-    NSMutableDictionary *newStats = [self.modulesContent mutableCopy];
-    [newStats removeObjectForKey:moduleName];
-    self.modulesContent = newStats;
+    double seconds[XRG_STAT_MAX_EWMA];
+    for (NSUInteger i = 0; i < ewmaTimeConstants.count; i++) {
+        seconds[i] = ewmaTimeConstants[i].doubleValue;
+    }
+    XRGStatSetEWMATimeConstants(seconds, ewmaTimeConstants.count);
 }
 
-- (XRGStatsContentItem *)statForKey:(NSString *)key inModule:(XRGStatsModule)module {
-    return [[self contentForModule:module] statsForKey:key];
+- (void)clearHistory {
+    @synchronized (self) {
+        for (XRGStatHandle handle = 0; handle < self.nextHandle; handle++) {
+            XRGStatClear(handle);
+        }
+    }
 }
 
-- (void)observeStat:(double)value forKey:(NSString *)key inModule:(XRGStatsModule)module {
-    [[self contentForModule:module] observeStat:value forKey:key];
+- (void)clearHistoryForModule:(XRGStatsModule)module {
+    @synchronized (self) {
+        for (NSNumber *handle in [self.handlesByModule[[XRGStatsManager nameOfModule:module]] allValues]) {
+            XRGStatClear(handle.unsignedIntValue);
+        }
+    }
 }
 
-- (XRGStatsModuleContent *)contentForModule:(XRGStatsModule)module {
+- (XRGStatHandle)handleForKey:(NSString *)key inModule:(XRGStatsModule)module {
     NSString *moduleName = [XRGStatsManager nameOfModule:module];
 
-    XRGStatsModuleContent *content = self.modulesContent[moduleName];
-    if (content) return content;
+    @synchronized (self) {
+        NSMutableDictionary<NSString *, NSNumber *> *moduleHandles = self.handlesByModule[moduleName];
+        if (!moduleHandles) {
+            moduleHandles = [NSMutableDictionary dictionary];
+            self.handlesByModule[moduleName] = moduleHandles;
+        }
 
-    XRGStatsModuleContent *newContent = [[XRGStatsModuleContent alloc] init];
+        NSNumber *existingHandle = moduleHandles[key];
+        if (existingHandle) return existingHandle.unsignedIntValue;
 
-    NSMutableDictionary *newModulesContent = [self.modulesContent mutableCopy];
-    newModulesContent[moduleName] = newContent;
-    self.modulesContent = newModulesContent;
+        if (self.nextHandle >= XRG_STAT_MAX_HANDLES) return XRGStatHandleInvalid;
 
-    return newContent;
+        XRGStatHandle newHandle = self.nextHandle;
+        self.nextHandle = newHandle + 1;
+        moduleHandles[[key copy]] = @(newHandle);
+
+        return newHandle;
+    }
 }
 
-@end
+- (NSArray<NSString *> *)keysForModule:(XRGStatsModule)module {
+    NSDictionary<NSString *, NSNumber *> *moduleHandles;
+    @synchronized (self) {
+        moduleHandles = [self.handlesByModule[[XRGStatsManager nameOfModule:module]] copy];
+    }
+
+    NSMutableArray<NSString *> *keys = [NSMutableArray arrayWithCapacity:moduleHandles.count];
+    [moduleHandles enumerateKeysAndObjectsUsingBlock:^(NSString *key, NSNumber *handle, BOOL *stop) {
+        XRGStatSummary summary;
+        if (XRGStatRead(handle.unsignedIntValue, &summary)) [keys addObject:key];
+    }];
 
+    return keys;
+}
+
+- (XRGStatsContentItem *)statForKey:(NSString *)key inModule:(XRGStatsModule)module {
+    NSNumber *handle;
+    @synchronized (self) {
+        handle = self.handlesByModule[[XRGStatsManager nameOfModule:module]][key];
+    }
+    if (!handle) return nil;
 
-#pragma mark - XRGStatsModuleContent
-@interface XRGStatsModuleContent ()
+    return [[XRGStatsContentItem alloc] initWithKey:key handle:handle.unsignedIntValue];
+}
 
-@property NSDictionary<NSString *, XRGStatsContentItem *> *items;
+- (void)observeStat:(double)value forHandle:(XRGStatHandle)handle {
+    XRGStatObserve(handle, value);
+}
+
+- (void)observeStat:(double)value forKey:(NSString *)key inModule:(XRGStatsModule)module {
+    XRGStatObserve([self handleForKey:key inModule:module], value);
+}
 
 @end
 
-@implementation XRGStatsModuleContent: NSObject
 
-- (instancetype)init {
+#pragma mark - XRGStatsContentItem
+@implementation XRGStatsContentItem
+
+- (instancetype)initWithKey:(NSString *)key handle:(XRGStatHandle)handle {
+    XRGStatSummary summary;
+    if (!XRGStatRead(handle, &summary)) return nil;
+
     self = [super init];
     if (self) {
-        self.items = [NSDictionary dictionary];
+        _key = key;
+        _handle = handle;
+        _last = summary.last;
+        _min = summary.min;
+        _max = summary.max;
+        _average = summary.average;
+        _count = (NSUInteger)summary.count;
+
+        double quantiles[3] = { 0.5, 0.95, 0.99 };
+        double results[3];
+        XRGStatQuantiles(handle, quantiles, results, 3);
+        _p50 = results[0];
+        _p95 = results[1];
+        _p99 = results[2];
     }
     return self;
 }
 
-- (NSArray<NSString *> *)keys {
-    return self.items.allKeys;
+- (double)quantile:(double)quantile {
+    double result;
+    XRGStatQuantiles(self.handle, &quantile, &result, 1);
+    return result;
 }
 
-- (nullable XRGStatsContentItem *)statsForKey:(NSString *)key {
-    return self.items[key];
+- (XRGStatsWindowSummary *)summaryForWindow:(XRGStatsWindow)window {
+    return [[XRGStatsWindowSummary alloc] initWithHandle:self.handle window:window];
 }
 
-- (void)observeStat:(double)value forKey:(NSString *)key {
-    XRGStatsContentItem *item = [self statItemForKey:key initialValue:value];
+- (NSArray<NSNumber *> *)ewmaValues {
+    double results[XRG_STAT_MAX_EWMA];
+    size_t count = XRGStatReadEWMA(self.handle, results, XRG_STAT_MAX_EWMA);
 
-    [item observeStat:value];
+    NSMutableArray<NSNumber *> *values = [NSMutableArray arrayWithCapacity:count];
+    for (size_t i = 0; i < count; i++) {
+        [values addObject:@(results[i])];
+    }
+    return values;
 }
 
-#pragma mark Private
-- (XRGStatsContentItem *)statItemForKey:(NSString *)key initialValue:(double)initialValue {
-    XRGStatsContentItem *existingItem = self.items[key];
-    if (existingItem) return existingItem;
+@end
 
-    XRGStatsContentItem *newItem = [[XRGStatsContentItem alloc] initWithKey:key initialValue:initialValue];
 
-    NSMutableDictionary *newItems = [self.items mutableCopy];
-    newItems[key] = newItem;
-    self.items = newItems;
+#pragma mark - XRGStatsWindowSummary
+@implementation XRGStatsWindowSummary
 
-    return newItem;
-}
++ (XRGStatWindow)shardWindowForWindow:(XRGStatsWindow)window {
+    switch (window) {
+        case XRGStatsWindowOneMinute:
+            return XRGStatWindowOneMinute;
 
-@end
+        case XRGStatsWindowFiveMinutes:
+            return XRGStatWindowFiveMinutes;
 
+        case XRGStatsWindowOneHour:
+            return XRGStatWindowOneHour;
+    }
+    return XRGStatWindowCount;
+}
 
-#pragma mark - XRGStatsContentItem
-@interface XRGStatsContentItem ()
-@property NSUInteger statsObservedCount;
-@end
+- (instancetype)initWithHandle:(XRGStatHandle)handle window:(XRGStatsWindow)window {
+    XRGStatWindow shardWindow = [XRGStatsWindowSummary shardWindowForWindow:window];
 
-@implementation XRGStatsContentItem
+    XRGStatSummary summary;
+    if (!XRGStatReadWindow(handle, shardWindow, &summary)) return nil;
 
-- (instancetype)initWithKey:(NSString *)key initialValue:(double)initialValue {
     self = [super init];
     if (self) {
-        self.key = key;
-        self.last = initialValue;
-        self.min = initialValue;
-        self.max = initialValue;
-        self.average = initialValue;
-        self.statsObservedCount = 1;
+        _window = window;
+        _duration = XRGStatWindowSeconds(shardWindow);
+        _last = summary.last;
+        _min = summary.min;
+        _max = summary.max;
+        _average = summary.average;
+        _count = (NSUInteger)summary.count;
+
+        double quantiles[3] = { 0.5, 0.95, 0.99 };
+        double results[3];
+        XRGStatReadWindowQuantiles(handle, shardWindow, quantiles, results, 3);
+        _p50 = results[0];
+        _p95 = results[1];
+        _p99 = results[2];
     }
     return self;
 }
 
-- (void)observeStat:(double)value {
-    if (value < self.min) {
-        self.min = value;
-    }
-    if (value > self.max) {
-        self.max = value;
-    }
-
-    self.average = (self.average * self.statsObservedCount + value) / (self.statsObservedCount + 1);
-    self.statsObservedCount++;
-
-    self.last = value;
-}
-
 @end
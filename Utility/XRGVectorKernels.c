@@ -0,0 +1,425 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGVectorKernels.c
+//
+
+#include "XRGVectorKernels.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define XRG_VECTOR_X86 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define XRG_VECTOR_NEON 1
+#endif
+
+typedef struct {
+    XRGVectorBackend backend;
+    void (*minMaxSum)(const double *, size_t, double *, double *, double *);
+    void (*add)(const double *, const double *, double *, size_t);
+    void (*subtract)(const double *, const double *, double *, size_t);
+    void (*scale)(const double *, double, double *, size_t);
+    void (*fill)(double, double *, size_t);
+} XRGVectorKernelTable;
+
+// MARK: - Scalar
+
+static void XRGMinMaxSumScalar(const double *values, size_t count, double *min, double *max, double *sum) {
+    if (count == 0) {
+        *min = *max = *sum = 0;
+        return;
+    }
+    
+    double lo = values[0], hi = values[0], total = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (values[i] < lo) lo = values[i];
+        if (values[i] > hi) hi = values[i];
+        total += values[i];
+    }
+    
+    *min = lo;
+    *max = hi;
+    *sum = total;
+}
+
+static void XRGAddScalar(const double *a, const double *b, double *result, size_t count) {
+    for (size_t i = 0; i < count; i++) result[i] = a[i] + b[i];
+}
+
+static void XRGSubtractScalar(const double *a, const double *b, double *result, size_t count) {
+    for (size_t i = 0; i < count; i++) result[i] = a[i] - b[i];
+}
+
+static void XRGScaleScalar(const double *a, double scale, double *result, size_t count) {
+    for (size_t i = 0; i < count; i++) result[i] = a[i] * scale;
+}
+
+static void XRGFillScalar(double value, double *result, size_t count) {
+    for (size_t i = 0; i < count; i++) result[i] = value;
+}
+
+static const XRGVectorKernelTable XRGScalarKernels = {
+    XRGVectorBackendScalar, XRGMinMaxSumScalar, XRGAddScalar, XRGSubtractScalar, XRGScaleScalar, XRGFillScalar
+};
+
+// MARK: - SSE2
+
+#if XRG_VECTOR_X86
+// SSE2 is part of the x86_64 baseline, so these need no runtime check.
+
+static void XRGMinMaxSumSSE2(const double *values, size_t count, double *min, double *max, double *sum) {
+    if (count < 4) {
+        XRGMinMaxSumScalar(values, count, min, max, sum);
+        return;
+    }
+    
+    __m128d lo = _mm_loadu_pd(values);
+    __m128d hi = lo;
+    __m128d total = _mm_setzero_pd();
+    
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128d v = _mm_loadu_pd(values + i);
+        lo = _mm_min_pd(lo, v);
+        hi = _mm_max_pd(hi, v);
+        total = _mm_add_pd(total, v);
+    }
+    
+    double l[2], h[2], t[2];
+    _mm_storeu_pd(l, lo);
+    _mm_storeu_pd(h, hi);
+    _mm_storeu_pd(t, total);
+    
+    double rl = l[0] < l[1] ? l[0] : l[1];
+    double rh = h[0] > h[1] ? h[0] : h[1];
+    double rt = t[0] + t[1];
+    for (; i < count; i++) {
+        if (values[i] < rl) rl = values[i];
+        if (values[i] > rh) rh = values[i];
+        rt += values[i];
+    }
+    
+    *min = rl;
+    *max = rh;
+    *sum = rt;
+}
+
+static void XRGAddSSE2(const double *a, const double *b, double *result, size_t count) {
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        _mm_storeu_pd(result + i, _mm_add_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+    }
+    for (; i < count; i++) result[i] = a[i] + b[i];
+}
+
+static void XRGSubtractSSE2(const double *a, const double *b, double *result, size_t count) {
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        _mm_storeu_pd(result + i, _mm_sub_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+    }
+    for (; i < count; i++) result[i] = a[i] - b[i];
+}
+
+static void XRGScaleSSE2(const double *a, double scale, double *result, size_t count) {
+    __m128d s = _mm_set1_pd(scale);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        _mm_storeu_pd(result + i, _mm_mul_pd(_mm_loadu_pd(a + i), s));
+    }
+    for (; i < count; i++) result[i] = a[i] * scale;
+}
+
+static void XRGFillSSE2(double value, double *result, size_t count) {
+    __m128d v = _mm_set1_pd(value);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        _mm_storeu_pd(result + i, v);
+    }
+    for (; i < count; i++) result[i] = value;
+}
+
+static const XRGVectorKernelTable XRGSSE2Kernels = {
+    XRGVectorBackendSSE2, XRGMinMaxSumSSE2, XRGAddSSE2, XRGSubtractSSE2, XRGScaleSSE2, XRGFillSSE2
+};
+
+// MARK: - AVX2
+
+#define XRG_AVX2 __attribute__((target("avx2")))
+
+XRG_AVX2 static void XRGMinMaxSumAVX2(const double *values, size_t count, double *min, double *max, double *sum) {
+    if (count < 8) {
+        XRGMinMaxSumSSE2(values, count, min, max, sum);
+        return;
+    }
+    
+    // Two accumulators per value hide the latency of the dependent min/max/add chains.
+    __m256d lo0 = _mm256_loadu_pd(values), lo1 = lo0;
+    __m256d hi0 = lo0, hi1 = lo0;
+    __m256d total0 = _mm256_setzero_pd(), total1 = _mm256_setzero_pd();
+    
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256d v0 = _mm256_loadu_pd(values + i);
+        __m256d v1 = _mm256_loadu_pd(values + i + 4);
+        lo0 = _mm256_min_pd(lo0, v0);
+        lo1 = _mm256_min_pd(lo1, v1);
+        hi0 = _mm256_max_pd(hi0, v0);
+        hi1 = _mm256_max_pd(hi1, v1);
+        total0 = _mm256_add_pd(total0, v0);
+        total1 = _mm256_add_pd(total1, v1);
+    }
+    
+    double l[4], h[4], t[4];
+    _mm256_storeu_pd(l, _mm256_min_pd(lo0, lo1));
+    _mm256_storeu_pd(h, _mm256_max_pd(hi0, hi1));
+    _mm256_storeu_pd(t, _mm256_add_pd(total0, total1));
+    
+    double rl = l[0], rh = h[0], rt = t[0] + t[1] + t[2] + t[3];
+    for (int k = 1; k < 4; k++) {
+        if (l[k] < rl) rl = l[k];
+        if (h[k] > rh) rh = h[k];
+    }
+    for (; i < count; i++) {
+        if (values[i] < rl) rl = values[i];
+        if (values[i] > rh) rh = values[i];
+        rt += values[i];
+    }
+    
+    *min = rl;
+    *max = rh;
+    *sum = rt;
+}
+
+XRG_AVX2 static void XRGAddAVX2(const double *a, const double *b, double *result, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm256_storeu_pd(result + i, _mm256_add_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    }
+    for (; i < count; i++) result[i] = a[i] + b[i];
+}
+
+XRG_AVX2 static void XRGSubtractAVX2(const double *a, const double *b, double *result, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm256_storeu_pd(result + i, _mm256_sub_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    }
+    for (; i < count; i++) result[i] = a[i] - b[i];
+}
+
+XRG_AVX2 static void XRGScaleAVX2(const double *a, double scale, double *result, size_t count) {
+    __m256d s = _mm256_set1_pd(scale);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm256_storeu_pd(result + i, _mm256_mul_pd(_mm256_loadu_pd(a + i), s));
+    }
+    for (; i < count; i++) result[i] = a[i] * scale;
+}
+
+XRG_AVX2 static void XRGFillAVX2(double value, double *result, size_t count) {
+    __m256d v = _mm256_set1_pd(value);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm256_storeu_pd(result + i, v);
+    }
+    for (; i < count; i++) result[i] = value;
+}
+
+static const XRGVectorKernelTable XRGAVX2Kernels = {
+    XRGVectorBackendAVX2, XRGMinMaxSumAVX2, XRGAddAVX2, XRGSubtractAVX2, XRGScaleAVX2, XRGFillAVX2
+};
+
+#endif
+
+// MARK: - NEON
+
+#if XRG_VECTOR_NEON
+// NEON with double lanes is part of the arm64 baseline, so these need no runtime check.
+
+static void XRGMinMaxSumNEON(const double *values, size_t count, double *min, double *max, double *sum) {
+    if (count < 4) {
+        XRGMinMaxSumScalar(values, count, min, max, sum);
+        return;
+    }
+    
+    float64x2_t lo0 = vld1q_f64(values), lo1 = lo0;
+    float64x2_t hi0 = lo0, hi1 = lo0;
+    float64x2_t total0 = vdupq_n_f64(0), total1 = vdupq_n_f64(0);
+    
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float64x2_t v0 = vld1q_f64(values + i);
+        float64x2_t v1 = vld1q_f64(values + i + 2);
+        lo0 = vminq_f64(lo0, v0);
+        lo1 = vminq_f64(lo1, v1);
+        hi0 = vmaxq_f64(hi0, v0);
+        hi1 = vmaxq_f64(hi1, v1);
+        total0 = vaddq_f64(total0, v0);
+        total1 = vaddq_f64(total1, v1);
+    }
+    
+    double rl = vminvq_f64(vminq_f64(lo0, lo1));
+    double rh = vmaxvq_f64(vmaxq_f64(hi0, hi1));
+    double rt = vaddvq_f64(vaddq_f64(total0, total1));
+    for (; i < count; i++) {
+        if (values[i] < rl) rl = values[i];
+        if (values[i] > rh) rh = values[i];
+        rt += values[i];
+    }
+    
+    *min = rl;
+    *max = rh;
+    *sum = rt;
+}
+
+static void XRGAddNEON(const double *a, const double *b, double *result, size_t count) {
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        vst1q_f64(result + i, vaddq_f64(vld1q_f64(a + i), vld1q_f64(b + i)));
+    }
+    for (; i < count; i++) result[i] = a[i] + b[i];
+}
+
+static void XRGSubtractNEON(const double *a, const double *b, double *result, size_t count) {
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        vst1q_f64(result + i, vsubq_f64(vld1q_f64(a + i), vld1q_f64(b + i)));
+    }
+    for (; i < count; i++) result[i] = a[i] - b[i];
+}
+
+static void XRGScaleNEON(const double *a, double scale, double *result, size_t count) {
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        vst1q_f64(result + i, vmulq_n_f64(vld1q_f64(a + i), scale));
+    }
+    for (; i < count; i++) result[i] = a[i] * scale;
+}
+
+static void XRGFillNEON(double value, double *result, size_t count) {
+    float64x2_t v = vdupq_n_f64(value);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        vst1q_f64(result + i, v);
+    }
+    for (; i < count; i++) result[i] = value;
+}
+
+static const XRGVectorKernelTable XRGNEONKernels = {
+    XRGVectorBackendNEON, XRGMinMaxSumNEON, XRGAddNEON, XRGSubtractNEON, XRGScaleNEON, XRGFillNEON
+};
+
+#endif
+
+// MARK: - Dispatch
+
+// The tables are const, so switching backends is a single atomic pointer swap: a kernel call on another thread
+// loads the pointer once and runs entirely on either the old table or the new one.
+static _Atomic(const XRGVectorKernelTable *) XRGKernels = &XRGScalarKernels;
+static pthread_once_t XRGKernelsOnce = PTHREAD_ONCE_INIT;
+
+static const XRGVectorKernelTable *XRGKernelTableForBackend(XRGVectorBackend backend) {
+    switch (backend) {
+        case XRGVectorBackendScalar:
+            return &XRGScalarKernels;
+#if XRG_VECTOR_X86
+        case XRGVectorBackendSSE2:
+            return &XRGSSE2Kernels;
+        case XRGVectorBackendAVX2:
+            return __builtin_cpu_supports("avx2") ? &XRGAVX2Kernels : NULL;
+#endif
+#if XRG_VECTOR_NEON
+        case XRGVectorBackendNEON:
+            return &XRGNEONKernels;
+#endif
+        default:
+            return NULL;
+    }
+}
+
+static void XRGSelectKernels(void) {
+    const XRGVectorBackend preferred[] = { XRGVectorBackendAVX2, XRGVectorBackendNEON, XRGVectorBackendSSE2 };
+    
+    for (size_t i = 0; i < sizeof(preferred) / sizeof(preferred[0]); i++) {
+        const XRGVectorKernelTable *table = XRGKernelTableForBackend(preferred[i]);
+        if (table) {
+            atomic_store_explicit(&XRGKernels, table, memory_order_release);
+            return;
+        }
+    }
+}
+
+static inline const XRGVectorKernelTable *XRGCurrentKernels(void) {
+    pthread_once(&XRGKernelsOnce, XRGSelectKernels);
+    return atomic_load_explicit(&XRGKernels, memory_order_acquire);
+}
+
+XRGVectorBackend XRGVectorCurrentBackend(void) {
+    return XRGCurrentKernels()->backend;
+}
+
+const char *XRGVectorBackendName(XRGVectorBackend backend) {
+    switch (backend) {
+        case XRGVectorBackendScalar: return "Scalar";
+        case XRGVectorBackendSSE2:   return "SSE2";
+        case XRGVectorBackendAVX2:   return "AVX2";
+        case XRGVectorBackendNEON:   return "NEON";
+    }
+    return "Unknown";
+}
+
+bool XRGVectorSetBackend(XRGVectorBackend backend) {
+    pthread_once(&XRGKernelsOnce, XRGSelectKernels);
+    
+    const XRGVectorKernelTable *table = XRGKernelTableForBackend(backend);
+    if (!table) return false;
+    
+    // After the pthread_once above, so the automatic selection can't overwrite this.
+    atomic_store_explicit(&XRGKernels, table, memory_order_release);
+    return true;
+}
+
+// MARK: - Kernels
+
+void XRGVectorMinMaxSum(const double *values, size_t count, double *min, double *max, double *sum) {
+    XRGCurrentKernels()->minMaxSum(values, count, min, max, sum);
+}
+
+void XRGVectorAdd(const double *a, const double *b, double *result, size_t count) {
+    XRGCurrentKernels()->add(a, b, result, count);
+}
+
+void XRGVectorSubtract(const double *a, const double *b, double *result, size_t count) {
+    XRGCurrentKernels()->subtract(a, b, result, count);
+}
+
+void XRGVectorScale(const double *a, double scale, double *result, size_t count) {
+    XRGCurrentKernels()->scale(a, scale, result, count);
+}
+
+void XRGVectorFill(double value, double *result, size_t count) {
+    XRGCurrentKernels()->fill(value, result, count);
+}
@@ -0,0 +1,68 @@
+/* 
+ * XRG (X Resource Graph):  A system resource grapher for Mac OS X.
+ * Copyright (C) 2002-2022 Gaucho Software, LLC.
+ * You can view the complete license in the LICENSE file in the root
+ * of the source tree.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+//
+//  XRGVectorKernels.h
+//
+
+#ifndef XRG_VECTOR_KERNELS_H
+#define XRG_VECTOR_KERNELS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Vector kernels for the data set math, in plain C so they build anywhere.  Each kernel has a scalar reference
+// implementation plus SSE2, AVX2 and NEON versions, and the fastest one the CPU supports is picked the first
+// time any kernel is called.  Input and output arrays may be the same array.
+
+typedef enum {
+    XRGVectorBackendScalar = 0,
+    XRGVectorBackendSSE2,
+    XRGVectorBackendAVX2,
+    XRGVectorBackendNEON
+} XRGVectorBackend;
+
+/// Min, max and sum of values in a single pass.  All three are 0 when count is 0.
+void XRGVectorMinMaxSum(const double *values, size_t count, double *min, double *max, double *sum);
+
+/// result[i] = a[i] + b[i]
+void XRGVectorAdd(const double *a, const double *b, double *result, size_t count);
+
+/// result[i] = a[i] - b[i]
+void XRGVectorSubtract(const double *a, const double *b, double *result, size_t count);
+
+/// result[i] = a[i] * scale
+void XRGVectorScale(const double *a, double scale, double *result, size_t count);
+
+/// result[i] = value
+void XRGVectorFill(double value, double *result, size_t count);
+
+/// The backend the kernels are currently using.
+XRGVectorBackend XRGVectorCurrentBackend(void);
+const char *XRGVectorBackendName(XRGVectorBackend backend);
+
+/// Switch to a specific backend, e.g. to compare it against the scalar reference.  Returns false and leaves the
+/// current backend in place if this CPU or build doesn't support it.  Safe to call while other threads are running
+/// kernels; each call in flight finishes on the backend it started with.
+bool XRGVectorSetBackend(XRGVectorBackend backend);
+
+#endif